@@ -27,6 +27,7 @@ limitations under the License.
 #include "oneflow/core/common/global.h"
 #include "oneflow/core/common/hash_container.h"
 #include "oneflow/core/common/just.h"
+#include "oneflow/core/common/scalar.h"
 #include "oneflow/core/common/shape.h"
 #include "oneflow/core/common/symbol.h"
 #include "oneflow/core/common/util.h"
@@ -54,10 +55,15 @@ limitations under the License.
 #include "oneflow/core/operator/interface_blob_conf.pb.h"
 #include "oneflow/core/operator/op_conf.pb.h"
 #include "oneflow/core/register/logical_blob_id.pb.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
 
 namespace oneflow_api {
 
 namespace of = oneflow;
+// for the CHECK_*_OR_RETURN macros
+using of::Error;
 
 enum class XrtKind : int { kNone = 0, kTensorRT = 1 };
 
@@ -109,6 +115,25 @@ std::string GetDeviceTag(const Device& device) {
   }
 }
 
+// Compiling uses the global JobBuildAndInferCtx, so the graphs are compiled one by one
+std::mutex* GlobalCompileMutex() {
+  static std::mutex mutex;
+  return &mutex;
+}
+
+// Pad the batch dimension of `tensor` to `batch_size` with zeros
+of::Maybe<of::one::Tensor> PadBatch(const std::shared_ptr<of::one::Tensor>& tensor,
+                                    int64_t batch_size) {
+  const int64_t pad_size = batch_size - tensor->shape()->At(0);
+  CHECK_GE_OR_RETURN(pad_size, 0);
+  if (pad_size == 0) { return tensor; }
+  of::DimVector pad_dim_vec = tensor->shape()->dim_vec();
+  pad_dim_vec.at(0) = pad_size;
+  const auto padding = JUST(of::one::functional::Constant(
+      of::Shape(pad_dim_vec), of::Scalar(0), tensor->dtype(), JUST(tensor->device())));
+  return of::one::functional::Concat(of::one::TensorTuple{tensor, padding}, 0);
+}
+
 template<class T1, class T2>
 const std::pair<std::vector<T1>, std::vector<T2>> Unzip(const of::HashMap<T1, T2>& hash_map) {
   std::vector<T1> vec1;
@@ -125,24 +150,38 @@ const std::pair<std::vector<T1>, std::vector<T2>> Unzip(const of::HashMap<T1, T2
 class Graph::GraphImpl final {
  public:
   explicit GraphImpl(const std::string& model_path, const Device& device = Device("cpu"));
+  // A graph of the batch size bucket of `parent`, which shares the variables of `parent`
+  GraphImpl(const GraphImpl& parent, int batch_size_bucket);
 
   GraphImpl(const GraphImpl& graph) = delete;
-  GraphImpl(GraphImpl&& graph) noexcept;
+  GraphImpl(GraphImpl&& graph) = delete;
 
   ~GraphImpl() = default;
 
   GraphImpl& operator=(const GraphImpl& graph) = delete;
-  GraphImpl& operator=(GraphImpl&& graph) noexcept;
+  GraphImpl& operator=(GraphImpl&& graph) = delete;
 
   std::vector<Tensor> Forward(const std::vector<Tensor>& inputs);
   void set_batch_size(int batch_size) { batch_size_ = batch_size; }
+  void set_batch_size_buckets(const std::vector<int>& batch_size_buckets);
+  void CompileBatchSizeBuckets();
   void enable_tensorrt() { xrt_kind_ = XrtKind::kTensorRT; }
 
  private:
+  // Run with `inputs` padded to the batch size bucket, the outputs are narrowed to `batch_size`
+  oneflow::Maybe<std::vector<Tensor>> CompileAndRun(const std::vector<Tensor>& inputs,
+                                                    int64_t batch_size);
+  oneflow::Maybe<std::vector<Tensor>> ForwardWithBatchSizeBucket(
+      const std::vector<Tensor>& inputs);
+  GraphImpl* GetOrCreateBatchSizeBucketGraph(int batch_size_bucket);
+  oneflow::Maybe<void> CompileIfNeeded(const std::vector<Tensor>& inputs);
   oneflow::Maybe<void> Compile(const std::vector<Tensor>& inputs);
-  oneflow::Maybe<std::vector<Tensor>> Run(const std::vector<Tensor>& inputs) const;
+  oneflow::Maybe<std::vector<Tensor>> MakeEmptyInputs() const;
+  oneflow::Maybe<std::vector<Tensor>> Run(const std::vector<Tensor>& inputs,
+                                          int64_t batch_size) const;
   oneflow::Maybe<void> AddOp(oneflow::OperatorConf op_conf);
   oneflow::Maybe<void> BuildGraph(const std::vector<Tensor>& inputs);
+  oneflow::Maybe<void> LoadVariablesIfNeeded();
   oneflow::Maybe<void> LoadCheckpoint();
   oneflow::Maybe<void> RegisterTensors(const std::vector<Tensor>& inputs);
 
@@ -153,10 +192,17 @@ class Graph::GraphImpl final {
   XrtKind xrt_kind_ = XrtKind::kNone;
   Device device_;
   oneflow::Job job_;
+  // guards is_compiled_, the variables and batch_size_bucket_to_graph_, and serializes Run
+  std::mutex mutex_;
+  std::vector<int> batch_size_buckets_;
+  std::map<int, std::unique_ptr<GraphImpl>> batch_size_bucket_to_graph_;
 
   oneflow::HashMap<std::string, int> input_name_to_order_;
+  std::vector<oneflow::InterfaceBlobConf> input_blob_confs_;
   oneflow::HashMap<std::string, std::shared_ptr<oneflow::one::Tensor>> output_name_to_tensor_;
-  oneflow::HashMap<std::string, std::shared_ptr<oneflow::one::Tensor>> variable_op_name_to_tensor_;
+  // shared by the graphs of all the batch size buckets
+  std::shared_ptr<const oneflow::HashMap<std::string, std::shared_ptr<oneflow::one::Tensor>>>
+      variable_op_name_to_tensor_;
   std::shared_ptr<oneflow::one::TensorTuple> output_tensor_tuple_;
   std::shared_ptr<oneflow::one::TensorTuple> parameter_tensor_tuple_;
 };
@@ -198,6 +244,12 @@ IValue Graph::Forward(const IValue& inputs) {
 
 void Graph::set_batch_size(int batch_size) { graph_->set_batch_size(batch_size); }
 
+void Graph::set_batch_size_buckets(const std::vector<int>& batch_size_buckets) {
+  graph_->set_batch_size_buckets(batch_size_buckets);
+}
+
+void Graph::CompileBatchSizeBuckets() { graph_->CompileBatchSizeBuckets(); }
+
 void Graph::enable_tensorrt() { graph_->enable_tensorrt(); }
 
 Graph Graph::Load(const std::string& model_path, const Device& device) {
@@ -210,60 +262,121 @@ Graph::GraphImpl::GraphImpl(const std::string& model_path, const Device& device)
   CHECK_JUST(of::LoadJobFromIR(&job_, model_path + "/model.mlir"));
   job_.mutable_job_conf()->mutable_predict_conf();
   job_.mutable_job_conf()->set_job_name(job_.mutable_job_conf()->job_name() + of::NewUniqueId());
-  graph_ = std::make_shared<of::NNGraph>(job_.job_conf().job_name());
-  of::Global<of::MultiClientSessionContext>::Get()->AddCGraph(graph_).GetOrThrow();
 }
 
-Graph::GraphImpl::GraphImpl(GraphImpl&& graph) noexcept
-    : graph_(std::move(graph.graph_)),
-      model_path_(std::move(graph.model_path_)),
-      is_compiled_(graph.is_compiled_),
-      batch_size_(graph.batch_size_),
-      xrt_kind_(graph.xrt_kind_),
-      device_(std::move(graph.device_)),
-      job_(std::move(graph.job_)),
-      input_name_to_order_(std::move(graph.input_name_to_order_)),
-      output_name_to_tensor_(std::move(graph.output_name_to_tensor_)),
-      variable_op_name_to_tensor_(std::move(graph.variable_op_name_to_tensor_)),
-      output_tensor_tuple_(std::move(graph.output_tensor_tuple_)),
-      parameter_tensor_tuple_(std::move(graph.parameter_tensor_tuple_)) {}
-
-Graph::GraphImpl& Graph::GraphImpl::operator=(Graph::GraphImpl&& graph) noexcept {
-  if (&graph == this) { return *this; }
-  graph_ = std::move(graph.graph_);
-  model_path_ = std::move(graph.model_path_);
-  is_compiled_ = graph.is_compiled_;
-  batch_size_ = graph.batch_size_;
-  xrt_kind_ = graph.xrt_kind_;
-  device_ = std::move(graph.device_);
-  job_ = std::move(graph.job_);
-  input_name_to_order_ = std::move(graph.input_name_to_order_);
-  output_name_to_tensor_ = std::move(graph.output_name_to_tensor_);
-  variable_op_name_to_tensor_ = std::move(graph.variable_op_name_to_tensor_);
-  output_tensor_tuple_ = std::move(graph.output_tensor_tuple_);
-  parameter_tensor_tuple_ = std::move(graph.parameter_tensor_tuple_);
-  return *this;
+Graph::GraphImpl::GraphImpl(const GraphImpl& parent, int batch_size_bucket)
+    : model_path_(parent.model_path_),
+      batch_size_(batch_size_bucket),
+      xrt_kind_(parent.xrt_kind_),
+      device_(parent.device_),
+      job_(parent.job_),
+      variable_op_name_to_tensor_(parent.variable_op_name_to_tensor_) {
+  CHECK(variable_op_name_to_tensor_);
+  job_.mutable_job_conf()->set_job_name(job_.mutable_job_conf()->job_name() + "_batch_size_"
+                                        + std::to_string(batch_size_bucket));
 }
 
 std::vector<Tensor> Graph::GraphImpl::Forward(const std::vector<Tensor>& inputs) {
-  if (!is_compiled_) {
-    static std::mutex mtx;
-    std::lock_guard<std::mutex> lock(mtx);
-    Compile(inputs).GetOrThrow();
-    is_compiled_ = true;
+  if (!batch_size_buckets_.empty()) { return ForwardWithBatchSizeBucket(inputs).GetOrThrow(); }
+  return CompileAndRun(inputs, /*batch_size=*/0).GetOrThrow();
+}
+
+void Graph::GraphImpl::set_batch_size_buckets(const std::vector<int>& batch_size_buckets) {
+  for (int batch_size : batch_size_buckets) { CHECK_GT(batch_size, 0); }
+  batch_size_buckets_ = batch_size_buckets;
+  std::sort(batch_size_buckets_.begin(), batch_size_buckets_.end());
+  batch_size_buckets_.erase(std::unique(batch_size_buckets_.begin(), batch_size_buckets_.end()),
+                            batch_size_buckets_.end());
+}
+
+void Graph::GraphImpl::CompileBatchSizeBuckets() {
+  for (int batch_size_bucket : batch_size_buckets_) {
+    GraphImpl* graph = GetOrCreateBatchSizeBucketGraph(batch_size_bucket);
+    std::lock_guard<std::mutex> lock(graph->mutex_);
+    graph->CompileIfNeeded({}).GetOrThrow();
+  }
+}
+
+of::Maybe<std::vector<Tensor>> Graph::GraphImpl::CompileAndRun(const std::vector<Tensor>& inputs,
+                                                                int64_t batch_size) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  JUST(CompileIfNeeded(inputs));
+  return Run(inputs, batch_size);
+}
+
+of::Maybe<std::vector<Tensor>> Graph::GraphImpl::ForwardWithBatchSizeBucket(
+    const std::vector<Tensor>& inputs) {
+  CHECK_OR_RETURN(!inputs.empty()) << "Graph with batch size buckets needs inputs";
+  const int64_t batch_size = inputs.at(0).tensor_->shape()->At(0);
+  const auto bucket_it =
+      std::lower_bound(batch_size_buckets_.begin(), batch_size_buckets_.end(), batch_size);
+  CHECK_OR_RETURN(bucket_it != batch_size_buckets_.end())
+      << "batch size " << batch_size << " is larger than the largest bucket "
+      << batch_size_buckets_.back();
+  const int batch_size_bucket = *bucket_it;
+  std::vector<Tensor> padded_inputs;
+  for (const auto& input : inputs) {
+    CHECK_EQ_OR_RETURN(input.tensor_->shape()->At(0), batch_size)
+        << "all the inputs should have the same batch size";
+    padded_inputs.emplace_back(JUST(PadBatch(input.tensor_, batch_size_bucket)));
   }
-  return Run(inputs).GetOrThrow();
+  GraphImpl* graph = GetOrCreateBatchSizeBucketGraph(batch_size_bucket);
+  return graph->CompileAndRun(padded_inputs, batch_size);
+}
+
+Graph::GraphImpl* Graph::GraphImpl::GetOrCreateBatchSizeBucketGraph(int batch_size_bucket) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = batch_size_bucket_to_graph_.find(batch_size_bucket);
+  if (it == batch_size_bucket_to_graph_.end()) {
+    // the variables are loaded once and shared by the graphs of all the buckets
+    LoadVariablesIfNeeded().GetOrThrow();
+    it = batch_size_bucket_to_graph_
+             .emplace(batch_size_bucket, std::make_unique<GraphImpl>(*this, batch_size_bucket))
+             .first;
+  }
+  return it->second.get();
+}
+
+// mutex_ should be held
+of::Maybe<void> Graph::GraphImpl::CompileIfNeeded(const std::vector<Tensor>& inputs) {
+  if (is_compiled_) { return of::Maybe<void>::Ok(); }
+  std::lock_guard<std::mutex> lock(*GlobalCompileMutex());
+  JUST(Compile(inputs));
+  is_compiled_ = true;
+  return of::Maybe<void>::Ok();
 }
 
 of::Maybe<void> Graph::GraphImpl::Compile(const std::vector<Tensor>& inputs) {
+  // the NNGraph is only made for a graph which runs, not for the parent of batch size buckets
+  graph_ = std::make_shared<of::NNGraph>(job_.job_conf().job_name());
+  JUST(of::Global<of::MultiClientSessionContext>::Get()->AddCGraph(graph_));
+  JUST(LoadVariablesIfNeeded());
   JUST(BuildGraph(inputs));
-  JUST(LoadCheckpoint());
-  JUST(RegisterTensors(inputs));
+  if (inputs.empty() && !input_blob_confs_.empty()) {
+    // compiled ahead of time, the inputs are made from the input ops
+    JUST(RegisterTensors(*JUST(MakeEmptyInputs())));
+  } else {
+    JUST(RegisterTensors(inputs));
+  }
   JUST(graph_->CompileAndInitRuntime());
   return of::Maybe<void>::Ok();
 }
 
-of::Maybe<std::vector<Tensor>> Graph::GraphImpl::Run(const std::vector<Tensor>& inputs) const {
+of::Maybe<std::vector<Tensor>> Graph::GraphImpl::MakeEmptyInputs() const {
+  const of::LazyMode::Guard lazy_mode_disabled_guard{false};
+  std::vector<Tensor> inputs;
+  for (const auto& blob_conf : input_blob_confs_) {
+    inputs.emplace_back(JUST(of::one::functional::Empty(
+        of::Shape(blob_conf.shape()),
+        JUST(of::DType::Get(static_cast<of::DataType>(blob_conf.data_type()))),
+        *device_.device_)));
+  }
+  return inputs;
+}
+
+// mutex_ should be held
+of::Maybe<std::vector<Tensor>> Graph::GraphImpl::Run(const std::vector<Tensor>& inputs,
+                                                     int64_t batch_size) const {
   const auto input_tensor_tuple = std::make_shared<of::one::TensorTuple>();
   for (const auto& tensor : inputs) { input_tensor_tuple->emplace_back(tensor.tensor_); }
 
@@ -271,8 +384,20 @@ of::Maybe<std::vector<Tensor>> Graph::GraphImpl::Run(const std::vector<Tensor>&
                           graph_));
   JUST(of::SoftSyncNNGraphBuffers(*output_tensor_tuple_, graph_));
 
+  // The output tensors are overwritten by the next run, which may come from another thread as
+  // soon as mutex_ is released, so every call gets a copy of its own
   std::vector<Tensor> outputs;
-  for (const auto& tensor : *output_tensor_tuple_) { outputs.emplace_back(Tensor(tensor)); }
+  for (const auto& tensor : *output_tensor_tuple_) {
+    std::shared_ptr<of::one::Tensor> output = tensor;
+    const auto& shape = output->shape();
+    if (batch_size > 0 && batch_size != batch_size_ && shape->NumAxes() > 0
+        && shape->At(0) == batch_size_) {
+      output = JUST(of::one::functional::Narrow(output, 0, 0, batch_size));
+    }
+    const auto& device = JUST(output->device());
+    outputs.emplace_back(
+        Tensor(JUST(of::one::functional::Copy(output, device->type(), device->device_id()))));
+  }
   return outputs;
 }
 
@@ -303,13 +428,9 @@ of::Maybe<void> Graph::GraphImpl::BuildGraph(const std::vector<Tensor>& inputs)
       if (op_conf.has_input_conf()) {
         input_name_to_order_[op_conf.name()] = input_tensor_order;
         input_tensor_order += 1;
-      } else if (op_conf.has_variable_conf()) {
-        const of::LazyMode::Guard lazy_mode_disabled_guard{false};
-        const of::VariableOpConf& variable_conf = op_conf.variable_conf();
-        variable_op_name_to_tensor_[op_conf.name()] = JUST(of::one::functional::Empty(
-            of::Shape(variable_conf.shape()),
-            JUST(of::DType::Get(static_cast<of::DataType>(variable_conf.data_type()))),
-            *device_.device_));
+        of::InterfaceBlobConf blob_conf = op_conf.input_conf().blob_conf();
+        if (batch_size_ > 0) { blob_conf.mutable_shape()->set_dim(0, batch_size_); }
+        input_blob_confs_.emplace_back(blob_conf);
       }
       return of::Maybe<void>::Ok();
     });
@@ -340,8 +461,28 @@ of::Maybe<void> Graph::GraphImpl::BuildGraph(const std::vector<Tensor>& inputs)
   return of::Maybe<void>::Ok();
 }
 
+// mutex_ should be held
+of::Maybe<void> Graph::GraphImpl::LoadVariablesIfNeeded() {
+  if (variable_op_name_to_tensor_) { return of::Maybe<void>::Ok(); }
+  auto variable_op_name_to_tensor =
+      std::make_shared<of::HashMap<std::string, std::shared_ptr<of::one::Tensor>>>();
+  {
+    const of::LazyMode::Guard lazy_mode_disabled_guard{false};
+    for (const of::OperatorConf& op_conf : job_.net().op()) {
+      if (!op_conf.has_variable_conf()) { continue; }
+      const of::VariableOpConf& variable_conf = op_conf.variable_conf();
+      (*variable_op_name_to_tensor)[op_conf.name()] = JUST(of::one::functional::Empty(
+          of::Shape(variable_conf.shape()),
+          JUST(of::DType::Get(static_cast<of::DataType>(variable_conf.data_type()))),
+          *device_.device_));
+    }
+  }
+  variable_op_name_to_tensor_ = variable_op_name_to_tensor;
+  return LoadCheckpoint();
+}
+
 of::Maybe<void> Graph::GraphImpl::LoadCheckpoint() {
-  for (const auto& variable_op_name_and_tensor : variable_op_name_to_tensor_) {
+  for (const auto& variable_op_name_and_tensor : *variable_op_name_to_tensor_) {
     const auto& variable_op_name = variable_op_name_and_tensor.first;
     const auto& variable_tensor = variable_op_name_and_tensor.second;
     const std::string variable_filename = model_path_ + "/" + variable_op_name + "/out";
@@ -383,7 +524,7 @@ of::Maybe<void> Graph::GraphImpl::RegisterTensors(const std::vector<Tensor>& inp
     output_tensor_tuple_ = ConvertToTensorTuple(output_tensors);
   }
   {
-    const auto& pair = Unzip(variable_op_name_to_tensor_);
+    const auto& pair = Unzip(*variable_op_name_to_tensor_);
     const std::vector<std::string>& variable_op_names = pair.first;
     const std::vector<std::shared_ptr<of::one::Tensor>>& variable_tensors = pair.second;
     JUST(graph_->RegisterVariableOpNamesAndTensors(variable_op_names, variable_tensors));
@@ -40,8 +40,14 @@ class Graph {
   Graph& operator=(const Graph& graph) = delete;
   Graph& operator=(Graph&& graph) noexcept;
 
+  // Graph instances can run Forward concurrently, the Forward calls of one instance are serialized
   IValue Forward(const IValue& inputs);
   void set_batch_size(int batch_size);
+  // The batch dimension of the inputs is padded to the smallest bucket not less than it, and the
+  // outputs are sliced back. The graph of every bucket is compiled on its first use, or in advance
+  // by CompileBatchSizeBuckets.
+  void set_batch_size_buckets(const std::vector<int>& batch_size_buckets);
+  void CompileBatchSizeBuckets();
   void enable_tensorrt();
 
   static Graph Load(const std::string& model_path, const Device& device = Device("cpu"));
@@ -36,9 +36,11 @@ inline Graph LoadGraph(const Device& device) {
   return graph;
 }
 
-inline void Forward(Graph& graph, const Device& device, int expected_batch_dim = 1) {
+// every output element of affine_with_parameter is 3 * input_value + 1
+inline void Forward(Graph& graph, const Device& device, int expected_batch_dim = 1,
+                    float input_value = 1) {
   std::vector<float> data(expected_batch_dim * 3);
-  std::fill(data.begin(), data.end(), 1);
+  std::fill(data.begin(), data.end(), input_value);
   std::vector<Tensor> inputs;
   inputs.emplace_back(
       Tensor::from_buffer(data.data(), Shape({expected_batch_dim, 3}), device, DType::kFloat));
@@ -50,7 +52,7 @@ inline void Forward(Graph& graph, const Device& device, int expected_batch_dim =
   ASSERT_EQ(shape.At(1), 4);
   std::vector<float> buf(expected_batch_dim * 4);
   output.copy_to(buf.data());
-  for (const float& element : buf) { ASSERT_EQ(element, 4); }
+  for (const float& element : buf) { ASSERT_EQ(element, 3 * input_value + 1); }
 }
 
 }  // namespace
@@ -151,6 +153,34 @@ TEST(Api, graph_unload_test) {
 }
 #endif
 
+TEST(Api, graph_cpu_batch_size_buckets_test) {
+  EnvScope scope;
+  Device device("cpu");
+  Graph graph = LoadGraph(device);
+  graph.set_batch_size_buckets({8, 4});
+  graph.CompileBatchSizeBuckets();
+  Forward(graph, device, 3);
+  Forward(graph, device, 4);
+  Forward(graph, device, 7);
+  Forward(graph, device, 1);
+}
+
+TEST(Api, graph_batch_size_buckets_thread_test) {
+  EnvScope scope;
+  Device device("cpu");
+  Graph graph = LoadGraph(device);
+  graph.set_batch_size_buckets({2, 4, 8});
+
+  std::vector<std::thread> threads;
+  for (int batch_size = 1; batch_size <= 8; batch_size++) {
+    threads.emplace_back([&graph, &device, batch_size]() {
+      // distinct inputs per thread and per call, so that an output of another call is caught
+      for (int i = 0; i < 10; i++) { Forward(graph, device, batch_size, batch_size * 100 + i); }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+}
+
 TEST(Api, graph_thread_test) {
   EnvScope scope;
 
@@ -160,7 +190,7 @@ TEST(Api, graph_thread_test) {
 
   std::vector<std::thread> threads;
   for (Graph& graph : graphs) {
-    threads.emplace_back(std::thread(std::bind(Forward, std::move(graph), device, 1)));
+    threads.emplace_back(std::thread(std::bind(Forward, std::move(graph), device, 1, 1)));
   }
   for (auto& thread : threads) { thread.join(); }
 }
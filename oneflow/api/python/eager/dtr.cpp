@@ -0,0 +1,39 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/eager/dtr_util.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace py = pybind11;
+
+ONEFLOW_API_PYBIND11_MODULE("", m) {
+  m.def("GetDtrStats", []() {
+    const DtrStats stats = DtrTensorStoragePool::Get()->GetStats();
+    py::dict ret;
+    ret["eviction_count"] = stats.eviction_count;
+    ret["evicted_bytes"] = stats.evicted_bytes;
+    ret["recompute_count"] = stats.recompute_count;
+    ret["materialized_bytes"] = stats.materialized_bytes;
+    ret["budget_bytes"] = stats.budget_bytes;
+    return ret;
+  });
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -22,6 +22,18 @@ namespace py = pybind11;
 
 namespace oneflow {
 
+ONEFLOW_API_PYBIND11_MODULE("", m) {
+  py::class_<CapturedInstructions, std::shared_ptr<CapturedInstructions>>(m, "CapturedInstructions")
+      .def(py::init<>())
+      .def("__len__", &CapturedInstructions::size)
+      .def("replay", [](const CapturedInstructions& captured) { captured.Replay().GetOrThrow(); });
+  m.def("BeginCapturingInstructions",
+        [](const std::shared_ptr<CapturedInstructions>& captured) {
+          BeginCapturingInstructions(captured).GetOrThrow();
+        });
+  m.def("EndCapturingInstructions", []() { EndCapturingInstructions().GetOrThrow(); });
+}
+
 namespace debug {
 
 ONEFLOW_API_PYBIND11_MODULE("debug", m) {
@@ -30,6 +30,13 @@ ONEFLOW_API_PYBIND11_MODULE("profiler", m) {
   m.def("ProfilerStart", []() { profiler::ProfilerStart(); });
 
   m.def("ProfilerStop", []() { profiler::ProfilerStop(); });
+
+  m.def("HostTracerStart", []() { profiler::HostTracerStart(); });
+
+  m.def("HostTracerStop", []() { profiler::HostTracerStop(); });
+
+  m.def("HostTracerDumpChromeTrace",
+        [](const std::string& path) { profiler::HostTracerDumpChromeTrace(path).GetOrThrow(); });
 }
 
 }  // namespace oneflow
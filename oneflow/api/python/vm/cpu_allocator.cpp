@@ -0,0 +1,46 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <pybind11/pybind11.h>
+#include "oneflow/api/python/of_api_registry.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace py = pybind11;
+
+ONEFLOW_API_PYBIND11_MODULE("vm", m) {
+  m.def("GetCpuAllocatorStats", []() {
+    const CpuAllocatorStats stats = Global<CpuAllocator>::Get()->GetStats();
+    py::dict ret;
+    ret["allocate_count"] = stats.allocate_count;
+    ret["hit_count"] = stats.hit_count;
+    ret["miss_count"] = stats.miss_count;
+    ret["released_block_count"] = stats.released_block_count;
+    ret["reserved_bytes"] = stats.reserved_bytes;
+    ret["peak_reserved_bytes"] = stats.peak_reserved_bytes;
+    ret["allocated_bytes"] = stats.allocated_bytes;
+    ret["cached_free_bytes"] = stats.cached_free_bytes();
+    ret["largest_free_piece_bytes"] = stats.largest_free_piece_bytes;
+    ret["fragmentation"] = stats.fragmentation();
+    return ret;
+  });
+  m.def("CpuAllocatorReleaseCachedMemory",
+        []() { Global<CpuAllocator>::Get()->ReleaseCachedMemory(); });
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/profiler/host_tracer.h"
 
 namespace oneflow {
 
@@ -39,6 +40,7 @@ void CommNet::Read(void* actor_read_id, int64_t src_machine_id, void* src_token,
   ReadContext* read_ctx = new ReadContext;
   read_ctx->actor_read_ctx = actor_read_ctx;
   auto do_read = [this, read_ctx, src_machine_id, src_token, dst_token]() {
+    OF_HOST_TRACER_RANGE_GUARD("CommNet::Read");
     DoRead(read_ctx, src_machine_id, src_token, dst_token);
   };
   AddWorkToStream(actor_read_id, do_read, true);
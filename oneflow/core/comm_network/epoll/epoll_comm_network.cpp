@@ -22,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/profiler/host_tracer.h"
 #include <netinet/tcp.h>
 
 namespace oneflow {
@@ -93,6 +94,7 @@ EpollCommNet::~EpollCommNet() {
 }
 
 void EpollCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& actor_msg) {
+  OF_HOST_TRACER_RANGE_GUARD("CommNet::SendActorMsg");
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kActor;
   msg.actor_msg = actor_msg;
@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/platform/include/ibv.h"
 #include "oneflow/core/lazy/actor/actor_message_bus.h"
+#include "oneflow/core/profiler/host_tracer.h"
 
 #if defined(WITH_RDMA) && defined(OF_PLATFORM_POSIX)
 
@@ -77,6 +78,7 @@ IBVerbsCommNet::~IBVerbsCommNet() {
 }
 
 void IBVerbsCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& msg) {
+  OF_HOST_TRACER_RANGE_GUARD("CommNet::SendActorMsg");
   ActorMsg new_msg = msg;
   if (msg.IsDataRegstMsgToConsumer()) {
     CHECK_EQ(msg.user_data_size(), 0);
@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_LRU_CACHE_H_
+#define ONEFLOW_CORE_COMMON_LRU_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+#include <glog/logging.h>
+
+namespace oneflow {
+
+// A fixed capacity map which evicts the least recently used entry on insertion when full. It is
+// not thread safe, the users guard it or keep it thread local.
+template<typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache final {
+ public:
+  explicit LruCache(size_t capacity) : capacity_(capacity) { CHECK_GT(capacity_, 0); }
+  ~LruCache() = default;
+
+  size_t size() const { return entries_.size(); }
+  size_t capacity() const { return capacity_; }
+
+  // Return nullptr if `key` is not cached, otherwise mark it as the most recently used
+  Value* Find(const Key& key) {
+    auto it = key2entry_.find(key);
+    if (it == key2entry_.end()) { return nullptr; }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->second;
+  }
+
+  // Insert or overwrite `key` as the most recently used entry
+  Value* Put(const Key& key, Value value) {
+    auto it = key2entry_.find(key);
+    if (it != key2entry_.end()) {
+      it->second->second = std::move(value);
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return &it->second->second;
+    }
+    if (entries_.size() == capacity_) {
+      key2entry_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::move(value));
+    key2entry_.emplace(key, entries_.begin());
+    return &entries_.front().second;
+  }
+
+  template<typename CreateFn>
+  Value* FindOrPut(const Key& key, const CreateFn& Create) {
+    Value* value = Find(key);
+    if (value != nullptr) { return value; }
+    return Put(key, Create());
+  }
+
+  void Clear() {
+    key2entry_.clear();
+    entries_.clear();
+  }
+
+ private:
+  using Entry = std::pair<Key, Value>;
+
+  const size_t capacity_;
+  // from the most to the least recently used
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> key2entry_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_LRU_CACHE_H_
@@ -0,0 +1,65 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <string>
+#include "oneflow/core/common/lru_cache.h"
+
+namespace oneflow {
+
+namespace test {
+
+TEST(LruCache, evict_least_recently_used) {
+  LruCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  ASSERT_EQ(*cache.Find("a"), 1);
+  // "b" is the least recently used one now
+  cache.Put("c", 3);
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(cache.Find("b"), nullptr);
+  ASSERT_EQ(*cache.Find("a"), 1);
+  ASSERT_EQ(*cache.Find("c"), 3);
+  cache.Put("d", 4);
+  ASSERT_EQ(cache.Find("a"), nullptr);
+  cache.Clear();
+  ASSERT_EQ(cache.size(), 0);
+  ASSERT_EQ(cache.Find("c"), nullptr);
+}
+
+TEST(LruCache, put_existing_key) {
+  LruCache<int, std::string> cache(2);
+  cache.Put(0, "x");
+  cache.Put(1, "y");
+  *cache.Put(0, "z") += "!";
+  cache.Put(2, "w");
+  ASSERT_EQ(cache.Find(1), nullptr);
+  ASSERT_EQ(*cache.Find(0), "z!");
+}
+
+TEST(LruCache, find_or_put) {
+  LruCache<int, int> cache(4);
+  int create_cnt = 0;
+  auto Create = [&]() { return ++create_cnt; };
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(*cache.FindOrPut(7, Create), 1);
+    ASSERT_EQ(*cache.FindOrPut(8, Create), 2);
+  }
+  ASSERT_EQ(create_cnt, 2);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,237 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MPSC_RING_CHANNEL_H_
+#define ONEFLOW_CORE_COMMON_MPSC_RING_CHANNEL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+// MpscRingChannel has the same interface as Channel but allows only one receiver thread.
+//
+// Send() claims a slot of a bounded ring with one CAS and never takes a lock unless the ring is
+// full, in which case the item goes to a mutex-protected overflow queue. While the overflow queue
+// is not empty all the senders use it, and the receiver only takes from the overflow queue after
+// every claimed ring slot is received, so items of one sender are always received in order.
+//
+// The receiver spins for a while when the channel is empty and then parks on a condition
+// variable. Senders only touch the mutex when the receiver is parked.
+template<typename T>
+class MpscRingChannel final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MpscRingChannel);
+  explicit MpscRingChannel(size_t capacity);
+  ~MpscRingChannel() = default;
+
+  template<typename U>
+  ChannelStatus Send(U&& item);
+  ChannelStatus Receive(T* item);
+  // Move all the received items into `items`, block only if there is nothing to receive
+  ChannelStatus ReceiveMany(std::queue<T>* items);
+  void Close();
+
+ private:
+  static constexpr int kSpinCountBeforePark = 1024;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  bool TryPushRing(T* item);
+  bool TryPopRing(T* item);
+  bool RingEmpty() const;
+  // all the claimed ring slots have been received
+  bool RingDrained() const;
+  bool ChannelEmpty() const;
+  void WaitUntilNotEmptyOrClosed();
+  void NotifyReceiverIfParked();
+
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  std::atomic<size_t> enqueue_pos_;
+  // only touched by the receiver
+  size_t dequeue_pos_;
+
+  std::mutex overflow_mutex_;
+  std::queue<T> overflow_queue_;
+  std::atomic<size_t> overflow_size_;
+
+  std::mutex park_mutex_;
+  std::condition_variable park_cond_;
+  std::atomic<bool> is_receiver_parked_;
+  std::atomic<bool> is_closed_;
+};
+
+template<typename T>
+MpscRingChannel<T>::MpscRingChannel(size_t capacity)
+    : mask_(capacity - 1),
+      cells_(new Cell[capacity]),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      overflow_size_(0),
+      is_receiver_parked_(false),
+      is_closed_(false) {
+  CHECK_GT(capacity, 0);
+  CHECK_EQ(capacity & mask_, 0) << "capacity must be power of 2";
+  FOR_RANGE(size_t, i, 0, capacity) { cells_[i].sequence.store(i, std::memory_order_relaxed); }
+}
+
+template<typename T>
+bool MpscRingChannel<T>::TryPushRing(T* item) {
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Cell* cell = nullptr;
+  while (true) {
+    cell = &cells_[pos & mask_];
+    const size_t seq = cell->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->data = std::move(*item);
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+template<typename T>
+bool MpscRingChannel<T>::TryPopRing(T* item) {
+  Cell* cell = &cells_[dequeue_pos_ & mask_];
+  if (cell->sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) { return false; }
+  *item = std::move(cell->data);
+  cell->sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+template<typename T>
+bool MpscRingChannel<T>::RingEmpty() const {
+  return cells_[dequeue_pos_ & mask_].sequence.load(std::memory_order_acquire)
+         != dequeue_pos_ + 1;
+}
+
+template<typename T>
+bool MpscRingChannel<T>::RingDrained() const {
+  return enqueue_pos_.load(std::memory_order_acquire) == dequeue_pos_;
+}
+
+template<typename T>
+bool MpscRingChannel<T>::ChannelEmpty() const {
+  return RingEmpty() && overflow_size_.load(std::memory_order_acquire) == 0;
+}
+
+template<typename T>
+void MpscRingChannel<T>::NotifyReceiverIfParked() {
+  // pairs with the fence in WaitUntilNotEmptyOrClosed
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (is_receiver_parked_.load(std::memory_order_relaxed)) {
+    { std::unique_lock<std::mutex> lock(park_mutex_); }
+    park_cond_.notify_one();
+  }
+}
+
+template<typename T>
+template<typename U>
+ChannelStatus MpscRingChannel<T>::Send(U&& item) {
+  if (is_closed_.load(std::memory_order_acquire)) { return kChannelStatusErrorClosed; }
+  T value(std::forward<U>(item));
+  if (overflow_size_.load(std::memory_order_acquire) > 0 || !TryPushRing(&value)) {
+    std::unique_lock<std::mutex> lock(overflow_mutex_);
+    overflow_queue_.push(std::move(value));
+    overflow_size_.fetch_add(1, std::memory_order_release);
+  }
+  NotifyReceiverIfParked();
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+void MpscRingChannel<T>::WaitUntilNotEmptyOrClosed() {
+  FOR_RANGE(int, i, 0, kSpinCountBeforePark) {
+    if (!ChannelEmpty() || is_closed_.load(std::memory_order_acquire)) { return; }
+    if (i % 16 == 15) { std::this_thread::yield(); }
+  }
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  is_receiver_parked_.store(true, std::memory_order_relaxed);
+  // pairs with the fence in NotifyReceiverIfParked
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  park_cond_.wait(lock, [this]() {
+    return !ChannelEmpty() || is_closed_.load(std::memory_order_acquire);
+  });
+  is_receiver_parked_.store(false, std::memory_order_relaxed);
+}
+
+template<typename T>
+ChannelStatus MpscRingChannel<T>::Receive(T* item) {
+  while (true) {
+    WaitUntilNotEmptyOrClosed();
+    if (TryPopRing(item)) { return kChannelStatusSuccess; }
+    if (RingDrained()) {
+      std::unique_lock<std::mutex> lock(overflow_mutex_);
+      if (!overflow_queue_.empty()) {
+        *item = std::move(overflow_queue_.front());
+        overflow_queue_.pop();
+        overflow_size_.fetch_sub(1, std::memory_order_release);
+        return kChannelStatusSuccess;
+      }
+    }
+    if (is_closed_.load(std::memory_order_acquire) && ChannelEmpty()) {
+      return kChannelStatusErrorClosed;
+    }
+  }
+}
+
+template<typename T>
+ChannelStatus MpscRingChannel<T>::ReceiveMany(std::queue<T>* items) {
+  while (true) {
+    WaitUntilNotEmptyOrClosed();
+    // The ring is drained before the overflow queue, see the comment of the class.
+    T item;
+    size_t received_cnt = 0;
+    while (TryPopRing(&item)) {
+      items->push(std::move(item));
+      ++received_cnt;
+    }
+    if (overflow_size_.load(std::memory_order_acquire) > 0 && RingDrained()) {
+      std::unique_lock<std::mutex> lock(overflow_mutex_);
+      while (!overflow_queue_.empty()) {
+        items->push(std::move(overflow_queue_.front()));
+        overflow_queue_.pop();
+        ++received_cnt;
+      }
+      overflow_size_.store(0, std::memory_order_release);
+    }
+    if (received_cnt > 0) { return kChannelStatusSuccess; }
+    if (is_closed_.load(std::memory_order_acquire) && ChannelEmpty()) {
+      return kChannelStatusErrorClosed;
+    }
+  }
+}
+
+template<typename T>
+void MpscRingChannel<T>::Close() {
+  std::unique_lock<std::mutex> lock(park_mutex_);
+  is_closed_.store(true, std::memory_order_release);
+  park_cond_.notify_all();
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MPSC_RING_CHANNEL_H_
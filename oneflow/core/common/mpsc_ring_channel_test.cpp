@@ -0,0 +1,107 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <chrono>
+#include "oneflow/core/common/mpsc_ring_channel.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+namespace {
+
+struct Msg {
+  int64_t sender_id = -1;
+  int64_t seq = -1;
+};
+
+template<typename ChannelT>
+double SendAndReceiveMany(ChannelT* channel, int64_t sender_num, int64_t msg_num_per_sender,
+                          std::vector<int64_t>* received_cnt) {
+  received_cnt->assign(sender_num, 0);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> senders;
+  FOR_RANGE(int64_t, sender_id, 0, sender_num) {
+    senders.emplace_back([channel, sender_id, msg_num_per_sender]() {
+      FOR_RANGE(int64_t, seq, 0, msg_num_per_sender) {
+        Msg msg;
+        msg.sender_id = sender_id;
+        msg.seq = seq;
+        CHECK_EQ(channel->Send(msg), kChannelStatusSuccess);
+      }
+    });
+  }
+  int64_t total_cnt = 0;
+  std::queue<Msg> msgs;
+  while (total_cnt < sender_num * msg_num_per_sender) {
+    CHECK_EQ(channel->ReceiveMany(&msgs), kChannelStatusSuccess);
+    while (!msgs.empty()) {
+      const Msg& msg = msgs.front();
+      // items of one sender are received in order
+      CHECK_EQ(msg.seq, received_cnt->at(msg.sender_id));
+      received_cnt->at(msg.sender_id) += 1;
+      msgs.pop();
+      ++total_cnt;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  for (std::thread& sender : senders) { sender.join(); }
+  return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+TEST(MpscRingChannel, in_order_per_sender) {
+  // small capacity to run into the overflow queue
+  MpscRingChannel<Msg> channel(8);
+  std::vector<int64_t> received_cnt;
+  SendAndReceiveMany(&channel, 8, 10000, &received_cnt);
+  for (int64_t cnt : received_cnt) { ASSERT_EQ(cnt, 10000); }
+  channel.Close();
+  Msg msg;
+  ASSERT_EQ(channel.Receive(&msg), kChannelStatusErrorClosed);
+}
+
+TEST(MpscRingChannel, receive_one_by_one) {
+  MpscRingChannel<int64_t> channel(4);
+  std::thread sender([&channel]() {
+    FOR_RANGE(int64_t, i, 0, 1000) { channel.Send(i); }
+    channel.Close();
+  });
+  int64_t expected = 0;
+  int64_t value = -1;
+  while (channel.Receive(&value) == kChannelStatusSuccess) { ASSERT_EQ(value, expected++); }
+  ASSERT_EQ(expected, 1000);
+  sender.join();
+}
+
+TEST(MpscRingChannel, benchmark) {
+  const int64_t msg_num_per_sender = 200000;
+  for (int64_t sender_num : {1, 4, 16}) {
+    std::vector<int64_t> received_cnt;
+    Channel<Msg> channel;
+    const double channel_seconds =
+        SendAndReceiveMany(&channel, sender_num, msg_num_per_sender, &received_cnt);
+    MpscRingChannel<Msg> ring_channel(4096);
+    const double ring_channel_seconds =
+        SendAndReceiveMany(&ring_channel, sender_num, msg_num_per_sender, &received_cnt);
+    const double msg_num = sender_num * msg_num_per_sender;
+    LOG(INFO) << "senders: " << sender_num
+              << ", Channel msgs/s: " << static_cast<int64_t>(msg_num / channel_seconds)
+              << ", MpscRingChannel msgs/s: "
+              << static_cast<int64_t>(msg_num / ring_channel_seconds);
+  }
+}
+
+}  // namespace oneflow
@@ -31,7 +31,11 @@ inline void CheckTensorBufferDataType(DataType val) {
 class TensorBuffer {
  public:
   struct Deleter {
-    void operator()(void* ptr) { MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr); }
+    void operator()(void* ptr) {
+      if (!external_holder) { MemoryAllocatorImpl::DeallocateUnPinnedHostMem(ptr); }
+    }
+    // not null if the buffer views external memory which is owned by the holder
+    std::shared_ptr<const void> external_holder;
   };
   typedef std::unique_ptr<void, Deleter> BufferType;
 
@@ -55,10 +59,13 @@ class TensorBuffer {
     }
   }
 
+  // Copy the viewed external memory into a buffer of its own first, so the external memory, e.g.
+  // a read-only mapped file, is never written
   template<typename T = void>
   inline T* mut_data() {
     if (data_ == nullptr) { return nullptr; }
     CheckDataType<T>(data_type_);
+    if (data_.get_deleter().external_holder) { CopyExternalData(); }
     return static_cast<T*>(data_.get());
   }
 
@@ -71,7 +78,7 @@ class TensorBuffer {
 
   void reset() {
     shape_ = Shape();
-    data_.reset();
+    data_ = BufferType(nullptr, Deleter());
     data_type_ = DataType::kInvalidDataType;
     num_bytes_ = 0;
   }
@@ -79,10 +86,26 @@ class TensorBuffer {
   void reserve(size_t new_num_bytes) {
     if (new_num_bytes <= num_bytes_) { return; }
     data_.reset();
-    data_.reset(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes));
+    data_ = BufferType(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes), Deleter());
     num_bytes_ = new_num_bytes;
   }
 
+  // View the memory owned by `holder` without copying, e.g. a record in a memory-mapped file.
+  // The viewed memory is never written, the next mut_data() copies it and the next Resize()
+  // allocates a buffer of its own.
+  void ShareExternalData(const void* ptr, const Shape& shape, DataType data_type,
+                         std::shared_ptr<const void> holder) {
+    CheckTensorBufferDataType(data_type);
+    CHECK(holder);
+    Deleter deleter;
+    deleter.external_holder = std::move(holder);
+    data_ = BufferType(const_cast<void*>(ptr), std::move(deleter));
+    // capacity 0 makes any Resize() reallocate
+    num_bytes_ = 0;
+    shape_ = shape;
+    data_type_ = data_type;
+  }
+
   int64_t elem_cnt() const { return shape_.elem_cnt(); }
 
   size_t nbytes() const { return elem_cnt() * GetSizeOfDataType(data_type_); }
@@ -126,6 +149,15 @@ class TensorBuffer {
   }
 
  private:
+  void CopyExternalData() {
+    const size_t data_num_bytes = nbytes();
+    const size_t new_num_bytes = RoundUp(data_num_bytes, kTensorBufferAlignedSize);
+    BufferType data(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes), Deleter());
+    memcpy(data.get(), data_.get(), data_num_bytes);
+    data_ = std::move(data);
+    num_bytes_ = new_num_bytes;
+  }
+
   // TODO(chengcheng)
   static double growth_factor_;
   static double shrink_threshold_;
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/cpp_attribute.h"
 #include "oneflow/core/intrusive/flat_msg_view.h"
 #include "oneflow/core/job/parallel_desc.h"
 #include "oneflow/core/vm/instruction.h"
@@ -30,6 +31,7 @@ limitations under the License.
 #include "oneflow/core/vm/access_blob_arg_cb_phy_instr_operand.h"
 #include "oneflow/core/register/ofblob.h"
 #include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/eager/dtr_util.h"
 #include "oneflow/core/vm/tensor_view_operand.h"
 
 namespace oneflow {
@@ -126,6 +128,9 @@ void TensorViewInstructionType::Compute(vm::Instruction* instruction) const {
   const auto* ptr = dynamic_cast<const vm::TensorViewOperand*>(phy_instr_operand.get());
   CHECK_NOTNULL(ptr);
   DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
+  if (unlikely(IsDtrEnabled() && ptr->eager_blob_object()->mem_case().has_host_mem())) {
+    CHECK_JUST(DtrTensorStoragePool::Get()->Access(device_ctx, ptr->eager_blob_object().get()));
+  }
   OfBlob input_ofblob(device_ctx->stream(), ptr->eager_blob_object()->mut_blob());
   OfBlob view_ofblob(device_ctx->stream(), ptr->view_eager_blob_object()->mut_blob());
 
@@ -141,6 +146,14 @@ void AccessBlobByCallbackInstructionType::Compute(vm::Instruction* instruction)
       dynamic_cast<const vm::AccessBlobArgCbPhyInstrOperand*>(phy_instr_operand.get());
   CHECK_NOTNULL(ptr);
   DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
+  if (unlikely(IsDtrEnabled() && ptr->eager_blob_object()->mem_case().has_host_mem())) {
+    auto* pool = DtrTensorStoragePool::Get();
+    if (ptr->modifier() == "const") {
+      CHECK_JUST(pool->Access(device_ctx, ptr->eager_blob_object().get()));
+    } else {
+      CHECK_JUST(pool->Mutate(device_ctx, ptr->eager_blob_object().get()));
+    }
+  }
   OfBlob ofblob(device_ctx->stream(), ptr->eager_blob_object()->mut_blob());
   ptr->callback()(reinterpret_cast<uint64_t>(&ofblob));
 }
@@ -0,0 +1,362 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/eager/dtr_util.h"
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/vm/cpu_stream_type.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+DtrComputeRecord::Arg MakeDtrComputeRecordArg(const EagerBlobObject& blob_object) {
+  return DtrComputeRecord::Arg{std::make_shared<MemoryCase>(blob_object.mem_case()),
+                               blob_object.blob_desc().shape(),
+                               blob_object.blob_desc().data_type(), blob_object.storage_offset()};
+}
+
+std::shared_ptr<EagerBlobObject> MakeReplayBlobObject(
+    const DtrComputeRecord::Arg& arg, const std::shared_ptr<TensorStorage>& storage) {
+  auto blob_object = std::make_shared<EagerBlobObject>(
+      arg.mem_case, std::make_shared<Shape>(arg.shape), arg.data_type, storage);
+  blob_object->set_storage_offset(arg.storage_offset);
+  return blob_object;
+}
+
+// Blobs keep the data pointers they were allocated with, which are released by evictions
+void ResetBlobDptr(EagerBlobObject* blob_object) {
+  Blob* blob = blob_object->mut_blob();
+  char* dptr = blob_object->tensor_storage()->blob_dptr();
+  if (blob == nullptr || dptr == nullptr) { return; }
+  int64_t storage_offset_bytes =
+      blob_object->storage_offset() * GetSizeOfDataType(blob_object->blob_desc().data_type());
+  blob->reset_dptr(dptr + storage_offset_bytes);
+}
+
+}  // namespace
+
+bool IsDtrEnabled() {
+  static const bool enabled = GetDtrBudgetBytes() > 0 && GetCpuComputeStreamNumPerDevice() == 1;
+  return enabled;
+}
+
+size_t GetDtrBudgetBytes() {
+  static const size_t budget_bytes =
+      std::max<int64_t>(ParseIntegerFromEnv("ONEFLOW_DTR_BUDGET_MB", 0), 0) << 20;
+  return budget_bytes;
+}
+
+DtrComputeRecord::DtrComputeRecord(const one::EagerBlobObjectList& inputs,
+                                   const one::EagerBlobObjectList& outputs,
+                                   const ReplayFn& Replay, int64_t compute_cost)
+    : replay_(Replay), compute_cost_(compute_cost) {
+  for (const auto& input : inputs) {
+    input_args_.emplace_back(MakeDtrComputeRecordArg(*input));
+    input_storages_.emplace_back(input->tensor_storage());
+  }
+  for (const auto& output : outputs) {
+    output_args_.emplace_back(MakeDtrComputeRecordArg(*output));
+    output_storages_.emplace_back(output->tensor_storage());
+  }
+}
+
+DtrTensorStoragePool* DtrTensorStoragePool::Get() {
+  // never destructed, tensor storages may be released after static variables
+  static DtrTensorStoragePool* pool = new DtrTensorStoragePool();
+  return pool;
+}
+
+Maybe<void> DtrTensorStoragePool::Access(DeviceCtx* device_ctx, EagerBlobObject* blob_object) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  TensorStorage* storage = blob_object->tensor_storage().get();
+  if (storage->mut_dtr_info() != nullptr) {
+    ++clock_;
+    JUST(RematerializeLocked(device_ctx, storage));
+    TouchLocked(storage);
+  }
+  ResetBlobDptr(blob_object);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DtrTensorStoragePool::Mutate(DeviceCtx* device_ctx, EagerBlobObject* blob_object) {
+  // released after unlocking since they may release tracked storages
+  std::vector<std::shared_ptr<DtrComputeRecord>> dropped_records;
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  TensorStorage* storage = blob_object->tensor_storage().get();
+  if (storage->mut_dtr_info() != nullptr) {
+    ++clock_;
+    JUST(MutateLocked(device_ctx, storage, &dropped_records));
+    TouchLocked(storage);
+  }
+  ResetBlobDptr(blob_object);
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DtrTensorStoragePool::PrepareCompute(DeviceCtx* device_ctx,
+                                                 const one::EagerBlobObjectList& inputs,
+                                                 const std::vector<int64_t>& mut_input_indexes,
+                                                 const one::EagerBlobObjectList& outputs) {
+  std::vector<std::shared_ptr<DtrComputeRecord>> dropped_records;
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  ++clock_;
+  // FinishCompute unpins the storages tracked here
+  const auto& TryTrackAndPin = [&](TensorStorage* storage) {
+    if (storage->mut_dtr_info() == nullptr && storage->blob_dptr() == nullptr) { return; }
+    TrackLocked(storage);
+    PinLocked(storage);
+  };
+  for (const auto& input : inputs) { TryTrackAndPin(input->tensor_storage().get()); }
+  for (const auto& output : outputs) { TryTrackAndPin(output->tensor_storage().get()); }
+  for (const auto& input : inputs) {
+    JUST(RematerializeLocked(device_ctx, input->tensor_storage().get()));
+  }
+  for (int64_t index : mut_input_indexes) {
+    JUST(MutateLocked(device_ctx, inputs.at(index)->tensor_storage().get(), &dropped_records));
+  }
+  size_t required_bytes = 0;
+  for (const auto& output : outputs) {
+    TensorStorage* storage = output->tensor_storage().get();
+    if (storage->mut_dtr_info() != nullptr) {
+      // written in place
+      JUST(MutateLocked(device_ctx, storage, &dropped_records));
+    } else {
+      JUST(output->TryInitBlob());
+      required_bytes += output->blob().AlignedByteSizeOfBlobBody();
+    }
+  }
+  EvictUntilFitLocked(required_bytes);
+  for (const auto& input : inputs) {
+    TouchLocked(input->tensor_storage().get());
+    ResetBlobDptr(input.get());
+  }
+  for (const auto& output : outputs) {
+    TouchLocked(output->tensor_storage().get());
+    ResetBlobDptr(output.get());
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DtrTensorStoragePool::FinishCompute(const one::EagerBlobObjectList& inputs,
+                                                const one::EagerBlobObjectList& outputs,
+                                                const std::shared_ptr<DtrComputeRecord>& record) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  for (const auto& input : inputs) { UnpinLocked(input->tensor_storage().get()); }
+  for (const auto& output : outputs) { UnpinLocked(output->tensor_storage().get()); }
+  for (const auto& output : outputs) {
+    const auto& storage = output->tensor_storage();
+    // skip the outputs written in place and the empty ones
+    if (storage->mut_dtr_info() != nullptr || storage->blob_dptr() == nullptr) { continue; }
+    DtrStorageInfo* info = TrackLocked(storage.get());
+    if (!record) { continue; }
+    info->compute_record = record;
+    candidates_.insert(storage.get());
+    for (const auto& input_storage : record->input_storages()) {
+      AddDependentLocked(input_storage.get(), storage);
+    }
+  }
+  return Maybe<void>::Ok();
+}
+
+bool DtrTensorStoragePool::IsTracked(EagerBlobObject* blob_object) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  return blob_object->tensor_storage()->mut_dtr_info() != nullptr;
+}
+
+void DtrTensorStoragePool::Remove(TensorStorage* storage) {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (!info->is_evicted && storage->blob_dptr() != nullptr) {
+    materialized_bytes_ -= storage->blob_bytes();
+  }
+  candidates_.erase(storage);
+}
+
+size_t DtrTensorStoragePool::materialized_bytes() {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  return materialized_bytes_;
+}
+
+DtrStats DtrTensorStoragePool::GetStats() {
+  std::unique_lock<std::recursive_mutex> lock(mutex_);
+  DtrStats stats;
+  stats.eviction_count = eviction_count_;
+  stats.evicted_bytes = evicted_bytes_;
+  stats.recompute_count = recompute_count_;
+  stats.materialized_bytes = materialized_bytes_;
+  stats.budget_bytes = budget_bytes_;
+  return stats;
+}
+
+DtrStorageInfo* DtrTensorStoragePool::TrackLocked(TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info != nullptr) { return info; }
+  storage->set_dtr_info(std::make_unique<DtrStorageInfo>());
+  info = storage->mut_dtr_info();
+  info->last_access_time = clock_;
+  if (storage->blob_dptr() != nullptr) { materialized_bytes_ += storage->blob_bytes(); }
+  return info;
+}
+
+void DtrTensorStoragePool::TouchLocked(TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info != nullptr) { info->last_access_time = clock_; }
+}
+
+void DtrTensorStoragePool::PinLocked(TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info != nullptr) { ++info->pin_count; }
+}
+
+void DtrTensorStoragePool::UnpinLocked(TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info != nullptr) { --info->pin_count; }
+}
+
+Maybe<void> DtrTensorStoragePool::RematerializeLocked(DeviceCtx* device_ctx,
+                                                      TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info == nullptr || !info->is_evicted) { return Maybe<void>::Ok(); }
+  const std::shared_ptr<DtrComputeRecord> record = info->compute_record;
+  CHECK_OR_RETURN(static_cast<bool>(record));
+  const auto& input_storages = record->input_storages();
+  for (const auto& input_storage : input_storages) { PinLocked(input_storage.get()); }
+  auto inputs = std::make_shared<one::EagerBlobObjectList>();
+  for (int64_t i = 0; i < input_storages.size(); ++i) {
+    JUST(RematerializeLocked(device_ctx, input_storages.at(i).get()));
+    TouchLocked(input_storages.at(i).get());
+    inputs->emplace_back(MakeReplayBlobObject(record->input_args().at(i), input_storages.at(i)));
+  }
+  // The evicted outputs of `record` are computed in place, the others are computed into scratch
+  // storages released after the replay since they are materialized or mutated.
+  std::vector<std::shared_ptr<TensorStorage>> rematerialized_storages;
+  auto outputs = std::make_shared<one::EagerBlobObjectList>();
+  size_t required_bytes = 0;
+  for (int64_t i = 0; i < record->output_storages().size(); ++i) {
+    std::shared_ptr<TensorStorage> output_storage = record->output_storages().at(i).lock();
+    DtrStorageInfo* output_info = output_storage ? output_storage->mut_dtr_info() : nullptr;
+    if (output_info != nullptr && output_info->is_evicted
+        && output_info->compute_record == record) {
+      rematerialized_storages.emplace_back(output_storage);
+    } else {
+      output_storage = std::make_shared<TensorStorage>();
+    }
+    outputs->emplace_back(MakeReplayBlobObject(record->output_args().at(i), output_storage));
+    JUST(outputs->back()->TryInitBlob());
+    required_bytes += outputs->back()->blob().AlignedByteSizeOfBlobBody();
+  }
+  EvictUntilFitLocked(required_bytes);
+  JUST(record->Replay(device_ctx, inputs, outputs));
+  recompute_count_ += 1;
+  for (const auto& output_storage : rematerialized_storages) {
+    output_storage->mut_dtr_info()->is_evicted = false;
+    materialized_bytes_ += output_storage->blob_bytes();
+    candidates_.insert(output_storage.get());
+    TouchLocked(output_storage.get());
+  }
+  for (const auto& input_storage : input_storages) { UnpinLocked(input_storage.get()); }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> DtrTensorStoragePool::MutateLocked(
+    DeviceCtx* device_ctx, TensorStorage* storage,
+    std::vector<std::shared_ptr<DtrComputeRecord>>* dropped_records) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info == nullptr) { return Maybe<void>::Ok(); }
+  PinLocked(storage);
+  JUST(RematerializeLocked(device_ctx, storage));
+  // the dependents could not be computed again from the mutated storage
+  for (const auto& weak_dependent : info->dependents) {
+    const auto& dependent = weak_dependent.lock();
+    if (!dependent) { continue; }
+    JUST(RematerializeLocked(device_ctx, dependent.get()));
+    ForgetComputeRecordLocked(dependent.get(), dropped_records);
+  }
+  info->dependents.clear();
+  ForgetComputeRecordLocked(storage, dropped_records);
+  UnpinLocked(storage);
+  return Maybe<void>::Ok();
+}
+
+void DtrTensorStoragePool::ForgetComputeRecordLocked(
+    TensorStorage* storage, std::vector<std::shared_ptr<DtrComputeRecord>>* dropped_records) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info == nullptr || !info->compute_record) { return; }
+  dropped_records->emplace_back(std::move(info->compute_record));
+  info->compute_record.reset();
+  candidates_.erase(storage);
+}
+
+void DtrTensorStoragePool::AddDependentLocked(TensorStorage* storage,
+                                              const std::shared_ptr<TensorStorage>& dependent) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  if (info == nullptr) { return; }
+  auto* dependents = &info->dependents;
+  // inputs like weights are used by a lot of instructions
+  if (dependents->size() >= info->num_dependents_to_prune) {
+    dependents->erase(std::remove_if(dependents->begin(), dependents->end(),
+                                     [](const std::weak_ptr<TensorStorage>& weak_dependent) {
+                                       return weak_dependent.expired();
+                                     }),
+                      dependents->end());
+    info->num_dependents_to_prune = std::max<size_t>(64, dependents->size() * 2);
+  }
+  dependents->emplace_back(dependent);
+}
+
+void DtrTensorStoragePool::EvictUntilFitLocked(size_t required_bytes) {
+  while (materialized_bytes_ + required_bytes > budget_bytes_) {
+    TensorStorage* victim = nullptr;
+    double min_cost = 0;
+    for (TensorStorage* candidate : candidates_) {
+      if (candidate->mut_dtr_info()->pin_count > 0) { continue; }
+      double cost = EvictionCostLocked(candidate);
+      if (victim == nullptr || cost < min_cost) {
+        victim = candidate;
+        min_cost = cost;
+      }
+    }
+    // the others are in use or can not be computed again, go beyond the budget
+    if (victim == nullptr) { break; }
+    EvictLocked(victim);
+  }
+}
+
+void DtrTensorStoragePool::EvictLocked(TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  materialized_bytes_ -= storage->blob_bytes();
+  eviction_count_ += 1;
+  evicted_bytes_ += storage->blob_bytes();
+  storage->ReleaseBlobDptr();
+  info->is_evicted = true;
+  candidates_.erase(storage);
+}
+
+// compute cost / (size * staleness), the evicted inputs are computed again along with the storage
+double DtrTensorStoragePool::EvictionCostLocked(TensorStorage* storage) {
+  DtrStorageInfo* info = storage->mut_dtr_info();
+  double compute_cost = info->compute_record->compute_cost() + 1;
+  for (const auto& input_storage : info->compute_record->input_storages()) {
+    DtrStorageInfo* input_info = input_storage->mut_dtr_info();
+    if (input_info != nullptr && input_info->is_evicted) {
+      compute_cost += input_info->compute_record->compute_cost();
+    }
+  }
+  double staleness = clock_ - info->last_access_time + 1;
+  return compute_cost / (static_cast<double>(storage->blob_bytes()) * staleness);
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -0,0 +1,179 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EAGER_DTR_UTIL_H_
+#define ONEFLOW_CORE_EAGER_DTR_UTIL_H_
+
+#include <mutex>
+#include <unordered_set>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/eager/local_call_opkernel_phy_instr_operand.h"
+
+namespace oneflow {
+
+class DeviceCtx;
+
+namespace vm {
+
+// Dynamic tensor rematerialization (DTR) keeps the host memory of eager tensors under the budget
+// ONEFLOW_DTR_BUDGET_MB, 0 disables it. Under pressure the storages computed by cpu
+// LocalCallOpKernel instructions are evicted, and computed again by replaying their producers when
+// they are accessed. Replays run synchronously on the thread of the accessing instruction, so DTR
+// requires the single cpu compute stream which runs on the scheduler thread. Only
+// LocalCallOpKernel, TensorView and AccessBlobByCallback instructions materialize the evicted
+// storages.
+bool IsDtrEnabled();
+size_t GetDtrBudgetBytes();
+
+// What is needed to compute the outputs of a LocalCallOpKernel instruction again
+class DtrComputeRecord final {
+ public:
+  using ReplayFn = std::function<Maybe<void>(DeviceCtx* device_ctx,
+                                             const one::EagerBlobObjectListPtr& inputs,
+                                             const one::EagerBlobObjectListPtr& outputs)>;
+
+  struct Arg {
+    std::shared_ptr<MemoryCase> mem_case;
+    Shape shape;
+    DataType data_type;
+    int64_t storage_offset;
+  };
+
+  OF_DISALLOW_COPY_AND_MOVE(DtrComputeRecord);
+  DtrComputeRecord(const one::EagerBlobObjectList& inputs, const one::EagerBlobObjectList& outputs,
+                   const ReplayFn& Replay, int64_t compute_cost);
+  ~DtrComputeRecord() = default;
+
+  const std::vector<Arg>& input_args() const { return input_args_; }
+  // the inputs are kept alive, they may be evicted too
+  const std::vector<std::shared_ptr<TensorStorage>>& input_storages() const {
+    return input_storages_;
+  }
+  const std::vector<Arg>& output_args() const { return output_args_; }
+  // the outputs are not kept alive, otherwise storages would hold themselves through records
+  const std::vector<std::weak_ptr<TensorStorage>>& output_storages() const {
+    return output_storages_;
+  }
+  // nanoseconds the producer took
+  int64_t compute_cost() const { return compute_cost_; }
+
+  Maybe<void> Replay(DeviceCtx* device_ctx, const one::EagerBlobObjectListPtr& inputs,
+                     const one::EagerBlobObjectListPtr& outputs) const {
+    return replay_(device_ctx, inputs, outputs);
+  }
+
+ private:
+  std::vector<Arg> input_args_;
+  std::vector<std::shared_ptr<TensorStorage>> input_storages_;
+  std::vector<Arg> output_args_;
+  std::vector<std::weak_ptr<TensorStorage>> output_storages_;
+  ReplayFn replay_;
+  int64_t compute_cost_;
+};
+
+// The state of a TensorStorage tracked by DtrTensorStoragePool
+struct DtrStorageInfo {
+  // nullptr if the storage can not be computed again, e.g. it is mutated or produced randomly
+  std::shared_ptr<DtrComputeRecord> compute_record;
+  bool is_evicted = false;
+  // storages used by the running instruction are not evicted
+  int32_t pin_count = 0;
+  int64_t last_access_time = 0;
+  // storages computed from this one, they are materialized and fixed before this one is mutated
+  std::vector<std::weak_ptr<TensorStorage>> dependents;
+  // the released dependents are dropped when there are this many
+  size_t num_dependents_to_prune = 64;
+};
+
+struct DtrStats {
+  // storages released under the budget
+  int64_t eviction_count = 0;
+  size_t evicted_bytes = 0;
+  // producers replayed to compute evicted storages again
+  int64_t recompute_count = 0;
+  size_t materialized_bytes = 0;
+  size_t budget_bytes = 0;
+};
+
+class DtrTensorStoragePool final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(DtrTensorStoragePool);
+  ~DtrTensorStoragePool() = default;
+
+  static DtrTensorStoragePool* Get();
+
+  // Materialize the storage of `blob_object` before it is read
+  Maybe<void> Access(DeviceCtx* device_ctx, EagerBlobObject* blob_object);
+  // Materialize the storage of `blob_object` and the storages computed from it before it is written
+  Maybe<void> Mutate(DeviceCtx* device_ctx, EagerBlobObject* blob_object);
+
+  // Materialize and pin the arguments of a cpu LocalCallOpKernel instruction, and evict other
+  // storages to make room for its new outputs
+  Maybe<void> PrepareCompute(DeviceCtx* device_ctx, const one::EagerBlobObjectList& inputs,
+                             const std::vector<int64_t>& mut_input_indexes,
+                             const one::EagerBlobObjectList& outputs);
+  // Unpin the arguments and track the new outputs, which are evictable if `record` is not nullptr
+  Maybe<void> FinishCompute(const one::EagerBlobObjectList& inputs,
+                            const one::EagerBlobObjectList& outputs,
+                            const std::shared_ptr<DtrComputeRecord>& record);
+
+  bool IsTracked(EagerBlobObject* blob_object);
+  // Called by the destructor of tracked storages
+  void Remove(TensorStorage* storage);
+
+  size_t materialized_bytes();
+  DtrStats GetStats();
+
+ private:
+  DtrTensorStoragePool()
+      : budget_bytes_(GetDtrBudgetBytes()),
+        materialized_bytes_(0),
+        clock_(0),
+        eviction_count_(0),
+        evicted_bytes_(0),
+        recompute_count_(0) {}
+
+  DtrStorageInfo* TrackLocked(TensorStorage* storage);
+  void TouchLocked(TensorStorage* storage);
+  void PinLocked(TensorStorage* storage);
+  void UnpinLocked(TensorStorage* storage);
+  Maybe<void> RematerializeLocked(DeviceCtx* device_ctx, TensorStorage* storage);
+  Maybe<void> MutateLocked(DeviceCtx* device_ctx, TensorStorage* storage,
+                           std::vector<std::shared_ptr<DtrComputeRecord>>* dropped_records);
+  void ForgetComputeRecordLocked(TensorStorage* storage,
+                                 std::vector<std::shared_ptr<DtrComputeRecord>>* dropped_records);
+  void AddDependentLocked(TensorStorage* storage, const std::shared_ptr<TensorStorage>& dependent);
+  void EvictUntilFitLocked(size_t required_bytes);
+  void EvictLocked(TensorStorage* storage);
+  double EvictionCostLocked(TensorStorage* storage);
+
+  const size_t budget_bytes_;
+  std::recursive_mutex mutex_;
+  size_t materialized_bytes_;
+  // logical time, increased by every access
+  int64_t clock_;
+  int64_t eviction_count_;
+  size_t evicted_bytes_;
+  int64_t recompute_count_;
+  // materialized storages which can be computed again
+  std::unordered_set<TensorStorage*> candidates_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EAGER_DTR_UTIL_H_
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/eager/eager_blob_object.h"
+#include "oneflow/core/eager/dtr_util.h"
 #include "oneflow/core/vm/allocator.h"
 #include "oneflow/core/framework/to_string.h"
 #include "oneflow/core/framework/shut_down_util.h"
@@ -22,6 +23,19 @@ limitations under the License.
 namespace oneflow {
 namespace vm {
 
+TensorStorage::TensorStorage()
+    : non_pod_allocator_(std::make_unique<MemoryAllocator>()),
+      producer_op_device_(NullOpt),
+      last_used_device_(NullOpt) {}
+
+TensorStorage::~TensorStorage() {
+  if (dtr_info_) { DtrTensorStoragePool::Get()->Remove(this); }
+}
+
+void TensorStorage::set_dtr_info(std::unique_ptr<DtrStorageInfo>&& dtr_info) {
+  dtr_info_ = std::move(dtr_info);
+}
+
 EagerBlobObject::EagerBlobObject(const std::shared_ptr<MemoryCase>& mem_case,
                                  const std::shared_ptr<Shape>& shape, DataType data_type,
                                  const std::shared_ptr<TensorStorage>& tensor_storage,
@@ -28,12 +28,12 @@ namespace oneflow {
 
 namespace vm {
 
+struct DtrStorageInfo;
+
 class TensorStorage {
  public:
-  TensorStorage()
-      : non_pod_allocator_(std::make_unique<MemoryAllocator>()),
-        producer_op_device_(NullOpt),
-        last_used_device_(NullOpt) {}
+  TensorStorage();
+  ~TensorStorage();
 
   size_t blob_bytes() const { return blob_bytes_; }
 
@@ -45,6 +45,12 @@ class TensorStorage {
     blob_dptr_ = std::move(blob_dptr);
     blob_bytes_ = bytes;
   }
+  // evicted by DTR, blob_bytes() is kept for the recomputation
+  void ReleaseBlobDptr() { blob_dptr_.reset(); }
+
+  // nullptr if the storage is not tracked by DtrTensorStoragePool
+  DtrStorageInfo* mut_dtr_info() { return dtr_info_.get(); }
+  void set_dtr_info(std::unique_ptr<DtrStorageInfo>&& dtr_info);
 
   const Optional<Symbol<Device>>& producer_op_device() const { return producer_op_device_; }
   Maybe<void> init_producer_op_device(Symbol<Device> producer_op_device) {
@@ -64,6 +70,7 @@ class TensorStorage {
   std::unique_ptr<MemoryAllocator> non_pod_allocator_;
   Optional<Symbol<Device>> producer_op_device_;
   Optional<Symbol<Device>> last_used_device_;
+  std::unique_ptr<DtrStorageInfo> dtr_info_;
 };
 
 class EagerBlobObject final : public BlobObject {
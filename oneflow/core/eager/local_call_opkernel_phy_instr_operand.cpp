@@ -16,10 +16,23 @@ limitations under the License.
 #include "oneflow/core/eager/local_call_opkernel_phy_instr_operand.h"
 #include "oneflow/user/kernels/stateful_local_opkernel.h"
 #include "oneflow/core/eager/dev_vm_dep_object_consume_mode.h"
+#include "oneflow/core/vm/cpu_stream_type.h"
 
 namespace oneflow {
 namespace vm {
 
+namespace {
+
+// Ops with inputs are ordered by the inputs already, sequentializing them too would keep the
+// parallel cpu compute streams from running independent ops side by side.
+bool IsParallelCpuNonSourceOp(const Device& device, const one::EagerBlobObjectList& inputs,
+                              bool is_consistent) {
+  return device.type() == "cpu" && GetCpuComputeStreamNumPerDevice() > 1 && !inputs.empty()
+         && !is_consistent;
+}
+
+}  // namespace
+
 Maybe<void> LocalCallOpKernelPhyInstrOperand::Init() {
   JUST(mut_opkernel()->ChooseOpKernel(&user_opkernel_, &need_temp_storage_, attrs(), inputs().get(),
                                       outputs().get(), consistent_tensor_infer_result().get()));
@@ -48,7 +61,8 @@ void LocalCallOpKernelPhyInstrOperand::ForEachMutMirroredObject(
     DoEach(device_schedule_dep_object->mut_mirrored_object());
   } else {
     // Sequantialize instructions to avoid explosive memory allocation of source ops
-    if (dev_vm_dep_object_consume_mode() == one::DevVmDepObjectConsumeMode::MUTABLE) {
+    if (dev_vm_dep_object_consume_mode() == one::DevVmDepObjectConsumeMode::MUTABLE
+        && !IsParallelCpuNonSourceOp(*device, *inputs(), !IsParallelizableOnStreams())) {
       DoEach(device_schedule_dep_object->mut_mirrored_object());
     }
   }
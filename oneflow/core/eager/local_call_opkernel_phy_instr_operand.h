@@ -56,6 +56,7 @@ class LocalCallOpKernelPhyInstrOperand final : public vm::PhyInstrOperand {
   }
 
   const one::StatefulLocalOpKernel& opkernel() const { return *opkernel_; }
+  const std::shared_ptr<one::StatefulLocalOpKernel>& shared_opkernel() const { return opkernel_; }
   const one::EagerBlobObjectListPtr& inputs() const { return inputs_; }
   const one::EagerBlobObjectListPtr& outputs() const { return outputs_; }
   const AttrMap& attrs() const { return op_interp_ctx_.attrs; }
@@ -89,6 +90,11 @@ class LocalCallOpKernelPhyInstrOperand final : public vm::PhyInstrOperand {
     return consistent_tensor_infer_result_;
   }
 
+  // Consistent ops may communicate, which needs the same instruction order in every process
+  bool IsParallelizableOnStreams() const override {
+    return consistent_tensor_infer_result_ == nullptr;
+  }
+
  private:
   LocalCallOpKernelPhyInstrOperand(
       const std::shared_ptr<one::StatefulLocalOpKernel>& opkernel,
@@ -13,6 +13,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <chrono>
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/common/protobuf.h"
 #include "oneflow/core/job/job_desc.h"
@@ -28,6 +29,7 @@ limitations under the License.
 #include "oneflow/core/eager/opkernel_instruction.h"
 #include "oneflow/core/eager/opkernel_instruction_type.h"
 #include "oneflow/core/eager/local_call_opkernel_phy_instr_operand.h"
+#include "oneflow/core/eager/dtr_util.h"
 #include "oneflow/core/vm/device_helper_stream_type.h"
 #include "oneflow/core/vm/instruction.h"
 #include "oneflow/core/vm/instruction_type.h"
@@ -441,37 +443,154 @@ Maybe<T*> GetSharedOpKernel(vm::Instruction* instruction, DeviceType device_type
   return rw_mutexed_object->Init<T>(op_conf, job_desc_ptr, device_type);
 }
 
+// The arguments of a LocalCallOpKernel instruction replayed by DTR, which provides the accessors of
+// LocalCallOpKernelPhyInstrOperand used by LocalCallOpKernelUtil
+class DtrReplayOperand final {
+ public:
+  DtrReplayOperand(const std::shared_ptr<one::StatefulLocalOpKernel>& opkernel,
+                   const user_op::OpKernel* user_opkernel, bool need_temp_storage,
+                   const one::OpExprInterpContext& op_interp_ctx,
+                   const one::EagerBlobObjectListPtr& inputs,
+                   const one::EagerBlobObjectListPtr& outputs)
+      : opkernel_(opkernel),
+        user_opkernel_(user_opkernel),
+        need_temp_storage_(need_temp_storage),
+        op_interp_ctx_(op_interp_ctx),
+        inputs_(inputs),
+        outputs_(outputs) {}
+  ~DtrReplayOperand() = default;
+
+  const one::StatefulLocalOpKernel& opkernel() const { return *opkernel_; }
+  one::StatefulLocalOpKernel* mut_opkernel() { return opkernel_.get(); }
+  const user_op::OpKernel* user_opkernel() const { return user_opkernel_; }
+  bool need_temp_storage() const { return need_temp_storage_; }
+  const AttrMap& attrs() const { return op_interp_ctx_.attrs; }
+  const one::OpExprInterpContext& op_interp_ctx() const { return op_interp_ctx_; }
+  const one::EagerBlobObjectListPtr& inputs() const { return inputs_; }
+  const one::EagerBlobObjectListPtr& outputs() const { return outputs_; }
+  // only local ops are recorded
+  const std::shared_ptr<const one::ConsistentTensorInferResult>& consistent_tensor_infer_result()
+      const {
+    return consistent_tensor_infer_result_;
+  }
+
+ private:
+  std::shared_ptr<one::StatefulLocalOpKernel> opkernel_;
+  const user_op::OpKernel* user_opkernel_;
+  bool need_temp_storage_;
+  const one::OpExprInterpContext op_interp_ctx_;
+  one::EagerBlobObjectListPtr inputs_;
+  one::EagerBlobObjectListPtr outputs_;
+  std::shared_ptr<const one::ConsistentTensorInferResult> consistent_tensor_infer_result_;
+};
+
 }  // namespace
 
 struct LocalCallOpKernelUtil final {
   static inline Maybe<void> Compute(vm::Instruction* instruction) {
     auto* operand = LocalCallOpKernelUtil::GetLocalCallOpKernelPhyInstrOperand(instruction);
-    operand->mut_opkernel()->composed_attrs_for_scheduler_thread()->ResetPrior(operand->attrs());
     DeviceCtx* device_ctx = instruction->stream().device_ctx().get();
+    if (unlikely(IsDtrEnabled())) { return ComputeWithDtr(operand, device_ctx); }
+    user_op::OpKernelState* state = nullptr;
+    return ComputeOperand(operand, device_ctx, &state);
+  }
+
+  static inline LocalCallOpKernelPhyInstrOperand* GetLocalCallOpKernelPhyInstrOperand(
+      vm::Instruction* instruction) {
+    auto* operand = CHECK_NOTNULL(instruction->instr_msg().phy_instr_operand().get());
+    return CHECK_NOTNULL(dynamic_cast<LocalCallOpKernelPhyInstrOperand*>(operand));
+  }
+
+ private:
+  template<typename OperandT>
+  static inline Maybe<void> ComputeOperand(OperandT* operand, DeviceCtx* device_ctx,
+                                           user_op::OpKernelState** state) {
+    operand->mut_opkernel()->composed_attrs_for_scheduler_thread()->ResetPrior(operand->attrs());
     JUST(AllocateOutputBlobsMemory(operand, device_ctx));
     if (unlikely(operand->need_temp_storage())) {
       InferTempStorageBlobDesc(operand);
       JUST(ResetTempStorageBlob(operand));
       JUST(TryAllocateTempStorageBlobMemory(operand, device_ctx));
     }
-    user_op::OpKernelState* state = nullptr;
     user_op::OpKernelCache* cache = nullptr;
-    TryInitOpKernelStateAndCache(operand, device_ctx, &state, &cache);
-    OpKernelCompute(operand, device_ctx, state, cache);
+    TryInitOpKernelStateAndCache(operand, device_ctx, state, &cache);
+    OpKernelCompute(operand, device_ctx, *state, cache);
     if (unlikely(operand->need_temp_storage())) {
       JUST(DeallocateTempStorageBlobMemory(operand, device_ctx));
     }
     return Maybe<void>::Ok();
   }
 
-  static inline LocalCallOpKernelPhyInstrOperand* GetLocalCallOpKernelPhyInstrOperand(
-      vm::Instruction* instruction) {
-    auto* operand = CHECK_NOTNULL(instruction->instr_msg().phy_instr_operand().get());
-    return CHECK_NOTNULL(dynamic_cast<LocalCallOpKernelPhyInstrOperand*>(operand));
+  static inline Maybe<void> ComputeWithDtr(LocalCallOpKernelPhyInstrOperand* operand,
+                                           DeviceCtx* device_ctx) {
+    auto* pool = DtrTensorStoragePool::Get();
+    if (operand->opkernel().device()->type() != "cpu") {
+      for (const auto* blob_objects : {operand->inputs().get(), operand->outputs().get()}) {
+        for (const auto& blob_object : *blob_objects) {
+          CHECK_OR_RETURN(!pool->IsTracked(blob_object.get()))
+              << "tensors managed by DTR can only be used by cpu ops";
+        }
+      }
+      user_op::OpKernelState* state = nullptr;
+      return ComputeOperand(operand, device_ctx, &state);
+    }
+    bool is_recomputable = IsDtrRecomputable(*operand);
+    JUST(pool->PrepareCompute(device_ctx, *operand->inputs(),
+                              operand->opkernel().input_tuple_indexes4mut_ibns(),
+                              *operand->outputs()));
+    const auto start = std::chrono::steady_clock::now();
+    user_op::OpKernelState* state = nullptr;
+    JUST(ComputeOperand(operand, device_ctx, &state));
+    const int64_t compute_cost = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count();
+    std::shared_ptr<DtrComputeRecord> record;
+    // kernels with states, e.g. random ones, may compute different results when replayed
+    if (is_recomputable && state == nullptr) {
+      record = std::make_shared<DtrComputeRecord>(*operand->inputs(), *operand->outputs(),
+                                                  MakeDtrReplayFn(*operand), compute_cost);
+    }
+    return pool->FinishCompute(*operand->inputs(), *operand->outputs(), record);
   }
 
- private:
-  static inline void InferTempStorageBlobDesc(LocalCallOpKernelPhyInstrOperand* operand) {
+  // Whether the outputs can be computed again from the inputs
+  static inline bool IsDtrRecomputable(const LocalCallOpKernelPhyInstrOperand& operand) {
+    if (operand.consistent_tensor_infer_result()) { return false; }
+    if (!operand.opkernel().input_tuple_indexes4mut_ibns().empty()) { return false; }
+    const auto& IsHostPOD = [](const std::shared_ptr<EagerBlobObject>& blob_object) {
+      return blob_object->mem_case().has_host_mem()
+             && IsPODDataType(blob_object->blob_desc().data_type());
+    };
+    for (const auto& input : *operand.inputs()) {
+      if (!IsHostPOD(input)) { return false; }
+    }
+    for (const auto& output : *operand.outputs()) {
+      if (!IsHostPOD(output)) { return false; }
+      // written in place
+      const auto& storage = output->tensor_storage();
+      if (storage->blob_dptr() != nullptr || storage->mut_dtr_info() != nullptr) { return false; }
+    }
+    return true;
+  }
+
+  static inline DtrComputeRecord::ReplayFn MakeDtrReplayFn(
+      const LocalCallOpKernelPhyInstrOperand& operand) {
+    const auto& opkernel = operand.shared_opkernel();
+    const user_op::OpKernel* user_opkernel = operand.user_opkernel();
+    bool need_temp_storage = operand.need_temp_storage();
+    const one::OpExprInterpContext& op_interp_ctx = operand.op_interp_ctx();
+    return [opkernel, user_opkernel, need_temp_storage, op_interp_ctx](
+               DeviceCtx* device_ctx, const one::EagerBlobObjectListPtr& inputs,
+               const one::EagerBlobObjectListPtr& outputs) -> Maybe<void> {
+      DtrReplayOperand replay_operand(opkernel, user_opkernel, need_temp_storage, op_interp_ctx,
+                                      inputs, outputs);
+      user_op::OpKernelState* state = nullptr;
+      return ComputeOperand(&replay_operand, device_ctx, &state);
+    };
+  }
+
+  template<typename OperandT>
+  static inline void InferTempStorageBlobDesc(OperandT* operand) {
     const auto& InferTmpSizeFn = operand->opkernel().GetInferTmpSizeFn(operand->user_opkernel());
     auto* temp_blob_desc = operand->mut_opkernel()->mut_temp_blob_object()->mut_blob_desc();
     CHECK(temp_blob_desc->data_type() == DataType::kChar);
@@ -485,12 +604,13 @@ struct LocalCallOpKernelUtil final {
     op_infer_ctx->Update(nullptr, nullptr, nullptr);
   }
 
-  static inline Maybe<void> ResetTempStorageBlob(LocalCallOpKernelPhyInstrOperand* operand) {
+  template<typename OperandT>
+  static inline Maybe<void> ResetTempStorageBlob(OperandT* operand) {
     return operand->mut_opkernel()->mut_temp_blob_object()->InitBlob();
   }
 
-  static inline void TryInitOpKernelStateAndCache(LocalCallOpKernelPhyInstrOperand* operand,
-                                                  DeviceCtx* device_ctx,
+  template<typename OperandT>
+  static inline void TryInitOpKernelStateAndCache(OperandT* operand, DeviceCtx* device_ctx,
                                                   user_op::OpKernelState** state,
                                                   user_op::OpKernelCache** cache) {
     if (likely(operand->op_interp_ctx().state)) {
@@ -504,8 +624,8 @@ struct LocalCallOpKernelUtil final {
         operand->consistent_tensor_infer_result().get(), state, cache);
   }
 
-  static inline Maybe<void> AllocateOutputBlobsMemory(LocalCallOpKernelPhyInstrOperand* operand,
-                                                      DeviceCtx* device_ctx) {
+  template<typename OperandT>
+  static inline Maybe<void> AllocateOutputBlobsMemory(OperandT* operand, DeviceCtx* device_ctx) {
     for (const auto& blob_object : *operand->outputs()) {
       CHECK_NOTNULL_OR_RETURN(blob_object);
       JUST(blob_object->TryInitBlob());
@@ -514,13 +634,15 @@ struct LocalCallOpKernelUtil final {
     return Maybe<void>::Ok();
   }
 
-  static inline Maybe<void> TryAllocateTempStorageBlobMemory(
-      LocalCallOpKernelPhyInstrOperand* operand, DeviceCtx* device_ctx) {
+  template<typename OperandT>
+  static inline Maybe<void> TryAllocateTempStorageBlobMemory(OperandT* operand,
+                                                             DeviceCtx* device_ctx) {
     return operand->mut_opkernel()->mut_temp_blob_object()->TryAllocateBlobBodyMemory(device_ctx);
   }
 
-  static inline void OpKernelCompute(LocalCallOpKernelPhyInstrOperand* operand,
-                                     DeviceCtx* device_ctx, user_op::OpKernelState* state,
+  template<typename OperandT>
+  static inline void OpKernelCompute(OperandT* operand, DeviceCtx* device_ctx,
+                                     user_op::OpKernelState* state,
                                      const user_op::OpKernelCache* cache) {
     auto* opkernel = operand->mut_opkernel();
     auto* compute_ctx =
@@ -531,8 +653,9 @@ struct LocalCallOpKernelUtil final {
     opkernel->UpdateComputeContext(nullptr, nullptr, nullptr, nullptr);
   }
 
-  static inline Maybe<void> DeallocateTempStorageBlobMemory(
-      LocalCallOpKernelPhyInstrOperand* operand, DeviceCtx* device_ctx) {
+  template<typename OperandT>
+  static inline Maybe<void> DeallocateTempStorageBlobMemory(OperandT* operand,
+                                                            DeviceCtx* device_ctx) {
     return operand->mut_opkernel()->mut_temp_blob_object()->DeallocateBlobDataPtr();
   }
 };
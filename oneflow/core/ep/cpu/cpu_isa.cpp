@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+#include <cpuid.h>
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+namespace oneflow {
+
+namespace ep {
+
+namespace {
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+// __builtin_cpu_supports does not know F16C in every compiler, so it is read from CPUID leaf 1
+bool DetectF16c() {
+  unsigned int eax = 0;
+  unsigned int ebx = 0;
+  unsigned int ecx = 0;
+  unsigned int edx = 0;
+  return __get_cpuid(1, &eax, &ebx, &ecx, &edx) != 0 && (ecx & bit_F16C) != 0;
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+CpuIsa DetectCpuIsa() {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni")) {
+      return CpuIsa::kAvx512Vnni;
+    }
+    return CpuIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return CpuIsa::kAvx2; }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  return CpuIsa::kScalar;
+}
+
+CpuIsa ParseMaxCpuIsa(const std::string& name) {
+  if (name == "scalar") {
+    return CpuIsa::kScalar;
+  } else if (name == "avx2") {
+    return CpuIsa::kAvx2;
+  } else if (name == "avx512") {
+    return CpuIsa::kAvx512;
+  } else if (name == "avx512_vnni") {
+    return CpuIsa::kAvx512Vnni;
+  } else {
+    LOG(FATAL) << "invalid ONEFLOW_EP_CPU_MAX_ISA " << name;
+  }
+  return CpuIsa::kScalar;
+}
+
+thread_local CpuIsa thread_max_isa = CpuIsa::kAvx512Vnni;
+
+}  // namespace
+
+CpuIsa GetCpuIsa() {
+  static const CpuIsa isa = []() {
+    const CpuIsa max_isa =
+        ParseMaxCpuIsa(GetStringFromEnv("ONEFLOW_EP_CPU_MAX_ISA", "avx512_vnni"));
+    return std::min(GetSupportedCpuIsa(), max_isa);
+  }();
+  return std::min(isa, thread_max_isa);
+}
+
+CpuIsa GetSupportedCpuIsa() {
+  static const CpuIsa isa = DetectCpuIsa();
+  return isa;
+}
+
+bool CpuSupportsF16c() {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  static const bool supported = DetectF16c();
+  return supported;
+#else
+  return false;
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+}
+
+CpuIsaGuard::CpuIsaGuard(CpuIsa max_isa) : prev_max_isa_(thread_max_isa) {
+  thread_max_isa = max_isa;
+}
+
+CpuIsaGuard::~CpuIsaGuard() { thread_max_isa = prev_max_isa_; }
+
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,72 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
+#define ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace ep {
+
+// The instruction sets that the CPU primitives have specialized kernels for, in ascending order
+enum class CpuIsa : int {
+  kScalar = 0,
+  kAvx2 = 1,        // AVX2 with FMA
+  kAvx512 = 2,      // AVX-512F
+  kAvx512Vnni = 3,  // AVX-512F with AVX-512BW and the VNNI int8 dot products
+};
+
+// The best instruction set supported by the running CPU, detected once. It can be lowered by
+// ONEFLOW_EP_CPU_MAX_ISA=scalar|avx2|avx512|avx512_vnni to compare the kernels or to work around
+// a CPU.
+CpuIsa GetCpuIsa();
+
+// The best instruction set supported by the running CPU, regardless of ONEFLOW_EP_CPU_MAX_ISA
+CpuIsa GetSupportedCpuIsa();
+
+// Whether the running CPU converts float16 with F16C. It is checked on its own by the float16
+// conversions, the other kernels of an instruction set do not need it.
+bool CpuSupportsF16c();
+
+// Lowers GetCpuIsa() of the current thread to `max_isa` while it lives, so that the tests can run
+// the kernels of every supported instruction set. The primitives which choose their kernels at
+// construction should be created inside the guard.
+class CpuIsaGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuIsaGuard);
+  explicit CpuIsaGuard(CpuIsa max_isa);
+  ~CpuIsaGuard();
+
+ private:
+  CpuIsa prev_max_isa_;
+};
+
+}  // namespace ep
+
+}  // namespace oneflow
+
+// The kernels of an instruction set are compiled with the function attributes below, so they do
+// not need any global compiler flag and are only called after GetCpuIsa() allows them.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define OF_EP_CPU_WITH_X86_SIMD
+#define OF_EP_CPU_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define OF_EP_CPU_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma,f16c")))
+#define OF_EP_CPU_TARGET_AVX512_VNNI \
+  __attribute__((target("avx512f,avx512bw,avx512vnni,avx2,fma,f16c")))
+#endif
+
+#endif  // ONEFLOW_CORE_EP_CPU_CPU_ISA_H_
@@ -0,0 +1,40 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_CPU_PARALLEL_H_
+#define ONEFLOW_CORE_EP_CPU_CPU_PARALLEL_H_
+
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace ep {
+
+// The number of elements a thread handles at least, smaller problems run on the caller thread
+constexpr int64_t kCpuParallelGrainSize = 32768;
+
+// Split [0, rows) into ranges of about kCpuParallelGrainSize elements for Global<ThreadPool>,
+// where every row has `cols` elements
+template<typename DoRangeT>
+void CpuParallelForRows(int64_t rows, int64_t cols, const DoRangeT& DoRange) {
+  const int64_t grain = std::max<int64_t>(kCpuParallelGrainSize / std::max<int64_t>(cols, 1), 1);
+  ParallelFor(0, rows, grain, DoRange);
+}
+
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_CPU_PARALLEL_H_
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/ep/include/stream.h"
 #ifdef WITH_ONEDNN
 #include <oneapi/dnnl/dnnl.hpp>
+#include "oneflow/core/ep/cpu/onednn_primitive_cache.h"
 #endif
 
 namespace oneflow {
@@ -32,6 +33,7 @@ class CpuStream : public Stream {
 #ifdef WITH_ONEDNN
     onednn_engine_.reset(new dnnl::engine(dnnl::engine::kind::cpu, 0));
     onednn_stream_.reset(new dnnl::stream(*onednn_engine_));
+    onednn_primitive_cache_.reset(new OneDnnPrimitiveCache(GetOneDnnPrimitiveCacheCapacity()));
 #endif
   }
 
@@ -45,10 +47,12 @@ class CpuStream : public Stream {
 #ifdef WITH_ONEDNN
   dnnl::engine* onednn_engine() const { return onednn_engine_.get(); }
   dnnl::stream* onednn_stream() const { return onednn_stream_.get(); }
+  OneDnnPrimitiveCache* onednn_primitive_cache() const { return onednn_primitive_cache_.get(); }
 
  private:
   std::unique_ptr<dnnl::engine> onednn_engine_;
   std::unique_ptr<dnnl::stream> onednn_stream_;
+  std::unique_ptr<OneDnnPrimitiveCache> onednn_primitive_cache_;
 #endif
   Device* device_;
 };
@@ -0,0 +1,209 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_ONEDNN_PRIMITIVE_CACHE_H_
+#define ONEFLOW_CORE_EP_CPU_ONEDNN_PRIMITIVE_CACHE_H_
+
+#ifdef WITH_ONEDNN
+
+#include <oneapi/dnnl/dnnl.hpp>
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/lru_cache.h"
+
+namespace oneflow {
+
+namespace ep {
+
+// The shapes, data types and attributes a oneDNN primitive is created for, serialized into bytes
+class OneDnnPrimitiveKey final {
+ public:
+  explicit OneDnnPrimitiveKey(const std::string& kind) : key_(kind) {
+    key_.reserve(256);
+    key_.push_back('\0');
+  }
+  ~OneDnnPrimitiveKey() = default;
+
+  template<typename T>
+  OneDnnPrimitiveKey& Append(const T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "");
+    key_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    return *this;
+  }
+
+  template<typename T>
+  OneDnnPrimitiveKey& Append(const T* values, size_t n) {
+    Append(n);
+    for (size_t i = 0; i < n; ++i) { Append(values[i]); }
+    return *this;
+  }
+
+  const std::string& str() const { return key_; }
+
+ private:
+  std::string key_;
+};
+
+// Creating a oneDNN primitive descriptor and primitive costs much more than executing small
+// problems, so every CpuStream keeps the recently used ones. The entries are type-erased, the kind
+// in the key tells the type.
+class OneDnnPrimitiveCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OneDnnPrimitiveCache);
+  explicit OneDnnPrimitiveCache(size_t capacity) : cache_(capacity) {}
+  ~OneDnnPrimitiveCache() = default;
+
+  // The returned entry stays alive even if it is evicted by later calls
+  template<typename T, typename CreateFn>
+  std::shared_ptr<T> FindOrCreate(const OneDnnPrimitiveKey& key, const CreateFn& Create) {
+    // a kernel launched in a loop hits the same entry every time, which skips hashing the key
+    if (last_entry_ != nullptr && key.str() == last_key_) {
+      return std::static_pointer_cast<T>(*last_entry_);
+    }
+    std::shared_ptr<void>* entry = cache_.FindOrPut(
+        key.str(), [&]() -> std::shared_ptr<void> { return std::shared_ptr<T>(Create()); });
+    last_key_ = key.str();
+    last_entry_ = entry;
+    return std::static_pointer_cast<T>(*entry);
+  }
+
+  size_t size() const { return cache_.size(); }
+
+ private:
+  LruCache<std::string, std::shared_ptr<void>> cache_;
+  std::string last_key_;
+  // points into cache_, it is the most recently used entry so it is never the one evicted
+  std::shared_ptr<void>* last_entry_ = nullptr;
+};
+
+inline size_t GetOneDnnPrimitiveCacheCapacity() {
+  static const size_t capacity = std::max<int64_t>(
+      ParseIntegerFromEnv("ONEFLOW_EP_CPU_ONEDNN_PRIMITIVE_CACHE_CAPACITY", 1024), 1);
+  return capacity;
+}
+
+// The oneDNN convolution, deconvolution, pooling, batch normalization and matmul primitives and the
+// cached sum are opt-in until they are covered by a WITH_ONEDNN build in CI, otherwise the kernels
+// keep their im2col/gemm, loop and cblas paths and Add creates its sum primitive every call.
+inline bool IsOneDnnPrimitiveEnabled() {
+  static const bool enabled = ParseBooleanFromEnv("ONEFLOW_EP_CPU_ENABLE_ONEDNN_PRIMITIVES", false);
+  return enabled;
+}
+
+// Weights reordered into the blocked layout are reused while the weight pointer stays the same,
+// which is only safe if weights are not updated in place, e.g. inference.
+inline bool IsOneDnnReorderedWeightReuseEnabled() {
+  static const bool enabled =
+      ParseBooleanFromEnv("ONEFLOW_EP_CPU_ONEDNN_REUSE_REORDERED_WEIGHTS", false);
+  return enabled;
+}
+
+// Return dnnl::memory::data_type::undef if oneDNN does not support `data_type`
+inline dnnl::memory::data_type GetOneDnnDataType(DataType data_type) {
+  switch (data_type) {
+    case DataType::kFloat: return dnnl::memory::data_type::f32;
+    case DataType::kFloat16: return dnnl::memory::data_type::f16;
+    case DataType::kBFloat16: return dnnl::memory::data_type::bf16;
+    case DataType::kInt32: return dnnl::memory::data_type::s32;
+    case DataType::kInt8: return dnnl::memory::data_type::s8;
+    case DataType::kUInt8: return dnnl::memory::data_type::u8;
+    default: return dnnl::memory::data_type::undef;
+  }
+}
+
+// The plain row-major strides of `dims`
+inline dnnl::memory::dims GetContiguousStrides(const dnnl::memory::dims& dims) {
+  dnnl::memory::dims strides(dims.size(), 1);
+  for (int64_t i = static_cast<int64_t>(dims.size()) - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * dims[i + 1];
+  }
+  return strides;
+}
+
+// oneDNN describes activations and weights in the logical order (D0, D1, spatial...), this gives
+// the logical dims and strides of a plain tensor whose `dims` are (D0, D1, spatial...) or
+// (D0, spatial..., D1) if channels_last
+inline void GetOneDnnLogicalDimsAndStrides(size_t num_dims, const int64_t* dims,
+                                           bool channels_last, dnnl::memory::dims* logical_dims,
+                                           dnnl::memory::dims* strides) {
+  CHECK_GE(num_dims, 2);
+  const dnnl::memory::dims memory_dims(dims, dims + num_dims);
+  const dnnl::memory::dims memory_strides = GetContiguousStrides(memory_dims);
+  if (!channels_last) {
+    *logical_dims = memory_dims;
+    *strides = memory_strides;
+    return;
+  }
+  logical_dims->resize(num_dims);
+  strides->resize(num_dims);
+  (*logical_dims)[0] = memory_dims[0];
+  (*strides)[0] = memory_strides[0];
+  (*logical_dims)[1] = memory_dims[num_dims - 1];
+  (*strides)[1] = memory_strides[num_dims - 1];
+  for (size_t i = 2; i < num_dims; ++i) {
+    (*logical_dims)[i] = memory_dims[i - 1];
+    (*strides)[i] = memory_strides[i - 1];
+  }
+}
+
+inline dnnl::memory::desc MakeOneDnnPlainDesc(size_t num_dims, const int64_t* dims,
+                                              bool channels_last,
+                                              dnnl::memory::data_type data_type) {
+  dnnl::memory::dims logical_dims;
+  dnnl::memory::dims strides;
+  GetOneDnnLogicalDimsAndStrides(num_dims, dims, channels_last, &logical_dims, &strides);
+  return dnnl::memory::desc(logical_dims, data_type, strides);
+}
+
+// A weight in the layout a primitive prefers, which is usually blocked. The reorder and the
+// buffer are created once with the primitive.
+class OneDnnReorderedWeight final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OneDnnReorderedWeight);
+  OneDnnReorderedWeight(const dnnl::engine& engine, const dnnl::memory::desc& user_desc,
+                        const dnnl::memory::desc& desc)
+      : user_desc_(user_desc), desc_(desc), reordered_src_(nullptr) {
+    if (user_desc_ != desc_) {
+      reorder_ = dnnl::reorder(dnnl::reorder::primitive_desc(engine, user_desc_, engine, desc_));
+      reordered_ = dnnl::memory(desc_, engine);
+    }
+  }
+  ~OneDnnReorderedWeight() = default;
+
+  dnnl::memory Get(const dnnl::engine& engine, dnnl::stream* stream, const void* weight) {
+    if (user_desc_ == desc_) { return dnnl::memory(desc_, engine, const_cast<void*>(weight)); }
+    if (reordered_src_ != weight || !IsOneDnnReorderedWeightReuseEnabled()) {
+      dnnl::memory user_weight(user_desc_, engine, const_cast<void*>(weight));
+      reorder_.execute(*stream, user_weight, reordered_);
+      reordered_src_ = weight;
+    }
+    return reordered_;
+  }
+
+ private:
+  dnnl::memory::desc user_desc_;
+  dnnl::memory::desc desc_;
+  dnnl::reorder reorder_;
+  dnnl::memory reordered_;
+  const void* reordered_src_;
+};
+
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // WITH_ONEDNN
+
+#endif  // ONEFLOW_CORE_EP_CPU_ONEDNN_PRIMITIVE_CACHE_H_
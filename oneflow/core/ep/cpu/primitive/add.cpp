@@ -88,6 +88,10 @@ class AddOneDnnImpl : public Add {
     for (int i = 1; i < arity; i++) {
       if (srcs[i] == dst) { LOG(FATAL) << "Only the first parameter can be operated inplace"; }
     }
+    if (IsOneDnnPrimitiveEnabled()) {
+      LaunchCachedSum(stream->As<CpuStream>(), srcs, arity, dst, count);
+      return;
+    }
     dnnl::engine* onednn_engine = stream->As<CpuStream>()->onednn_engine();
     dnnl::stream* onednn_stream = stream->As<CpuStream>()->onednn_stream();
 
@@ -116,6 +120,40 @@ class AddOneDnnImpl : public Add {
   }
 
  private:
+  void LaunchCachedSum(CpuStream* cpu_stream, const void* const* srcs, size_t arity, void* dst,
+                       size_t count) {
+    dnnl::engine* onednn_engine = cpu_stream->onednn_engine();
+    dnnl::stream* onednn_stream = cpu_stream->onednn_stream();
+
+    OneDnnPrimitiveKey key("sum");
+    key.Append(type_onednn_).Append(arity).Append(count);
+    auto sum = cpu_stream->onednn_primitive_cache()->FindOrCreate<SumPrimitive>(key, [&]() {
+      dnnl::memory::dims src_dims = {static_cast<dnnl::memory::dim>(count)};
+      std::vector<dnnl::memory::desc> src_md(
+          arity, dnnl::memory::desc(src_dims, type_onednn_, dnnl::memory::format_tag::x));
+      std::vector<float> scales(arity, 1.0);
+      auto* primitive = new SumPrimitive();
+      primitive->pd = dnnl::sum::primitive_desc(scales, src_md, *onednn_engine);
+      primitive->sum = dnnl::sum(primitive->pd);
+      return primitive;
+    });
+
+    std::unordered_map<int, dnnl::memory> sum_args{
+        {DNNL_ARG_DST, dnnl::memory(sum->pd.dst_desc(), *onednn_engine, dst)}};
+    for (int i = 0; i < arity; ++i) {
+      sum_args.insert({DNNL_ARG_MULTIPLE_SRC + i,
+                       dnnl::memory(sum->pd.src_desc(i), *onednn_engine, (void*)(srcs)[i])});
+    }
+
+    sum->sum.execute(*onednn_stream, sum_args);
+    onednn_stream->wait();
+  }
+
+  struct SumPrimitive {
+    dnnl::sum::primitive_desc pd;
+    dnnl::sum sum;
+  };
+
   dnnl::memory::data_type type_onednn_;
 };
 
@@ -0,0 +1,114 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/include/primitive/batch_normalization.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+#ifdef WITH_ONEDNN
+
+struct BatchNormalizationPrimitive {
+  dnnl::batch_normalization_forward::primitive_desc pd;
+  dnnl::batch_normalization_forward batch_norm;
+  dnnl::memory::desc param_desc;
+};
+
+class BatchNormalizationImpl : public BatchNormalization {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BatchNormalizationImpl);
+  BatchNormalizationImpl(DataType data_type, bool channels_last)
+      : data_type_(data_type), channels_last_(channels_last) {}
+  ~BatchNormalizationImpl() override = default;
+
+  void Launch(Stream* stream, size_t num_dims, const int64_t* dims, const void* x,
+              const void* mean, const void* variance, const void* gamma, const void* beta,
+              float epsilon, void* y) override {
+    CpuStream* cpu_stream = stream->As<CpuStream>();
+    OneDnnPrimitiveKey key("batch_normalization");
+    key.Append(data_type_).Append(channels_last_).Append(dims, num_dims).Append(epsilon);
+    auto primitive =
+        cpu_stream->onednn_primitive_cache()->FindOrCreate<BatchNormalizationPrimitive>(
+            key, [&]() {
+              const dnnl::memory::data_type data_type = GetOneDnnDataType(data_type_);
+              const dnnl::memory::desc data_desc =
+                  MakeOneDnnPlainDesc(num_dims, dims, channels_last_, data_type);
+              auto* batch_norm = new BatchNormalizationPrimitive();
+              batch_norm->pd = dnnl::batch_normalization_forward::primitive_desc(
+                  dnnl::batch_normalization_forward::desc(
+                      dnnl::prop_kind::forward_inference, data_desc, epsilon,
+                      dnnl::normalization_flags::use_global_stats
+                          | dnnl::normalization_flags::use_scale
+                          | dnnl::normalization_flags::use_shift),
+                  *cpu_stream->onednn_engine());
+              batch_norm->batch_norm = dnnl::batch_normalization_forward(batch_norm->pd);
+              batch_norm->param_desc = dnnl::memory::desc(
+                  {data_desc.dims().at(1)}, dnnl::memory::data_type::f32,
+                  dnnl::memory::format_tag::x);
+              return batch_norm;
+            });
+    const dnnl::engine& engine = *cpu_stream->onednn_engine();
+    dnnl::stream* onednn_stream = cpu_stream->onednn_stream();
+    auto MakeMemory = [&](const dnnl::memory::desc& desc, const void* ptr) {
+      return dnnl::memory(desc, engine, const_cast<void*>(ptr));
+    };
+    primitive->batch_norm.execute(
+        *onednn_stream, {{DNNL_ARG_SRC, MakeMemory(primitive->pd.src_desc(), x)},
+                         {DNNL_ARG_MEAN, MakeMemory(primitive->pd.mean_desc(), mean)},
+                         {DNNL_ARG_VARIANCE, MakeMemory(primitive->pd.variance_desc(), variance)},
+                         {DNNL_ARG_SCALE, MakeMemory(primitive->param_desc, gamma)},
+                         {DNNL_ARG_SHIFT, MakeMemory(primitive->param_desc, beta)},
+                         {DNNL_ARG_DST, MakeMemory(primitive->pd.dst_desc(), y)}});
+    onednn_stream->wait();
+  }
+
+ private:
+  DataType data_type_;
+  bool channels_last_;
+};
+
+#endif  // WITH_ONEDNN
+
+class BatchNormalizationFactoryImpl : public BatchNormalizationFactory {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BatchNormalizationFactoryImpl);
+  BatchNormalizationFactoryImpl() = default;
+  ~BatchNormalizationFactoryImpl() override = default;
+
+  std::unique_ptr<BatchNormalization> New(DataType data_type, bool channels_last) override {
+#ifdef WITH_ONEDNN
+    if (data_type == DataType::kFloat && IsOneDnnPrimitiveEnabled()) {
+      return std::unique_ptr<BatchNormalization>(
+          new BatchNormalizationImpl(data_type, channels_last));
+    }
+#endif  // WITH_ONEDNN
+    return nullptr;
+  }
+};
+
+REGISTER_PRIMITIVE_FACTORY(DeviceType::kCPU, BatchNormalizationFactory,
+                           BatchNormalizationFactoryImpl);
+
+}  // namespace
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,90 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/batch_normalization.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+#ifdef WITH_ONEDNN
+
+namespace {
+
+// The oneDNN primitives are opt-in, this binary enables them before the first one is created
+const bool kOneDnnPrimitiveEnabled =
+    setenv("ONEFLOW_EP_CPU_ENABLE_ONEDNN_PRIMITIVES", "1", 0) == 0;
+
+void TestBatchNormalization(const std::vector<int64_t>& dims, bool channels_last) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto batch_norm = NewPrimitive<BatchNormalizationFactory>(DeviceType::kCPU, DataType::kFloat,
+                                                            channels_last);
+  ASSERT_TRUE(batch_norm);
+  const int64_t num_channels = channels_last ? dims.back() : dims.at(1);
+  int64_t elem_cnt = 1;
+  for (int64_t dim : dims) { elem_cnt *= dim; }
+  const int64_t inner_size = channels_last ? 1 : elem_cnt / dims.at(0) / num_channels;
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dis(-1, 1);
+  auto Random = [&](size_t n, float min) {
+    std::vector<float> vec(n);
+    for (float& v : vec) { v = std::max(dis(gen), min); }
+    return vec;
+  };
+  const std::vector<float> x = Random(elem_cnt, -1);
+  const std::vector<float> mean = Random(num_channels, -1);
+  const std::vector<float> variance = Random(num_channels, 0.1);
+  const std::vector<float> gamma = Random(num_channels, -1);
+  const std::vector<float> beta = Random(num_channels, -1);
+  const float epsilon = 1e-5;
+  std::vector<float> y(elem_cnt);
+  batch_norm->Launch(&stream, dims.size(), dims.data(), x.data(), mean.data(), variance.data(),
+                     gamma.data(), beta.data(), epsilon, y.data());
+  for (int64_t i = 0; i < elem_cnt; ++i) {
+    const int64_t c = channels_last ? i % num_channels : i / inner_size % num_channels;
+    const double expected =
+        (x[i] - mean[c]) / std::sqrt(static_cast<double>(variance[c]) + epsilon) * gamma[c]
+        + beta[c];
+    ASSERT_NEAR(y[i], expected, 1e-4) << "num_dims: " << dims.size()
+                                      << ", channels_last: " << channels_last << ", index: " << i;
+  }
+}
+
+}  // namespace
+
+TEST(CpuBatchNormalization, batch_normalization) {
+  TestBatchNormalization({4, 7}, false);
+  TestBatchNormalization({2, 5, 9}, false);
+  TestBatchNormalization({2, 9, 5}, true);
+  TestBatchNormalization({2, 6, 5, 7}, false);
+  TestBatchNormalization({2, 5, 7, 6}, true);
+  TestBatchNormalization({2, 3, 4, 5, 6}, false);
+  TestBatchNormalization({2, 4, 5, 6, 3}, true);
+}
+
+#endif  // WITH_ONEDNN
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -17,6 +17,9 @@ limitations under the License.
 #include "oneflow/core/ep/include/primitive/broadcast_matmul.h"
 #include "oneflow/core/ep/common/primitive/broadcast_matmul.h"
 #include "oneflow/core/common/blas.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#include "oneflow/core/ep/cpu/primitive/float_convert.h"
 
 namespace oneflow {
 
@@ -31,6 +34,11 @@ namespace {
 
 constexpr size_t kMaxNumDims = 8;
 
+// OpenBLAS runs products up to about 64^3 on one thread, so the batches of them are split across
+// threads instead, e.g. the per-head matmuls of attention. Larger products are left to the
+// multithreaded BLAS, running them in the batch loop too would oversubscribe the cores
+constexpr int64_t kMaxBatchParallelMatmulMnk = 64 * 64 * 64;
+
 CBLAS_TRANSPOSE GetCblasTranspose(BlasTransposeType transpose_type) {
   if (transpose_type == BlasTransposeType::N) {
     return CblasNoTrans;
@@ -65,6 +73,23 @@ void CblasMatmul(CBLAS_TRANSPOSE trans_a, CBLAS_TRANSPOSE trans_b, int m, int n,
   cblas_gemm<T>(CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
 }
 
+// The matrices of a batch are multiplied in parallel if each of them writes its own c
+bool IsBatchParallelMatmul(int64_t num_batch_dims, const int64_t* broadcast_batch_dims,
+                           const int64_t* c_batch_dims, int64_t m, int64_t n, int64_t k) {
+  int64_t batch_count = 1;
+  for (int64_t i = 0; i < num_batch_dims; ++i) {
+    if (c_batch_dims[i] != broadcast_batch_dims[i]) { return false; }
+    batch_count *= c_batch_dims[i];
+  }
+  return batch_count > 1 && m * n * k <= kMaxBatchParallelMatmulMnk;
+}
+
+struct BatchMatmulPtrs {
+  const void* a;
+  const void* b;
+  void* c;
+};
+
 template<typename T>
 void LaunchCblasBroadcastMatmul(Stream* /*stream*/, DataType data_type,
                                 BlasTransposeType transpose_a, BlasTransposeType transpose_b,
@@ -75,6 +100,24 @@ void LaunchCblasBroadcastMatmul(Stream* /*stream*/, DataType data_type,
   const CBLAS_TRANSPOSE cblas_trans_a = GetCblasTranspose(transpose_a);
   const CBLAS_TRANSPOSE cblas_trans_b = GetCblasTranspose(transpose_b);
   const T alpha_value = alpha.Value<T>();
+  if (IsBatchParallelMatmul(num_batch_dims, broadcast_batch_dims, c_batch_dims, m, n, k)) {
+    std::vector<BatchMatmulPtrs> batches;
+    ForEachMatmul<kMaxNumDims>(
+        data_type, m, n, k, beta, num_batch_dims, broadcast_batch_dims, a_batch_dims, b_batch_dims,
+        c_batch_dims, a, b, c,
+        [&](const void* batch_a, const void* batch_b, void* batch_c, Scalar /*batch_beta*/) {
+          batches.push_back(BatchMatmulPtrs{batch_a, batch_b, batch_c});
+        });
+    const T beta_value = beta.Value<T>();
+    CpuParallelForRows(batches.size(), m * n * k, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        CblasMatmul<T>(cblas_trans_a, cblas_trans_b, m, n, k, alpha_value,
+                       static_cast<const T*>(batches[i].a), static_cast<const T*>(batches[i].b),
+                       beta_value, static_cast<T*>(batches[i].c));
+      }
+    });
+    return;
+  }
   auto func = [&](const void* batch_a, const void* batch_b, void* batch_c, Scalar batch_beta) {
     const T beta_value = batch_beta.Value<T>();
     CblasMatmul<T>(cblas_trans_a, cblas_trans_b, m, n, k, alpha_value,
@@ -85,12 +128,164 @@ void LaunchCblasBroadcastMatmul(Stream* /*stream*/, DataType data_type,
                              a_batch_dims, b_batch_dims, c_batch_dims, a, b, c, func);
 }
 
+int64_t GetBatchedMatrixElemCnt(int64_t num_batch_dims, const int64_t* batch_dims, int64_t rows,
+                                int64_t cols) {
+  int64_t elem_cnt = rows * cols;
+  for (int64_t i = 0; i < num_batch_dims; ++i) { elem_cnt *= batch_dims[i]; }
+  return elem_cnt;
+}
+
+// The conversion buffers are kept for the next matmul of the thread, except the ones larger than
+// this, so that a single large matmul does not hold its memory for the lifetime of the thread
+constexpr size_t kMaxRetainedConversionBufferElemCnt = 1 << 20;
+
+void ReleaseLargeConversionBuffer(std::vector<float>* buffer) {
+  if (buffer->capacity() > kMaxRetainedConversionBufferElemCnt) {
+    std::vector<float>().swap(*buffer);
+  }
+}
+
+// float16 and bfloat16 are converted to float and multiplied by sgemm, so the products are
+// accumulated in float and c is rounded only once
+void LaunchConvertedBroadcastMatmul(Stream* stream, DataType data_type,
+                                    BlasTransposeType transpose_a, BlasTransposeType transpose_b,
+                                    int64_t num_batch_dims, const int64_t* broadcast_batch_dims,
+                                    const int64_t* a_batch_dims, const int64_t* b_batch_dims,
+                                    const int64_t* c_batch_dims, int64_t m, int64_t n, int64_t k,
+                                    Scalar alpha, const void* a, const void* b, Scalar beta,
+                                    void* c) {
+  static thread_local std::vector<float> a_buffer;
+  static thread_local std::vector<float> b_buffer;
+  static thread_local std::vector<float> c_buffer;
+  const int64_t a_elem_cnt = GetBatchedMatrixElemCnt(num_batch_dims, a_batch_dims, m, k);
+  const int64_t b_elem_cnt = GetBatchedMatrixElemCnt(num_batch_dims, b_batch_dims, k, n);
+  const int64_t c_elem_cnt = GetBatchedMatrixElemCnt(num_batch_dims, c_batch_dims, m, n);
+  a_buffer.resize(a_elem_cnt);
+  ConvertToFloat(data_type, a_elem_cnt, a, a_buffer.data());
+  b_buffer.resize(b_elem_cnt);
+  ConvertToFloat(data_type, b_elem_cnt, b, b_buffer.data());
+  c_buffer.resize(c_elem_cnt);
+  if (beta.Value<float>() != 0) { ConvertToFloat(data_type, c_elem_cnt, c, c_buffer.data()); }
+  LaunchCblasBroadcastMatmul<float>(stream, DataType::kFloat, transpose_a, transpose_b,
+                                    num_batch_dims, broadcast_batch_dims, a_batch_dims,
+                                    b_batch_dims, c_batch_dims, m, n, k, alpha, a_buffer.data(),
+                                    b_buffer.data(), beta, c_buffer.data());
+  ConvertFromFloat(data_type, c_elem_cnt, c_buffer.data(), c);
+  ReleaseLargeConversionBuffer(&a_buffer);
+  ReleaseLargeConversionBuffer(&b_buffer);
+  ReleaseLargeConversionBuffer(&c_buffer);
+}
+
+#ifdef WITH_ONEDNN
+
+struct OneDnnMatmulPrimitive {
+  dnnl::matmul::primitive_desc pd;
+  dnnl::matmul matmul;
+};
+
+// The strides of the batched matrices (batch..., rows, cols), which are stored as (cols, rows) if
+// transposed
+dnnl::memory::dims GetOneDnnMatrixStrides(const dnnl::memory::dims& dims, bool transpose) {
+  const size_t num_dims = dims.size();
+  dnnl::memory::dims strides = GetContiguousStrides(dims);
+  if (transpose) {
+    strides[num_dims - 2] = 1;
+    strides[num_dims - 1] = dims[num_dims - 2];
+  }
+  return strides;
+}
+
+// oneDNN matmul broadcasts the batch dims of a and b, but cannot reduce into a broadcast c.
+// bfloat16 runs on AVX512-BF16 or AMX if the CPU has them, oneDNN refuses it without AVX-512.
+bool TryLaunchOneDnnBroadcastMatmul(Stream* stream, DataType data_type,
+                                    BlasTransposeType transpose_a, BlasTransposeType transpose_b,
+                                    int64_t num_batch_dims, const int64_t* broadcast_batch_dims,
+                                    const int64_t* a_batch_dims, const int64_t* b_batch_dims,
+                                    const int64_t* c_batch_dims, int64_t m, int64_t n, int64_t k,
+                                    Scalar alpha, const void* a, const void* b, Scalar beta,
+                                    void* c) {
+  if (!IsOneDnnPrimitiveEnabled()) { return false; }
+  if (data_type != DataType::kFloat && data_type != DataType::kBFloat16) { return false; }
+  if (num_batch_dims + 2 > DNNL_MAX_NDIMS) { return false; }
+  for (int64_t i = 0; i < num_batch_dims; ++i) {
+    if (c_batch_dims[i] != broadcast_batch_dims[i]) { return false; }
+  }
+  const float alpha_value = alpha.Value<float>();
+  const float beta_value = beta.Value<float>();
+  CpuStream* cpu_stream = stream->As<CpuStream>();
+  OneDnnPrimitiveKey key("matmul");
+  key.Append(data_type)
+      .Append(transpose_a)
+      .Append(transpose_b)
+      .Append(a_batch_dims, num_batch_dims)
+      .Append(b_batch_dims, num_batch_dims)
+      .Append(c_batch_dims, num_batch_dims)
+      .Append(m)
+      .Append(n)
+      .Append(k)
+      .Append(alpha_value)
+      .Append(beta_value);
+  auto primitive =
+      cpu_stream->onednn_primitive_cache()->FindOrCreate<OneDnnMatmulPrimitive>(key, [&]() {
+        dnnl::memory::dims a_dims(a_batch_dims, a_batch_dims + num_batch_dims);
+        dnnl::memory::dims b_dims(b_batch_dims, b_batch_dims + num_batch_dims);
+        dnnl::memory::dims c_dims(c_batch_dims, c_batch_dims + num_batch_dims);
+        a_dims.insert(a_dims.end(), {m, k});
+        b_dims.insert(b_dims.end(), {k, n});
+        c_dims.insert(c_dims.end(), {m, n});
+        const dnnl::memory::data_type onednn_data_type = GetOneDnnDataType(data_type);
+        const dnnl::memory::desc a_desc(
+            a_dims, onednn_data_type,
+            GetOneDnnMatrixStrides(a_dims, transpose_a == BlasTransposeType::T));
+        const dnnl::memory::desc b_desc(
+            b_dims, onednn_data_type,
+            GetOneDnnMatrixStrides(b_dims, transpose_b == BlasTransposeType::T));
+        const dnnl::memory::desc c_desc(c_dims, onednn_data_type, GetContiguousStrides(c_dims));
+        dnnl::primitive_attr attr;
+        if (alpha_value != 1) { attr.set_output_scales(0, {alpha_value}); }
+        if (beta_value != 0) {
+          dnnl::post_ops post_ops;
+          post_ops.append_sum(beta_value);
+          attr.set_post_ops(post_ops);
+        }
+        std::unique_ptr<OneDnnMatmulPrimitive> matmul(new OneDnnMatmulPrimitive());
+        try {
+          matmul->pd = dnnl::matmul::primitive_desc(dnnl::matmul::desc(a_desc, b_desc, c_desc),
+                                                    attr, *cpu_stream->onednn_engine());
+        } catch (const dnnl::error&) {
+          // cache the unsupported case as nullptr to fall back without retrying
+          return static_cast<OneDnnMatmulPrimitive*>(nullptr);
+        }
+        matmul->matmul = dnnl::matmul(matmul->pd);
+        return matmul.release();
+      });
+  if (!primitive) { return false; }
+  const dnnl::engine& engine = *cpu_stream->onednn_engine();
+  dnnl::stream* onednn_stream = cpu_stream->onednn_stream();
+  primitive->matmul.execute(
+      *onednn_stream,
+      {{DNNL_ARG_SRC, dnnl::memory(primitive->pd.src_desc(), engine, const_cast<void*>(a))},
+       {DNNL_ARG_WEIGHTS, dnnl::memory(primitive->pd.weights_desc(), engine, const_cast<void*>(b))},
+       {DNNL_ARG_DST, dnnl::memory(primitive->pd.dst_desc(), engine, c)}});
+  onednn_stream->wait();
+  return true;
+}
+
+#endif  // WITH_ONEDNN
+
 void LaunchBroadcastMatmul(Stream* stream, DataType data_type, BlasTransposeType transpose_a,
                            BlasTransposeType transpose_b, int64_t num_batch_dims,
                            const int64_t* broadcast_batch_dims, const int64_t* a_batch_dims,
                            const int64_t* b_batch_dims, const int64_t* c_batch_dims, int64_t m,
                            int64_t n, int64_t k, Scalar alpha, const void* a, const void* b,
                            Scalar beta, void* c) {
+#ifdef WITH_ONEDNN
+  if (TryLaunchOneDnnBroadcastMatmul(stream, data_type, transpose_a, transpose_b, num_batch_dims,
+                                     broadcast_batch_dims, a_batch_dims, b_batch_dims,
+                                     c_batch_dims, m, n, k, alpha, a, b, beta, c)) {
+    return;
+  }
+#endif  // WITH_ONEDNN
   if (data_type == DataType::kFloat) {
     LaunchCblasBroadcastMatmul<float>(stream, data_type, transpose_a, transpose_b, num_batch_dims,
                                       broadcast_batch_dims, a_batch_dims, b_batch_dims,
@@ -99,6 +294,10 @@ void LaunchBroadcastMatmul(Stream* stream, DataType data_type, BlasTransposeType
     LaunchCblasBroadcastMatmul<double>(stream, data_type, transpose_a, transpose_b, num_batch_dims,
                                        broadcast_batch_dims, a_batch_dims, b_batch_dims,
                                        c_batch_dims, m, n, k, alpha, a, b, beta, c);
+  } else if (IsFloatConvertible(data_type)) {
+    LaunchConvertedBroadcastMatmul(stream, data_type, transpose_a, transpose_b, num_batch_dims,
+                                   broadcast_batch_dims, a_batch_dims, b_batch_dims, c_batch_dims,
+                                   m, n, k, alpha, a, b, beta, c);
   } else {
     UNIMPLEMENTED();
   }
@@ -114,7 +313,8 @@ class BroadcastMatmulFactoryImpl : public BroadcastMatmulFactory {
                                        BlasTransposeType transpose_b,
                                        size_t max_num_dims) override {
     if (max_num_dims > kMaxNumDims) { return nullptr; }
-    if (data_type == DataType::kFloat || data_type == DataType::kDouble) {
+    if (data_type == DataType::kFloat || data_type == DataType::kDouble
+        || IsFloatConvertible(data_type)) {
       return std::make_unique<BroadcastMatmulImpl<kMaxNumDims>>(data_type, transpose_a,
                                                                 transpose_b);
     } else {
@@ -0,0 +1,178 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/primitive/float_convert.h"
+#include "oneflow/core/ep/include/primitive/broadcast_matmul.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+// c (batch, m, n) = a (batch, m, k) x b (k, n), b is shared by the batch like a linear weight
+void TestHalfBroadcastMatmul(DataType data_type, int64_t batch, int64_t m, int64_t n,
+                             int64_t k) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto matmul = NewPrimitive<BroadcastMatmulFactory>(DeviceType::kCPU, data_type,
+                                                     BlasTransposeType::N, BlasTransposeType::N, 3);
+  ASSERT_TRUE(matmul);
+  const int64_t a_dims[3] = {batch, m, k};
+  const int64_t b_dims[2] = {k, n};
+  const int64_t c_dims[3] = {batch, m, n};
+  std::vector<float> a(batch * m * k);
+  std::vector<float> b(k * n);
+  FOR_RANGE(size_t, i, 0, a.size()) { a[i] = static_cast<float>(i % 17) / 8 - 1; }
+  FOR_RANGE(size_t, i, 0, b.size()) { b[i] = static_cast<float>(i % 13) / 16 - 0.375f; }
+  // the inputs are exactly representable, so only the rounding of c differs from the reference
+  std::vector<uint16_t> half_a(a.size());
+  std::vector<uint16_t> half_b(b.size());
+  std::vector<uint16_t> half_c(batch * m * n);
+  ConvertFromFloat(data_type, a.size(), a.data(), half_a.data());
+  ConvertFromFloat(data_type, b.size(), b.data(), half_b.data());
+  for (const float beta : {0.0f, 1.0f}) {
+    std::vector<float> expected(half_c.size(), 0);
+    if (beta != 0) { ConvertToFloat(data_type, half_c.size(), half_c.data(), expected.data()); }
+    FOR_RANGE(int64_t, p, 0, batch) {
+      FOR_RANGE(int64_t, i, 0, m) {
+        FOR_RANGE(int64_t, j, 0, n) {
+          float sum = 0;
+          FOR_RANGE(int64_t, l, 0, k) { sum += a[(p * m + i) * k + l] * b[l * n + j]; }
+          expected[(p * m + i) * n + j] += sum;
+        }
+      }
+    }
+    matmul->Launch(&stream, 1.0, 3, a_dims, half_a.data(), 2, b_dims, half_b.data(), beta, 3,
+                   c_dims, half_c.data());
+    std::vector<float> c(half_c.size());
+    ConvertToFloat(data_type, half_c.size(), half_c.data(), c.data());
+    const float rtol = data_type == DataType::kBFloat16 ? 1.0f / 128 : 1.0f / 1024;
+    FOR_RANGE(size_t, i, 0, c.size()) {
+      ASSERT_NEAR(c[i], expected[i], std::abs(expected[i]) * rtol + 1e-3) << "index: " << i;
+    }
+  }
+}
+
+// c (4, 3, m, n) = a (4, 3, m, k) x b (1, 3, n, k)^T, the batches of c are multiplied in parallel
+void TestBatchedBroadcastMatmul(int64_t m, int64_t n, int64_t k) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto matmul = NewPrimitive<BroadcastMatmulFactory>(DeviceType::kCPU, DataType::kFloat,
+                                                     BlasTransposeType::N, BlasTransposeType::T, 4);
+  ASSERT_TRUE(matmul);
+  const int64_t a_dims[4] = {4, 3, m, k};
+  const int64_t b_dims[4] = {1, 3, n, k};
+  const int64_t c_dims[4] = {4, 3, m, n};
+  std::vector<float> a(12 * m * k);
+  std::vector<float> b(3 * n * k);
+  FOR_RANGE(size_t, i, 0, a.size()) { a[i] = static_cast<float>(i % 23) / 8 - 1; }
+  FOR_RANGE(size_t, i, 0, b.size()) { b[i] = static_cast<float>(i % 11) / 4 - 1; }
+  std::vector<float> c(12 * m * n, 1);
+  std::vector<float> expected(c.size());
+  FOR_RANGE(int64_t, p, 0, 12) {
+    const float* batch_a = a.data() + p * m * k;
+    const float* batch_b = b.data() + (p % 3) * n * k;
+    FOR_RANGE(int64_t, i, 0, m) {
+      FOR_RANGE(int64_t, j, 0, n) {
+        float sum = 0;
+        FOR_RANGE(int64_t, l, 0, k) { sum += batch_a[i * k + l] * batch_b[j * k + l]; }
+        expected[(p * m + i) * n + j] = 2 * sum + 0.5f;
+      }
+    }
+  }
+  matmul->Launch(&stream, 2.0, 4, a_dims, a.data(), 4, b_dims, b.data(), 0.5, 4, c_dims,
+                 c.data());
+  FOR_RANGE(size_t, i, 0, c.size()) {
+    ASSERT_NEAR(c[i], expected[i], std::abs(expected[i]) * 1e-5 + 1e-4) << "index: " << i;
+  }
+}
+
+// c (2, 3, m, n) = a (2, 1, m, k) x b (1, 3, k, n), each of a and b may be stored transposed
+void TestTransposedBroadcastMatmul(BlasTransposeType transpose_a, BlasTransposeType transpose_b,
+                                   int64_t m, int64_t n, int64_t k) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto matmul = NewPrimitive<BroadcastMatmulFactory>(DeviceType::kCPU, DataType::kFloat,
+                                                     transpose_a, transpose_b, 4);
+  ASSERT_TRUE(matmul);
+  const bool trans_a = transpose_a == BlasTransposeType::T;
+  const bool trans_b = transpose_b == BlasTransposeType::T;
+  const int64_t a_dims[4] = {2, 1, trans_a ? k : m, trans_a ? m : k};
+  const int64_t b_dims[4] = {1, 3, trans_b ? n : k, trans_b ? k : n};
+  const int64_t c_dims[4] = {2, 3, m, n};
+  std::vector<float> a(2 * m * k);
+  std::vector<float> b(3 * k * n);
+  FOR_RANGE(size_t, i, 0, a.size()) { a[i] = static_cast<float>(i % 19) / 8 - 1; }
+  FOR_RANGE(size_t, i, 0, b.size()) { b[i] = static_cast<float>(i % 7) / 4 - 0.75f; }
+  std::vector<float> c(6 * m * n, 1);
+  std::vector<float> expected(c.size());
+  FOR_RANGE(int64_t, p, 0, 6) {
+    const float* batch_a = a.data() + p / 3 * m * k;
+    const float* batch_b = b.data() + p % 3 * k * n;
+    FOR_RANGE(int64_t, i, 0, m) {
+      FOR_RANGE(int64_t, j, 0, n) {
+        float sum = 0;
+        FOR_RANGE(int64_t, l, 0, k) {
+          const float a_il = batch_a[trans_a ? l * m + i : i * k + l];
+          const float b_lj = batch_b[trans_b ? j * k + l : l * n + j];
+          sum += a_il * b_lj;
+        }
+        expected[(p * m + i) * n + j] = 0.5f * sum - 1;
+      }
+    }
+  }
+  matmul->Launch(&stream, 0.5, 4, a_dims, a.data(), 4, b_dims, b.data(), -1.0, 4, c_dims,
+                 c.data());
+  FOR_RANGE(size_t, i, 0, c.size()) {
+    ASSERT_NEAR(c[i], expected[i], std::abs(expected[i]) * 1e-5 + 1e-4)
+        << "trans_a: " << trans_a << ", trans_b: " << trans_b << ", index: " << i;
+  }
+}
+
+}  // namespace
+
+TEST(CpuBroadcastMatmul, half) {
+  for (const DataType data_type : {DataType::kFloat16, DataType::kBFloat16}) {
+    TestHalfBroadcastMatmul(data_type, 1, 1, 1, 1);
+    TestHalfBroadcastMatmul(data_type, 2, 7, 9, 33);
+    TestHalfBroadcastMatmul(data_type, 3, 64, 48, 96);
+  }
+}
+
+TEST(CpuBroadcastMatmul, batched) {
+  TestBatchedBroadcastMatmul(1, 1, 1);
+  TestBatchedBroadcastMatmul(64, 64, 64);
+  TestBatchedBroadcastMatmul(17, 9, 130);
+}
+
+TEST(CpuBroadcastMatmul, transposed) {
+  for (const BlasTransposeType transpose_a : {BlasTransposeType::N, BlasTransposeType::T}) {
+    for (const BlasTransposeType transpose_b : {BlasTransposeType::N, BlasTransposeType::T}) {
+      TestTransposedBroadcastMatmul(transpose_a, transpose_b, 1, 1, 1);
+      TestTransposedBroadcastMatmul(transpose_a, transpose_b, 5, 7, 3);
+      TestTransposedBroadcastMatmul(transpose_a, transpose_b, 33, 17, 65);
+    }
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
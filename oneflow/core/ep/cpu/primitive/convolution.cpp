@@ -0,0 +1,324 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/include/primitive/convolution.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+#ifdef WITH_ONEDNN
+
+// Split the first logical dim of the weight into (groups, dim / groups)
+void SplitWeightGroups(int64_t groups, dnnl::memory::dims* dims, dnnl::memory::dims* strides) {
+  if (groups == 1) { return; }
+  CHECK_EQ(dims->at(0) % groups, 0);
+  const dnnl::memory::dim group_size = dims->at(0) / groups;
+  dims->at(0) = group_size;
+  dims->insert(dims->begin(), groups);
+  strides->insert(strides->begin(), group_size * strides->at(0));
+}
+
+void CheckParams(const ConvolutionParams& params) {
+  CHECK_GT(params.num_spatial_dims, 0);
+  CHECK_EQ(params.strides.size(), params.num_spatial_dims);
+  CHECK_EQ(params.dilation_rate.size(), params.num_spatial_dims);
+  CHECK_EQ(params.padding_before.size(), params.num_spatial_dims);
+  CHECK_GT(params.groups, 0);
+}
+
+// The part of the key which does not change between the launches of a primitive
+OneDnnPrimitiveKey MakeKeyPrefix(const std::string& kind, DataType data_type,
+                                 const ConvolutionParams& params) {
+  CheckParams(params);
+  OneDnnPrimitiveKey key(kind);
+  key.Append(data_type)
+      .Append(params.channels_last)
+      .Append(params.groups)
+      .Append(params.strides.data(), params.num_spatial_dims)
+      .Append(params.dilation_rate.data(), params.num_spatial_dims)
+      .Append(params.padding_before.data(), params.num_spatial_dims);
+  return key;
+}
+
+OneDnnPrimitiveKey MakeKey(const OneDnnPrimitiveKey& prefix, const ConvolutionParams& params,
+                           const int64_t* src_dims, const int64_t* weight_dims, bool has_bias,
+                           const int64_t* dst_dims) {
+  const size_t num_dims = params.num_spatial_dims + 2;
+  OneDnnPrimitiveKey key(prefix);
+  key.Append(src_dims, num_dims)
+      .Append(weight_dims, num_dims)
+      .Append(has_bias)
+      .Append(dst_dims, num_dims);
+  return key;
+}
+
+// The descs and attributes shared by the convolution and the deconvolution, the spatial dims of
+// the weight are the last ones in the logical order
+struct ConvolutionDescs {
+  dnnl::memory::desc src;
+  dnnl::memory::desc user_weight;
+  dnnl::memory::desc any_weight;
+  dnnl::memory::desc bias;
+  dnnl::memory::desc dst;
+  dnnl::memory::dims strides;
+  dnnl::memory::dims dilates;
+  dnnl::memory::dims padding_l;
+  dnnl::memory::dims padding_r;
+};
+
+// The padding after such that (src + padding_l + padding_r - kernel_extent) / stride + 1 == dst
+dnnl::memory::dim GetConvolutionPaddingR(dnnl::memory::dim src, dnnl::memory::dim dst,
+                                         dnnl::memory::dim kernel_extent, dnnl::memory::dim stride,
+                                         dnnl::memory::dim padding_l) {
+  return std::max<dnnl::memory::dim>((dst - 1) * stride + kernel_extent - src - padding_l, 0);
+}
+
+ConvolutionDescs MakeConvolutionDescs(dnnl::memory::data_type data_type,
+                                      const ConvolutionParams& params, const int64_t* src_dims,
+                                      const dnnl::memory::dims& weight_logical_dims,
+                                      const dnnl::memory::dims& weight_strides,
+                                      const int64_t* dst_dims, bool is_deconvolution) {
+  const size_t num_dims = params.num_spatial_dims + 2;
+  ConvolutionDescs descs;
+  descs.src = MakeOneDnnPlainDesc(num_dims, src_dims, params.channels_last, data_type);
+  descs.dst = MakeOneDnnPlainDesc(num_dims, dst_dims, params.channels_last, data_type);
+  descs.user_weight = dnnl::memory::desc(weight_logical_dims, data_type, weight_strides);
+  descs.any_weight =
+      dnnl::memory::desc(weight_logical_dims, data_type, dnnl::memory::format_tag::any);
+  const dnnl::memory::dims& src_logical_dims = descs.src.dims();
+  const dnnl::memory::dims& dst_logical_dims = descs.dst.dims();
+  descs.bias = dnnl::memory::desc({dst_logical_dims.at(1)}, data_type, dnnl::memory::format_tag::x);
+  const size_t weight_spatial_offset = weight_logical_dims.size() - params.num_spatial_dims;
+  for (size_t i = 0; i < params.num_spatial_dims; ++i) {
+    const dnnl::memory::dim kernel = weight_logical_dims.at(weight_spatial_offset + i);
+    const dnnl::memory::dim stride = params.strides.at(i);
+    const dnnl::memory::dim dilation = params.dilation_rate.at(i);
+    const dnnl::memory::dim padding_l = params.padding_before.at(i);
+    const dnnl::memory::dim kernel_extent = (kernel - 1) * dilation + 1;
+    dnnl::memory::dim padding_r = 0;
+    if (is_deconvolution) {
+      // dst = (src - 1) * stride + kernel_extent - padding_l - padding_r
+      padding_r = (src_logical_dims.at(i + 2) - 1) * stride + kernel_extent - padding_l
+                  - dst_logical_dims.at(i + 2);
+      CHECK_GE(padding_r, 0) << "output_padding is not supported";
+    } else {
+      padding_r = GetConvolutionPaddingR(src_logical_dims.at(i + 2), dst_logical_dims.at(i + 2),
+                                         kernel_extent, stride, padding_l);
+    }
+    descs.strides.push_back(stride);
+    // oneDNN counts the dilation from 0
+    descs.dilates.push_back(dilation - 1);
+    descs.padding_l.push_back(padding_l);
+    descs.padding_r.push_back(padding_r);
+  }
+  return descs;
+}
+
+struct ConvolutionPrimitive {
+  dnnl::convolution_forward::primitive_desc pd;
+  dnnl::convolution_forward conv;
+  std::unique_ptr<OneDnnReorderedWeight> weight;
+};
+
+struct DeconvolutionPrimitive {
+  dnnl::deconvolution_forward::primitive_desc pd;
+  dnnl::deconvolution_forward deconv;
+  std::unique_ptr<OneDnnReorderedWeight> weight;
+};
+
+template<typename PrimitiveT>
+void Execute(CpuStream* cpu_stream, const PrimitiveT& primitive, const dnnl::primitive& prim,
+             const void* src, const void* weight, const void* bias, void* dst) {
+  const dnnl::engine& engine = *cpu_stream->onednn_engine();
+  dnnl::stream* onednn_stream = cpu_stream->onednn_stream();
+  std::unordered_map<int, dnnl::memory> args{
+      {DNNL_ARG_SRC, dnnl::memory(primitive.pd.src_desc(), engine, const_cast<void*>(src))},
+      {DNNL_ARG_WEIGHTS, primitive.weight->Get(engine, onednn_stream, weight)},
+      {DNNL_ARG_DST, dnnl::memory(primitive.pd.dst_desc(), engine, dst)}};
+  if (bias != nullptr) {
+    args.emplace(DNNL_ARG_BIAS,
+                 dnnl::memory(primitive.pd.bias_desc(), engine, const_cast<void*>(bias)));
+  }
+  prim.execute(*onednn_stream, args);
+  onednn_stream->wait();
+}
+
+class ConvolutionImpl : public Convolution {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ConvolutionImpl);
+  ConvolutionImpl(DataType data_type, const ConvolutionParams& params)
+      : data_type_(data_type),
+        params_(params),
+        key_prefix_(MakeKeyPrefix("convolution", data_type, params)) {}
+  ~ConvolutionImpl() override = default;
+
+  void Launch(Stream* stream, const int64_t* src_dims, const void* src, const int64_t* weight_dims,
+              const void* weight, const void* bias, const int64_t* dst_dims, void* dst) override {
+    CpuStream* cpu_stream = stream->As<CpuStream>();
+    const OneDnnPrimitiveKey key =
+        MakeKey(key_prefix_, params_, src_dims, weight_dims, bias != nullptr, dst_dims);
+    auto primitive =
+        cpu_stream->onednn_primitive_cache()->FindOrCreate<ConvolutionPrimitive>(key, [&]() {
+          const size_t num_dims = params_.num_spatial_dims + 2;
+          dnnl::memory::dims weight_logical_dims;
+          dnnl::memory::dims weight_strides;
+          // (out_channels, in_channels / groups, kernel...)
+          GetOneDnnLogicalDimsAndStrides(num_dims, weight_dims, params_.channels_last,
+                                         &weight_logical_dims, &weight_strides);
+          SplitWeightGroups(params_.groups, &weight_logical_dims, &weight_strides);
+          const ConvolutionDescs descs =
+              MakeConvolutionDescs(GetOneDnnDataType(data_type_), params_, src_dims,
+                                   weight_logical_dims, weight_strides, dst_dims, false);
+          const dnnl::engine& engine = *cpu_stream->onednn_engine();
+          auto* conv = new ConvolutionPrimitive();
+          if (bias != nullptr) {
+            conv->pd = dnnl::convolution_forward::primitive_desc(
+                dnnl::convolution_forward::desc(
+                    dnnl::prop_kind::forward_inference, dnnl::algorithm::convolution_direct,
+                    descs.src, descs.any_weight, descs.bias, descs.dst, descs.strides,
+                    descs.dilates, descs.padding_l, descs.padding_r),
+                engine);
+          } else {
+            conv->pd = dnnl::convolution_forward::primitive_desc(
+                dnnl::convolution_forward::desc(
+                    dnnl::prop_kind::forward_inference, dnnl::algorithm::convolution_direct,
+                    descs.src, descs.any_weight, descs.dst, descs.strides, descs.dilates,
+                    descs.padding_l, descs.padding_r),
+                engine);
+          }
+          conv->conv = dnnl::convolution_forward(conv->pd);
+          conv->weight.reset(
+              new OneDnnReorderedWeight(engine, descs.user_weight, conv->pd.weights_desc()));
+          return conv;
+        });
+    Execute(cpu_stream, *primitive, primitive->conv, src, weight, bias, dst);
+  }
+
+ private:
+  DataType data_type_;
+  ConvolutionParams params_;
+  OneDnnPrimitiveKey key_prefix_;
+};
+
+class DeconvolutionImpl : public Deconvolution {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(DeconvolutionImpl);
+  DeconvolutionImpl(DataType data_type, const ConvolutionParams& params)
+      : data_type_(data_type),
+        params_(params),
+        key_prefix_(MakeKeyPrefix("deconvolution", data_type, params)) {}
+  ~DeconvolutionImpl() override = default;
+
+  void Launch(Stream* stream, const int64_t* src_dims, const void* src, const int64_t* weight_dims,
+              const void* weight, const void* bias, const int64_t* dst_dims, void* dst) override {
+    CpuStream* cpu_stream = stream->As<CpuStream>();
+    const OneDnnPrimitiveKey key =
+        MakeKey(key_prefix_, params_, src_dims, weight_dims, bias != nullptr, dst_dims);
+    auto primitive =
+        cpu_stream->onednn_primitive_cache()->FindOrCreate<DeconvolutionPrimitive>(key, [&]() {
+          const size_t num_dims = params_.num_spatial_dims + 2;
+          dnnl::memory::dims weight_logical_dims;
+          dnnl::memory::dims weight_strides;
+          // (in_channels, out_channels / groups, kernel...), oneDNN wants the out_channels first
+          GetOneDnnLogicalDimsAndStrides(num_dims, weight_dims, params_.channels_last,
+                                         &weight_logical_dims, &weight_strides);
+          SplitWeightGroups(params_.groups, &weight_logical_dims, &weight_strides);
+          const size_t in_channel_axis = params_.groups == 1 ? 0 : 1;
+          std::swap(weight_logical_dims.at(in_channel_axis),
+                    weight_logical_dims.at(in_channel_axis + 1));
+          std::swap(weight_strides.at(in_channel_axis), weight_strides.at(in_channel_axis + 1));
+          const ConvolutionDescs descs =
+              MakeConvolutionDescs(GetOneDnnDataType(data_type_), params_, src_dims,
+                                   weight_logical_dims, weight_strides, dst_dims, true);
+          const dnnl::engine& engine = *cpu_stream->onednn_engine();
+          auto* deconv = new DeconvolutionPrimitive();
+          if (bias != nullptr) {
+            deconv->pd = dnnl::deconvolution_forward::primitive_desc(
+                dnnl::deconvolution_forward::desc(
+                    dnnl::prop_kind::forward_inference, dnnl::algorithm::deconvolution_direct,
+                    descs.src, descs.any_weight, descs.bias, descs.dst, descs.strides,
+                    descs.dilates, descs.padding_l, descs.padding_r),
+                engine);
+          } else {
+            deconv->pd = dnnl::deconvolution_forward::primitive_desc(
+                dnnl::deconvolution_forward::desc(
+                    dnnl::prop_kind::forward_inference, dnnl::algorithm::deconvolution_direct,
+                    descs.src, descs.any_weight, descs.dst, descs.strides, descs.dilates,
+                    descs.padding_l, descs.padding_r),
+                engine);
+          }
+          deconv->deconv = dnnl::deconvolution_forward(deconv->pd);
+          deconv->weight.reset(
+              new OneDnnReorderedWeight(engine, descs.user_weight, deconv->pd.weights_desc()));
+          return deconv;
+        });
+    Execute(cpu_stream, *primitive, primitive->deconv, src, weight, bias, dst);
+  }
+
+ private:
+  DataType data_type_;
+  ConvolutionParams params_;
+  OneDnnPrimitiveKey key_prefix_;
+};
+
+#endif  // WITH_ONEDNN
+
+class ConvolutionFactoryImpl : public ConvolutionFactory {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ConvolutionFactoryImpl);
+  ConvolutionFactoryImpl() = default;
+  ~ConvolutionFactoryImpl() override = default;
+
+  std::unique_ptr<Convolution> New(DataType data_type, const ConvolutionParams& params) override {
+#ifdef WITH_ONEDNN
+    if (data_type == DataType::kFloat && IsOneDnnPrimitiveEnabled()) {
+      return std::unique_ptr<Convolution>(new ConvolutionImpl(data_type, params));
+    }
+#endif  // WITH_ONEDNN
+    return nullptr;
+  }
+};
+
+class DeconvolutionFactoryImpl : public DeconvolutionFactory {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(DeconvolutionFactoryImpl);
+  DeconvolutionFactoryImpl() = default;
+  ~DeconvolutionFactoryImpl() override = default;
+
+  std::unique_ptr<Deconvolution> New(DataType data_type,
+                                     const ConvolutionParams& params) override {
+#ifdef WITH_ONEDNN
+    if (data_type == DataType::kFloat && IsOneDnnPrimitiveEnabled()) {
+      return std::unique_ptr<Deconvolution>(new DeconvolutionImpl(data_type, params));
+    }
+#endif  // WITH_ONEDNN
+    return nullptr;
+  }
+};
+
+REGISTER_PRIMITIVE_FACTORY(DeviceType::kCPU, ConvolutionFactory, ConvolutionFactoryImpl);
+REGISTER_PRIMITIVE_FACTORY(DeviceType::kCPU, DeconvolutionFactory, DeconvolutionFactoryImpl);
+
+}  // namespace
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,328 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/convolution.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// The primitives only exist with oneDNN, the kernels run im2col and gemm otherwise. The reference
+// loops below compute what im2col and gemm compute.
+#ifdef WITH_ONEDNN
+
+namespace {
+
+// The oneDNN primitives are opt-in, this binary enables them before the first one is created
+const bool kOneDnnPrimitiveEnabled =
+    setenv("ONEFLOW_EP_CPU_ENABLE_ONEDNN_PRIMITIVES", "1", 0) == 0;
+
+constexpr size_t kMaxSpatialDims = 3;
+
+// A tensor of the logical dims (N, C, D, H, W), the spatial dims of fewer than 3 are 1 at the
+// front, stored as (N, C, spatial...) or (N, spatial..., C) if channels_last
+struct Layout {
+  Layout(size_t num_spatial_dims, bool channels_last, int64_t n, int64_t c,
+         const std::vector<int64_t>& spatial)
+      : num_spatial_dims(num_spatial_dims), channels_last(channels_last) {
+    logical = {n, c, 1, 1, 1};
+    for (size_t i = 0; i < num_spatial_dims; ++i) {
+      logical[2 + kMaxSpatialDims - num_spatial_dims + i] = spatial.at(i);
+    }
+    memory.push_back(n);
+    if (!channels_last) { memory.push_back(c); }
+    memory.insert(memory.end(), spatial.begin(), spatial.begin() + num_spatial_dims);
+    if (channels_last) { memory.push_back(c); }
+  }
+
+  int64_t ElemCnt() const {
+    return logical[0] * logical[1] * logical[2] * logical[3] * logical[4];
+  }
+
+  int64_t Offset(int64_t n, int64_t c, int64_t d, int64_t h, int64_t w) const {
+    const int64_t spatial = (d * logical[3] + h) * logical[4] + w;
+    const int64_t spatial_size = logical[2] * logical[3] * logical[4];
+    if (channels_last) { return (n * spatial_size + spatial) * logical[1] + c; }
+    return (n * logical[1] + c) * spatial_size + spatial;
+  }
+
+  size_t num_spatial_dims;
+  bool channels_last;
+  std::array<int64_t, 5> logical;
+  std::vector<int64_t> memory;
+};
+
+std::vector<float> RandomVector(size_t n, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dis(-1, 1);
+  std::vector<float> vec(n);
+  for (float& v : vec) { v = dis(gen); }
+  return vec;
+}
+
+struct ConvCase {
+  size_t num_spatial_dims;
+  bool channels_last;
+  int64_t groups;
+  int64_t batch;
+  int64_t in_channels;
+  int64_t out_channels;
+  std::vector<int64_t> in_spatial;
+  std::vector<int64_t> kernel;
+  std::vector<int32_t> strides;
+  std::vector<int32_t> dilation_rate;
+  std::vector<int32_t> padding;
+  bool has_bias;
+};
+
+std::string ToString(const ConvCase& c) {
+  std::string str = "num_spatial_dims: " + std::to_string(c.num_spatial_dims)
+                    + ", channels_last: " + std::to_string(c.channels_last)
+                    + ", groups: " + std::to_string(c.groups) + ", stride: "
+                    + std::to_string(c.strides.at(0)) + ", dilation: "
+                    + std::to_string(c.dilation_rate.at(0)) + ", padding: "
+                    + std::to_string(c.padding.at(0)) + ", bias: " + std::to_string(c.has_bias);
+  return str;
+}
+
+ConvolutionParams GetParams(const ConvCase& c) {
+  ConvolutionParams params;
+  params.num_spatial_dims = c.num_spatial_dims;
+  params.channels_last = c.channels_last;
+  params.groups = c.groups;
+  params.strides = c.strides;
+  params.dilation_rate = c.dilation_rate;
+  params.padding_before = c.padding;
+  return params;
+}
+
+// The stride, dilation and padding of the logical spatial dim i of 3, the missing dims are 1, 1, 0
+int64_t Stride(const ConvCase& c, size_t i) {
+  const int64_t j = static_cast<int64_t>(i) - (kMaxSpatialDims - c.num_spatial_dims);
+  return j < 0 ? 1 : c.strides.at(j);
+}
+
+int64_t Dilation(const ConvCase& c, size_t i) {
+  const int64_t j = static_cast<int64_t>(i) - (kMaxSpatialDims - c.num_spatial_dims);
+  return j < 0 ? 1 : c.dilation_rate.at(j);
+}
+
+int64_t Padding(const ConvCase& c, size_t i) {
+  const int64_t j = static_cast<int64_t>(i) - (kMaxSpatialDims - c.num_spatial_dims);
+  return j < 0 ? 0 : c.padding.at(j);
+}
+
+void AssertNear(const std::vector<float>& out, const std::vector<double>& expected,
+                const std::string& name) {
+  ASSERT_EQ(out.size(), expected.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    ASSERT_NEAR(out[i], expected[i], 1e-4 + 1e-4 * std::abs(expected[i]))
+        << name << ", index: " << i;
+  }
+}
+
+void TestConvolution(const ConvCase& c) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto conv = NewPrimitive<ConvolutionFactory>(DeviceType::kCPU, DataType::kFloat, GetParams(c));
+  ASSERT_TRUE(conv);
+  std::vector<int64_t> out_spatial;
+  for (size_t i = 0; i < c.num_spatial_dims; ++i) {
+    const int64_t kernel_extent = (c.kernel.at(i) - 1) * c.dilation_rate.at(i) + 1;
+    out_spatial.push_back((c.in_spatial.at(i) + 2 * c.padding.at(i) - kernel_extent)
+                              / c.strides.at(i)
+                          + 1);
+  }
+  const int64_t in_group_channels = c.in_channels / c.groups;
+  const int64_t out_group_channels = c.out_channels / c.groups;
+  const Layout in(c.num_spatial_dims, c.channels_last, c.batch, c.in_channels, c.in_spatial);
+  const Layout weight(c.num_spatial_dims, c.channels_last, c.out_channels, in_group_channels,
+                      c.kernel);
+  const Layout out(c.num_spatial_dims, c.channels_last, c.batch, c.out_channels, out_spatial);
+  const std::vector<float> x = RandomVector(in.ElemCnt(), 0);
+  const std::vector<float> w = RandomVector(weight.ElemCnt(), 1);
+  const std::vector<float> bias = RandomVector(c.out_channels, 2);
+  std::vector<float> y(out.ElemCnt());
+  conv->Launch(&stream, in.memory.data(), x.data(), weight.memory.data(), w.data(),
+               c.has_bias ? bias.data() : nullptr, out.memory.data(), y.data());
+
+  std::vector<double> expected(out.ElemCnt());
+  const auto& o = out.logical;
+  const auto& k = weight.logical;
+  const auto& s = in.logical;
+  for (int64_t n = 0; n < o[0]; ++n) {
+    for (int64_t oc = 0; oc < o[1]; ++oc) {
+      const int64_t g = oc / out_group_channels;
+      for (int64_t od = 0; od < o[2]; ++od) {
+        for (int64_t oh = 0; oh < o[3]; ++oh) {
+          for (int64_t ow = 0; ow < o[4]; ++ow) {
+            double sum = c.has_bias ? bias[oc] : 0;
+            for (int64_t ic = 0; ic < in_group_channels; ++ic) {
+              for (int64_t kd = 0; kd < k[2]; ++kd) {
+                const int64_t id = od * Stride(c, 0) - Padding(c, 0) + kd * Dilation(c, 0);
+                if (id < 0 || id >= s[2]) { continue; }
+                for (int64_t kh = 0; kh < k[3]; ++kh) {
+                  const int64_t ih = oh * Stride(c, 1) - Padding(c, 1) + kh * Dilation(c, 1);
+                  if (ih < 0 || ih >= s[3]) { continue; }
+                  for (int64_t kw = 0; kw < k[4]; ++kw) {
+                    const int64_t iw = ow * Stride(c, 2) - Padding(c, 2) + kw * Dilation(c, 2);
+                    if (iw < 0 || iw >= s[4]) { continue; }
+                    sum += static_cast<double>(
+                               x[in.Offset(n, g * in_group_channels + ic, id, ih, iw)])
+                           * w[weight.Offset(oc, ic, kd, kh, kw)];
+                  }
+                }
+              }
+            }
+            expected[out.Offset(n, oc, od, oh, ow)] = sum;
+          }
+        }
+      }
+    }
+  }
+  AssertNear(y, expected, ToString(c));
+}
+
+void TestDeconvolution(const ConvCase& c) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto deconv =
+      NewPrimitive<DeconvolutionFactory>(DeviceType::kCPU, DataType::kFloat, GetParams(c));
+  ASSERT_TRUE(deconv);
+  std::vector<int64_t> out_spatial;
+  for (size_t i = 0; i < c.num_spatial_dims; ++i) {
+    const int64_t kernel_extent = (c.kernel.at(i) - 1) * c.dilation_rate.at(i) + 1;
+    out_spatial.push_back((c.in_spatial.at(i) - 1) * c.strides.at(i) - 2 * c.padding.at(i)
+                          + kernel_extent);
+  }
+  const int64_t in_group_channels = c.in_channels / c.groups;
+  const int64_t out_group_channels = c.out_channels / c.groups;
+  const Layout in(c.num_spatial_dims, c.channels_last, c.batch, c.in_channels, c.in_spatial);
+  // (in_channels, out_channels / groups, kernel...)
+  const Layout weight(c.num_spatial_dims, c.channels_last, c.in_channels, out_group_channels,
+                      c.kernel);
+  const Layout out(c.num_spatial_dims, c.channels_last, c.batch, c.out_channels, out_spatial);
+  const std::vector<float> x = RandomVector(in.ElemCnt(), 3);
+  const std::vector<float> w = RandomVector(weight.ElemCnt(), 4);
+  const std::vector<float> bias = RandomVector(c.out_channels, 5);
+  std::vector<float> y(out.ElemCnt());
+  deconv->Launch(&stream, in.memory.data(), x.data(), weight.memory.data(), w.data(),
+                 c.has_bias ? bias.data() : nullptr, out.memory.data(), y.data());
+
+  // the transposed convolution scatters every input element, as gemm and col2im do
+  std::vector<double> expected(out.ElemCnt(), 0);
+  const auto& o = out.logical;
+  const auto& k = weight.logical;
+  const auto& s = in.logical;
+  if (c.has_bias) {
+    for (int64_t n = 0; n < o[0]; ++n) {
+      for (int64_t oc = 0; oc < o[1]; ++oc) {
+        for (int64_t od = 0; od < o[2]; ++od) {
+          for (int64_t oh = 0; oh < o[3]; ++oh) {
+            for (int64_t ow = 0; ow < o[4]; ++ow) {
+              expected[out.Offset(n, oc, od, oh, ow)] = bias[oc];
+            }
+          }
+        }
+      }
+    }
+  }
+  for (int64_t n = 0; n < s[0]; ++n) {
+    for (int64_t ic = 0; ic < s[1]; ++ic) {
+      const int64_t g = ic / in_group_channels;
+      for (int64_t id = 0; id < s[2]; ++id) {
+        for (int64_t ih = 0; ih < s[3]; ++ih) {
+          for (int64_t iw = 0; iw < s[4]; ++iw) {
+            const double value = x[in.Offset(n, ic, id, ih, iw)];
+            for (int64_t oc = 0; oc < out_group_channels; ++oc) {
+              for (int64_t kd = 0; kd < k[2]; ++kd) {
+                const int64_t od = id * Stride(c, 0) - Padding(c, 0) + kd * Dilation(c, 0);
+                if (od < 0 || od >= o[2]) { continue; }
+                for (int64_t kh = 0; kh < k[3]; ++kh) {
+                  const int64_t oh = ih * Stride(c, 1) - Padding(c, 1) + kh * Dilation(c, 1);
+                  if (oh < 0 || oh >= o[3]) { continue; }
+                  for (int64_t kw = 0; kw < k[4]; ++kw) {
+                    const int64_t ow = iw * Stride(c, 2) - Padding(c, 2) + kw * Dilation(c, 2);
+                    if (ow < 0 || ow >= o[4]) { continue; }
+                    expected[out.Offset(n, g * out_group_channels + oc, od, oh, ow)] +=
+                        value * w[weight.Offset(ic, oc, kd, kh, kw)];
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  AssertNear(y, expected, ToString(c));
+}
+
+// The cases of every stride, padding, dilation, groups, layout and bias
+std::vector<ConvCase> GetConvCases() {
+  std::vector<ConvCase> cases;
+  for (size_t num_spatial_dims : {1, 2, 3}) {
+    for (bool channels_last : {false, true}) {
+      for (int64_t groups : {1, 2, 4}) {
+        for (int32_t stride : {1, 2}) {
+          for (int32_t dilation : {1, 2}) {
+            for (int32_t padding : {0, 1}) {
+              ConvCase c;
+              c.num_spatial_dims = num_spatial_dims;
+              c.channels_last = channels_last;
+              c.groups = groups;
+              c.batch = 2;
+              c.in_channels = 4;
+              c.out_channels = 8;
+              c.in_spatial.assign(num_spatial_dims, num_spatial_dims == 3 ? 6 : 9);
+              c.in_spatial.back() += 1;
+              c.kernel.assign(num_spatial_dims, 3);
+              c.strides.assign(num_spatial_dims, stride);
+              c.dilation_rate.assign(num_spatial_dims, dilation);
+              c.padding.assign(num_spatial_dims, padding);
+              c.has_bias = (stride + dilation + padding) % 2 == 0;
+              cases.push_back(c);
+            }
+          }
+        }
+      }
+    }
+  }
+  return cases;
+}
+
+}  // namespace
+
+TEST(CpuConvolution, convolution) {
+  for (const ConvCase& c : GetConvCases()) { TestConvolution(c); }
+}
+
+TEST(CpuConvolution, deconvolution) {
+  for (const ConvCase& c : GetConvCases()) { TestDeconvolution(c); }
+}
+
+#endif  // WITH_ONEDNN
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -15,6 +15,10 @@ limitations under the License.
 */
 #include "oneflow/core/ep/include/primitive/copy_nd.h"
 #include "oneflow/core/ep/common/primitive/copy_nd.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#ifdef __x86_64__
+#include <emmintrin.h>
+#endif
 
 namespace oneflow {
 
@@ -23,29 +27,102 @@ namespace primitive {
 
 namespace {
 
+// Non-temporal stores only pay off for long rows, the partially written cache lines at both ends
+// of short rows are slower than the ordinary stores
+constexpr int64_t kMinNonTemporalRowBytes = 8192;
+
+// Longer rows are split into chunks of this many bytes, so that a contiguous copy, which is a
+// single row after the simplification, is still shared by the threads
+constexpr int64_t kMaxChunkBytes = 65536;
+
+// Copies of at least this many bytes bypass the cache with non-temporal stores, the data would
+// evict everything else before it is read again
+int64_t GetNonTemporalCopyThreshold() {
+  static const int64_t threshold =
+      ParseIntegerFromEnv("ONEFLOW_EP_CPU_COPY_ND_NON_TEMPORAL_THRESHOLD", 16 * 1024 * 1024);
+  return threshold;
+}
+
+void NonTemporalCopy(void* dst, const void* src, size_t size) {
+#ifdef __x86_64__
+  char* dst_ptr = reinterpret_cast<char*>(dst);
+  const char* src_ptr = reinterpret_cast<const char*>(src);
+  const size_t head = std::min<size_t>((16 - reinterpret_cast<std::uintptr_t>(dst_ptr) % 16) % 16,
+                                       size);
+  std::memcpy(dst_ptr, src_ptr, head);
+  size_t offset = head;
+  for (; offset + 16 <= size; offset += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ptr + offset));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(dst_ptr + offset), v);
+  }
+  std::memcpy(dst_ptr + offset, src_ptr + offset, size - offset);
+#else
+  std::memcpy(dst, src, size);
+#endif  // __x86_64__
+}
+
+// The innermost dim of the simplified copy is contiguous in both src and dst, so the copy is done
+// chunk by chunk of the rows with one index computation and one memcpy per chunk
 template<size_t num_dims, size_t movement_size, typename IndexType>
-void CopyNdKernel(CopyNdKernelParams<num_dims, IndexType> params) {
-  using T = typename std::aligned_storage<movement_size, movement_size>::type;
-  const T* src = reinterpret_cast<const T*>(params.src);
-  T* dst = reinterpret_cast<T*>(params.dst);
-  for (IndexType i = 0; i < params.count; ++i) {
+void CopyNdKernel(CopyNdKernelParams<num_dims, IndexType> params, IndexType row_size,
+                  IndexType chunk_size, IndexType num_chunks_per_row, bool non_temporal,
+                  IndexType begin_chunk, IndexType end_chunk) {
+  const char* src = reinterpret_cast<const char*>(params.src);
+  char* dst = reinterpret_cast<char*>(params.dst);
+  for (IndexType chunk = begin_chunk; chunk < end_chunk; ++chunk) {
+    const IndexType row = chunk / num_chunks_per_row;
+    const IndexType chunk_offset = (chunk - row * num_chunks_per_row) * chunk_size;
+    const size_t chunk_bytes = std::min(chunk_size, row_size - chunk_offset) * movement_size;
     IndexType copy_index[num_dims];
     IndexType src_index[num_dims];
     IndexType dst_index[num_dims];
-    params.copy_index_helper.OffsetToNdIndex(i, copy_index);
+    params.copy_index_helper.OffsetToNdIndex(row * row_size, copy_index);
     for (size_t j = 0; j < num_dims; ++j) {
       src_index[j] = params.src_pos[j] + copy_index[j];
       dst_index[j] = params.dst_pos[j] + copy_index[j];
     }
-    const IndexType src_offset = params.src_index_helper.NdIndexToOffset(src_index);
-    const IndexType dst_offset = params.dst_index_helper.NdIndexToOffset(dst_index);
-    dst[dst_offset] = src[src_offset];
+    const IndexType src_offset = params.src_index_helper.NdIndexToOffset(src_index) + chunk_offset;
+    const IndexType dst_offset = params.dst_index_helper.NdIndexToOffset(dst_index) + chunk_offset;
+    if (non_temporal) {
+      NonTemporalCopy(dst + dst_offset * movement_size, src + src_offset * movement_size,
+                      chunk_bytes);
+    } else {
+      std::memcpy(dst + dst_offset * movement_size, src + src_offset * movement_size, chunk_bytes);
+    }
   }
+#ifdef __x86_64__
+  // make the non-temporal stores visible to the other threads
+  if (non_temporal) { _mm_sfence(); }
+#endif  // __x86_64__
+}
+
+// The size of the innermost dim, i.e. the stride of the second innermost dim of the extent
+template<size_t num_dims, typename IndexType>
+IndexType GetRowSize(const CopyNdKernelParams<num_dims, IndexType>& params) {
+  if (num_dims == 1) { return params.count; }
+  IndexType index[num_dims]{};
+  index[std::max<int>(static_cast<int>(num_dims) - 2, 0)] = 1;
+  return params.copy_index_helper.NdIndexToOffset(index);
 }
 
 template<size_t num_dims, size_t movement_size, typename IndexType>
 void LaunchKernel(Stream* stream, CopyNdKernelParams<num_dims, IndexType> params) {
-  CopyNdKernel<num_dims, movement_size, IndexType>(params);
+  if (params.count == 0) { return; }
+  const IndexType row_size = GetRowSize(params);
+  const IndexType num_rows = params.count / row_size;
+  const IndexType chunk_size =
+      std::min<IndexType>(row_size, std::max<int64_t>(kMaxChunkBytes / movement_size, 1));
+  const IndexType num_chunks_per_row = (row_size + chunk_size - 1) / chunk_size;
+  const bool non_temporal =
+      static_cast<int64_t>(chunk_size) * movement_size >= kMinNonTemporalRowBytes
+      && static_cast<int64_t>(params.count) * movement_size >= GetNonTemporalCopyThreshold();
+  CpuParallelForRows(
+      static_cast<int64_t>(num_rows) * num_chunks_per_row, chunk_size * movement_size,
+      [&](int64_t begin, int64_t end) {
+        CopyNdKernel<num_dims, movement_size, IndexType>(
+            params, row_size, chunk_size, num_chunks_per_row, non_temporal,
+            static_cast<IndexType>(begin), static_cast<IndexType>(end));
+      });
 }
 
 class CopyNdImpl : public CopyNd {
@@ -0,0 +1,174 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <chrono>
+#include <numeric>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/copy_nd.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+struct CopyNdCase {
+  std::vector<int64_t> dst_dims;
+  std::vector<int64_t> dst_pos;
+  std::vector<int64_t> src_dims;
+  std::vector<int64_t> src_pos;
+  std::vector<int64_t> extent;
+};
+
+int64_t ElemCnt(const std::vector<int64_t>& dims) {
+  return std::accumulate(dims.begin(), dims.end(), int64_t(1), std::multiplies<int64_t>());
+}
+
+std::string DimsToString(const std::vector<int64_t>& dims) {
+  std::string str = "(";
+  for (int64_t dim : dims) { str += std::to_string(dim) + ","; }
+  return str + ")";
+}
+
+template<typename T>
+void CopyNdReference(const CopyNdCase& c, const T* src, T* dst) {
+  const int64_t num_dims = c.extent.size();
+  std::vector<int64_t> index(num_dims, 0);
+  FOR_RANGE(int64_t, i, 0, ElemCnt(c.extent)) {
+    int64_t remaining = i;
+    int64_t src_offset = 0;
+    int64_t dst_offset = 0;
+    for (int64_t d = num_dims - 1; d >= 0; --d) {
+      index[d] = remaining % c.extent[d];
+      remaining /= c.extent[d];
+    }
+    for (int64_t d = 0; d < num_dims; ++d) {
+      src_offset = src_offset * c.src_dims[d] + c.src_pos[d] + index[d];
+      dst_offset = dst_offset * c.dst_dims[d] + c.dst_pos[d] + index[d];
+    }
+    dst[dst_offset] = src[src_offset];
+  }
+}
+
+template<typename T>
+void LaunchCopyNd(Stream* stream, CopyNd* copy_nd, DataType data_type, const CopyNdCase& c,
+                  const T* src, T* dst) {
+  copy_nd->Launch(stream, data_type, c.extent.size(), dst, c.dst_dims.data(), c.dst_pos.data(),
+                  src, c.src_dims.data(), c.src_pos.data(), c.extent.data());
+}
+
+template<typename T>
+void TestCopyNd(DataType data_type, const CopyNdCase& c) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto copy_nd = NewPrimitive<CopyNdFactory>(DeviceType::kCPU, c.extent.size());
+  ASSERT_TRUE(copy_nd);
+  std::vector<T> src(ElemCnt(c.src_dims));
+  FOR_RANGE(size_t, i, 0, src.size()) { src[i] = static_cast<T>(i % 1000); }
+  std::vector<T> dst(ElemCnt(c.dst_dims), static_cast<T>(-1));
+  std::vector<T> expected(dst);
+  LaunchCopyNd<T>(&stream, copy_nd.get(), data_type, c, src.data(), dst.data());
+  CopyNdReference<T>(c, src.data(), expected.data());
+  FOR_RANGE(size_t, i, 0, dst.size()) { ASSERT_EQ(dst[i], expected[i]) << "index: " << i; }
+}
+
+// Split a tensor of `dims` into `num_parts` along `axis`, copy the part `part_id`
+CopyNdCase SplitCase(const std::vector<int64_t>& dims, int64_t axis, int64_t num_parts,
+                     int64_t part_id) {
+  CopyNdCase c;
+  c.src_dims = dims;
+  c.src_pos.assign(dims.size(), 0);
+  c.src_pos[axis] = dims[axis] / num_parts * part_id;
+  c.extent = dims;
+  c.extent[axis] = dims[axis] / num_parts;
+  c.dst_dims = c.extent;
+  c.dst_pos.assign(dims.size(), 0);
+  return c;
+}
+
+}  // namespace
+
+TEST(CpuCopyNd, copy_nd) {
+  TestCopyNd<float>(DataType::kFloat, SplitCase({64, 96}, 0, 4, 1));
+  TestCopyNd<float>(DataType::kFloat, SplitCase({64, 96}, 1, 4, 3));
+  TestCopyNd<int8_t>(DataType::kInt8, SplitCase({3, 7, 13}, 2, 13, 5));
+  TestCopyNd<double>(DataType::kDouble, SplitCase({2, 6, 5, 7}, 1, 3, 2));
+  // copy into the middle of a larger tensor, like slice_update
+  CopyNdCase c;
+  c.dst_dims = {9, 10, 11};
+  c.dst_pos = {2, 3, 1};
+  c.src_dims = {5, 6, 7};
+  c.src_pos = {1, 0, 2};
+  c.extent = {4, 6, 5};
+  TestCopyNd<float>(DataType::kFloat, c);
+  // large enough to use the non-temporal stores
+  TestCopyNd<float>(DataType::kFloat, SplitCase({4096, 2051}, 1, 1, 0));
+  TestCopyNd<float>(DataType::kFloat, SplitCase({4096, 2051}, 0, 1, 0));
+}
+
+TEST(CpuCopyNd, long_rows) {
+  // the rows longer than a chunk are split across the threads of the pool
+  Global<ThreadPool>::New(4);
+  // a contiguous copy, which is a single row
+  TestCopyNd<float>(DataType::kFloat, SplitCase({1 << 20}, 0, 1, 0));
+  TestCopyNd<int8_t>(DataType::kInt8, SplitCase({3 << 18}, 0, 3, 1));
+  // a slice of the first axis, which is contiguous as well
+  TestCopyNd<float>(DataType::kFloat, SplitCase({64, 4099}, 0, 4, 2));
+  // rows of several chunks and a partial one
+  TestCopyNd<float>(DataType::kFloat, SplitCase({5, 70001}, 1, 1, 0));
+  TestCopyNd<double>(DataType::kDouble, SplitCase({3, 2, 50003}, 1, 2, 1));
+  TestCopyNd<float>(DataType::kFloat, SplitCase({7, 3, 40000}, 1, 3, 1));
+  Global<ThreadPool>::Delete();
+}
+
+// not a unit test, run it with --gtest_also_run_disabled_tests
+TEST(CpuCopyNd, DISABLED_benchmark) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  const int64_t iter_num = 10;
+  // the shapes of splitting activations and weights on different axes in slice boxing
+  for (const auto& c : std::vector<CopyNdCase>{
+           SplitCase({4096, 4096}, 0, 4, 1), SplitCase({4096, 4096}, 1, 4, 1),
+           SplitCase({4096, 4096}, 1, 64, 1), SplitCase({32, 256, 56, 56}, 1, 4, 1),
+           SplitCase({32, 256, 56, 56}, 3, 2, 1)}) {
+    auto copy_nd = NewPrimitive<CopyNdFactory>(DeviceType::kCPU, c.extent.size());
+    std::vector<float> src(ElemCnt(c.src_dims), 1.0);
+    std::vector<float> dst(ElemCnt(c.dst_dims));
+    LaunchCopyNd<float>(&stream, copy_nd.get(), DataType::kFloat, c, src.data(), dst.data());
+    auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, iter_num) {
+      LaunchCopyNd<float>(&stream, copy_nd.get(), DataType::kFloat, c, src.data(), dst.data());
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    CopyNdReference<float>(c, src.data(), dst.data());
+    const double reference_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double bytes = static_cast<double>(dst.size() * sizeof(float));
+    LOG(INFO) << "src: " << DimsToString(c.src_dims) << ", extent: " << DimsToString(c.extent)
+              << ", CopyNd GB/s: " << bytes * iter_num / seconds / 1e9
+              << ", element-wise GB/s: " << bytes / reference_seconds / 1e9;
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
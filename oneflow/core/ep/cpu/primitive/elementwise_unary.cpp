@@ -16,6 +16,8 @@ limitations under the License.
 #include "oneflow/core/ep/common/primitive/elementwise_unary.h"
 #include "oneflow/core/ep/cpu/primitive/unary_functor.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/primitive/vectorized_unary.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
 
 namespace oneflow {
 
@@ -24,20 +26,57 @@ namespace primitive {
 
 namespace {
 
+template<UnaryOp unary_op, typename Src, typename Dst>
+void UnaryCpu(size_t n, const Src* src, Dst* dst) {
+  UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src> functor;
+  for (size_t i = 0; i < n; ++i) { dst[i] = functor(src[i]); }
+}
+
+template<typename Src, typename Dst>
+using UnaryCpuFunc = void (*)(size_t n, const Src* src, Dst* dst);
+
+template<UnaryOp unary_op, typename Src, typename Dst>
+struct UnaryCpuFuncSelector {
+  static UnaryCpuFunc<Src, Dst> Select() { return &UnaryCpu<unary_op, Src, Dst>; }
+};
+
+template<UnaryOp unary_op, VectorizedUnaryOp vectorized_op>
+struct VectorizedUnaryCpuFuncSelector {
+  static UnaryCpuFunc<float, float> Select() {
+    const VectorizedUnaryFunc func = GetVectorizedUnaryFunc(vectorized_op);
+    return func != nullptr ? func : &UnaryCpu<unary_op, float, float>;
+  }
+};
+
+template<>
+struct UnaryCpuFuncSelector<UnaryOp::kRelu, float, float>
+    : public VectorizedUnaryCpuFuncSelector<UnaryOp::kRelu, VectorizedUnaryOp::kRelu> {};
+
+template<>
+struct UnaryCpuFuncSelector<UnaryOp::kGelu, float, float>
+    : public VectorizedUnaryCpuFuncSelector<UnaryOp::kGelu, VectorizedUnaryOp::kGelu> {};
+
+template<>
+struct UnaryCpuFuncSelector<UnaryOp::kTanh, float, float>
+    : public VectorizedUnaryCpuFuncSelector<UnaryOp::kTanh, VectorizedUnaryOp::kTanh> {};
+
 template<UnaryOp unary_op, typename Src, typename Dst>
 class ElementwiseUnaryImpl : public ElementwiseUnary {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ElementwiseUnaryImpl);
-  ElementwiseUnaryImpl() = default;
+  ElementwiseUnaryImpl() : unary_func_(UnaryCpuFuncSelector<unary_op, Src, Dst>::Select()) {}
   ~ElementwiseUnaryImpl() override = default;
 
   void Launch(Stream* stream, const void* src_ptr, void* dst_ptr, size_t count) override {
     Dst* dst = reinterpret_cast<Dst*>(dst_ptr);
     const Src* src = reinterpret_cast<const Src*>(src_ptr);
-    for (size_t i = 0; i < count; ++i) {
-      dst[i] = UnaryFunctor<DeviceType::kCPU, unary_op, Dst, Src>()(src[i]);
-    }
+    CpuParallelForRows(count, 1, [&](int64_t begin, int64_t end) {
+      unary_func_(end - begin, src + begin, dst + begin);
+    });
   }
+
+ private:
+  UnaryCpuFunc<Src, Dst> unary_func_;
 };
 
 template<UnaryOp unary_op, typename Src, typename Dst>
@@ -0,0 +1,199 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/primitive/vectorized_unary.h"
+#include "oneflow/core/ep/include/primitive/elementwise_unary.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+struct UnaryCase {
+  std::string name;
+  double (*reference)(double);
+  double low;
+  double high;
+};
+
+double Relu(double x) { return x > 0 ? x : 0; }
+double Gelu(double x) { return 0.5 * x * (1 + std::erf(x * std::sqrt(0.5))); }
+double Tanh(double x) { return std::tanh(x); }
+double Exp(double x) { return std::exp(x); }
+double Log(double x) { return std::log(x); }
+double Sigmoid(double x) { return 1 / (1 + std::exp(-x)); }
+double Erf(double x) { return std::erf(x); }
+
+const std::map<UnaryOp, UnaryCase>& PrimitiveCases() {
+  static const std::map<UnaryOp, UnaryCase> cases{
+      {UnaryOp::kRelu, {"relu", &Relu, -10, 10}},
+      {UnaryOp::kGelu, {"gelu", &Gelu, -10, 10}},
+      {UnaryOp::kTanh, {"tanh", &Tanh, -10, 10}}};
+  return cases;
+}
+
+const std::map<VectorizedUnaryOp, UnaryCase>& VectorizedCases() {
+  static const std::map<VectorizedUnaryOp, UnaryCase> cases{
+      {VectorizedUnaryOp::kRelu, {"relu", &Relu, -10, 10}},
+      {VectorizedUnaryOp::kGelu, {"gelu", &Gelu, -10, 10}},
+      {VectorizedUnaryOp::kTanh, {"tanh", &Tanh, -10, 10}},
+      {VectorizedUnaryOp::kExp, {"exp", &Exp, -100, 100}},
+      {VectorizedUnaryOp::kLog, {"log", &Log, 0, 1e6}},
+      {VectorizedUnaryOp::kSigmoid, {"sigmoid", &Sigmoid, -30, 30}},
+      {VectorizedUnaryOp::kErf, {"erf", &Erf, -5, 5}}};
+  return cases;
+}
+
+template<typename T>
+std::vector<T> RandomVector(size_t n, double low, double high, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> dis(low, high);
+  std::vector<T> vec(n);
+  for (T& v : vec) { v = static_cast<T>(dis(gen)); }
+  return vec;
+}
+
+template<typename T>
+void AssertNear(const UnaryCase& c, const std::vector<T>& x, const std::vector<T>& y) {
+  for (size_t i = 0; i < x.size(); ++i) {
+    const T expected = static_cast<T>(c.reference(x[i]));
+    if (std::isnan(expected)) {
+      ASSERT_TRUE(std::isnan(y[i])) << c.name << "(" << x[i] << ") = " << y[i];
+    } else if (std::isinf(expected)) {
+      ASSERT_EQ(y[i], expected) << c.name << "(" << x[i] << ")";
+    } else {
+      ASSERT_NEAR(y[i], expected, 1e-6 + 2e-6 * std::abs(expected))
+          << c.name << "(" << x[i] << ")";
+    }
+  }
+}
+
+// Cover the tails of 8 lanes and the splitting across threads
+const std::vector<size_t> kTestSizes = {1, 7, 8, 9, 31, 100003};
+
+template<typename T>
+void TestElementwiseUnary(DataType data_type) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  for (const auto& pair : PrimitiveCases()) {
+    auto primitive =
+        NewPrimitive<ElementwiseUnaryFactory>(DeviceType::kCPU, pair.first, data_type, data_type);
+    ASSERT_TRUE(primitive);
+    for (size_t n : kTestSizes) {
+      const std::vector<T> x = RandomVector<T>(n, pair.second.low, pair.second.high, n);
+      std::vector<T> y(n);
+      primitive->Launch(&stream, x.data(), y.data(), n);
+      AssertNear(pair.second, x, y);
+    }
+  }
+}
+
+double Seconds(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+TEST(CpuElementwiseUnary, float_ops) { TestElementwiseUnary<float>(DataType::kFloat); }
+
+TEST(CpuElementwiseUnary, double_ops) { TestElementwiseUnary<double>(DataType::kDouble); }
+
+TEST(CpuElementwiseUnary, vectorized) {
+  const float inf = std::numeric_limits<float>::infinity();
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const std::vector<float> special_values{0.0f,   -0.0f,   1.0f,   -1.0f, 1e-3f, -1e-3f, 1e-40f,
+                                          88.5f,  -100.0f, 100.0f, inf,   -inf,  nan};
+  for (const auto& pair : VectorizedCases()) {
+    const VectorizedUnaryFunc func = GetVectorizedUnaryFunc(pair.first);
+    if (func == nullptr) { continue; }
+    for (size_t n : kTestSizes) {
+      std::vector<float> x = RandomVector<float>(n, pair.second.low, pair.second.high, n);
+      std::vector<float> y(n);
+      func(n, x.data(), y.data());
+      AssertNear(pair.second, x, y);
+    }
+    std::vector<float> y(special_values.size());
+    func(special_values.size(), special_values.data(), y.data());
+    AssertNear(pair.second, special_values, y);
+  }
+}
+
+// not a unit test, run it with --gtest_also_run_disabled_tests
+TEST(CpuElementwiseUnary, DISABLED_benchmark) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  const size_t n = 1 << 20;
+  const int64_t iter_num = 10;
+  for (const auto& pair : PrimitiveCases()) {
+    const UnaryCase& c = pair.second;
+    for (DataType data_type : {DataType::kFloat, DataType::kDouble}) {
+      auto primitive =
+          NewPrimitive<ElementwiseUnaryFactory>(DeviceType::kCPU, pair.first, data_type, data_type);
+      const size_t size = GetSizeOfDataType(data_type);
+      std::vector<char> x(n * size);
+      std::vector<char> y(n * size);
+      if (data_type == DataType::kFloat) {
+        const std::vector<float> values = RandomVector<float>(n, c.low, c.high, 0);
+        std::memcpy(x.data(), values.data(), x.size());
+      } else {
+        const std::vector<double> values = RandomVector<double>(n, c.low, c.high, 0);
+        std::memcpy(x.data(), values.data(), x.size());
+      }
+      primitive->Launch(&stream, x.data(), y.data(), n);
+      const auto start = std::chrono::steady_clock::now();
+      FOR_RANGE(int64_t, i, 0, iter_num) { primitive->Launch(&stream, x.data(), y.data(), n); }
+      LOG(INFO) << "isa: " << static_cast<int>(GetCpuIsa()) << ", primitive " << c.name
+                << ", data type: " << data_type
+                << ", Gelem/s: " << n * iter_num / Seconds(start) / 1e9;
+    }
+  }
+  // the single threaded kernels against the scalar functions of the standard library
+  for (const auto& pair : VectorizedCases()) {
+    const UnaryCase& c = pair.second;
+    const VectorizedUnaryFunc func = GetVectorizedUnaryFunc(pair.first);
+    if (func == nullptr) { continue; }
+    const std::vector<float> x = RandomVector<float>(n, c.low, c.high, 0);
+    std::vector<float> y(n);
+    auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, iter_num) { func(n, x.data(), y.data()); }
+    const double seconds = Seconds(start);
+    start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, iter_num) {
+      for (size_t j = 0; j < n; ++j) { y[j] = static_cast<float>(c.reference(x[j])); }
+    }
+    const double scalar_seconds = Seconds(start);
+    LOG(INFO) << "isa: " << static_cast<int>(GetCpuIsa()) << ", vectorized " << c.name
+              << ", float Gelem/s: " << n * iter_num / seconds / 1e9
+              << ", scalar double Gelem/s: " << n * iter_num / scalar_seconds / 1e9;
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,177 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/primitive/float_convert.h"
+#include <cmath>
+#include <cstring>
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+#include <immintrin.h>
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+float BFloat16ToFloat(uint16_t value) {
+  const uint32_t bits = static_cast<uint32_t>(value) << 16;
+  float result = 0;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+uint16_t FloatToBFloat16(float value) {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  // keep NaN quiet instead of rounding it to inf
+  if (std::isnan(value)) { return static_cast<uint16_t>((bits >> 16) | 0x40); }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+void ConvertToFloatCpu(DataType src_type, size_t n, const void* src, float* dst) {
+  if (src_type == DataType::kFloat16) {
+    const float16* src_ptr = static_cast<const float16*>(src);
+    for (size_t i = 0; i < n; ++i) { dst[i] = static_cast<float>(src_ptr[i]); }
+  } else {
+    const uint16_t* src_ptr = static_cast<const uint16_t*>(src);
+    for (size_t i = 0; i < n; ++i) { dst[i] = BFloat16ToFloat(src_ptr[i]); }
+  }
+}
+
+void ConvertFromFloatCpu(DataType dst_type, size_t n, const float* src, void* dst) {
+  if (dst_type == DataType::kFloat16) {
+    float16* dst_ptr = static_cast<float16*>(dst);
+    for (size_t i = 0; i < n; ++i) { dst_ptr[i] = static_cast<float16>(src[i]); }
+  } else {
+    uint16_t* dst_ptr = static_cast<uint16_t*>(dst);
+    for (size_t i = 0; i < n; ++i) { dst_ptr[i] = FloatToBFloat16(src[i]); }
+  }
+}
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+OF_EP_CPU_TARGET_AVX2 inline __m256 ToFloatAvx2(DataType src_type, const uint16_t* src) {
+  const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  if (src_type == DataType::kFloat16) { return _mm256_cvtph_ps(value); }
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(value), 16));
+}
+
+OF_EP_CPU_TARGET_AVX2 inline void FromFloatAvx2(DataType dst_type, __m256 x, uint16_t* dst) {
+  __m128i value;
+  if (dst_type == DataType::kFloat16) {
+    value = _mm256_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  } else {
+    const __m256i bits = _mm256_castps_si256(x);
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    const __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(0x7fff)), lsb), 16);
+    const __m256i quiet_nan =
+        _mm256_or_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x40));
+    const __m256i nan_mask = _mm256_castps_si256(_mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    const __m256i result = _mm256_blendv_epi8(rounded, quiet_nan, nan_mask);
+    // the 16 bit values are in the lower halves of the qwords 0 and 2 after packing
+    value = _mm256_castsi256_si128(
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(result, result), 0x08));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), value);
+}
+
+// The tails go through a padded block so that they are rounded the same way
+OF_EP_CPU_TARGET_AVX2 void ConvertToFloatAvx2(DataType src_type, size_t n, const void* src,
+                                              float* dst) {
+  const uint16_t* src_ptr = static_cast<const uint16_t*>(src);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) { _mm256_storeu_ps(dst + i, ToFloatAvx2(src_type, src_ptr + i)); }
+  if (i < n) {
+    uint16_t src_block[8]{};
+    float dst_block[8];
+    std::memcpy(src_block, src_ptr + i, (n - i) * sizeof(uint16_t));
+    _mm256_storeu_ps(dst_block, ToFloatAvx2(src_type, src_block));
+    std::memcpy(dst + i, dst_block, (n - i) * sizeof(float));
+  }
+}
+
+OF_EP_CPU_TARGET_AVX2 void ConvertFromFloatAvx2(DataType dst_type, size_t n, const float* src,
+                                                void* dst) {
+  uint16_t* dst_ptr = static_cast<uint16_t*>(dst);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) { FromFloatAvx2(dst_type, _mm256_loadu_ps(src + i), dst_ptr + i); }
+  if (i < n) {
+    float src_block[8]{};
+    uint16_t dst_block[8];
+    std::memcpy(src_block, src + i, (n - i) * sizeof(float));
+    FromFloatAvx2(dst_type, _mm256_loadu_ps(src_block), dst_block);
+    std::memcpy(dst_ptr + i, dst_block, (n - i) * sizeof(uint16_t));
+  }
+}
+
+// The AVX2 kernels convert float16 with F16C
+bool UseAvx2Conversion(DataType data_type) {
+  return GetCpuIsa() >= CpuIsa::kAvx2 && (data_type != DataType::kFloat16 || CpuSupportsF16c());
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+using ConvertToFloatFunc = void (*)(DataType src_type, size_t n, const void* src, float* dst);
+using ConvertFromFloatFunc = void (*)(DataType dst_type, size_t n, const float* src, void* dst);
+
+ConvertToFloatFunc SelectConvertToFloatFunc(DataType src_type) {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  if (UseAvx2Conversion(src_type)) { return &ConvertToFloatAvx2; }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  return &ConvertToFloatCpu;
+}
+
+ConvertFromFloatFunc SelectConvertFromFloatFunc(DataType dst_type) {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  if (UseAvx2Conversion(dst_type)) { return &ConvertFromFloatAvx2; }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  return &ConvertFromFloatCpu;
+}
+
+}  // namespace
+
+void ConvertToFloat(DataType src_type, size_t n, const void* src, float* dst) {
+  CHECK(IsFloatConvertible(src_type));
+  static const ConvertToFloatFunc float16_func = SelectConvertToFloatFunc(DataType::kFloat16);
+  static const ConvertToFloatFunc bfloat16_func = SelectConvertToFloatFunc(DataType::kBFloat16);
+  const ConvertToFloatFunc func = src_type == DataType::kFloat16 ? float16_func : bfloat16_func;
+  const uint16_t* src_ptr = static_cast<const uint16_t*>(src);
+  CpuParallelForRows(n, 1, [&](int64_t begin, int64_t end) {
+    func(src_type, end - begin, src_ptr + begin, dst + begin);
+  });
+}
+
+void ConvertFromFloat(DataType dst_type, size_t n, const float* src, void* dst) {
+  CHECK(IsFloatConvertible(dst_type));
+  static const ConvertFromFloatFunc float16_func = SelectConvertFromFloatFunc(DataType::kFloat16);
+  static const ConvertFromFloatFunc bfloat16_func =
+      SelectConvertFromFloatFunc(DataType::kBFloat16);
+  const ConvertFromFloatFunc func = dst_type == DataType::kFloat16 ? float16_func : bfloat16_func;
+  uint16_t* dst_ptr = static_cast<uint16_t*>(dst);
+  CpuParallelForRows(n, 1, [&](int64_t begin, int64_t end) {
+    func(dst_type, end - begin, src + begin, dst_ptr + begin);
+  });
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
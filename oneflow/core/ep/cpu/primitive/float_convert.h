@@ -0,0 +1,41 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_FLOAT_CONVERT_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_FLOAT_CONVERT_H_
+
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// The reduced precision types computed in float by the CPU primitives
+inline bool IsFloatConvertible(DataType data_type) {
+  return data_type == DataType::kFloat16 || data_type == DataType::kBFloat16;
+}
+
+// Convert n fp16 or bf16 values to float and back, rounding to the nearest even. Large arrays are
+// split across the thread pool.
+void ConvertToFloat(DataType src_type, size_t n, const void* src, float* dst);
+void ConvertFromFloat(DataType dst_type, size_t n, const float* src, void* dst);
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_FLOAT_CONVERT_H_
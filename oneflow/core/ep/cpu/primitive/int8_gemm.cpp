@@ -0,0 +1,312 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/primitive/int8_gemm.h"
+#include <cstring>
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+#include <immintrin.h>
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+// k of a is padded to a multiple of kMaxKGroup, which every kernel reads in whole groups
+constexpr int64_t kMaxKGroup = 4;
+
+// The largest k whose products can not overflow the int32 accumulators
+constexpr int64_t kMaxInt8GemmK = 32768;
+
+// The packed b is made of panels of nr columns. In a panel, every kg consecutive elements of a
+// column are adjacent, so that the kernels multiply them by kg elements of a row of a at once.
+struct Int8GemmLayout {
+  int64_t nr;
+  int64_t kg;
+};
+
+struct Int8GemmParams {
+  int64_t n;
+  int64_t padded_k;
+  // rows of a from a_first_row, which are uint8 or widened by the kernel
+  const void* a;
+  int64_t a_first_row;
+  int64_t lda;
+  const int8_t* b;
+  const int32_t* row_sums;
+  // k * a_zero_point * zero_points[j] - a_zero_point * col_sums[j]
+  const int32_t* col_offsets;
+  const int32_t* zero_points;
+  const float* scales;
+  float* c;
+};
+
+struct ScalarInt8GemmKernel {
+  static constexpr int64_t kNr = 8;
+  static constexpr int64_t kKg = 4;
+  static constexpr int64_t kMr = 4;
+
+  static void PrepareRows(Int8GemmParams* p, int64_t row_begin, int64_t row_end) {}
+
+  template<int64_t rows>
+  static void Tile(const Int8GemmParams& p, int64_t i, int64_t j) {
+    const int8_t* b_panel = p.b + j * p.padded_k;
+    const int64_t cols = std::min(kNr, p.n - j);
+    for (int64_t r = 0; r < rows; ++r) {
+      const uint8_t* a_row = static_cast<const uint8_t*>(p.a) + (i - p.a_first_row + r) * p.lda;
+      int32_t acc[kNr]{};
+      for (int64_t l = 0; l < p.padded_k; ++l) {
+        const int8_t* b_group = b_panel + (l / kKg) * kNr * kKg + l % kKg;
+        for (int64_t col = 0; col < kNr; ++col) {
+          acc[col] += static_cast<int32_t>(a_row[l]) * b_group[col * kKg];
+        }
+      }
+      float* c_row = p.c + (i + r) * p.n + j;
+      for (int64_t col = 0; col < cols; ++col) {
+        const int64_t value = static_cast<int64_t>(acc[col]) + p.col_offsets[j + col]
+                              - static_cast<int64_t>(p.zero_points[j + col]) * p.row_sums[i + r];
+        c_row[col] = static_cast<float>(value) * p.scales[j + col];
+      }
+    }
+  }
+};
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+// vpmaddwd multiplies pairs of int16, the uint8 a and int8 b are widened to avoid the saturation
+// of vpmaddubsw
+struct Avx2Int8GemmKernel {
+  static constexpr int64_t kNr = 8;
+  static constexpr int64_t kKg = 2;
+  static constexpr int64_t kMr = 6;
+
+  // a is widened once for all the panels, then a pair of it is broadcast by one load
+  static void PrepareRows(Int8GemmParams* p, int64_t row_begin, int64_t row_end) {
+    static thread_local std::vector<int16_t> widened_a;
+    const int64_t elem_cnt = (row_end - row_begin) * p->lda;
+    const uint8_t* a = static_cast<const uint8_t*>(p->a) + row_begin * p->lda;
+    widened_a.resize(elem_cnt);
+    for (int64_t i = 0; i < elem_cnt; ++i) { widened_a[i] = a[i]; }
+    p->a = widened_a.data();
+    p->a_first_row = row_begin;
+  }
+
+  template<int64_t rows>
+  OF_EP_CPU_TARGET_AVX2 static void Tile(const Int8GemmParams& p, int64_t i, int64_t j) {
+    const int8_t* b_panel = p.b + j * p.padded_k;
+    const int64_t cols = std::min(kNr, p.n - j);
+    const int16_t* a = static_cast<const int16_t*>(p.a) + (i - p.a_first_row) * p.lda;
+    __m256i acc[rows];
+    for (int64_t r = 0; r < rows; ++r) { acc[r] = _mm256_setzero_si256(); }
+    for (int64_t g = 0; g < p.padded_k / kKg; ++g) {
+      const __m256i b = _mm256_cvtepi8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b_panel + g * kNr * kKg)));
+      for (int64_t r = 0; r < rows; ++r) {
+        int32_t a_pair = 0;
+        std::memcpy(&a_pair, a + r * p.lda + g * kKg, sizeof(int32_t));
+        const __m256i a_value = _mm256_set1_epi32(a_pair);
+        acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(a_value, b));
+      }
+    }
+    const __m256i col_offsets =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.col_offsets + j));
+    const __m256i zero_points =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.zero_points + j));
+    const __m256 scales = _mm256_loadu_ps(p.scales + j);
+    const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(cols),
+                                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    for (int64_t r = 0; r < rows; ++r) {
+      __m256i value = _mm256_add_epi32(acc[r], col_offsets);
+      value = _mm256_sub_epi32(
+          value, _mm256_mullo_epi32(zero_points, _mm256_set1_epi32(p.row_sums[i + r])));
+      const __m256 out = _mm256_mul_ps(_mm256_cvtepi32_ps(value), scales);
+      float* c_row = p.c + (i + r) * p.n + j;
+      if (cols == kNr) {
+        _mm256_storeu_ps(c_row, out);
+      } else {
+        _mm256_maskstore_ps(c_row, mask, out);
+      }
+    }
+  }
+};
+
+// vpdpbusd accumulates the products of 4 uint8 of a and 4 int8 of b into int32 without saturation
+struct Avx512VnniInt8GemmKernel {
+  static constexpr int64_t kNr = 16;
+  static constexpr int64_t kKg = 4;
+  static constexpr int64_t kMr = 8;
+
+  static void PrepareRows(Int8GemmParams* p, int64_t row_begin, int64_t row_end) {}
+
+  template<int64_t rows>
+  OF_EP_CPU_TARGET_AVX512_VNNI static void Tile(const Int8GemmParams& p, int64_t i, int64_t j) {
+    const int8_t* b_panel = p.b + j * p.padded_k;
+    const int64_t cols = std::min(kNr, p.n - j);
+    const uint8_t* a = static_cast<const uint8_t*>(p.a) + (i - p.a_first_row) * p.lda;
+    __m512i acc[rows];
+    for (int64_t r = 0; r < rows; ++r) { acc[r] = _mm512_setzero_si512(); }
+    for (int64_t g = 0; g < p.padded_k / kKg; ++g) {
+      const __m512i b = _mm512_loadu_si512(b_panel + g * kNr * kKg);
+      for (int64_t r = 0; r < rows; ++r) {
+        int32_t a_group = 0;
+        std::memcpy(&a_group, a + r * p.lda + g * kKg, sizeof(int32_t));
+        acc[r] = _mm512_dpbusd_epi32(acc[r], _mm512_set1_epi32(a_group), b);
+      }
+    }
+    const __m512i col_offsets = _mm512_loadu_si512(p.col_offsets + j);
+    const __m512i zero_points = _mm512_loadu_si512(p.zero_points + j);
+    const __m512 scales = _mm512_loadu_ps(p.scales + j);
+    const __mmask16 mask = static_cast<__mmask16>((1U << cols) - 1);
+    for (int64_t r = 0; r < rows; ++r) {
+      __m512i value = _mm512_add_epi32(acc[r], col_offsets);
+      value = _mm512_sub_epi32(
+          value, _mm512_mullo_epi32(zero_points, _mm512_set1_epi32(p.row_sums[i + r])));
+      const __m512 out = _mm512_mul_ps(_mm512_cvtepi32_ps(value), scales);
+      _mm512_mask_storeu_ps(p.c + (i + r) * p.n + j, mask, out);
+    }
+  }
+};
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+// Dispatch the last rows of a panel, which are fewer than Kernel::kMr, to the tile of their number
+template<typename Kernel, int64_t rows>
+struct TailTile {
+  static void Run(int64_t num_rows, const Int8GemmParams& p, int64_t i, int64_t j) {
+    if (num_rows == rows) {
+      Kernel::template Tile<rows>(p, i, j);
+    } else {
+      TailTile<Kernel, rows - 1>::Run(num_rows, p, i, j);
+    }
+  }
+};
+
+template<typename Kernel>
+struct TailTile<Kernel, 0> {
+  static void Run(int64_t num_rows, const Int8GemmParams& p, int64_t i, int64_t j) {}
+};
+
+template<typename Kernel>
+void Int8GemmRows(const Int8GemmParams& params, int64_t row_begin, int64_t row_end) {
+  Int8GemmParams p = params;
+  Kernel::PrepareRows(&p, row_begin, row_end);
+  for (int64_t j = 0; j < p.n; j += Kernel::kNr) {
+    int64_t i = row_begin;
+    for (; i + Kernel::kMr <= row_end; i += Kernel::kMr) {
+      Kernel::template Tile<Kernel::kMr>(p, i, j);
+    }
+    TailTile<Kernel, Kernel::kMr - 1>::Run(row_end - i, p, i, j);
+  }
+}
+
+using Int8GemmRowsFunc = void (*)(const Int8GemmParams& p, int64_t row_begin, int64_t row_end);
+
+template<typename Kernel>
+Int8GemmLayout MakeInt8GemmLayout() {
+  return Int8GemmLayout{Kernel::kNr, Kernel::kKg};
+}
+
+// The layout and kernel of the running CPU, packing and multiplying must agree on them
+void GetInt8GemmKernel(Int8GemmLayout* layout, Int8GemmRowsFunc* rows_func) {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  const CpuIsa isa = GetCpuIsa();
+  if (isa >= CpuIsa::kAvx512Vnni) {
+    *layout = MakeInt8GemmLayout<Avx512VnniInt8GemmKernel>();
+    *rows_func = &Int8GemmRows<Avx512VnniInt8GemmKernel>;
+    return;
+  }
+  if (isa >= CpuIsa::kAvx2) {
+    *layout = MakeInt8GemmLayout<Avx2Int8GemmKernel>();
+    *rows_func = &Int8GemmRows<Avx2Int8GemmKernel>;
+    return;
+  }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  *layout = MakeInt8GemmLayout<ScalarInt8GemmKernel>();
+  *rows_func = &Int8GemmRows<ScalarInt8GemmKernel>;
+}
+
+}  // namespace
+
+void PackInt8GemmB(bool transpose_b, int64_t n, int64_t k, const int8_t* b,
+                   const int32_t* zero_points, Int8GemmPackedB* packed_b) {
+  CHECK_LE(k, kMaxInt8GemmK);
+  Int8GemmLayout layout{};
+  Int8GemmRowsFunc rows_func = nullptr;
+  GetInt8GemmKernel(&layout, &rows_func);
+  const int64_t padded_n = RoundUp(n, layout.nr);
+  const int64_t padded_k = GetInt8GemmLda(k);
+  packed_b->n = n;
+  packed_b->k = k;
+  packed_b->data.assign(padded_n * padded_k, 0);
+  packed_b->col_sums.assign(padded_n, 0);
+  packed_b->zero_points.assign(padded_n, 0);
+  for (int64_t j = 0; j < n; ++j) {
+    int8_t* panel = packed_b->data.data() + (j / layout.nr) * layout.nr * padded_k;
+    const int64_t col = j % layout.nr;
+    int32_t col_sum = 0;
+    for (int64_t l = 0; l < k; ++l) {
+      const int8_t value = transpose_b ? b[j * k + l] : b[l * n + j];
+      panel[(l / layout.kg) * layout.nr * layout.kg + col * layout.kg + l % layout.kg] = value;
+      col_sum += value;
+    }
+    packed_b->col_sums[j] = col_sum;
+    packed_b->zero_points[j] = zero_points[j];
+  }
+}
+
+int64_t GetInt8GemmLda(int64_t k) { return RoundUp(k, kMaxKGroup); }
+
+void Int8Gemm(int64_t m, const uint8_t* a, int32_t a_zero_point, const int32_t* a_row_sums,
+              const Int8GemmPackedB& b, const float* scales, float* c) {
+  Int8GemmLayout layout{};
+  Int8GemmRowsFunc rows_func = nullptr;
+  GetInt8GemmKernel(&layout, &rows_func);
+  const int64_t n = b.n;
+  const int64_t k = b.k;
+  const int64_t padded_n = b.col_sums.size();
+  CHECK_EQ(padded_n, RoundUp(n, layout.nr));
+  static thread_local std::vector<int32_t> col_offsets;
+  static thread_local std::vector<float> padded_scales;
+  col_offsets.resize(padded_n);
+  padded_scales.assign(padded_n, 0);
+  for (int64_t j = 0; j < n; ++j) {
+    col_offsets[j] = k * a_zero_point * b.zero_points[j] - a_zero_point * b.col_sums[j];
+    padded_scales[j] = scales[j];
+  }
+  for (int64_t j = n; j < padded_n; ++j) { col_offsets[j] = 0; }
+  Int8GemmParams params{};
+  params.n = n;
+  params.padded_k = GetInt8GemmLda(k);
+  params.a = a;
+  params.a_first_row = 0;
+  params.lda = GetInt8GemmLda(k);
+  params.b = b.data.data();
+  params.row_sums = a_row_sums;
+  params.col_offsets = col_offsets.data();
+  params.zero_points = b.zero_points.data();
+  params.scales = padded_scales.data();
+  params.c = c;
+  CpuParallelForRows(m, n * k,
+                     [&](int64_t begin, int64_t end) { rows_func(params, begin, end); });
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
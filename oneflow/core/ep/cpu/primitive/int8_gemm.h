@@ -0,0 +1,58 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_INT8_GEMM_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_INT8_GEMM_H_
+
+#include <vector>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// b of an int8 GEMM packed in the layout of the kernel for the running CPU. It is usually the
+// weight of a quantized matmul, which is packed once and multiplied by the activations of many
+// steps.
+struct Int8GemmPackedB {
+  int64_t n = 0;
+  int64_t k = 0;
+  std::vector<int8_t> data;
+  // the sums over k and the zero points of the columns, padded with 0 like the columns of data
+  std::vector<int32_t> col_sums;
+  std::vector<int32_t> zero_points;
+};
+
+// Pack b of k x n, or n x k if transpose_b, whose columns have `zero_points`
+void PackInt8GemmB(bool transpose_b, int64_t n, int64_t k, const int8_t* b,
+                   const int32_t* zero_points, Int8GemmPackedB* packed_b);
+
+// The row size of a in Int8Gemm, the elements after k must be 0
+int64_t GetInt8GemmLda(int64_t k);
+
+// c[i][j] = scales[j] * sum((a[i][l] - a_zero_point) * (b[l][j] - b.zero_points[j])) of uint8 a,
+// whose rows sum to `a_row_sums`, and float c of m x n. The products are accumulated exactly in
+// int32 with the AVX-512 VNNI or AVX2 kernel if the CPU has them, the rows of c are split across
+// threads.
+void Int8Gemm(int64_t m, const uint8_t* a, int32_t a_zero_point, const int32_t* a_row_sums,
+              const Int8GemmPackedB& b, const float* scales, float* c);
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_INT8_GEMM_H_
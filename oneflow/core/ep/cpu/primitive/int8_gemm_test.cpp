@@ -0,0 +1,75 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/ep/cpu/primitive/int8_gemm.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+void TestInt8Gemm(bool transpose_b, int64_t m, int64_t n, int64_t k) {
+  std::vector<int8_t> b(n * k);
+  std::vector<int32_t> b_zero_points(n);
+  FOR_RANGE(size_t, i, 0, b.size()) { b[i] = static_cast<int8_t>((i * 37) % 256 - 128); }
+  FOR_RANGE(int64_t, j, 0, n) { b_zero_points[j] = (j * 11) % 256 - 128; }
+  const int64_t lda = GetInt8GemmLda(k);
+  const int32_t a_zero_point = 131;
+  std::vector<uint8_t> a(m * lda, 0);
+  std::vector<int32_t> a_row_sums(m, 0);
+  FOR_RANGE(int64_t, i, 0, m) {
+    FOR_RANGE(int64_t, l, 0, k) {
+      a[i * lda + l] = static_cast<uint8_t>((i * 29 + l * 53) % 256);
+      a_row_sums[i] += a[i * lda + l];
+    }
+  }
+  std::vector<float> scales(n);
+  FOR_RANGE(int64_t, j, 0, n) { scales[j] = 0.001f * (1 + j % 7); }
+  Int8GemmPackedB packed_b;
+  PackInt8GemmB(transpose_b, n, k, b.data(), b_zero_points.data(), &packed_b);
+  std::vector<float> c(m * n);
+  Int8Gemm(m, a.data(), a_zero_point, a_row_sums.data(), packed_b, scales.data(), c.data());
+  FOR_RANGE(int64_t, i, 0, m) {
+    FOR_RANGE(int64_t, j, 0, n) {
+      int64_t sum = 0;
+      FOR_RANGE(int64_t, l, 0, k) {
+        const int32_t b_value = transpose_b ? b[j * k + l] : b[l * n + j];
+        sum += (a[i * lda + l] - a_zero_point) * (b_value - b_zero_points[j]);
+      }
+      // the int32 accumulation is exact, so is c up to the same rounding of the float product
+      ASSERT_EQ(c[i * n + j], static_cast<float>(sum) * scales[j]);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(CpuInt8Gemm, int8_gemm) {
+  for (const bool transpose_b : {false, true}) {
+    for (const int64_t m : {1, 3, 8, 9, 17}) {
+      for (const int64_t n : {1, 7, 16, 17, 40}) {
+        for (const int64_t k : {1, 3, 4, 5, 67}) { TestInt8Gemm(transpose_b, m, n, k); }
+      }
+    }
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
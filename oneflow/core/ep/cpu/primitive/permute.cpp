@@ -15,6 +15,11 @@ limitations under the License.
 */
 #include "oneflow/core/ep/include/primitive/permute.h"
 #include "oneflow/core/ep/common/primitive/permute_impl.h"
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+#include <immintrin.h>
+#endif
 
 namespace oneflow {
 
@@ -28,11 +33,12 @@ namespace internal {
 namespace {
 
 template<size_t num_dims, size_t movement_size, typename IndexType>
-void PermuteKernel(PermuteKernelParams<num_dims, IndexType> params) {
+void PermuteKernel(PermuteKernelParams<num_dims, IndexType> params, IndexType begin,
+                   IndexType end) {
   using T = typename std::aligned_storage<movement_size, movement_size>::type;
   const T* src = reinterpret_cast<const T*>(params.src);
   T* dst = reinterpret_cast<T*>(params.dst);
-  for (IndexType i = 0; i < params.count; ++i) {
+  for (IndexType i = begin; i < end; ++i) {
     IndexType src_index[num_dims];
     IndexType dst_index[num_dims];
     params.dst_index_helper.OffsetToNdIndex(i, dst_index);
@@ -44,13 +50,203 @@ void PermuteKernel(PermuteKernelParams<num_dims, IndexType> params) {
   }
 }
 
+// The side of the square tiles of the batch transpose, a tile of 16-byte elements is 16KB
+constexpr int64_t kTransposeTileSize = 32;
+
+// Transpose the rows x cols block at `src` into `dst`, the strides are in elements
+template<typename T>
+void TransposeBlock(const T* src, int64_t src_stride, T* dst, int64_t dst_stride, int64_t rows,
+                    int64_t cols) {
+  for (int64_t j = 0; j < cols; ++j) {
+    for (int64_t i = 0; i < rows; ++i) { dst[j * dst_stride + i] = src[i * src_stride + j]; }
+  }
+}
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+// Micro kernels transposing a kBlockSize x kBlockSize block in registers
+template<size_t movement_size>
+struct TransposeMicroKernel;
+
+template<>
+struct TransposeMicroKernel<4> {
+  static constexpr int64_t kBlockSize = 8;
+  OF_EP_CPU_TARGET_AVX2 static void Transpose(const void* src, int64_t src_stride, void* dst,
+                                              int64_t dst_stride) {
+    const float* x = reinterpret_cast<const float*>(src);
+    float* y = reinterpret_cast<float*>(dst);
+    const __m256 r0 = _mm256_loadu_ps(x);
+    const __m256 r1 = _mm256_loadu_ps(x + src_stride);
+    const __m256 r2 = _mm256_loadu_ps(x + 2 * src_stride);
+    const __m256 r3 = _mm256_loadu_ps(x + 3 * src_stride);
+    const __m256 r4 = _mm256_loadu_ps(x + 4 * src_stride);
+    const __m256 r5 = _mm256_loadu_ps(x + 5 * src_stride);
+    const __m256 r6 = _mm256_loadu_ps(x + 6 * src_stride);
+    const __m256 r7 = _mm256_loadu_ps(x + 7 * src_stride);
+    const __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    const __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    const __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    const __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    const __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+    const __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+    const __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+    const __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+    const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    _mm256_storeu_ps(y, _mm256_permute2f128_ps(s0, s4, 0x20));
+    _mm256_storeu_ps(y + dst_stride, _mm256_permute2f128_ps(s1, s5, 0x20));
+    _mm256_storeu_ps(y + 2 * dst_stride, _mm256_permute2f128_ps(s2, s6, 0x20));
+    _mm256_storeu_ps(y + 3 * dst_stride, _mm256_permute2f128_ps(s3, s7, 0x20));
+    _mm256_storeu_ps(y + 4 * dst_stride, _mm256_permute2f128_ps(s0, s4, 0x31));
+    _mm256_storeu_ps(y + 5 * dst_stride, _mm256_permute2f128_ps(s1, s5, 0x31));
+    _mm256_storeu_ps(y + 6 * dst_stride, _mm256_permute2f128_ps(s2, s6, 0x31));
+    _mm256_storeu_ps(y + 7 * dst_stride, _mm256_permute2f128_ps(s3, s7, 0x31));
+  }
+};
+
+template<>
+struct TransposeMicroKernel<8> {
+  static constexpr int64_t kBlockSize = 4;
+  OF_EP_CPU_TARGET_AVX2 static void Transpose(const void* src, int64_t src_stride, void* dst,
+                                              int64_t dst_stride) {
+    const double* x = reinterpret_cast<const double*>(src);
+    double* y = reinterpret_cast<double*>(dst);
+    const __m256d r0 = _mm256_loadu_pd(x);
+    const __m256d r1 = _mm256_loadu_pd(x + src_stride);
+    const __m256d r2 = _mm256_loadu_pd(x + 2 * src_stride);
+    const __m256d r3 = _mm256_loadu_pd(x + 3 * src_stride);
+    const __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+    const __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+    const __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+    const __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(y, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(y + dst_stride, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(y + 2 * dst_stride, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(y + 3 * dst_stride, _mm256_permute2f128_pd(t1, t3, 0x31));
+  }
+};
+
+template<>
+struct TransposeMicroKernel<16> {
+  static constexpr int64_t kBlockSize = 2;
+  OF_EP_CPU_TARGET_AVX2 static void Transpose(const void* src, int64_t src_stride, void* dst,
+                                              int64_t dst_stride) {
+    const __m128i* x = reinterpret_cast<const __m128i*>(src);
+    __m128i* y = reinterpret_cast<__m128i*>(dst);
+    const __m256i r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x));
+    const __m256i r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + src_stride));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(y), _mm256_permute2x128_si256(r0, r1, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + dst_stride),
+                        _mm256_permute2x128_si256(r0, r1, 0x31));
+  }
+};
+
+template<size_t movement_size>
+OF_EP_CPU_TARGET_AVX2 void TransposeBlockAvx2(const void* src, int64_t src_stride, void* dst,
+                                              int64_t dst_stride, int64_t rows, int64_t cols) {
+  using T = typename std::aligned_storage<movement_size, movement_size>::type;
+  using MicroKernel = TransposeMicroKernel<movement_size>;
+  const T* x = reinterpret_cast<const T*>(src);
+  T* y = reinterpret_cast<T*>(dst);
+  const int64_t block_rows = rows / MicroKernel::kBlockSize * MicroKernel::kBlockSize;
+  const int64_t block_cols = cols / MicroKernel::kBlockSize * MicroKernel::kBlockSize;
+  for (int64_t j = 0; j < block_cols; j += MicroKernel::kBlockSize) {
+    for (int64_t i = 0; i < block_rows; i += MicroKernel::kBlockSize) {
+      MicroKernel::Transpose(x + i * src_stride + j, src_stride, y + j * dst_stride + i,
+                             dst_stride);
+    }
+  }
+  TransposeBlock<T>(x + block_cols, src_stride, y + block_cols * dst_stride, dst_stride,
+                    block_rows, cols - block_cols);
+  TransposeBlock<T>(x + block_rows * src_stride, src_stride, y + block_rows, dst_stride,
+                    rows - block_rows, cols);
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+using TransposeBlockFunc = void (*)(const void* src, int64_t src_stride, void* dst,
+                                    int64_t dst_stride, int64_t rows, int64_t cols);
+
+template<size_t movement_size>
+void TransposeBlockScalar(const void* src, int64_t src_stride, void* dst, int64_t dst_stride,
+                          int64_t rows, int64_t cols) {
+  using T = typename std::aligned_storage<movement_size, movement_size>::type;
+  TransposeBlock<T>(reinterpret_cast<const T*>(src), src_stride, reinterpret_cast<T*>(dst),
+                    dst_stride, rows, cols);
+}
+
+// The 1-byte and 2-byte elements have no micro kernels
+template<size_t movement_size>
+TransposeBlockFunc SelectTransposeBlockFunc(std::false_type /*has_micro_kernel*/) {
+  return &TransposeBlockScalar<movement_size>;
+}
+
+template<size_t movement_size>
+TransposeBlockFunc SelectTransposeBlockFunc(std::true_type /*has_micro_kernel*/) {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  if (GetCpuIsa() >= CpuIsa::kAvx2) { return &TransposeBlockAvx2<movement_size>; }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  return &TransposeBlockScalar<movement_size>;
+}
+
+// Transpose the last two dims of a (batch, rows, cols) tensor, tile by tile in parallel
+template<size_t movement_size>
+void LaunchBatchTranspose(int64_t batch, int64_t rows, int64_t cols, const void* src,
+                          void* dst) {
+  static const TransposeBlockFunc transpose_block = SelectTransposeBlockFunc<movement_size>(
+      std::integral_constant<bool, movement_size >= 4>());
+  const int64_t num_tile_rows = (rows + kTransposeTileSize - 1) / kTransposeTileSize;
+  const int64_t num_tile_cols = (cols + kTransposeTileSize - 1) / kTransposeTileSize;
+  const int64_t num_tiles = batch * num_tile_rows * num_tile_cols;
+  const char* src_ptr = reinterpret_cast<const char*>(src);
+  char* dst_ptr = reinterpret_cast<char*>(dst);
+  CpuParallelForRows(num_tiles, kTransposeTileSize * kTransposeTileSize, [&](int64_t begin,
+                                                                             int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const int64_t batch_idx = i / (num_tile_rows * num_tile_cols);
+      const int64_t row = i / num_tile_cols % num_tile_rows * kTransposeTileSize;
+      const int64_t col = i % num_tile_cols * kTransposeTileSize;
+      const int64_t offset = batch_idx * rows * cols;
+      transpose_block(src_ptr + (offset + row * cols + col) * movement_size, cols,
+                      dst_ptr + (offset + col * rows + row) * movement_size, rows,
+                      std::min(kTransposeTileSize, rows - row),
+                      std::min(kTransposeTileSize, cols - col));
+    }
+  });
+}
+
+// The simplified permutation is a 2D transpose or swaps the last two dims, e.g. NCHW <-> NHWC
+bool IsBatchTranspose(size_t num_dims, const int* permutation) {
+  if (num_dims == 2) { return permutation[0] == 1 && permutation[1] == 0; }
+  if (num_dims == 3) {
+    return permutation[0] == 0 && permutation[1] == 2 && permutation[2] == 1;
+  }
+  return false;
+}
+
 template<size_t num_dims, size_t movement_size, typename IndexType>
 void LaunchKernel(Stream* stream, const int64_t* src_dims, const void* src, const int* permutation,
                   void* dst, size_t count) {
+  if (IsBatchTranspose(num_dims, permutation)) {
+    const int64_t batch = num_dims == 3 ? src_dims[0] : 1;
+    LaunchBatchTranspose<movement_size>(batch, src_dims[num_dims - 2], src_dims[num_dims - 1],
+                                        src, dst);
+    return;
+  }
   PermuteKernelParams<num_dims, IndexType> params =
       MakePermuteParams<num_dims, IndexType>(src_dims, src, permutation, dst, count);
-  PermuteKernel<num_dims, movement_size, IndexType>(params);
+  CpuParallelForRows(count, 1, [&](int64_t begin, int64_t end) {
+    PermuteKernel<num_dims, movement_size, IndexType>(params, static_cast<IndexType>(begin),
+                                                      static_cast<IndexType>(end));
+  });
 }
+
 class PermuteImpl : public Permute {
  public:
   OF_DISALLOW_COPY_AND_MOVE(PermuteImpl);
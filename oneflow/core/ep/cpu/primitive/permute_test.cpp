@@ -0,0 +1,100 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/permute.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+template<typename T>
+void PermuteReference(const std::vector<int64_t>& src_dims, const std::vector<int>& permutation,
+                      const T* src, T* dst) {
+  const int64_t num_dims = src_dims.size();
+  std::vector<int64_t> src_strides(num_dims, 1);
+  std::vector<int64_t> dst_strides(num_dims, 1);
+  for (int64_t i = num_dims - 2; i >= 0; --i) {
+    src_strides[i] = src_strides[i + 1] * src_dims[i + 1];
+    dst_strides[i] = dst_strides[i + 1] * src_dims[permutation[i + 1]];
+  }
+  const int64_t count = src_strides[0] * src_dims[0];
+  for (int64_t dst_offset = 0; dst_offset < count; ++dst_offset) {
+    int64_t remaining = dst_offset;
+    int64_t src_offset = 0;
+    for (int64_t i = 0; i < num_dims; ++i) {
+      src_offset += remaining / dst_strides[i] * src_strides[permutation[i]];
+      remaining %= dst_strides[i];
+    }
+    dst[dst_offset] = src[src_offset];
+  }
+}
+
+template<typename T>
+void TestPermute(DataType data_type, const std::vector<int64_t>& src_dims,
+                 const std::vector<int>& permutation) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto primitive = NewPrimitive<PermuteFactory>(DeviceType::kCPU, src_dims.size());
+  ASSERT_TRUE(primitive);
+  int64_t count = 1;
+  for (int64_t dim : src_dims) { count *= dim; }
+  std::vector<T> src(count);
+  for (int64_t i = 0; i < count; ++i) { src[i] = static_cast<T>(i % 1000); }
+  std::vector<T> dst(count);
+  std::vector<T> expected(count);
+  primitive->Launch(&stream, data_type, src_dims.size(), src_dims.data(), src.data(),
+                    permutation.data(), dst.data());
+  PermuteReference<T>(src_dims, permutation, src.data(), expected.data());
+  for (int64_t i = 0; i < count; ++i) { ASSERT_EQ(dst[i], expected[i]) << "index: " << i; }
+}
+
+}  // namespace
+
+TEST(CpuPermute, transpose) {
+  // Cover the partial tiles and the tails of the micro kernels
+  for (int64_t rows : {1, 3, 8, 33, 70}) {
+    for (int64_t cols : {1, 5, 16, 40, 65}) {
+      TestPermute<int8_t>(DataType::kInt8, {rows, cols}, {1, 0});
+      TestPermute<float>(DataType::kFloat, {rows, cols}, {1, 0});
+      TestPermute<double>(DataType::kDouble, {rows, cols}, {1, 0});
+      // 16-byte elements after simplification
+      TestPermute<float>(DataType::kFloat, {rows, cols, 4}, {1, 0, 2});
+    }
+  }
+}
+
+TEST(CpuPermute, batch_transpose) {
+  TestPermute<float>(DataType::kFloat, {3, 37, 45}, {0, 2, 1});
+  TestPermute<double>(DataType::kDouble, {2, 64, 9}, {0, 2, 1});
+  // NCHW -> NHWC and NHWC -> NCHW
+  TestPermute<float>(DataType::kFloat, {2, 5, 7, 9}, {0, 2, 3, 1});
+  TestPermute<float>(DataType::kFloat, {2, 7, 9, 5}, {0, 3, 1, 2});
+}
+
+TEST(CpuPermute, generic) {
+  TestPermute<float>(DataType::kFloat, {2, 5, 7, 9}, {3, 1, 0, 2});
+  TestPermute<int8_t>(DataType::kInt8, {4, 3, 5, 6}, {2, 0, 3, 1});
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
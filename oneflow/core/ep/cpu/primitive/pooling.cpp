@@ -0,0 +1,142 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/include/primitive/pooling.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+#ifdef WITH_ONEDNN
+
+dnnl::algorithm GetOneDnnPoolingAlgorithm(PoolingMode mode) {
+  if (mode == PoolingMode::kMax) {
+    return dnnl::algorithm::pooling_max;
+  } else if (mode == PoolingMode::kAvgIncludePadding) {
+    return dnnl::algorithm::pooling_avg_include_padding;
+  } else if (mode == PoolingMode::kAvgExcludePadding) {
+    return dnnl::algorithm::pooling_avg_exclude_padding;
+  } else {
+    UNIMPLEMENTED();
+    return dnnl::algorithm::pooling_max;
+  }
+}
+
+struct PoolingPrimitive {
+  dnnl::pooling_forward::primitive_desc pd;
+  dnnl::pooling_forward pooling;
+};
+
+class PoolingImpl : public Pooling {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PoolingImpl);
+  PoolingImpl(DataType data_type, const PoolingParams& params)
+      : data_type_(data_type), params_(params) {
+    CHECK_GT(params_.num_spatial_dims, 0);
+    CHECK_EQ(params_.kernel_size.size(), params_.num_spatial_dims);
+    CHECK_EQ(params_.strides.size(), params_.num_spatial_dims);
+    CHECK_EQ(params_.padding_before.size(), params_.num_spatial_dims);
+  }
+  ~PoolingImpl() override = default;
+
+  void Launch(Stream* stream, const int64_t* src_dims, const void* src, const int64_t* dst_dims,
+              void* dst) override {
+    CpuStream* cpu_stream = stream->As<CpuStream>();
+    const size_t num_dims = params_.num_spatial_dims + 2;
+    OneDnnPrimitiveKey key("pooling");
+    key.Append(data_type_)
+        .Append(params_.mode)
+        .Append(params_.channels_last)
+        .Append(params_.kernel_size.data(), params_.num_spatial_dims)
+        .Append(params_.strides.data(), params_.num_spatial_dims)
+        .Append(params_.padding_before.data(), params_.num_spatial_dims)
+        .Append(src_dims, num_dims)
+        .Append(dst_dims, num_dims);
+    auto primitive =
+        cpu_stream->onednn_primitive_cache()->FindOrCreate<PoolingPrimitive>(key, [&]() {
+          const dnnl::memory::data_type data_type = GetOneDnnDataType(data_type_);
+          const dnnl::memory::desc src_desc =
+              MakeOneDnnPlainDesc(num_dims, src_dims, params_.channels_last, data_type);
+          const dnnl::memory::desc dst_desc =
+              MakeOneDnnPlainDesc(num_dims, dst_dims, params_.channels_last, data_type);
+          const dnnl::memory::dims src_logical_dims = src_desc.dims();
+          const dnnl::memory::dims dst_logical_dims = dst_desc.dims();
+          dnnl::memory::dims kernel;
+          dnnl::memory::dims strides;
+          dnnl::memory::dims padding_l;
+          dnnl::memory::dims padding_r;
+          for (size_t i = 0; i < params_.num_spatial_dims; ++i) {
+            kernel.push_back(params_.kernel_size.at(i));
+            strides.push_back(params_.strides.at(i));
+            padding_l.push_back(params_.padding_before.at(i));
+            // the last window of ceil_mode may end in the padding after
+            padding_r.push_back(std::max<dnnl::memory::dim>(
+                (dst_logical_dims.at(i + 2) - 1) * strides.back() + kernel.back()
+                    - src_logical_dims.at(i + 2) - padding_l.back(),
+                0));
+          }
+          auto* pooling = new PoolingPrimitive();
+          pooling->pd = dnnl::pooling_forward::primitive_desc(
+              dnnl::pooling_forward::desc(dnnl::prop_kind::forward_inference,
+                                          GetOneDnnPoolingAlgorithm(params_.mode), src_desc,
+                                          dst_desc, strides, kernel, padding_l, padding_r),
+              *cpu_stream->onednn_engine());
+          pooling->pooling = dnnl::pooling_forward(pooling->pd);
+          return pooling;
+        });
+    const dnnl::engine& engine = *cpu_stream->onednn_engine();
+    dnnl::stream* onednn_stream = cpu_stream->onednn_stream();
+    primitive->pooling.execute(
+        *onednn_stream,
+        {{DNNL_ARG_SRC, dnnl::memory(primitive->pd.src_desc(), engine, const_cast<void*>(src))},
+         {DNNL_ARG_DST, dnnl::memory(primitive->pd.dst_desc(), engine, dst)}});
+    onednn_stream->wait();
+  }
+
+ private:
+  DataType data_type_;
+  PoolingParams params_;
+};
+
+#endif  // WITH_ONEDNN
+
+class PoolingFactoryImpl : public PoolingFactory {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PoolingFactoryImpl);
+  PoolingFactoryImpl() = default;
+  ~PoolingFactoryImpl() override = default;
+
+  std::unique_ptr<Pooling> New(DataType data_type, const PoolingParams& params) override {
+#ifdef WITH_ONEDNN
+    if (data_type == DataType::kFloat && IsOneDnnPrimitiveEnabled()) {
+      return std::unique_ptr<Pooling>(new PoolingImpl(data_type, params));
+    }
+#endif  // WITH_ONEDNN
+    return nullptr;
+  }
+};
+
+REGISTER_PRIMITIVE_FACTORY(DeviceType::kCPU, PoolingFactory, PoolingFactoryImpl);
+
+}  // namespace
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
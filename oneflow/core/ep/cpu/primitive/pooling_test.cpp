@@ -0,0 +1,182 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/include/primitive/pooling.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+#ifdef WITH_ONEDNN
+
+namespace {
+
+// The oneDNN primitives are opt-in, this binary enables them before the first one is created
+const bool kOneDnnPrimitiveEnabled =
+    setenv("ONEFLOW_EP_CPU_ENABLE_ONEDNN_PRIMITIVES", "1", 0) == 0;
+
+// The logical dims (N, C, D, H, W) and their memory order, (N, C, spatial...) or
+// (N, spatial..., C) if channels_last
+struct Layout {
+  Layout(size_t num_spatial_dims, bool channels_last, int64_t n, int64_t c,
+         const std::vector<int64_t>& spatial)
+      : channels_last(channels_last) {
+    logical = {n, c, 1, 1, 1};
+    for (size_t i = 0; i < num_spatial_dims; ++i) {
+      logical[2 + 3 - num_spatial_dims + i] = spatial.at(i);
+    }
+    memory.push_back(n);
+    if (!channels_last) { memory.push_back(c); }
+    memory.insert(memory.end(), spatial.begin(), spatial.begin() + num_spatial_dims);
+    if (channels_last) { memory.push_back(c); }
+  }
+
+  int64_t ElemCnt() const {
+    return logical[0] * logical[1] * logical[2] * logical[3] * logical[4];
+  }
+
+  int64_t Offset(int64_t n, int64_t c, const std::array<int64_t, 3>& s) const {
+    const int64_t spatial = (s[0] * logical[3] + s[1]) * logical[4] + s[2];
+    const int64_t spatial_size = logical[2] * logical[3] * logical[4];
+    if (channels_last) { return (n * spatial_size + spatial) * logical[1] + c; }
+    return (n * logical[1] + c) * spatial_size + spatial;
+  }
+
+  bool channels_last;
+  std::array<int64_t, 5> logical;
+  std::vector<int64_t> memory;
+};
+
+void TestPooling(size_t num_spatial_dims, PoolingMode mode, bool channels_last, int32_t stride,
+                 int32_t padding, bool ceil_mode) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  PoolingParams params;
+  params.num_spatial_dims = num_spatial_dims;
+  params.mode = mode;
+  params.channels_last = channels_last;
+  params.kernel_size.assign(num_spatial_dims, 3);
+  params.strides.assign(num_spatial_dims, stride);
+  params.padding_before.assign(num_spatial_dims, padding);
+  auto pooling = NewPrimitive<PoolingFactory>(DeviceType::kCPU, DataType::kFloat, params);
+  ASSERT_TRUE(pooling);
+  std::vector<int64_t> in_spatial(num_spatial_dims, 8);
+  std::vector<int64_t> out_spatial;
+  for (size_t i = 0; i < num_spatial_dims; ++i) {
+    const int64_t span = in_spatial.at(i) + 2 * padding - 3;
+    out_spatial.push_back((ceil_mode ? (span + stride - 1) / stride : span / stride) + 1);
+  }
+  const Layout in(num_spatial_dims, channels_last, 2, 5, in_spatial);
+  const Layout out(num_spatial_dims, channels_last, 2, 5, out_spatial);
+  std::vector<float> x(in.ElemCnt());
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<float> dis(-1, 1);
+  for (float& v : x) { v = dis(gen); }
+  std::vector<float> y(out.ElemCnt());
+  pooling->Launch(&stream, in.memory.data(), x.data(), out.memory.data(), y.data());
+
+  // the windows of the logical spatial dims, the missing dims are a window of 1
+  std::array<int64_t, 3> kernel{1, 1, 1};
+  std::array<int64_t, 3> strides{1, 1, 1};
+  std::array<int64_t, 3> pad{0, 0, 0};
+  for (size_t i = 0; i < num_spatial_dims; ++i) {
+    kernel[3 - num_spatial_dims + i] = 3;
+    strides[3 - num_spatial_dims + i] = stride;
+    pad[3 - num_spatial_dims + i] = padding;
+  }
+  for (int64_t n = 0; n < out.logical[0]; ++n) {
+    for (int64_t c = 0; c < out.logical[1]; ++c) {
+      std::array<int64_t, 3> o{};
+      for (o[0] = 0; o[0] < out.logical[2]; ++o[0]) {
+        for (o[1] = 0; o[1] < out.logical[3]; ++o[1]) {
+          for (o[2] = 0; o[2] < out.logical[4]; ++o[2]) {
+            double max = -std::numeric_limits<double>::infinity();
+            double sum = 0;
+            int64_t count = 0;
+            // oneDNN pads after as far as the last window of ceil_mode needs, so every window
+            // including the padding is a whole one
+            const int64_t count_include_padding = kernel[0] * kernel[1] * kernel[2];
+            std::array<int64_t, 3> begin{};
+            std::array<int64_t, 3> end{};
+            for (size_t d = 0; d < 3; ++d) {
+              begin[d] = o[d] * strides[d] - pad[d];
+              end[d] = begin[d] + kernel[d];
+            }
+            std::array<int64_t, 3> i{};
+            for (i[0] = std::max<int64_t>(begin[0], 0);
+                 i[0] < std::min(end[0], in.logical[2]); ++i[0]) {
+              for (i[1] = std::max<int64_t>(begin[1], 0);
+                   i[1] < std::min(end[1], in.logical[3]); ++i[1]) {
+                for (i[2] = std::max<int64_t>(begin[2], 0);
+                     i[2] < std::min(end[2], in.logical[4]); ++i[2]) {
+                  const double value = x[in.Offset(n, c, i)];
+                  max = std::max(max, value);
+                  sum += value;
+                  count += 1;
+                }
+              }
+            }
+            double expected = 0;
+            if (mode == PoolingMode::kMax) {
+              expected = max;
+            } else if (mode == PoolingMode::kAvgIncludePadding) {
+              expected = sum / count_include_padding;
+            } else {
+              expected = sum / count;
+            }
+            ASSERT_NEAR(y[out.Offset(n, c, o)], expected, 1e-5)
+                << "num_spatial_dims: " << num_spatial_dims
+                << ", mode: " << static_cast<int>(mode) << ", channels_last: " << channels_last
+                << ", stride: " << stride << ", padding: " << padding
+                << ", ceil_mode: " << ceil_mode;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(CpuPooling, pooling) {
+  for (size_t num_spatial_dims : {1, 2, 3}) {
+    for (PoolingMode mode :
+         {PoolingMode::kMax, PoolingMode::kAvgIncludePadding, PoolingMode::kAvgExcludePadding}) {
+      for (bool channels_last : {false, true}) {
+        for (int32_t stride : {1, 2}) {
+          for (int32_t padding : {0, 1}) {
+            for (bool ceil_mode : {false, true}) {
+              TestPooling(num_spatial_dims, mode, channels_last, stride, padding, ceil_mode);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif  // WITH_ONEDNN
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
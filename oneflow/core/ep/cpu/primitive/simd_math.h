@@ -0,0 +1,251 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_SIMD_MATH_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_SIMD_MATH_H_
+
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+#include <immintrin.h>
+#include <limits>
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace simd {
+
+// exp(x) = 2^n * exp(r), n = round(x / ln2), r = x - n * ln2, exp(r) is approximated by the
+// polynomial of Cephes, the relative error is below 2e-7 for the normal results. NaN is kept.
+constexpr float kExpHi = 88.3762626647949f;
+constexpr float kExpLo = -88.3762626647949f;
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kExpP0 = 1.9875691500e-4f;
+constexpr float kExpP1 = 1.3981999507e-3f;
+constexpr float kExpP2 = 8.3334519073e-3f;
+constexpr float kExpP3 = 4.1665795894e-2f;
+constexpr float kExpP4 = 1.6666665459e-1f;
+constexpr float kExpP5 = 5.0000001201e-1f;
+
+OF_EP_CPU_TARGET_AVX2 inline __m256 Exp(__m256 x) {
+  // min and max return the second operand if any of them is NaN
+  x = _mm256_max_ps(_mm256_set1_ps(kExpLo), _mm256_min_ps(_mm256_set1_ps(kExpHi), x));
+  const __m256 n =
+      _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(kLog2e), _mm256_set1_ps(0.5f)));
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(kLn2Hi), x);
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(kLn2Lo), x);
+  __m256 y = _mm256_set1_ps(kExpP0);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kExpP1));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kExpP2));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kExpP3));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kExpP4));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kExpP5));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+  const __m256i pow2n = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(pow2n));
+}
+
+// log(x) = e * ln2 + log(m), x = 2^e * m, m in [sqrt(0.5), sqrt(2)), log(m) is approximated by the
+// polynomial of Cephes. Denormals are scaled by 2^23 first, NaN is returned for negative and NaN
+// inputs.
+constexpr float kSqrtHalf = 0.707106781186547524f;
+constexpr float kLogP0 = 7.0376836292e-2f;
+constexpr float kLogP1 = -1.1514610310e-1f;
+constexpr float kLogP2 = 1.1676998740e-1f;
+constexpr float kLogP3 = -1.2420140846e-1f;
+constexpr float kLogP4 = 1.4249322787e-1f;
+constexpr float kLogP5 = -1.6668057665e-1f;
+constexpr float kLogP6 = 2.0000714765e-1f;
+constexpr float kLogP7 = -2.4999993993e-1f;
+constexpr float kLogP8 = 3.3333331174e-1f;
+
+OF_EP_CPU_TARGET_AVX2 inline __m256 Log(__m256 x) {
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  const __m256 nan_mask = _mm256_cmp_ps(x, zero, _CMP_NGE_UQ);
+  const __m256 zero_mask = _mm256_cmp_ps(x, zero, _CMP_EQ_OQ);
+  const __m256 inf_mask = _mm256_cmp_ps(x, inf, _CMP_EQ_OQ);
+  const __m256 denormal_mask =
+      _mm256_cmp_ps(x, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ);
+  x = _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)), denormal_mask);
+  const __m256i biased_e = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+  // m in [0.5, 1) and the exponent of it
+  x = _mm256_or_ps(_mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x807fffff))),
+                   _mm256_set1_ps(0.5f));
+  __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(biased_e, _mm256_set1_epi32(126)));
+  e = _mm256_sub_ps(e, _mm256_and_ps(_mm256_set1_ps(23.0f), denormal_mask));
+  const __m256 lt_sqrt_half = _mm256_cmp_ps(x, _mm256_set1_ps(kSqrtHalf), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(one, lt_sqrt_half));
+  x = _mm256_add_ps(_mm256_sub_ps(x, one), _mm256_and_ps(x, lt_sqrt_half));
+  const __m256 z = _mm256_mul_ps(x, x);
+  __m256 y = _mm256_set1_ps(kLogP0);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP1));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP2));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP3));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP4));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP5));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP6));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP7));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP8));
+  y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(kLn2Lo), y);
+  y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+  y = _mm256_fmadd_ps(e, _mm256_set1_ps(kLn2Hi), _mm256_add_ps(x, y));
+  y = _mm256_blendv_ps(y, _mm256_sub_ps(zero, inf), zero_mask);
+  y = _mm256_blendv_ps(y, inf, inf_mask);
+  // all bits set is a NaN
+  return _mm256_or_ps(y, nan_mask);
+}
+
+// tanh(x) = x + x^3 * P(x^2) for |x| < 0.625 by the polynomial of Cephes, otherwise
+// sign(x) * (1 - 2 / (exp(2|x|) + 1))
+constexpr float kTanhSmall = 0.625f;
+constexpr float kTanhP0 = -5.70498872745e-3f;
+constexpr float kTanhP1 = 2.06390887954e-2f;
+constexpr float kTanhP2 = -5.37397155531e-2f;
+constexpr float kTanhP3 = 1.33314422036e-1f;
+constexpr float kTanhP4 = -3.33332819422e-1f;
+
+OF_EP_CPU_TARGET_AVX2 inline __m256 Tanh(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+  const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+  const __m256 exp_2x = Exp(_mm256_add_ps(abs_x, abs_x));
+  __m256 large =
+      _mm256_sub_ps(one, _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(exp_2x, one)));
+  large = _mm256_or_ps(large, _mm256_and_ps(x, sign_mask));
+  const __m256 z = _mm256_mul_ps(x, x);
+  __m256 p = _mm256_set1_ps(kTanhP0);
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kTanhP1));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kTanhP2));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kTanhP3));
+  p = _mm256_fmadd_ps(p, z, _mm256_set1_ps(kTanhP4));
+  const __m256 small = _mm256_fmadd_ps(_mm256_mul_ps(p, z), x, x);
+  return _mm256_blendv_ps(large, small,
+                          _mm256_cmp_ps(abs_x, _mm256_set1_ps(kTanhSmall), _CMP_LT_OQ));
+}
+
+OF_EP_CPU_TARGET_AVX2 inline __m256 Sigmoid(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  return _mm256_div_ps(one, _mm256_add_ps(one, Exp(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+}
+
+// erf(x) is approximated by the Taylor series for |x| < 0.5, otherwise by the formula 7.1.26 of
+// Abramowitz and Stegun, whose absolute error is below 1.5e-7
+constexpr float kErfSmall = 0.5f;
+constexpr float kTwoOverSqrtPi = 1.12837916709551257f;
+constexpr float kErfP = 0.3275911f;
+constexpr float kErfA1 = 0.254829592f;
+constexpr float kErfA2 = -0.284496736f;
+constexpr float kErfA3 = 1.421413741f;
+constexpr float kErfA4 = -1.453152027f;
+constexpr float kErfA5 = 1.061405429f;
+
+OF_EP_CPU_TARGET_AVX2 inline __m256 Erf(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+  const __m256 abs_x = _mm256_andnot_ps(sign_mask, x);
+  const __m256 z = _mm256_mul_ps(x, x);
+  const __m256 t = _mm256_div_ps(one, _mm256_fmadd_ps(_mm256_set1_ps(kErfP), abs_x, one));
+  __m256 p = _mm256_set1_ps(kErfA5);
+  p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(kErfA4));
+  p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(kErfA3));
+  p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(kErfA2));
+  p = _mm256_fmadd_ps(p, t, _mm256_set1_ps(kErfA1));
+  p = _mm256_mul_ps(p, t);
+  __m256 large = _mm256_fnmadd_ps(p, Exp(_mm256_sub_ps(_mm256_setzero_ps(), z)), one);
+  large = _mm256_or_ps(large, _mm256_and_ps(x, sign_mask));
+  // x * (1 - z / 3 + z^2 / 10 - z^3 / 42 + z^4 / 216 - z^5 / 1320) * 2 / sqrt(pi)
+  __m256 s = _mm256_set1_ps(-1.0f / 1320);
+  s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(1.0f / 216));
+  s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(-1.0f / 42));
+  s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(1.0f / 10));
+  s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(-1.0f / 3));
+  s = _mm256_fmadd_ps(s, z, one);
+  const __m256 small = _mm256_mul_ps(_mm256_mul_ps(s, x), _mm256_set1_ps(kTwoOverSqrtPi));
+  return _mm256_blendv_ps(large, small,
+                          _mm256_cmp_ps(abs_x, _mm256_set1_ps(kErfSmall), _CMP_LT_OQ));
+}
+
+OF_EP_CPU_TARGET_AVX2 inline float ReduceMax(__m256 v) {
+  __m128 r = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  r = _mm_max_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_max_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+
+OF_EP_CPU_TARGET_AVX2 inline float ReduceSum(__m256 v) {
+  __m128 r = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+  r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 1));
+  return _mm_cvtss_f32(r);
+}
+
+// Lanes [0, n) of the mask are set, n < 8
+OF_EP_CPU_TARGET_AVX2 inline __m256i TailMask(size_t n) {
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(n)),
+                            _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+OF_EP_CPU_TARGET_AVX512 inline __m512 Exp(__m512 x) {
+  x = _mm512_max_ps(_mm512_set1_ps(kExpLo), _mm512_min_ps(_mm512_set1_ps(kExpHi), x));
+  const __m512 n = _mm512_roundscale_ps(
+      _mm512_fmadd_ps(x, _mm512_set1_ps(kLog2e), _mm512_set1_ps(0.5f)),
+      _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+  x = _mm512_fnmadd_ps(n, _mm512_set1_ps(kLn2Hi), x);
+  x = _mm512_fnmadd_ps(n, _mm512_set1_ps(kLn2Lo), x);
+  __m512 y = _mm512_set1_ps(kExpP0);
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(kExpP1));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(kExpP2));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(kExpP3));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(kExpP4));
+  y = _mm512_fmadd_ps(y, x, _mm512_set1_ps(kExpP5));
+  y = _mm512_fmadd_ps(y, _mm512_mul_ps(x, x), _mm512_add_ps(x, _mm512_set1_ps(1.0f)));
+  const __m512i pow2n = _mm512_slli_epi32(
+      _mm512_add_epi32(_mm512_cvttps_epi32(n), _mm512_set1_epi32(127)), 23);
+  return _mm512_mul_ps(y, _mm512_castsi512_ps(pow2n));
+}
+
+// _mm512_reduce_* trigger -Wmaybe-uninitialized in some versions of GCC
+OF_EP_CPU_TARGET_AVX512 inline float ReduceMax(__m512 v) {
+  const __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+  return ReduceMax(_mm256_max_ps(_mm512_castps512_ps256(v), hi));
+}
+
+OF_EP_CPU_TARGET_AVX512 inline float ReduceSum(__m512 v) {
+  const __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+  return ReduceSum(_mm256_add_ps(_mm512_castps512_ps256(v), hi));
+}
+
+// Lanes [0, n) of the mask are set, n < 16
+inline __mmask16 TailMask16(size_t n) { return static_cast<__mmask16>((1U << n) - 1U); }
+
+}  // namespace simd
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_SIMD_MATH_H_
@@ -16,6 +16,8 @@ limitations under the License.
 #include "oneflow/core/ep/include/primitive/softmax.h"
 #include "oneflow/core/ep/include/primitive/log_softmax.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/primitive/simd_math.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
 
 namespace oneflow {
 
@@ -61,16 +63,184 @@ void SoftmaxCpu(size_t rows, size_t cols, const T* x, T* y) {
   }
 }
 
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+// The exp and the sum of a row are fused in one pass, the tail of a row is handled by masks
+template<Algorithm algorithm>
+OF_EP_CPU_TARGET_AVX2 void SoftmaxCpuAvx2(size_t rows, size_t cols, const float* x, float* y) {
+  constexpr size_t kPackSize = 8;
+  const size_t tail_offset = cols - cols % kPackSize;
+  const __m256i tail_mask = simd::TailMask(cols % kPackSize);
+  const bool has_tail = tail_offset < cols;
+  const __m256 neg_inf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+  for (size_t i = 0; i < rows; ++i) {
+    const float* row_x = x + i * cols;
+    float* row_y = y + i * cols;
+    __m256 max_pack = neg_inf;
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      max_pack = _mm256_max_ps(max_pack, _mm256_loadu_ps(row_x + j));
+    }
+    if (has_tail) {
+      const __m256 tail = _mm256_maskload_ps(row_x + tail_offset, tail_mask);
+      max_pack = _mm256_max_ps(max_pack,
+                               _mm256_blendv_ps(neg_inf, tail, _mm256_castsi256_ps(tail_mask)));
+    }
+    const float row_max = simd::ReduceMax(max_pack);
+    const __m256 row_max_pack = _mm256_set1_ps(row_max);
+    __m256 sum_pack = _mm256_setzero_ps();
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      const __m256 exp_pack = simd::Exp(_mm256_sub_ps(_mm256_loadu_ps(row_x + j), row_max_pack));
+      if (algorithm == Algorithm::kSoftmax) { _mm256_storeu_ps(row_y + j, exp_pack); }
+      sum_pack = _mm256_add_ps(sum_pack, exp_pack);
+    }
+    if (has_tail) {
+      const __m256 tail = _mm256_maskload_ps(row_x + tail_offset, tail_mask);
+      const __m256 exp_pack = _mm256_and_ps(simd::Exp(_mm256_sub_ps(tail, row_max_pack)),
+                                            _mm256_castsi256_ps(tail_mask));
+      if (algorithm == Algorithm::kSoftmax) {
+        _mm256_maskstore_ps(row_y + tail_offset, tail_mask, exp_pack);
+      }
+      sum_pack = _mm256_add_ps(sum_pack, exp_pack);
+    }
+    const float row_sum = simd::ReduceSum(sum_pack);
+    if (algorithm == Algorithm::kSoftmax) {
+      const __m256 scale = _mm256_set1_ps(1.0f / row_sum);
+      for (size_t j = 0; j < tail_offset; j += kPackSize) {
+        _mm256_storeu_ps(row_y + j, _mm256_mul_ps(_mm256_loadu_ps(row_y + j), scale));
+      }
+      if (has_tail) {
+        _mm256_maskstore_ps(
+            row_y + tail_offset, tail_mask,
+            _mm256_mul_ps(_mm256_maskload_ps(row_y + tail_offset, tail_mask), scale));
+      }
+    } else if (algorithm == Algorithm::kLogSoftmax) {
+      const __m256 shift = _mm256_set1_ps(row_max + std::log(row_sum));
+      for (size_t j = 0; j < tail_offset; j += kPackSize) {
+        _mm256_storeu_ps(row_y + j, _mm256_sub_ps(_mm256_loadu_ps(row_x + j), shift));
+      }
+      if (has_tail) {
+        _mm256_maskstore_ps(
+            row_y + tail_offset, tail_mask,
+            _mm256_sub_ps(_mm256_maskload_ps(row_x + tail_offset, tail_mask), shift));
+      }
+    } else {
+      UNIMPLEMENTED();
+    }
+  }
+}
+
+// GCC 12 gives false maybe-uninitialized positives inside the inlined avx512 intrinsics,
+// https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif  // defined(__GNUC__) && !defined(__clang__)
+
+template<Algorithm algorithm>
+OF_EP_CPU_TARGET_AVX512 void SoftmaxCpuAvx512(size_t rows, size_t cols, const float* x,
+                                              float* y) {
+  constexpr size_t kPackSize = 16;
+  const size_t tail_offset = cols - cols % kPackSize;
+  const __mmask16 tail_mask = simd::TailMask16(cols % kPackSize);
+  const bool has_tail = tail_offset < cols;
+  const __m512 neg_inf = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+  for (size_t i = 0; i < rows; ++i) {
+    const float* row_x = x + i * cols;
+    float* row_y = y + i * cols;
+    __m512 max_pack = neg_inf;
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      max_pack = _mm512_max_ps(max_pack, _mm512_loadu_ps(row_x + j));
+    }
+    if (has_tail) {
+      max_pack =
+          _mm512_max_ps(max_pack, _mm512_mask_loadu_ps(neg_inf, tail_mask, row_x + tail_offset));
+    }
+    const float row_max = simd::ReduceMax(max_pack);
+    const __m512 row_max_pack = _mm512_set1_ps(row_max);
+    __m512 sum_pack = _mm512_setzero_ps();
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      const __m512 exp_pack = simd::Exp(_mm512_sub_ps(_mm512_loadu_ps(row_x + j), row_max_pack));
+      if (algorithm == Algorithm::kSoftmax) { _mm512_storeu_ps(row_y + j, exp_pack); }
+      sum_pack = _mm512_add_ps(sum_pack, exp_pack);
+    }
+    if (has_tail) {
+      const __m512 exp_pack = simd::Exp(
+          _mm512_sub_ps(_mm512_maskz_loadu_ps(tail_mask, row_x + tail_offset), row_max_pack));
+      if (algorithm == Algorithm::kSoftmax) {
+        _mm512_mask_storeu_ps(row_y + tail_offset, tail_mask, exp_pack);
+      }
+      sum_pack = _mm512_mask_add_ps(sum_pack, tail_mask, sum_pack, exp_pack);
+    }
+    const float row_sum = simd::ReduceSum(sum_pack);
+    if (algorithm == Algorithm::kSoftmax) {
+      const __m512 scale = _mm512_set1_ps(1.0f / row_sum);
+      for (size_t j = 0; j < tail_offset; j += kPackSize) {
+        _mm512_storeu_ps(row_y + j, _mm512_mul_ps(_mm512_loadu_ps(row_y + j), scale));
+      }
+      if (has_tail) {
+        _mm512_mask_storeu_ps(
+            row_y + tail_offset, tail_mask,
+            _mm512_mul_ps(_mm512_maskz_loadu_ps(tail_mask, row_y + tail_offset), scale));
+      }
+    } else if (algorithm == Algorithm::kLogSoftmax) {
+      const __m512 shift = _mm512_set1_ps(row_max + std::log(row_sum));
+      for (size_t j = 0; j < tail_offset; j += kPackSize) {
+        _mm512_storeu_ps(row_y + j, _mm512_sub_ps(_mm512_loadu_ps(row_x + j), shift));
+      }
+      if (has_tail) {
+        _mm512_mask_storeu_ps(
+            row_y + tail_offset, tail_mask,
+            _mm512_sub_ps(_mm512_maskz_loadu_ps(tail_mask, row_x + tail_offset), shift));
+      }
+    } else {
+      UNIMPLEMENTED();
+    }
+  }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif  // defined(__GNUC__) && !defined(__clang__)
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+template<typename T>
+using SoftmaxCpuFunc = void (*)(size_t rows, size_t cols, const T* x, T* y);
+
+template<Algorithm algorithm, typename T>
+struct SoftmaxCpuFuncSelector {
+  static SoftmaxCpuFunc<T> Select() { return &SoftmaxCpu<algorithm, T>; }
+};
+
+template<Algorithm algorithm>
+struct SoftmaxCpuFuncSelector<algorithm, float> {
+  static SoftmaxCpuFunc<float> Select() {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+    const CpuIsa isa = GetCpuIsa();
+    if (isa >= CpuIsa::kAvx512) { return &SoftmaxCpuAvx512<algorithm>; }
+    if (isa >= CpuIsa::kAvx2) { return &SoftmaxCpuAvx2<algorithm>; }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+    return &SoftmaxCpu<algorithm, float>;
+  }
+};
+
 template<typename SoftmaxBase, Algorithm algorithm, typename T>
 class SoftmaxImpl : public SoftmaxBase {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SoftmaxImpl);
-  SoftmaxImpl() = default;
+  SoftmaxImpl() : softmax_func_(SoftmaxCpuFuncSelector<algorithm, T>::Select()) {}
   ~SoftmaxImpl() override = default;
 
   void Launch(Stream* stream, size_t rows, size_t cols, const void* x, void* y) override {
-    SoftmaxCpu<algorithm, T>(rows, cols, reinterpret_cast<const T*>(x), reinterpret_cast<T*>(y));
+    const T* x_ptr = reinterpret_cast<const T*>(x);
+    T* y_ptr = reinterpret_cast<T*>(y);
+    CpuParallelForRows(rows, cols, [&](int64_t begin, int64_t end) {
+      softmax_func_(end - begin, cols, x_ptr + begin * cols, y_ptr + begin * cols);
+    });
   }
+
+ private:
+  SoftmaxCpuFunc<T> softmax_func_;
 };
 
 template<typename SoftmaxBase, Algorithm algorithm, typename T>
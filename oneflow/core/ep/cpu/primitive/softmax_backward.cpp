@@ -16,6 +16,8 @@ limitations under the License.
 #include "oneflow/core/ep/include/primitive/softmax_backward.h"
 #include "oneflow/core/ep/include/primitive/log_softmax_backward.h"
 #include "oneflow/core/ep/cpu/primitive/type_seq.h"
+#include "oneflow/core/ep/cpu/primitive/simd_math.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
 
 namespace oneflow {
 
@@ -58,18 +60,186 @@ void SoftmaxBackwardCpu(size_t rows, size_t cols, const T* y, const T* dy, T* dx
   }
 }
 
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+// Lambdas do not inherit the target attributes, so dx of a pack is computed by the functions below
+template<Algorithm algorithm>
+OF_EP_CPU_TARGET_AVX2 inline __m256 SoftmaxBackwardDx(__m256 y, __m256 dy, __m256 row_sum) {
+  if (algorithm == Algorithm::kSoftmax) {
+    return _mm256_mul_ps(_mm256_sub_ps(dy, row_sum), y);
+  } else if (algorithm == Algorithm::kLogSoftmax) {
+    return _mm256_fnmadd_ps(simd::Exp(y), row_sum, dy);
+  } else {
+    UNIMPLEMENTED();
+  }
+  return dy;
+}
+
+template<Algorithm algorithm>
+OF_EP_CPU_TARGET_AVX512 inline __m512 SoftmaxBackwardDx(__m512 y, __m512 dy, __m512 row_sum) {
+  if (algorithm == Algorithm::kSoftmax) {
+    return _mm512_mul_ps(_mm512_sub_ps(dy, row_sum), y);
+  } else if (algorithm == Algorithm::kLogSoftmax) {
+    return _mm512_fnmadd_ps(simd::Exp(y), row_sum, dy);
+  } else {
+    UNIMPLEMENTED();
+  }
+  return dy;
+}
+
+template<Algorithm algorithm>
+OF_EP_CPU_TARGET_AVX2 void SoftmaxBackwardCpuAvx2(size_t rows, size_t cols, const float* y,
+                                                  const float* dy, float* dx) {
+  constexpr size_t kPackSize = 8;
+  const size_t tail_offset = cols - cols % kPackSize;
+  const __m256i tail_mask = simd::TailMask(cols % kPackSize);
+  const bool has_tail = tail_offset < cols;
+  for (size_t i = 0; i < rows; ++i) {
+    const size_t row_offset = i * cols;
+    const float* row_y = y + row_offset;
+    const float* row_dy = dy + row_offset;
+    float* row_dx = dx + row_offset;
+    __m256 sum_pack = _mm256_setzero_ps();
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      if (algorithm == Algorithm::kSoftmax) {
+        sum_pack = _mm256_fmadd_ps(_mm256_loadu_ps(row_y + j), _mm256_loadu_ps(row_dy + j),
+                                   sum_pack);
+      } else if (algorithm == Algorithm::kLogSoftmax) {
+        sum_pack = _mm256_add_ps(sum_pack, _mm256_loadu_ps(row_dy + j));
+      } else {
+        UNIMPLEMENTED();
+      }
+    }
+    if (has_tail) {
+      // the masked out lanes are loaded as zeros
+      const __m256 tail_dy = _mm256_maskload_ps(row_dy + tail_offset, tail_mask);
+      if (algorithm == Algorithm::kSoftmax) {
+        sum_pack = _mm256_fmadd_ps(_mm256_maskload_ps(row_y + tail_offset, tail_mask), tail_dy,
+                                   sum_pack);
+      } else if (algorithm == Algorithm::kLogSoftmax) {
+        sum_pack = _mm256_add_ps(sum_pack, tail_dy);
+      } else {
+        UNIMPLEMENTED();
+      }
+    }
+    const __m256 row_sum = _mm256_set1_ps(simd::ReduceSum(sum_pack));
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      _mm256_storeu_ps(row_dx + j, SoftmaxBackwardDx<algorithm>(_mm256_loadu_ps(row_y + j),
+                                                                _mm256_loadu_ps(row_dy + j),
+                                                                row_sum));
+    }
+    if (has_tail) {
+      _mm256_maskstore_ps(row_dx + tail_offset, tail_mask,
+                          SoftmaxBackwardDx<algorithm>(
+                              _mm256_maskload_ps(row_y + tail_offset, tail_mask),
+                              _mm256_maskload_ps(row_dy + tail_offset, tail_mask), row_sum));
+    }
+  }
+}
+
+// GCC 12 gives false maybe-uninitialized positives inside the inlined avx512 intrinsics,
+// https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif  // defined(__GNUC__) && !defined(__clang__)
+
+template<Algorithm algorithm>
+OF_EP_CPU_TARGET_AVX512 void SoftmaxBackwardCpuAvx512(size_t rows, size_t cols, const float* y,
+                                                      const float* dy, float* dx) {
+  constexpr size_t kPackSize = 16;
+  const size_t tail_offset = cols - cols % kPackSize;
+  const __mmask16 tail_mask = simd::TailMask16(cols % kPackSize);
+  const bool has_tail = tail_offset < cols;
+  for (size_t i = 0; i < rows; ++i) {
+    const size_t row_offset = i * cols;
+    const float* row_y = y + row_offset;
+    const float* row_dy = dy + row_offset;
+    float* row_dx = dx + row_offset;
+    __m512 sum_pack = _mm512_setzero_ps();
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      if (algorithm == Algorithm::kSoftmax) {
+        sum_pack = _mm512_fmadd_ps(_mm512_loadu_ps(row_y + j), _mm512_loadu_ps(row_dy + j),
+                                   sum_pack);
+      } else if (algorithm == Algorithm::kLogSoftmax) {
+        sum_pack = _mm512_add_ps(sum_pack, _mm512_loadu_ps(row_dy + j));
+      } else {
+        UNIMPLEMENTED();
+      }
+    }
+    if (has_tail) {
+      const __m512 tail_dy = _mm512_maskz_loadu_ps(tail_mask, row_dy + tail_offset);
+      if (algorithm == Algorithm::kSoftmax) {
+        sum_pack = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tail_mask, row_y + tail_offset), tail_dy,
+                                   sum_pack);
+      } else if (algorithm == Algorithm::kLogSoftmax) {
+        sum_pack = _mm512_add_ps(sum_pack, tail_dy);
+      } else {
+        UNIMPLEMENTED();
+      }
+    }
+    const __m512 row_sum = _mm512_set1_ps(simd::ReduceSum(sum_pack));
+    for (size_t j = 0; j < tail_offset; j += kPackSize) {
+      _mm512_storeu_ps(row_dx + j, SoftmaxBackwardDx<algorithm>(_mm512_loadu_ps(row_y + j),
+                                                                _mm512_loadu_ps(row_dy + j),
+                                                                row_sum));
+    }
+    if (has_tail) {
+      _mm512_mask_storeu_ps(row_dx + tail_offset, tail_mask,
+                            SoftmaxBackwardDx<algorithm>(
+                                _mm512_maskz_loadu_ps(tail_mask, row_y + tail_offset),
+                                _mm512_maskz_loadu_ps(tail_mask, row_dy + tail_offset), row_sum));
+    }
+  }
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif  // defined(__GNUC__) && !defined(__clang__)
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+template<typename T>
+using SoftmaxBackwardCpuFunc = void (*)(size_t rows, size_t cols, const T* y, const T* dy, T* dx);
+
+template<Algorithm algorithm, typename T>
+struct SoftmaxBackwardCpuFuncSelector {
+  static SoftmaxBackwardCpuFunc<T> Select() { return &SoftmaxBackwardCpu<algorithm, T>; }
+};
+
+template<Algorithm algorithm>
+struct SoftmaxBackwardCpuFuncSelector<algorithm, float> {
+  static SoftmaxBackwardCpuFunc<float> Select() {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+    const CpuIsa isa = GetCpuIsa();
+    if (isa >= CpuIsa::kAvx512) { return &SoftmaxBackwardCpuAvx512<algorithm>; }
+    if (isa >= CpuIsa::kAvx2) { return &SoftmaxBackwardCpuAvx2<algorithm>; }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+    return &SoftmaxBackwardCpu<algorithm, float>;
+  }
+};
+
 template<typename SoftmaxBackwardBase, Algorithm algorithm, typename T>
 class SoftmaxBackwardImpl : public SoftmaxBackwardBase {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SoftmaxBackwardImpl);
-  SoftmaxBackwardImpl() = default;
+  SoftmaxBackwardImpl()
+      : softmax_backward_func_(SoftmaxBackwardCpuFuncSelector<algorithm, T>::Select()) {}
   ~SoftmaxBackwardImpl() override = default;
 
   void Launch(Stream* stream, size_t rows, size_t cols, const void* y, const void* dy,
               void* dx) override {
-    SoftmaxBackwardCpu<algorithm, T>(rows, cols, reinterpret_cast<const T*>(y),
-                                     reinterpret_cast<const T*>(dy), reinterpret_cast<T*>(dx));
+    const T* y_ptr = reinterpret_cast<const T*>(y);
+    const T* dy_ptr = reinterpret_cast<const T*>(dy);
+    T* dx_ptr = reinterpret_cast<T*>(dx);
+    CpuParallelForRows(rows, cols, [&](int64_t begin, int64_t end) {
+      const size_t offset = begin * cols;
+      softmax_backward_func_(end - begin, cols, y_ptr + offset, dy_ptr + offset, dx_ptr + offset);
+    });
   }
+
+ private:
+  SoftmaxBackwardCpuFunc<T> softmax_backward_func_;
 };
 
 template<typename SoftmaxBackwardBase, Algorithm algorithm, typename T>
@@ -0,0 +1,187 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include "oneflow/core/ep/cpu/cpu_device.h"
+#include "oneflow/core/ep/cpu/cpu_stream.h"
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/include/primitive/softmax.h"
+#include "oneflow/core/ep/include/primitive/log_softmax.h"
+#include "oneflow/core/ep/include/primitive/softmax_backward.h"
+#include "oneflow/core/ep/include/primitive/log_softmax_backward.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+std::vector<float> RandomVector(size_t n, float scale, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dis(-scale, scale);
+  std::vector<float> vec(n);
+  for (float& v : vec) { v = dis(gen); }
+  return vec;
+}
+
+void SoftmaxReference(size_t rows, size_t cols, const float* x, bool is_log, float* y) {
+  for (size_t i = 0; i < rows; ++i) {
+    const float* row_x = x + i * cols;
+    double max = row_x[0];
+    for (size_t j = 1; j < cols; ++j) { max = std::max<double>(max, row_x[j]); }
+    double sum = 0;
+    for (size_t j = 0; j < cols; ++j) { sum += std::exp(row_x[j] - max); }
+    for (size_t j = 0; j < cols; ++j) {
+      y[i * cols + j] = is_log ? row_x[j] - max - std::log(sum) : std::exp(row_x[j] - max) / sum;
+    }
+  }
+}
+
+void SoftmaxBackwardReference(size_t rows, size_t cols, const float* y, const float* dy,
+                              bool is_log, float* dx) {
+  for (size_t i = 0; i < rows; ++i) {
+    double sum = 0;
+    for (size_t j = 0; j < cols; ++j) {
+      sum += is_log ? dy[i * cols + j] : y[i * cols + j] * dy[i * cols + j];
+    }
+    for (size_t j = 0; j < cols; ++j) {
+      const size_t k = i * cols + j;
+      dx[k] = is_log ? dy[k] - std::exp(y[k]) * sum : (dy[k] - sum) * y[k];
+    }
+  }
+}
+
+void AssertNear(const std::vector<float>& out, const std::vector<float>& expected) {
+  ASSERT_EQ(out.size(), expected.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    ASSERT_NEAR(out[i], expected[i], 1e-5 + 1e-4 * std::abs(expected[i])) << "index: " << i;
+  }
+}
+
+// Cover the tails of AVX2 (8) and AVX-512 (16) lanes
+const std::vector<std::pair<size_t, size_t>> kTestShapes = {
+    {1, 1}, {3, 7}, {5, 8}, {4, 15}, {2, 16}, {7, 33}, {64, 100}, {3, 1025}};
+
+// The instruction sets which the running CPU supports, the kernels of each are tested
+std::vector<CpuIsa> SupportedCpuIsas() {
+  std::vector<CpuIsa> isas;
+  for (CpuIsa isa : {CpuIsa::kScalar, CpuIsa::kAvx2, CpuIsa::kAvx512, CpuIsa::kAvx512Vnni}) {
+    if (isa <= GetSupportedCpuIsa()) { isas.push_back(isa); }
+  }
+  return isas;
+}
+
+template<typename FactoryType>
+void TestForward(CpuIsa isa, bool is_log) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  CpuIsaGuard isa_guard(isa);
+  auto primitive = NewPrimitive<FactoryType>(DeviceType::kCPU, DataType::kFloat);
+  ASSERT_TRUE(primitive);
+  for (const auto& shape : kTestShapes) {
+    const size_t rows = shape.first;
+    const size_t cols = shape.second;
+    const std::vector<float> x = RandomVector(rows * cols, 20, 0);
+    std::vector<float> y(rows * cols);
+    std::vector<float> expected(rows * cols);
+    primitive->Launch(&stream, rows, cols, x.data(), y.data());
+    SoftmaxReference(rows, cols, x.data(), is_log, expected.data());
+    SCOPED_TRACE("isa: " + std::to_string(static_cast<int>(isa)));
+    AssertNear(y, expected);
+  }
+}
+
+template<typename FactoryType>
+void TestBackward(CpuIsa isa, bool is_log) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  CpuIsaGuard isa_guard(isa);
+  auto primitive = NewPrimitive<FactoryType>(DeviceType::kCPU, DataType::kFloat);
+  ASSERT_TRUE(primitive);
+  for (const auto& shape : kTestShapes) {
+    const size_t rows = shape.first;
+    const size_t cols = shape.second;
+    std::vector<float> y(rows * cols);
+    SoftmaxReference(rows, cols, RandomVector(rows * cols, 5, 1).data(), is_log, y.data());
+    const std::vector<float> dy = RandomVector(rows * cols, 1, 2);
+    std::vector<float> dx(rows * cols);
+    std::vector<float> expected(rows * cols);
+    primitive->Launch(&stream, rows, cols, y.data(), dy.data(), dx.data());
+    SoftmaxBackwardReference(rows, cols, y.data(), dy.data(), is_log, expected.data());
+    SCOPED_TRACE("isa: " + std::to_string(static_cast<int>(isa)));
+    AssertNear(dx, expected);
+  }
+}
+
+}  // namespace
+
+TEST(CpuSoftmax, softmax) {
+  for (CpuIsa isa : SupportedCpuIsas()) { TestForward<SoftmaxFactory>(isa, false); }
+}
+
+TEST(CpuSoftmax, log_softmax) {
+  for (CpuIsa isa : SupportedCpuIsas()) { TestForward<LogSoftmaxFactory>(isa, true); }
+}
+
+TEST(CpuSoftmax, softmax_backward) {
+  for (CpuIsa isa : SupportedCpuIsas()) { TestBackward<SoftmaxBackwardFactory>(isa, false); }
+}
+
+TEST(CpuSoftmax, log_softmax_backward) {
+  for (CpuIsa isa : SupportedCpuIsas()) { TestBackward<LogSoftmaxBackwardFactory>(isa, true); }
+}
+
+// not a unit test, run it with --gtest_also_run_disabled_tests
+TEST(CpuSoftmax, DISABLED_benchmark) {
+  CpuDevice device(nullptr);
+  CpuStream stream(&device);
+  auto softmax = NewPrimitive<SoftmaxFactory>(DeviceType::kCPU, DataType::kFloat);
+  // the double one always runs the scalar kernel
+  auto scalar_softmax = NewPrimitive<SoftmaxFactory>(DeviceType::kCPU, DataType::kDouble);
+  const int64_t iter_num = 20;
+  for (const auto& shape : std::vector<std::pair<size_t, size_t>>{
+           {4096, 128}, {1024, 1024}, {128, 8192}, {32, 30522}}) {
+    const size_t rows = shape.first;
+    const size_t cols = shape.second;
+    const std::vector<float> x = RandomVector(rows * cols, 10, 0);
+    std::vector<float> y(rows * cols);
+    const std::vector<double> x_double(x.begin(), x.end());
+    std::vector<double> y_double(rows * cols);
+    auto start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, iter_num) {
+      softmax->Launch(&stream, rows, cols, x.data(), y.data());
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    FOR_RANGE(int64_t, i, 0, iter_num) {
+      scalar_softmax->Launch(&stream, rows, cols, x_double.data(), y_double.data());
+    }
+    const double scalar_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double elem_num = static_cast<double>(rows * cols * iter_num);
+    LOG(INFO) << "isa: " << static_cast<int>(GetCpuIsa()) << ", shape: (" << rows << ", " << cols
+              << "), float Gelem/s: " << elem_num / seconds / 1e9
+              << ", scalar double Gelem/s: " << elem_num / scalar_seconds / 1e9;
+  }
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
@@ -0,0 +1,122 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ep/cpu/primitive/vectorized_unary.h"
+#include "oneflow/core/ep/cpu/primitive/simd_math.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+namespace {
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+template<VectorizedUnaryOp op>
+struct Avx2UnaryFunctor;
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kRelu> {
+  // NaN is mapped to 0 like the scalar functor
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) {
+    return _mm256_max_ps(x, _mm256_setzero_ps());
+  }
+};
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kGelu> {
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) {
+    const __m256 half_x = _mm256_mul_ps(x, _mm256_set1_ps(0.5f));
+    const __m256 erf = simd::Erf(_mm256_mul_ps(x, _mm256_set1_ps(0.707106781186547524f)));
+    return _mm256_fmadd_ps(half_x, erf, half_x);
+  }
+};
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kTanh> {
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) { return simd::Tanh(x); }
+};
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kExp> {
+  // simd::Exp clamps the input below the overflow threshold, above it
+  // exp(x) = exp(x - kLn2Hi) * exp(kLn2Hi), where x - kLn2Hi is exact, so the results up to FLT_MAX
+  // are accurate and the larger ones overflow to inf
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) {
+    const __m256 large =
+        _mm256_mul_ps(simd::Exp(_mm256_sub_ps(x, _mm256_set1_ps(simd::kLn2Hi))),
+                      _mm256_set1_ps(2.00042443f));
+    return _mm256_blendv_ps(simd::Exp(x), large,
+                            _mm256_cmp_ps(x, _mm256_set1_ps(simd::kExpHi), _CMP_GT_OQ));
+  }
+};
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kLog> {
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) { return simd::Log(x); }
+};
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kSigmoid> {
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) { return simd::Sigmoid(x); }
+};
+
+template<>
+struct Avx2UnaryFunctor<VectorizedUnaryOp::kErf> {
+  OF_EP_CPU_TARGET_AVX2 static __m256 Apply(__m256 x) { return simd::Erf(x); }
+};
+
+template<VectorizedUnaryOp op>
+OF_EP_CPU_TARGET_AVX2 void UnaryCpuAvx2(size_t n, const float* x, float* y) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    _mm256_storeu_ps(y + i, Avx2UnaryFunctor<op>::Apply(_mm256_loadu_ps(x + i)));
+  }
+  if (i < n) {
+    const __m256i mask = simd::TailMask(n - i);
+    _mm256_maskstore_ps(y + i, mask,
+                        Avx2UnaryFunctor<op>::Apply(_mm256_maskload_ps(x + i, mask)));
+  }
+}
+
+VectorizedUnaryFunc GetAvx2UnaryFunc(VectorizedUnaryOp op) {
+  switch (op) {
+    case VectorizedUnaryOp::kRelu: return &UnaryCpuAvx2<VectorizedUnaryOp::kRelu>;
+    case VectorizedUnaryOp::kGelu: return &UnaryCpuAvx2<VectorizedUnaryOp::kGelu>;
+    case VectorizedUnaryOp::kTanh: return &UnaryCpuAvx2<VectorizedUnaryOp::kTanh>;
+    case VectorizedUnaryOp::kExp: return &UnaryCpuAvx2<VectorizedUnaryOp::kExp>;
+    case VectorizedUnaryOp::kLog: return &UnaryCpuAvx2<VectorizedUnaryOp::kLog>;
+    case VectorizedUnaryOp::kSigmoid: return &UnaryCpuAvx2<VectorizedUnaryOp::kSigmoid>;
+    case VectorizedUnaryOp::kErf: return &UnaryCpuAvx2<VectorizedUnaryOp::kErf>;
+    default: return nullptr;
+  }
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+}  // namespace
+
+VectorizedUnaryFunc GetVectorizedUnaryFunc(VectorizedUnaryOp op) {
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+  if (GetCpuIsa() >= CpuIsa::kAvx2) { return GetAvx2UnaryFunc(op); }
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+  return nullptr;
+}
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
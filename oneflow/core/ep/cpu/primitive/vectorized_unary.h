@@ -0,0 +1,49 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_CPU_PRIMITIVE_VECTORIZED_UNARY_H_
+#define ONEFLOW_CORE_EP_CPU_PRIMITIVE_VECTORIZED_UNARY_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// The float unary functions which have SIMD kernels, the transcendental ones are approximated by
+// simd_math.h
+enum class VectorizedUnaryOp {
+  kRelu,
+  kGelu,
+  kTanh,
+  kExp,
+  kLog,
+  kSigmoid,
+  kErf,
+};
+
+using VectorizedUnaryFunc = void (*)(size_t n, const float* x, float* y);
+
+// Return nullptr if the running CPU has no kernel for `op`, then the callers keep their scalar
+// loops. The kernels are single threaded, the callers split large tensors.
+VectorizedUnaryFunc GetVectorizedUnaryFunc(VectorizedUnaryOp op);
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_CPU_PRIMITIVE_VECTORIZED_UNARY_H_
@@ -0,0 +1,54 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_PRIMITIVE_BATCH_NORMALIZATION_H_
+#define ONEFLOW_CORE_EP_PRIMITIVE_BATCH_NORMALIZATION_H_
+
+#include "oneflow/core/ep/include/primitive/primitive.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+// The inference batch normalization with the given per-channel mean and variance:
+// y = (x - mean) / sqrt(variance + epsilon) * gamma + beta, where x is (N, C, spatial...) or
+// (N, spatial..., C) if channels_last
+class BatchNormalization : public Primitive {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BatchNormalization);
+  BatchNormalization() = default;
+  ~BatchNormalization() override = default;
+
+  virtual void Launch(Stream* stream, size_t num_dims, const int64_t* dims, const void* x,
+                      const void* mean, const void* variance, const void* gamma, const void* beta,
+                      float epsilon, void* y) = 0;
+};
+
+class BatchNormalizationFactory : public Factory<BatchNormalization> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(BatchNormalizationFactory);
+  BatchNormalizationFactory() = default;
+  ~BatchNormalizationFactory() override = default;
+
+  virtual std::unique_ptr<BatchNormalization> New(DataType data_type, bool channels_last) = 0;
+};
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_PRIMITIVE_BATCH_NORMALIZATION_H_
@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_PRIMITIVE_CONVOLUTION_H_
+#define ONEFLOW_CORE_EP_PRIMITIVE_CONVOLUTION_H_
+
+#include "oneflow/core/ep/include/primitive/primitive.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+struct ConvolutionParams {
+  size_t num_spatial_dims = 0;
+  // (N, spatial..., C) instead of (N, C, spatial...)
+  bool channels_last = false;
+  int64_t groups = 1;
+  std::vector<int32_t> strides;
+  std::vector<int32_t> dilation_rate;
+  // the padding after is deduced from the src and dst dims
+  std::vector<int32_t> padding_before;
+};
+
+// The dims are in the memory order of the tensors, the weight is (out_channels, in_channels /
+// groups, kernel...) or (out_channels, kernel..., in_channels / groups) if channels_last. The bias
+// of out_channels may be nullptr.
+class Convolution : public Primitive {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Convolution);
+  Convolution() = default;
+  ~Convolution() override = default;
+
+  virtual void Launch(Stream* stream, const int64_t* src_dims, const void* src,
+                      const int64_t* weight_dims, const void* weight, const void* bias,
+                      const int64_t* dst_dims, void* dst) = 0;
+};
+
+class ConvolutionFactory : public Factory<Convolution> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ConvolutionFactory);
+  ConvolutionFactory() = default;
+  ~ConvolutionFactory() override = default;
+
+  virtual std::unique_ptr<Convolution> New(DataType data_type,
+                                           const ConvolutionParams& params) = 0;
+};
+
+// The transposed convolution, the weight is (in_channels, out_channels / groups, kernel...) or
+// (in_channels, kernel..., out_channels / groups) if channels_last
+class Deconvolution : public Primitive {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Deconvolution);
+  Deconvolution() = default;
+  ~Deconvolution() override = default;
+
+  virtual void Launch(Stream* stream, const int64_t* src_dims, const void* src,
+                      const int64_t* weight_dims, const void* weight, const void* bias,
+                      const int64_t* dst_dims, void* dst) = 0;
+};
+
+class DeconvolutionFactory : public Factory<Deconvolution> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(DeconvolutionFactory);
+  DeconvolutionFactory() = default;
+  ~DeconvolutionFactory() override = default;
+
+  virtual std::unique_ptr<Deconvolution> New(DataType data_type,
+                                             const ConvolutionParams& params) = 0;
+};
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_PRIMITIVE_CONVOLUTION_H_
@@ -0,0 +1,68 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_EP_PRIMITIVE_POOLING_H_
+#define ONEFLOW_CORE_EP_PRIMITIVE_POOLING_H_
+
+#include "oneflow/core/ep/include/primitive/primitive.h"
+
+namespace oneflow {
+
+namespace ep {
+namespace primitive {
+
+enum class PoolingMode {
+  kMax,
+  kAvgIncludePadding,
+  kAvgExcludePadding,
+};
+
+struct PoolingParams {
+  size_t num_spatial_dims = 0;
+  PoolingMode mode = PoolingMode::kMax;
+  // (N, spatial..., C) instead of (N, C, spatial...)
+  bool channels_last = false;
+  std::vector<int32_t> kernel_size;
+  std::vector<int32_t> strides;
+  // the padding after is deduced from the src and dst dims, so ceil_mode is covered
+  std::vector<int32_t> padding_before;
+};
+
+// The forward pooling without indices, the dims are in the memory order of the tensors
+class Pooling : public Primitive {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Pooling);
+  Pooling() = default;
+  ~Pooling() override = default;
+
+  virtual void Launch(Stream* stream, const int64_t* src_dims, const void* src,
+                      const int64_t* dst_dims, void* dst) = 0;
+};
+
+class PoolingFactory : public Factory<Pooling> {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(PoolingFactory);
+  PoolingFactory() = default;
+  ~PoolingFactory() override = default;
+
+  virtual std::unique_ptr<Pooling> New(DataType data_type, const PoolingParams& params) = 0;
+};
+
+}  // namespace primitive
+}  // namespace ep
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_EP_PRIMITIVE_POOLING_H_
@@ -18,6 +18,9 @@ limitations under the License.
 #include "oneflow/core/framework/instruction_replay.h"
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/instruction.h"
+#include "oneflow/core/eager/blob_instruction_type.h"
+#include "oneflow/core/eager/opkernel_instruction_type.h"
+#include "oneflow/core/eager/release_tensor_instruction_type.h"
 
 namespace oneflow {
 
@@ -33,8 +36,76 @@ std::list<intrusive::shared_ptr<vm::InstructionMsg>>* RecordedInstructionList()
   return &list;
 }
 
+std::shared_ptr<CapturedInstructions>* ThreadLocalCapturedInstructions() {
+  static thread_local std::shared_ptr<CapturedInstructions> captured;
+  return &captured;
+}
+
+template<typename T>
+bool IsInstructionTypeOf(const vm::InstructionMsg& instr_msg) {
+  return dynamic_cast<const T*>(&instr_msg.instr_type_id().instruction_type()) != nullptr;
+}
+
+bool IsReleaseInstruction(const vm::InstructionMsg& instr_msg) {
+  return IsInstructionTypeOf<vm::ReleaseTensorInstructionType>(instr_msg);
+}
+
+// The instructions which only read and write the operands they were built with. The device types
+// derive from these instruction types, Touch has no type to derive from and is looked up.
+bool IsReplayableInstruction(const vm::InstructionMsg& instr_msg) {
+  static const vm::InstructionType* touch_instruction_type =
+      &vm::LookupInstrTypeId("Touch").instruction_type();
+  return IsInstructionTypeOf<vm::LocalCallOpKernelInstructionType>(instr_msg)
+         || IsInstructionTypeOf<vm::TensorViewInstructionType>(instr_msg)
+         || IsInstructionTypeOf<vm::RecordEventInstructionType>(instr_msg)
+         || &instr_msg.instr_type_id().instruction_type() == touch_instruction_type;
+}
+
 }  // namespace
 
+Maybe<void> CapturedInstructions::Append(vm::InstructionMsgList* instr_msg_list) {
+  INTRUSIVE_FOR_EACH_PTR(instr_msg, instr_msg_list) {
+    if (!IsReleaseInstruction(*instr_msg) && !IsReplayableInstruction(*instr_msg)) {
+      failed_ = true;
+      OF_UNIMPLEMENTED() << "instruction " << instr_msg->instr_type_name()
+                         << " can not be captured for replaying";
+    }
+  }
+  INTRUSIVE_FOR_EACH(instr_msg, instr_msg_list) {
+    if (IsReleaseInstruction(*instr_msg)) { continue; }
+    instr_msgs_.emplace_back(instr_msg);
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CapturedInstructions::Replay() const {
+  CHECK_OR_RETURN(!failed_) << "the capturing failed";
+  CHECK_OR_RETURN(CurrentCapturedInstructions() == nullptr)
+      << "can not replay instructions while capturing";
+  vm::InstructionMsgList instr_msg_list;
+  for (const auto& instr_msg : instr_msgs_) { instr_msg_list.EmplaceBack(instr_msg->Clone()); }
+  JUST(vm::Run(&instr_msg_list));
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> BeginCapturingInstructions(const std::shared_ptr<CapturedInstructions>& captured) {
+  CHECK_NOTNULL_OR_RETURN(captured.get());
+  CHECK_OR_RETURN(!*ThreadLocalCapturedInstructions()) << "instructions are being captured";
+  *ThreadLocalCapturedInstructions() = captured;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> EndCapturingInstructions() {
+  CHECK_OR_RETURN(static_cast<bool>(*ThreadLocalCapturedInstructions()))
+      << "instructions are not being captured";
+  ThreadLocalCapturedInstructions()->reset();
+  return Maybe<void>::Ok();
+}
+
+CapturedInstructions* CurrentCapturedInstructions() {
+  return ThreadLocalCapturedInstructions()->get();
+}
+
 namespace debug {
 
 bool RecordingInstructions() { return *RecordingInstructionsFlag(); }
@@ -17,10 +17,45 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_FRAMEWORK_INSTRUCTION_REPLAY_H_
 #define ONEFLOW_CORE_FRAMEWORK_INSTRUCTION_REPLAY_H_
 
+#include "oneflow/core/common/maybe.h"
 #include "oneflow/core/vm/instruction.h"
 
 namespace oneflow {
 
+// The instructions of a static eager step, e.g. one training iteration, captured while the step
+// runs once and replayed later. The captured instructions keep their kernels, states, operands and
+// streams, so replaying skips python, the interpreter, the shape inference and the instruction
+// building. Replays read and write the tensors the step used while capturing, new inputs are copied
+// into the captured input tensors before replaying. Tensor releases are not captured, the
+// intermediate tensors keep their memory between replays until the captured instructions are
+// destroyed.
+class CapturedInstructions final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CapturedInstructions);
+  CapturedInstructions() : failed_(false) {}
+  ~CapturedInstructions() = default;
+
+  size_t size() const { return instr_msgs_.size(); }
+
+  // Fail if any of the instructions can not be replayed, e.g. it calls back into python. Nothing
+  // can be replayed after a failure.
+  Maybe<void> Append(vm::InstructionMsgList* instr_msg_list);
+
+  Maybe<void> Replay() const;
+
+ private:
+  std::vector<intrusive::shared_ptr<vm::InstructionMsg>> instr_msgs_;
+  bool failed_;
+};
+
+// Capture the instructions run by the current thread into `captured`
+Maybe<void> BeginCapturingInstructions(const std::shared_ptr<CapturedInstructions>& captured);
+
+Maybe<void> EndCapturingInstructions();
+
+// Return nullptr if the current thread is not capturing
+CapturedInstructions* CurrentCapturedInstructions();
+
 namespace debug {
 
 bool RecordingInstructions();
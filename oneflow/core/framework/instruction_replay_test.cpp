@@ -0,0 +1,58 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/framework/instruction_replay.h"
+#include "oneflow/core/vm/vm_util.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+void AppendInstruction(vm::InstructionMsgList* list, const std::string& instr_type_name) {
+  list->EmplaceBack(vm::NewInstruction(instr_type_name));
+}
+
+}  // namespace
+
+TEST(CapturedInstructions, append_replayable_instructions) {
+  CapturedInstructions captured;
+  vm::InstructionMsgList list;
+  AppendInstruction(&list, "cpu.LocalCallOpKernel");
+  AppendInstruction(&list, "cpu.TensorView");
+  AppendInstruction(&list, "cpu.ReleaseTensor");
+  AppendInstruction(&list, "Touch");
+  ASSERT_TRUE(captured.Append(&list).IsOk());
+  // the releases are not captured
+  ASSERT_EQ(captured.size(), 3);
+}
+
+TEST(CapturedInstructions, append_other_instructions) {
+  for (const std::string& instr_type_name : {"cpu.CallOpKernel", "cpu.AccessBlobByCallback"}) {
+    CapturedInstructions captured;
+    vm::InstructionMsgList list;
+    AppendInstruction(&list, "cpu.LocalCallOpKernel");
+    AppendInstruction(&list, instr_type_name);
+    ASSERT_FALSE(captured.Append(&list).IsOk()) << instr_type_name;
+    // nothing can be replayed after a failure
+    ASSERT_FALSE(captured.Replay().IsOk()) << instr_type_name;
+  }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -1864,6 +1864,10 @@ Maybe<void> PhysicalRun(const std::function<Maybe<void>(InstructionsBuilder*)>&
       debug::RecordInstruction(instruction_msg);
     }
   }
+  auto* captured_instructions = CurrentCapturedInstructions();
+  if (captured_instructions != nullptr) {
+    JUST(captured_instructions->Append(instructions_builder.mut_instruction_list()));
+  }
   JUST(Global<vm::EagerOneflow>::Get()->RunPhysicalInstruction(
       instructions_builder.mut_instruction_list(), instructions_builder.eager_symbol_list()));
   return Maybe<void>::Ok();
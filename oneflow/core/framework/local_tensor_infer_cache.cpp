@@ -0,0 +1,182 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/local_tensor_infer_cache.h"
+#include "oneflow/core/framework/tensor_tuple.h"
+#include "oneflow/core/framework/tensor.h"
+#include "oneflow/core/framework/tensor_impl.h"
+#include "oneflow/core/framework/op_expr.h"
+
+namespace oneflow {
+namespace one {
+
+namespace {
+
+size_t GetLocalTensorInferCacheCapacity() {
+  static const size_t capacity = std::max<int64_t>(
+      ParseIntegerFromEnv("ONEFLOW_EAGER_LOCAL_TENSOR_INFER_CACHE_CAPACITY", 64), 0);
+  return capacity;
+}
+
+bool IsLocalTensorInferCacheStatsLogged() {
+  static const bool logged =
+      ParseBooleanFromEnv("ONEFLOW_EAGER_LOG_LOCAL_TENSOR_INFER_CACHE_STATS", false);
+  return logged;
+}
+
+}  // namespace
+
+size_t InputLocalTensorMeta::hash_value() const {
+  size_t hash_value = std::hash<Shape>()(shape_);
+  HashCombine(&hash_value, std::hash<Stride>()(stride_));
+  HashCombine(&hash_value, static_cast<size_t>(data_type_));
+  HashCombine(&hash_value, static_cast<size_t>(is_dynamic_));
+  return hash_value;
+}
+
+bool InputLocalTensorMeta::operator==(const InputLocalTensorMeta& other) const {
+  return this->shape_ == other.shape_ && this->stride_ == other.stride_
+         && this->data_type_ == other.data_type_ && this->is_dynamic_ == other.is_dynamic_;
+}
+
+void InputLocalTensorMeta::assign(const MirroredTensorMeta& tensor_meta) {
+  shape_ = tensor_meta.shape();
+  stride_ = tensor_meta.stride();
+  data_type_ = tensor_meta.dtype();
+  is_dynamic_ = tensor_meta.is_dynamic();
+}
+
+size_t LocalTensorMetaInferArgs::hash_value() const {
+  size_t hash_value = std::hash<AttrMap>()(attrs_);
+  HashCombine(&hash_value, std::hash<Symbol<Device>>()(op_device_));
+  const auto& tensor_meta_hash_functor = std::hash<InputLocalTensorMeta>();
+  for (const auto& tensor_meta : input_local_tensor_metas_) {
+    HashCombine(&hash_value, tensor_meta_hash_functor(tensor_meta));
+  }
+  return hash_value;
+}
+
+bool LocalTensorMetaInferArgs::operator==(const LocalTensorMetaInferArgs& other) const {
+  return this->attrs_ == other.attrs_ && this->op_device_ == other.op_device_
+         && this->input_local_tensor_metas_ == other.input_local_tensor_metas_;
+}
+
+Maybe<void> LocalTensorMetaInferArgs::Init(const AttrMap& attrs, Symbol<Device> op_device,
+                                           const TensorTuple& input_tensors) {
+  attrs_ = attrs;
+  op_device_ = op_device;
+  input_local_tensor_metas_.resize(input_tensors.size());
+  for (int i = 0; i < input_tensors.size(); ++i) {
+    const auto* tensor_impl = JUST(input_tensors.at(i)->mut_eager_mirrored_tensor_impl());
+    input_local_tensor_metas_.at(i).assign(*tensor_impl->tensor_meta());
+  }
+  return Maybe<void>::Ok();
+}
+
+LocalTensorInferResult::LocalTensorInferResult(size_t output_size)
+    : output_strides_(output_size) {
+  output_tensor_metas_.reserve(output_size);
+  for (size_t i = 0; i < output_size; ++i) {
+    output_tensor_metas_.emplace_back(std::make_shared<Shape>(), DataType::kInvalidDataType);
+  }
+}
+
+LocalTensorInferCache::LocalTensorInferCache(const std::shared_ptr<const UserOpExpr>& user_op_expr)
+    : user_op_expr_(user_op_expr), hit_count_(0), miss_count_(0) {
+  const size_t capacity = GetLocalTensorInferCacheCapacity();
+  if (capacity > 0) {
+    cache_.reset(
+        new LruCache<LocalTensorMetaInferArgs, std::shared_ptr<const LocalTensorInferResult>>(
+            capacity));
+  }
+  if (IsLocalTensorInferCacheStatsLogged()) { op_name_ = user_op_expr->op_name(); }
+}
+
+std::atomic<size_t> LocalTensorInferCache::total_hit_count_(0);
+std::atomic<size_t> LocalTensorInferCache::total_miss_count_(0);
+
+LocalTensorInferCache::~LocalTensorInferCache() {
+  if (IsLocalTensorInferCacheStatsLogged() && hit_count_ + miss_count_ > 0) {
+    LOG(INFO) << "local tensor infer cache of " << op_name_ << ": " << hit_count_ << " hits, "
+              << miss_count_ << " misses, hit rate "
+              << static_cast<double>(hit_count_) / (hit_count_ + miss_count_);
+  }
+}
+
+/* static */ Maybe<const LocalTensorInferResult> LocalTensorInferCache::Infer(
+    const UserOpExpr& user_op_expr, const LocalTensorMetaInferArgs& infer_args,
+    const TensorTuple& input_tensors) {
+  CHECK_EQ_OR_RETURN(input_tensors.size(), infer_args.input_local_tensor_metas().size());
+  auto result = std::make_shared<LocalTensorInferResult>(user_op_expr.output_size());
+  auto* output_tensor_metas = result->mut_output_tensor_metas();
+  const auto& device_tag = JUST(infer_args.op_device()->of_type());
+  JUST(user_op_expr.InferPhysicalShapeAndDType(
+      infer_args.attrs(), device_tag,
+      [&](int32_t i) -> const TensorMeta* {
+        return CHECK_JUST(input_tensors.at(i)->mut_eager_mirrored_tensor_impl())->mut_tensor_meta();
+      },
+      [&](int32_t i) -> TensorMeta* { return &output_tensor_metas->at(i); }));
+  for (int i = 0; i < output_tensor_metas->size(); ++i) {
+    result->mut_output_strides()->at(i) =
+        std::make_shared<const Stride>(output_tensor_metas->at(i).shape());
+  }
+  return std::shared_ptr<const LocalTensorInferResult>(result);
+}
+
+Maybe<const LocalTensorInferResult> LocalTensorInferCache::GetOrInfer(
+    const LocalTensorMetaInferArgs& infer_args, const TensorTuple& input_tensors) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto* cached = cache_ ? cache_->Find(infer_args) : nullptr;
+    if (cached != nullptr) {
+      ++hit_count_;
+      total_hit_count_.fetch_add(1, std::memory_order_relaxed);
+      return *cached;
+    }
+    ++miss_count_;
+    total_miss_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // the inference runs unlocked, two threads missing the same args both infer and the second
+  // result replaces the first one
+  const auto& user_op_expr = user_op_expr_.lock();
+  CHECK_OR_RETURN(static_cast<bool>(user_op_expr));
+  const auto& result = JUST(Infer(*user_op_expr, infer_args, input_tensors));
+  if (cache_) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_->Put(infer_args, result);
+  }
+  return result;
+}
+
+size_t LocalTensorInferCache::hit_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hit_count_;
+}
+
+size_t LocalTensorInferCache::miss_count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return miss_count_;
+}
+
+/* static */ size_t LocalTensorInferCache::total_hit_count() {
+  return total_hit_count_.load(std::memory_order_relaxed);
+}
+
+/* static */ size_t LocalTensorInferCache::total_miss_count() {
+  return total_miss_count_.load(std::memory_order_relaxed);
+}
+
+}  // namespace one
+}  // namespace oneflow
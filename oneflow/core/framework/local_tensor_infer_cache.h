@@ -0,0 +1,175 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_FRAMEWORK_LOCAL_TENSOR_INFER_CACHE_H_
+#define ONEFLOW_CORE_FRAMEWORK_LOCAL_TENSOR_INFER_CACHE_H_
+
+#include <atomic>
+#include <mutex>
+#include "oneflow/core/common/symbol.h"
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/lru_cache.h"
+#include "oneflow/core/framework/attr_map.h"
+#include "oneflow/core/framework/device.h"
+#include "oneflow/core/framework/stride.h"
+#include "oneflow/core/framework/tensor_meta.h"
+
+namespace oneflow {
+namespace one {
+
+// The part of an input tensor meta the physical shape and dtype inference may depend on. Shape and
+// stride are copied because the shape of a tensor with a dynamic shape is updated in place.
+class InputLocalTensorMeta final {
+ public:
+  InputLocalTensorMeta() : data_type_(DataType::kInvalidDataType), is_dynamic_(false) {}
+  InputLocalTensorMeta(const InputLocalTensorMeta&) = default;
+  InputLocalTensorMeta(InputLocalTensorMeta&&) = default;
+  InputLocalTensorMeta& operator=(const InputLocalTensorMeta&) = default;
+  ~InputLocalTensorMeta() = default;
+
+  size_t hash_value() const;
+  bool operator==(const InputLocalTensorMeta& other) const;
+
+  const Shape& shape() const { return shape_; }
+  const Stride& stride() const { return stride_; }
+  DataType data_type() const { return data_type_; }
+  bool is_dynamic() const { return is_dynamic_; }
+
+  void assign(const MirroredTensorMeta& tensor_meta);
+
+ private:
+  Shape shape_;
+  Stride stride_;
+  DataType data_type_;
+  bool is_dynamic_;
+};
+
+class TensorTuple;
+class UserOpExpr;
+
+class LocalTensorMetaInferArgs final {
+ public:
+  LocalTensorMetaInferArgs() = default;
+  LocalTensorMetaInferArgs(const LocalTensorMetaInferArgs&) = default;
+  LocalTensorMetaInferArgs(LocalTensorMetaInferArgs&&) = default;
+  LocalTensorMetaInferArgs& operator=(const LocalTensorMetaInferArgs&) = default;
+  ~LocalTensorMetaInferArgs() = default;
+
+  const AttrMap& attrs() const { return attrs_; }
+  Symbol<Device> op_device() const { return op_device_; }
+  const std::vector<InputLocalTensorMeta>& input_local_tensor_metas() const {
+    return input_local_tensor_metas_;
+  }
+
+  size_t hash_value() const;
+
+  bool operator==(const LocalTensorMetaInferArgs& other) const;
+
+  // Reuse the buffers of the last call, the args can be kept thread local
+  Maybe<void> Init(const AttrMap& attrs, Symbol<Device> op_device,
+                   const TensorTuple& input_tensors);
+
+ private:
+  AttrMap attrs_;
+  Symbol<Device> op_device_;
+  std::vector<InputLocalTensorMeta> input_local_tensor_metas_;
+};
+
+}  // namespace one
+}  // namespace oneflow
+
+namespace std {
+
+template<>
+struct hash<oneflow::one::InputLocalTensorMeta> final {
+  size_t operator()(const oneflow::one::InputLocalTensorMeta& val) const {
+    return val.hash_value();
+  }
+};
+
+template<>
+struct hash<oneflow::one::LocalTensorMetaInferArgs> final {
+  size_t operator()(const oneflow::one::LocalTensorMetaInferArgs& val) const {
+    return val.hash_value();
+  }
+};
+
+}  // namespace std
+
+namespace oneflow {
+namespace one {
+
+class LocalTensorInferResult final {
+ public:
+  explicit LocalTensorInferResult(size_t output_size);
+  LocalTensorInferResult(const LocalTensorInferResult&) = delete;
+  LocalTensorInferResult(LocalTensorInferResult&&) = delete;
+  ~LocalTensorInferResult() = default;
+
+  const std::vector<TensorMeta>& output_tensor_metas() const { return output_tensor_metas_; }
+  // The contiguous strides of the outputs, shared by all the outputs made from this result
+  const std::vector<std::shared_ptr<const Stride>>& output_strides() const {
+    return output_strides_;
+  }
+
+  std::vector<TensorMeta>* mut_output_tensor_metas() { return &output_tensor_metas_; }
+  std::vector<std::shared_ptr<const Stride>>* mut_output_strides() { return &output_strides_; }
+
+ private:
+  std::vector<TensorMeta> output_tensor_metas_;
+  std::vector<std::shared_ptr<const Stride>> output_strides_;
+};
+
+// Eager ops are dispatched with the same input metas and attributes over and over again, so the
+// results of the physical shape and dtype inference are kept per UserOpExpr. The cache is bounded
+// by ONEFLOW_EAGER_LOCAL_TENSOR_INFER_CACHE_CAPACITY, 0 disables it. An op expr may be dispatched
+// by several threads at once, e.g. the Python threads of a data loader, so the cache is locked.
+class LocalTensorInferCache final {
+ public:
+  explicit LocalTensorInferCache(const std::shared_ptr<const UserOpExpr>& user_op_expr);
+  ~LocalTensorInferCache();
+
+  Maybe<const LocalTensorInferResult> GetOrInfer(const LocalTensorMetaInferArgs& infer_args,
+                                                 const TensorTuple& input_tensors);
+
+  static Maybe<const LocalTensorInferResult> Infer(const UserOpExpr& user_op_expr,
+                                                   const LocalTensorMetaInferArgs& infer_args,
+                                                   const TensorTuple& input_tensors);
+
+  size_t hit_count() const;
+  size_t miss_count() const;
+
+  // The hits and misses of all the caches of the process
+  static size_t total_hit_count();
+  static size_t total_miss_count();
+
+ private:
+  std::weak_ptr<const UserOpExpr> user_op_expr_;
+  std::string op_name_;
+  std::unique_ptr<LruCache<LocalTensorMetaInferArgs, std::shared_ptr<const LocalTensorInferResult>>>
+      cache_;
+  size_t hit_count_;
+  size_t miss_count_;
+  mutable std::mutex mutex_;
+
+  static std::atomic<size_t> total_hit_count_;
+  static std::atomic<size_t> total_miss_count_;
+};
+
+}  // namespace one
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_FRAMEWORK_LOCAL_TENSOR_INFER_CACHE_H_
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "oneflow/core/autograd/autograd_mode.h"
 #include "oneflow/core/common/data_type.pb.h"
 #include "oneflow/core/common/optional.h"
 #include "oneflow/core/common/scalar.h"
@@ -1298,6 +1299,27 @@ class NormalizationAddReluFunctor {
                                                           .Output("inv_variance")
                                                           .Attr("training", true)
                                                           .Build());
+    fused_norm_inference_op_ = CHECK_JUST(one::OpBuilder("normalization_add_relu")
+                                              .Input("x")
+                                              .Input("moving_mean")
+                                              .Input("moving_variance")
+                                              .Input("gamma")
+                                              .Input("beta")
+                                              .Output("y")
+                                              .Output("reserve_space")
+                                              .Attr("training", false)
+                                              .Build());
+    fused_addend_norm_inference_op_ = CHECK_JUST(one::OpBuilder("normalization_add_relu")
+                                                     .Input("x")
+                                                     .Input("addend")
+                                                     .Input("moving_mean")
+                                                     .Input("moving_variance")
+                                                     .Input("gamma")
+                                                     .Input("beta")
+                                                     .Output("y")
+                                                     .Output("reserve_space")
+                                                     .Attr("training", false)
+                                                     .Build());
     fused_norm_training_no_stats_op_ = CHECK_JUST(one::OpBuilder("normalization_add_relu")
                                                       .Input("x")
                                                       .Input("gamma")
@@ -1339,6 +1361,18 @@ class NormalizationAddReluFunctor {
     if (!is_training) {
       CHECK_OR_RETURN(moving_mean && moving_variance)
           << "Must have moving_mean and moving_variance in eval mode.";
+      // The CPU kernel normalizes, adds and relus in one pass if no gradient is needed
+      if (JUST(IsFusedNormalizationInferenceSupported(x, addend, gamma, beta))) {
+        if (addend) {
+          return OpInterpUtil::Dispatch<one::Tensor>(
+              *fused_addend_norm_inference_op_,
+              {x, JUST(addend), JUST(moving_mean), JUST(moving_variance), gamma, beta}, attrs);
+        } else {
+          return OpInterpUtil::Dispatch<one::Tensor>(
+              *fused_norm_inference_op_, {x, JUST(moving_mean), JUST(moving_variance), gamma, beta},
+              attrs);
+        }
+      }
       const auto& normalize_result = JUST(OpInterpUtil::Dispatch<one::Tensor>(
           *norm_eval_op_, {x, JUST(moving_mean), JUST(moving_variance), gamma, beta}, attrs));
       if (addend) {
@@ -1370,9 +1404,23 @@ class NormalizationAddReluFunctor {
   }
 
  private:
+  Maybe<bool> IsFusedNormalizationInferenceSupported(
+      const std::shared_ptr<one::Tensor>& x, const Optional<one::Tensor>& addend,
+      const std::shared_ptr<one::Tensor>& gamma, const std::shared_ptr<one::Tensor>& beta) const {
+    if (LazyMode::is_enabled() || !x->is_local()) { return false; }
+    if (JUST(x->device())->type() != "cpu") { return false; }
+    if (autograd::GradMode::is_enabled()) {
+      if (x->requires_grad() || gamma->requires_grad() || beta->requires_grad()) { return false; }
+      if (addend && JUST(addend)->requires_grad()) { return false; }
+    }
+    return true;
+  }
+
   std::shared_ptr<OpExpr> norm_eval_op_;
   std::shared_ptr<OpExpr> relu_op_;
   std::shared_ptr<OpExpr> add_op_;
+  std::shared_ptr<OpExpr> fused_norm_inference_op_;
+  std::shared_ptr<OpExpr> fused_addend_norm_inference_op_;
   std::shared_ptr<OpExpr> fused_norm_training_stats_op_;
   std::shared_ptr<OpExpr> fused_addend_norm_training_stats_op_;
   std::shared_ptr<OpExpr> fused_norm_training_no_stats_op_;
@@ -30,6 +30,7 @@ limitations under the License.
 #include "oneflow/core/graph/boxing/hierarchical_sub_task_graph_builder_impl.h"
 #include "oneflow/core/graph/task_stream_index_manager.h"
 #include "oneflow/core/ep/include/primitive/memcpy.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
@@ -420,7 +421,8 @@ void ForEachOpGraphNecessaryCtrlEdge(
 
 }  // namespace
 
-TaskGraph::TaskGraph() {
+TaskGraph::TaskGraph()
+    : enable_parallel_compile_(ParseBooleanFromEnv("ONEFLOW_COMPILER_PARALLEL", false)) {
   OpGraph* op_graph = Global<OpGraph>::Get();
   sub_tsk_gph_builder_ctx_.reset(new SubTskGphBuilderCtx(this));
   boxing_logger_ = CreateBoxingLogger();
@@ -541,11 +543,43 @@ void TaskGraph::ConnectCtrlEdges(const std::vector<CompTaskNode*>& src_task_node
   }
 }
 
+void TaskGraph::ParallelForEachNode(const std::function<void(TaskNode*)>& Handler) const {
+  if (!enable_parallel_compile_) {
+    ForEachNode(Handler);
+    return;
+  }
+  std::vector<TaskNode*> nodes;
+  nodes.reserve(node_num());
+  ForEachNode([&](TaskNode* node) { nodes.push_back(node); });
+  MultiThreadLoop(nodes.size(), [&](size_t i) { Handler(nodes.at(i)); });
+}
+
+void TaskGraph::ParallelTopoForEachNode(const std::function<void(TaskNode*)>& Handler) const {
+  if (!enable_parallel_compile_) {
+    TopoForEachNode(Handler);
+    return;
+  }
+  // the level of a node is one more than the max level of its in nodes
+  HashMap<TaskNode*, int64_t> node2level;
+  std::vector<std::vector<TaskNode*>> levels;
+  TopoForEachNode([&](TaskNode* node) {
+    int64_t level = 0;
+    node->ForEachNodeOnInEdge(
+        [&](TaskNode* in_node) { level = std::max(level, node2level.at(in_node) + 1); });
+    node2level.emplace(node, level);
+    if (levels.size() <= static_cast<size_t>(level)) { levels.resize(level + 1); }
+    levels.at(level).push_back(node);
+  });
+  for (const std::vector<TaskNode*>& nodes : levels) {
+    MultiThreadLoop(nodes.size(), [&](size_t i) { Handler(nodes.at(i)); });
+  }
+}
+
 void TaskGraph::RemoveEmptyRegsts() {
-  ForEachNode([&](TaskNode* node) { node->EraseUninitializedShapeProducedBlob(); });
-  ForEachNode([&](TaskNode* node) { node->EraseZeroSizeConsumedRegst(); });
-  ForEachNode([&](TaskNode* node) { node->EraseZeroSizeProducedRegst(); });
-  ForEachNode([&](TaskNode* node) { node->UnbindBnWithEmptyRegst(); });
+  ParallelForEachNode([&](TaskNode* node) { node->EraseUninitializedShapeProducedBlob(); });
+  ParallelForEachNode([&](TaskNode* node) { node->EraseZeroSizeConsumedRegst(); });
+  ParallelForEachNode([&](TaskNode* node) { node->EraseZeroSizeProducedRegst(); });
+  ParallelForEachNode([&](TaskNode* node) { node->UnbindBnWithEmptyRegst(); });
 }
 
 void TaskGraph::MergeChainAndAddOrderingCtrlEdgeInSameChain() {
@@ -46,6 +46,12 @@ class TaskGraph final : public Graph<TaskNode, TaskEdge> {
   explicit TaskGraph();
 
   const char* TypeName() const override { return "TaskGraph"; }
+  bool enable_parallel_compile() const { return enable_parallel_compile_; }
+  // With ONEFLOW_COMPILER_PARALLEL the nodes are handled by Global<ThreadPool>, so Handler may
+  // only modify the node itself. Otherwise they are the same as ForEachNode and TopoForEachNode.
+  void ParallelForEachNode(const std::function<void(TaskNode*)>& Handler) const;
+  // The nodes of one topological level are handled concurrently after all the upstream levels
+  void ParallelTopoForEachNode(const std::function<void(TaskNode*)>& Handler) const;
   void RemoveEmptyRegsts();
   void MergeChainAndAddOrderingCtrlEdgeInSameChain();
 
@@ -97,6 +103,7 @@ class TaskGraph final : public Graph<TaskNode, TaskEdge> {
   void ForEachGpuDeviceNodes(
       const std::function<void(const HashSet<TaskNode*>& dev_nodes)>& Handler) const;
 
+  const bool enable_parallel_compile_;
   std::vector<TaskNode*> ordered_task_nodes_;
   std::unique_ptr<HierarchicalSubTskGphBuilder> hierarchical_sub_tsk_gph_builder_;
   std::unique_ptr<SubTskGphBuilderCtx> sub_tsk_gph_builder_ctx_;
@@ -30,6 +30,13 @@ class TaskIdGenerator final {
 
   TaskId Generate(const StreamId& stream_id);
 
+  const HashMap<StreamId, task_index_t>& task_index_counters() const {
+    return stream_id2task_index_counter_;
+  }
+  void set_task_index_counters(const HashMap<StreamId, task_index_t>& counters) {
+    stream_id2task_index_counter_ = counters;
+  }
+
  private:
   HashMap<StreamId, task_index_t> stream_id2task_index_counter_;
 };
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_INTRUSIVE_MPSC_LIST_H_
+#define ONEFLOW_CORE_INTRUSIVE_MPSC_LIST_H_
+
+#include <atomic>
+#include "oneflow/core/intrusive/list.h"
+
+namespace oneflow {
+
+namespace intrusive {
+
+// MpscList is a lock-free list for many producers and one consumer. Every MoveFrom pushes the
+// whole source list as a batch onto a lock-free stack, and MoveTo takes all the batches at once and
+// splices them to the destination in the order they were pushed. Neither side ever waits for the
+// other, and the elements are moved by splicing their hooks instead of one by one.
+template<typename HookField>
+class MpscList {
+ public:
+  using value_type = typename HookField::struct_type;
+  using list_type = List<HookField>;
+
+  MpscList(const MpscList&) = delete;
+  MpscList(MpscList&&) = delete;
+  MpscList() : top_(nullptr), size_(0) {}
+  ~MpscList() { this->Clear(); }
+
+  // Elements being pushed are counted before they can be taken, so the size may be larger than
+  // what MoveTo takes for a moment, but never smaller.
+  std::size_t thread_unsafe_size() const { return size_.load(std::memory_order_relaxed); }
+  std::size_t size() const { return size_.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+
+  void EmplaceBack(intrusive::shared_ptr<value_type>&& ptr) {
+    list_type list;
+    list.EmplaceBack(std::move(ptr));
+    MoveFrom(&list);
+  }
+  void PushBack(value_type* ptr) { EmplaceBack(intrusive::shared_ptr<value_type>(ptr)); }
+
+  // Returns true if old list is empty.
+  bool MoveFrom(list_type* src) {
+    if (src->empty()) { return top_.load(std::memory_order_acquire) == nullptr; }
+    auto* batch = new Batch();
+    size_.fetch_add(src->size(), std::memory_order_release);
+    src->MoveToDstBack(&batch->list);
+    Batch* top = top_.load(std::memory_order_relaxed);
+    do {
+      batch->next = top;
+    } while (!top_.compare_exchange_weak(top, batch, std::memory_order_release,
+                                         std::memory_order_relaxed));
+    return top == nullptr;
+  }
+
+  void MoveTo(list_type* dst) {
+    Batch* batch = top_.exchange(nullptr, std::memory_order_acquire);
+    if (batch == nullptr) { return; }
+    // the stack is from the latest batch to the earliest one
+    Batch* earliest = nullptr;
+    while (batch != nullptr) {
+      Batch* next = batch->next;
+      batch->next = earliest;
+      earliest = batch;
+      batch = next;
+    }
+    std::size_t moved_size = 0;
+    while (earliest != nullptr) {
+      moved_size += earliest->list.size();
+      earliest->list.MoveToDstBack(dst);
+      Batch* next = earliest->next;
+      delete earliest;
+      earliest = next;
+    }
+    size_.fetch_sub(moved_size, std::memory_order_release);
+  }
+
+  void Clear() {
+    list_type list;
+    MoveTo(&list);
+  }
+
+ private:
+  struct Batch {
+    list_type list;
+    Batch* next;
+  };
+
+  std::atomic<Batch*> top_;
+  std::atomic<std::size_t> size_;
+};
+
+}  // namespace intrusive
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_INTRUSIVE_MPSC_LIST_H_
@@ -0,0 +1,120 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <thread>
+#include "oneflow/core/intrusive/intrusive.h"
+#include "oneflow/core/intrusive/mpsc_list.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace intrusive {
+
+namespace test {
+
+namespace {
+
+class Foo final : public intrusive::Base {
+ public:
+  int sender() const { return sender_; }
+  int x() const { return x_; }
+  void set_sender(int val) { sender_ = val; }
+  void set_x(int val) { x_ = val; }
+  size_t ref_cnt() const { return intrusive_ref_.ref_cnt(); }
+
+ private:
+  Foo() : intrusive_ref_(), sender_(), x_(), hook_() {}
+  friend class intrusive::Ref;
+  intrusive::Ref* mut_intrusive_ref() { return &intrusive_ref_; }
+  intrusive::Ref intrusive_ref_;
+  // fields
+  int sender_;
+  int x_;
+
+ public:
+  // list hooks
+  intrusive::ListHook hook_;
+};
+
+using FooList = intrusive::List<INTRUSIVE_FIELD(Foo, hook_)>;
+using MpscFooList = intrusive::MpscList<INTRUSIVE_FIELD(Foo, hook_)>;
+
+intrusive::shared_ptr<Foo> NewFoo(int sender, int x) {
+  auto foo = intrusive::make_shared<Foo>();
+  foo->set_sender(sender);
+  foo->set_x(x);
+  return foo;
+}
+
+TEST(MpscList, move_from_and_move_to) {
+  MpscFooList mpsc_list;
+  ASSERT_TRUE(mpsc_list.empty());
+  FooList list;
+  list.EmplaceBack(NewFoo(0, 0));
+  list.EmplaceBack(NewFoo(0, 1));
+  ASSERT_TRUE(mpsc_list.MoveFrom(&list));
+  ASSERT_TRUE(list.empty());
+  list.EmplaceBack(NewFoo(0, 2));
+  ASSERT_FALSE(mpsc_list.MoveFrom(&list));
+  mpsc_list.EmplaceBack(NewFoo(0, 3));
+  ASSERT_EQ(mpsc_list.size(), 4);
+  FooList dst;
+  dst.EmplaceBack(NewFoo(0, -1));
+  mpsc_list.MoveTo(&dst);
+  ASSERT_TRUE(mpsc_list.empty());
+  ASSERT_EQ(dst.size(), 5);
+  int expected = -1;
+  INTRUSIVE_FOR_EACH_PTR(foo, &dst) {
+    ASSERT_EQ(foo->x(), expected++);
+    ASSERT_EQ(foo->ref_cnt(), 1);
+  }
+}
+
+TEST(MpscList, keep_the_order_of_every_sender) {
+  MpscFooList mpsc_list;
+  const int sender_num = 8;
+  const int batch_num = 2000;
+  const int batch_size = 3;
+  std::vector<std::thread> senders;
+  for (int i = 0; i < sender_num; ++i) {
+    senders.emplace_back([&mpsc_list, i]() {
+      for (int j = 0; j < batch_num; ++j) {
+        FooList list;
+        for (int k = 0; k < batch_size; ++k) { list.EmplaceBack(NewFoo(i, j * batch_size + k)); }
+        mpsc_list.MoveFrom(&list);
+      }
+    });
+  }
+  std::vector<int> next_x(sender_num, 0);
+  int received_cnt = 0;
+  while (received_cnt < sender_num * batch_num * batch_size) {
+    FooList list;
+    mpsc_list.MoveTo(&list);
+    INTRUSIVE_FOR_EACH_PTR(foo, &list) {
+      ASSERT_EQ(foo->x(), next_x.at(foo->sender())++);
+      ++received_cnt;
+    }
+  }
+  for (std::thread& sender : senders) { sender.join(); }
+  ASSERT_TRUE(mpsc_list.empty());
+}
+
+}  // namespace
+
+}  // namespace test
+
+}  // namespace intrusive
+
+}  // namespace oneflow
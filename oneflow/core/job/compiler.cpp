@@ -17,6 +17,8 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/job/intra_job_mem_sharing_util.h"
 #include "oneflow/core/job/plan_util.h"
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
@@ -25,6 +27,37 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+// Log the time of every phase of the compilation if ONEFLOW_COMPILER_LOG_PHASE_TIME is set
+class CompilePhaseTimer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CompilePhaseTimer);
+  explicit CompilePhaseTimer(const std::string& job_name)
+      : job_name_(job_name),
+        enabled_(ParseBooleanFromEnv("ONEFLOW_COMPILER_LOG_PHASE_TIME", false)),
+        start_time_(GetCurTime()),
+        phase_start_time_(start_time_) {}
+  ~CompilePhaseTimer() = default;
+
+  void PhaseDone(const std::string& phase) {
+    if (!enabled_) { return; }
+    const double cur_time = GetCurTime();
+    LOG(INFO) << "compile job " << job_name_ << ", phase " << phase << ": "
+              << (cur_time - phase_start_time_) / 1e6 << " ms, total "
+              << (cur_time - start_time_) / 1e6 << " ms";
+    phase_start_time_ = cur_time;
+  }
+
+ private:
+  const std::string job_name_;
+  const bool enabled_;
+  const double start_time_;
+  double phase_start_time_;
+};
+
+}  // namespace
+
 void CreateOpAttributeRef(Plan* plan, int64_t job_id, TaskProto* task_proto) {
   auto* job_id2op_attribute_ref_table = plan->mutable_job_id2op_attribute_ref_table();
   CHECK(task_proto->exec_sequence().exec_node_size() == 1);
@@ -46,11 +79,30 @@ void CreateOpAttributeRef(Plan* plan, int64_t job_id, TaskProto* task_proto) {
 }
 
 void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
+  CompilePhaseTimer timer(GlobalJobDesc().job_name());
   // Step1: ensure job is completed.
   if (need_job_complete) { CHECK_JUST(JobCompleter().Complete(job)); }
+  timer.PhaseDone("JobCompleter");
+
+  // Only the plan generated by a whole compilation is cached
+  std::string plan_cache_key;
+  if (PlanCacheEnabled() && plan->ByteSizeLong() == 0) {
+    IdState id_state;
+    Global<IDMgr>::Get()->SaveIdState(&id_state);
+    plan_cache_key = GenPlanCacheKey(*job, GlobalJobDesc().job_conf(),
+                                     Global<ResourceDesc, ForSession>::Get()->resource(),
+                                     GlobalJobDesc().job_id(), id_state);
+    if (LoadCachedPlan(plan_cache_key, plan, &id_state)) {
+      Global<IDMgr>::Get()->RestoreIdState(id_state);
+      LOG(INFO) << "load the plan of job " << GlobalJobDesc().job_name() << " from cache "
+                << plan_cache_key;
+      return;
+    }
+  }
 
   // Step2: new Global<OpGraph> and set log configs.
   Global<OpGraph>::New(*job);
+  timer.PhaseDone("OpGraph");
   const JobDesc& job_desc = GlobalJobDesc();
   if (Global<ResourceDesc, ForSession>::Get()->enable_debug_mode()
       || Global<ResourceDesc, ForSession>::Get()->enable_dry_run()) {
@@ -61,18 +113,40 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
 
   // Step3: build task_gph.
   // TODO(levi): we can rewrite this part of code in visitor pattern.
+  // NOTE: the passes producing and consuming regsts are always serial, because they allocate
+  //   regst desc ids and add consumers to the regsts shared by several nodes.
+  // NOTE: with ONEFLOW_COMPILER_PARALLEL, Build and InferTimeShapeIfMeaningful of the nodes of one
+  //   topological level run concurrently. The state they share is:
+  //   - the regsts consumed by a node, which are only read and are produced by the nodes of
+  //     earlier levels, so they are never written concurrently. A node writes the lbis, blob descs
+  //     and time shapes of its own produced regsts and builds its own exec graph only;
+  //   - the Operator, shared by the CompTaskNodes of one op on all the parallel ids, whose blob
+  //     desc and inplace inference is const and works on the context of the call. Its time
+  //     shapes and sbp signatures are inferred by OpGraph before;
+  //   - the id counters of the exec graph nodes and edges, which are atomic, the ids do not go
+  //     into the plan.
+  //   Ids of regsts, mem blocks and tasks are never allocated by these passes.
   auto task_gph = std::make_unique<TaskGraph>();
+  timer.PhaseDone("TaskGraph with " + std::to_string(task_gph->node_num()) + " nodes");
   using std::placeholders::_1;
   task_gph->ForEachNode(std::bind(&TaskNode::ProduceAllRegstsAndBindEdges, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::ConsumeAllRegsts, _1));
   task_gph->ForEachNode(std::bind(&TaskNode::PinConsumedRegst, _1));
-  task_gph->TopoForEachNode(&TaskNode::Build);
+  timer.PhaseDone("ProduceAndConsumeRegsts");
+  task_gph->ParallelTopoForEachNode(&TaskNode::Build);
+  timer.PhaseDone("Build");
   task_gph->RemoveEmptyRegsts();
+  timer.PhaseDone("RemoveEmptyRegsts");
   task_gph->MergeChainAndAddOrderingCtrlEdgeInSameChain();
+  timer.PhaseDone("MergeChainAndAddOrderingCtrlEdgeInSameChain");
   auto IsReachable = Global<OpGraph>::Get()->MakePredicatorIsOpNameDataOrCtrlReachable();
   if (job_desc.enable_inplace()) { task_gph->EnableInplaceMemSharing(IsReachable); }
-  task_gph->TopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
-  task_gph->ForEachEdge([&](TaskEdge* task_edge) { task_edge->CheckRegstLbiValid(); });
+  timer.PhaseDone("EnableInplaceMemSharing");
+  task_gph->ParallelTopoForEachNode(&TaskNode::InferTimeShapeIfMeaningful);
+  task_gph->ParallelForEachNode([&](TaskNode* task_node) {
+    for (TaskEdge* task_edge : task_node->out_edges()) { task_edge->CheckRegstLbiValid(); }
+  });
+  timer.PhaseDone("InferTimeShape");
 
   // Step4: put infomation from task_gph into plan.
   const int64_t node_num = task_gph->node_num();
@@ -101,6 +175,7 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
   counter.WaitUntilCntEqualZero();
   // NOTE(levi): release task_gph here to decrise memory peak.
   task_gph.reset();
+  timer.PhaseDone("ToProto");
 
   // Step5: post-process for plan and delete Global<OpGraph>.
   auto* job_id2job_conf = plan->mutable_job_confs()->mutable_job_id2job_conf();
@@ -109,6 +184,13 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
   IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(plan, IsReachable);
   PlanUtil::SetUniqueMemBlockId4UnreusedMemRegst(plan);
   Global<OpGraph>::Delete();
+  timer.PhaseDone("InferMemBlockId");
+
+  if (!plan_cache_key.empty()) {
+    IdState id_state;
+    Global<IDMgr>::Get()->SaveIdState(&id_state);
+    SaveCachedPlan(plan_cache_key, *plan, id_state);
+  }
 }
 
 }  // namespace oneflow
@@ -28,4 +28,28 @@ IDMgr::IDMgr() {
   chunk_id_count_ = 0;
 }
 
+void IDMgr::SaveIdState(IdState* id_state) const {
+  id_state->set_regst_desc_id_count(regst_desc_id_count_);
+  id_state->set_mem_block_id_count(mem_block_id_count_);
+  id_state->set_chunk_id_count(chunk_id_count_);
+  id_state->set_unique_id_count(MutUniqueIdCounter()->load());
+  auto* counters = id_state->mutable_stream_id2task_index_counter();
+  counters->clear();
+  for (const auto& pair : task_id_gen_.task_index_counters()) {
+    (*counters)[EncodeStreamIdToInt64(pair.first)] = pair.second;
+  }
+}
+
+void IDMgr::RestoreIdState(const IdState& id_state) {
+  regst_desc_id_count_ = id_state.regst_desc_id_count();
+  mem_block_id_count_ = id_state.mem_block_id_count();
+  chunk_id_count_ = id_state.chunk_id_count();
+  MutUniqueIdCounter()->store(id_state.unique_id_count());
+  HashMap<StreamId, TaskIdGenerator::task_index_t> counters;
+  for (const auto& pair : id_state.stream_id2task_index_counter()) {
+    counters.emplace(DecodeStreamIdFromInt64(pair.first), pair.second);
+  }
+  task_id_gen_.set_task_index_counters(counters);
+}
+
 }  // namespace oneflow
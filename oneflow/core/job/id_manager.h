@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/job/job_desc.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/id_state.pb.h"
 #include "oneflow/core/graph/task_id_generator.h"
 
 namespace oneflow {
@@ -35,6 +36,10 @@ class IDMgr final {
 
   TaskIdGenerator* GetTaskIdGenerator() { return &task_id_gen_; }
 
+  // Save and restore all the id counters, including the one of NewUniqueId
+  void SaveIdState(IdState* id_state) const;
+  void RestoreIdState(const IdState& id_state);
+
  private:
   friend class Global<IDMgr>;
   IDMgr();
@@ -765,13 +765,36 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(
   // info for inplace
   HashMap<int64_t, HashMap<RegstDescProto*, RegstDescProto*>> mem_chain2consumer2inplaced_regst;
 
-  // step 1: generate regst alloc/free queue AND regst mutual exclusions
-  for (const auto& pair : mem_chain2mem_reused_regsts) {
+  // step 1: generate regst alloc/free queue AND regst mutual exclusions for each mem chain. With
+  // ONEFLOW_COMPILER_PARALLEL the mem chains are handled by Global<ThreadPool>, the maps are filled
+  // in advance so that every thread only touches its own mem chain
+  for (int64_t mem_chain_id : mem_chains) {
+    mem_chain2task2alloc_regsts[mem_chain_id];
+    mem_chain2task2free_regsts[mem_chain_id];
+    mem_chain2regst2mutual_exclusion_regsts[mem_chain_id];
+    mem_chain2consumer2inplaced_regst[mem_chain_id];
+  }
+  auto GenTimeLine4MemChain = [&](int64_t mem_chain_id,
+                                  const HashSet<RegstDescProto*>& mem_reused_regsts) {
     GenRegstAllocFreeTimeLineAndRegstMutualExclusions(
-        mem_chain2sorted_tasks.at(pair.first), pair.second, regst_desc_id2regst_desc,
-        &mem_chain2task2alloc_regsts[pair.first], &mem_chain2task2free_regsts[pair.first],
-        &mem_chain2regst2mutual_exclusion_regsts[pair.first],
-        &mem_chain2consumer2inplaced_regst[pair.first]);
+        mem_chain2sorted_tasks.at(mem_chain_id), mem_reused_regsts, regst_desc_id2regst_desc,
+        &mem_chain2task2alloc_regsts.at(mem_chain_id), &mem_chain2task2free_regsts.at(mem_chain_id),
+        &mem_chain2regst2mutual_exclusion_regsts.at(mem_chain_id),
+        &mem_chain2consumer2inplaced_regst.at(mem_chain_id));
+  };
+  if (ParseBooleanFromEnv("ONEFLOW_COMPILER_PARALLEL", false)) {
+    BlockingCounter counter(mem_chain2mem_reused_regsts.size());
+    for (const auto& pair : mem_chain2mem_reused_regsts) {
+      Global<ThreadPool>::Get()->AddWork([&GenTimeLine4MemChain, &pair, &counter]() {
+        GenTimeLine4MemChain(pair.first, pair.second);
+        counter.Decrease();
+      });
+    }
+    counter.WaitUntilCntEqualZero();
+  } else {
+    for (const auto& pair : mem_chain2mem_reused_regsts) {
+      GenTimeLine4MemChain(pair.first, pair.second);
+    }
   }
 
   // step 2: multi-thread run several algorithm for each mem chain
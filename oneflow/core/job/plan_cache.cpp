@@ -0,0 +1,188 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/job/plan_cache.pb.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/version.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#define XXH_NAMESPACE LZ4_
+#include <xxhash.h>
+
+namespace oneflow {
+
+namespace {
+
+const char* PlanCacheDir() { return std::getenv("ONEFLOW_PLAN_CACHE_DIR"); }
+
+// The env options which change the plan generated by Compiler, the options in the job conf are
+// keyed by the job conf
+constexpr const char* kPlanEnvOptions[] = {
+    "ONEFLOW_COMPILER_PARALLEL",
+};
+
+// Find the NT_GNU_BUILD_ID note of the loaded object which contains `addr`
+std::string FindGnuBuildId(const void* addr) {
+  struct Ctx {
+    uintptr_t addr;
+    std::string build_id;
+  } ctx{reinterpret_cast<uintptr_t>(addr), ""};
+  dl_iterate_phdr(
+      [](struct dl_phdr_info* info, size_t, void* data) -> int {
+        auto* ctx = static_cast<Ctx*>(data);
+        bool contains_addr = false;
+        for (int i = 0; i < info->dlpi_phnum; ++i) {
+          const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+          const uintptr_t begin = info->dlpi_addr + phdr.p_vaddr;
+          if (phdr.p_type == PT_LOAD && begin <= ctx->addr && ctx->addr < begin + phdr.p_memsz) {
+            contains_addr = true;
+          }
+        }
+        if (!contains_addr) { return 0; }
+        for (int i = 0; i < info->dlpi_phnum; ++i) {
+          const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+          if (phdr.p_type != PT_NOTE) { continue; }
+          const char* note = reinterpret_cast<const char*>(info->dlpi_addr + phdr.p_vaddr);
+          const char* end = note + phdr.p_memsz;
+          while (note + sizeof(ElfW(Nhdr)) <= end) {
+            const auto* nhdr = reinterpret_cast<const ElfW(Nhdr)*>(note);
+            const char* name = note + sizeof(ElfW(Nhdr));
+            const char* desc = name + RoundUp(nhdr->n_namesz, 4);
+            if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4
+                && std::memcmp(name, "GNU", 4) == 0) {
+              std::ostringstream ss;
+              ss << std::hex << std::setfill('0');
+              for (size_t j = 0; j < nhdr->n_descsz; ++j) {
+                ss << std::setw(2) << static_cast<int>(static_cast<uint8_t>(desc[j]));
+              }
+              ctx->build_id = ss.str();
+              return 1;
+            }
+            note = desc + RoundUp(nhdr->n_descsz, 4);
+          }
+        }
+        return 1;
+      },
+      &ctx);
+  return ctx.build_id;
+}
+
+std::string GenOneFlowBuildId() {
+  const void* addr = reinterpret_cast<const void*>(&GenOneFlowBuildId);
+  const std::string gnu_build_id = FindGnuBuildId(addr);
+  if (!gnu_build_id.empty()) { return gnu_build_id; }
+  Dl_info info;
+  struct stat st;
+  if (dladdr(addr, &info) != 0 && info.dli_fname != nullptr && stat(info.dli_fname, &st) == 0) {
+    return std::string(info.dli_fname) + ":" + std::to_string(st.st_size) + ":"
+           + std::to_string(st.st_mtime);
+  }
+  // never reuse the plans of an unknown build
+  return "N/A:" + std::to_string(getpid()) + ":" + std::to_string(time(nullptr));
+}
+
+// Maps are serialized in the order of keys, so equal messages have equal bytes
+void AppendDeterministicSerialization(const PbMessage& msg, std::string* bytes) {
+  google::protobuf::io::StringOutputStream output(bytes);
+  google::protobuf::io::CodedOutputStream coded_output(&output);
+  coded_output.SetSerializationDeterministic(true);
+  CHECK(msg.SerializeToCodedStream(&coded_output));
+}
+
+std::string PlanCacheFilePath(const std::string& key) {
+  return JoinPath(PlanCacheDir(), key + ".plan");
+}
+
+}  // namespace
+
+bool PlanCacheEnabled() {
+  const char* dir = PlanCacheDir();
+  return dir != nullptr && dir[0] != '\0';
+}
+
+const std::string& GetOneFlowBuildId() {
+  static const std::string build_id = GenOneFlowBuildId();
+  return build_id;
+}
+
+std::string GenPlanCacheKey(const Job& job, const JobConfigProto& job_conf,
+                            const Resource& resource, int64_t job_id, const IdState& id_state) {
+  std::string bytes;
+  AppendDeterministicSerialization(job, &bytes);
+  AppendDeterministicSerialization(job_conf, &bytes);
+  AppendDeterministicSerialization(resource, &bytes);
+  AppendDeterministicSerialization(id_state, &bytes);
+  bytes += "\n" + std::to_string(job_id);
+  for (const char* env_option : kPlanEnvOptions) {
+    const char* value = std::getenv(env_option);
+    // tell an unset option from an empty one
+    bytes += "\n" + std::string(env_option) + (value == nullptr ? "" : "=" + std::string(value));
+  }
+  bytes += "\n" + std::string(GetOneFlowGitVersion());
+  bytes += "\n" + GetOneFlowBuildId();
+  std::ostringstream ss;
+  ss << std::hex << std::setfill('0');
+  for (XXH64_hash_t seed : {0, 1}) {
+    ss << std::setw(16) << XXH64(bytes.data(), bytes.size(), seed);
+  }
+  return ss.str();
+}
+
+bool LoadCachedPlan(const std::string& key, Plan* plan, IdState* id_state) {
+  std::ifstream stream(PlanCacheFilePath(key), std::ios::binary);
+  if (!stream.is_open()) { return false; }
+  std::string bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+  PlanCacheEntry entry;
+  if (!entry.ParseFromString(bytes) || entry.key() != key) {
+    LOG(WARNING) << "ignore the broken plan cache " << PlanCacheFilePath(key);
+    return false;
+  }
+  plan->Swap(entry.mutable_plan());
+  id_state->Swap(entry.mutable_id_state());
+  return true;
+}
+
+void SaveCachedPlan(const std::string& key, const Plan& plan, const IdState& id_state) {
+  const std::string path = PlanCacheFilePath(key);
+  // write to a temporary file first, so that a concurrent reader never sees a partial entry
+  const std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  {
+    PlanCacheEntry entry;
+    entry.set_key(key);
+    *entry.mutable_id_state() = id_state;
+    *entry.mutable_plan() = plan;
+    std::ofstream stream(tmp_path, std::ios::binary);
+    if (!stream.is_open() || !entry.SerializeToOstream(&stream)) {
+      LOG(WARNING) << "can not save the plan cache " << path;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "can not save the plan cache " << path;
+    std::remove(tmp_path.c_str());
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,50 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+#define ONEFLOW_CORE_JOB_PLAN_CACHE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/id_state.pb.h"
+#include "oneflow/core/job/job.pb.h"
+#include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/job/resource.pb.h"
+
+namespace oneflow {
+
+// The plan cache stores the plans generated by Compiler in the directory
+// ONEFLOW_PLAN_CACHE_DIR, so that restarts of an identical job skip the compilation.
+//
+// The key is a hash of everything the plan depends on: the completed job, its job conf, which has
+// the inplace and mem reuse options, the resource, the id counters of IDMgr before compiling,
+// which every id in the plan depends on, the env options read by the compiler and the build ID of
+// OneFlow. A cached plan comes with the id counters after compiling it, which are restored on
+// loading.
+bool PlanCacheEnabled();
+
+std::string GenPlanCacheKey(const Job& job, const JobConfigProto& job_conf,
+                            const Resource& resource, int64_t job_id, const IdState& id_state);
+
+// The GNU build ID of the binary OneFlow is linked into, or the path, size and modification time
+// of the binary if it has no build ID
+const std::string& GetOneFlowBuildId();
+
+// Return false if the plan is not cached
+bool LoadCachedPlan(const std::string& key, Plan* plan, IdState* id_state);
+void SaveCachedPlan(const std::string& key, const Plan& plan, const IdState& id_state);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_PLAN_CACHE_H_
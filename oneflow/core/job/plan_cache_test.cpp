@@ -0,0 +1,139 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/plan_cache.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+class PlanCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    cache_dir_ = JoinPath(GetCwd(), "plan_cache_test_dir");
+    LocalFS()->RecursivelyCreateDirIfNotExist(cache_dir_);
+    setenv("ONEFLOW_PLAN_CACHE_DIR", cache_dir_.c_str(), 1);
+    unsetenv("ONEFLOW_COMPILER_PARALLEL");
+
+    job_.mutable_job_conf()->set_job_name("plan_cache_test_job");
+    job_.mutable_net()->add_op()->set_name("op_0");
+    job_conf_ = job_.job_conf();
+    resource_.set_machine_num(1);
+    resource_.set_cpu_device_num(4);
+    id_state_.set_regst_desc_id_count(10);
+    id_state_.set_mem_block_id_count(20);
+    id_state_.set_chunk_id_count(30);
+    id_state_.set_unique_id_count(40);
+    (*id_state_.mutable_stream_id2task_index_counter())[1] = 2;
+  }
+  void TearDown() override {
+    unsetenv("ONEFLOW_PLAN_CACHE_DIR");
+    unsetenv("ONEFLOW_COMPILER_PARALLEL");
+    LocalFS()->RecursivelyDeleteDir(cache_dir_);
+  }
+
+  std::string Key() const { return GenPlanCacheKey(job_, job_conf_, resource_, 7, id_state_); }
+
+  std::string cache_dir_;
+  Job job_;
+  JobConfigProto job_conf_;
+  Resource resource_;
+  IdState id_state_;
+};
+
+Plan MakePlan() {
+  Plan plan;
+  plan.mutable_block_chunk_list();
+  plan.mutable_collective_boxing_plan();
+  plan.mutable_ctrl_regst_desc_info();
+  JobConfigProto job_conf;
+  job_conf.set_job_name("plan_cache_test_job");
+  (*plan.mutable_job_confs()->mutable_job_id2job_conf())[7] = job_conf;
+  return plan;
+}
+
+}  // namespace
+
+TEST_F(PlanCacheTest, save_and_load) {
+  ASSERT_TRUE(PlanCacheEnabled());
+  const std::string key = Key();
+  Plan plan;
+  IdState id_state;
+  ASSERT_FALSE(LoadCachedPlan(key, &plan, &id_state));
+
+  IdState id_state_after_compile = id_state_;
+  id_state_after_compile.set_regst_desc_id_count(100);
+  SaveCachedPlan(key, MakePlan(), id_state_after_compile);
+  ASSERT_TRUE(LoadCachedPlan(key, &plan, &id_state));
+  ASSERT_EQ(plan.DebugString(), MakePlan().DebugString());
+  ASSERT_EQ(id_state.DebugString(), id_state_after_compile.DebugString());
+
+  // an entry of another key or a broken entry is never loaded
+  const std::string other_key = std::string(key.size(), '0');
+  ASSERT_EQ(std::rename(JoinPath(cache_dir_, key + ".plan").c_str(),
+                        JoinPath(cache_dir_, other_key + ".plan").c_str()),
+            0);
+  ASSERT_FALSE(LoadCachedPlan(other_key, &plan, &id_state));
+  std::ofstream(JoinPath(cache_dir_, key + ".plan"), std::ios::binary) << "broken";
+  ASSERT_FALSE(LoadCachedPlan(key, &plan, &id_state));
+}
+
+TEST_F(PlanCacheTest, key_invalidation) {
+  const std::string key = Key();
+  ASSERT_EQ(Key(), key);
+  ASSERT_FALSE(GetOneFlowBuildId().empty());
+  ASSERT_NE(GetOneFlowBuildId().substr(0, 4), "N/A:");
+
+  job_.mutable_net()->mutable_op(0)->set_name("op_1");
+  ASSERT_NE(Key(), key);
+  job_.mutable_net()->mutable_op(0)->set_name("op_0");
+  ASSERT_EQ(Key(), key);
+
+  job_conf_.set_enable_inplace(false);
+  const std::string no_inplace_key = Key();
+  ASSERT_NE(no_inplace_key, key);
+  job_conf_.set_enable_reuse_mem(false);
+  ASSERT_NE(Key(), no_inplace_key);
+  ASSERT_NE(Key(), key);
+  job_conf_ = job_.job_conf();
+  ASSERT_EQ(Key(), key);
+
+  resource_.set_cpu_device_num(8);
+  ASSERT_NE(Key(), key);
+  resource_.set_cpu_device_num(4);
+
+  id_state_.set_unique_id_count(41);
+  ASSERT_NE(Key(), key);
+  id_state_.set_unique_id_count(40);
+
+  ASSERT_NE(GenPlanCacheKey(job_, job_conf_, resource_, 8, id_state_), key);
+
+  setenv("ONEFLOW_COMPILER_PARALLEL", "", 1);
+  const std::string empty_env_key = Key();
+  ASSERT_NE(empty_env_key, key);
+  setenv("ONEFLOW_COMPILER_PARALLEL", "1", 1);
+  ASSERT_NE(Key(), key);
+  ASSERT_NE(Key(), empty_env_key);
+  unsetenv("ONEFLOW_COMPILER_PARALLEL");
+  ASSERT_EQ(Key(), key);
+}
+
+}  // namespace oneflow
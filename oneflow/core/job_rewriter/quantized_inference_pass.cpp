@@ -0,0 +1,138 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+bool IsUserOpWithTypeName(const OperatorConf& op_conf, const std::string& op_type_name) {
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+// The fake quantization which produces `lbn` if quantized_matmul supports it, otherwise nullptr
+const OpNode* FindInt8FakeQuantizationNode(const OpGraph& op_graph, const std::string& lbn) {
+  const OpNode* node = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+  if (!IsUserOpWithTypeName(node->op().op_conf(), "fake_quantization")) { return nullptr; }
+  const user_op::UserOpConfWrapper conf(node->op().op_conf());
+  if (conf.attr<std::string>("quantization_formula") != "google") { return nullptr; }
+  if (conf.attr<int32_t>("quantization_bit") != 8) { return nullptr; }
+  return node;
+}
+
+int64_t ScaleElemCnt4FakeQuantizationNode(const OpNode* node) {
+  const user_op::UserOpConfWrapper conf(node->op().op_conf());
+  return node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input("scale", 0))).shape().elem_cnt();
+}
+
+// Replace the matmuls on CPU between fake quantizations, which only simulate int8 in float, by
+// quantized_matmul. The fake quantizations are deleted if no other op consumes them.
+class QuantizedInferencePass final : public JobPass {
+ public:
+  QuantizedInferencePass() = default;
+  ~QuantizedInferencePass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_quantized_inference() && !ctx.job_desc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> QuantizedInferencePass::Apply(const OpGraph& op_graph,
+                                          JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  HashSet<const OpNode*> lowered_nodes;
+  HashSet<const OpNode*> fake_quantization_nodes;
+  std::vector<OperatorConf> new_op_confs;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!IsUserOpWithTypeName(op_conf, "matmul")
+        && !IsUserOpWithTypeName(op_conf, "broadcast_matmul")) {
+      return;
+    }
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    const user_op::UserOpConfWrapper matmul_conf(op_conf);
+    if (matmul_conf.attr<bool>("transpose_a")) { return; }
+    if (matmul_conf.has_input("_add_to_output", 0)) { return; }
+    const std::string& a_lbn = matmul_conf.input("a", 0);
+    if (op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(a_lbn)).data_type() != DataType::kFloat) {
+      return;
+    }
+    const OpNode* a_node = FindInt8FakeQuantizationNode(op_graph, a_lbn);
+    const OpNode* b_node = FindInt8FakeQuantizationNode(op_graph, matmul_conf.input("b", 0));
+    if (a_node == nullptr || b_node == nullptr) { return; }
+    const bool transpose_b = matmul_conf.attr<bool>("transpose_b");
+    // a is quantized per-layer, b per-layer or per output channel
+    if (ScaleElemCnt4FakeQuantizationNode(a_node) != 1) { return; }
+    if (ScaleElemCnt4FakeQuantizationNode(b_node) != 1 && !transpose_b) { return; }
+    const user_op::UserOpConfWrapper a_conf(a_node->op().op_conf());
+    const user_op::UserOpConfWrapper b_conf(b_node->op().op_conf());
+    user_op::UserOpConfWrapperBuilder quantized_matmul_builder(op_node->op().op_name());
+    quantized_matmul_builder.OpTypeName("quantized_matmul")
+        .Input("a", a_conf.input("in", 0))
+        .Input("b", b_conf.input("in", 0))
+        .Input("a_scale", a_conf.input("scale", 0))
+        .Input("a_zero_point", a_conf.input("zero_point", 0))
+        .Input("b_scale", b_conf.input("scale", 0))
+        .Input("b_zero_point", b_conf.input("zero_point", 0))
+        .Attr<bool>("transpose_b", transpose_b)
+        .Attr<double>("alpha", matmul_conf.attr<double>("alpha"))
+        .Attr<std::string>("a_quantization_scheme", a_conf.attr<std::string>("quantization_scheme"))
+        .Attr<std::string>("b_quantization_scheme", b_conf.attr<std::string>("quantization_scheme"))
+        .Output("out");
+    OperatorConf new_op_conf = op_conf;
+    *new_op_conf.mutable_user_conf() = quantized_matmul_builder.Build().op_conf().user_conf();
+    new_op_confs.emplace_back(new_op_conf);
+    lowered_nodes.insert(op_node);
+    fake_quantization_nodes.insert(a_node);
+    fake_quantization_nodes.insert(b_node);
+  });
+  std::vector<OperatorConf> delete_ops;
+  for (const OpNode* fake_quantization_node : fake_quantization_nodes) {
+    const OperatorConf& op_conf = fake_quantization_node->op().op_conf();
+    if (!op_conf.ctrl_in_op_name().empty() || IsKeyFound(ctrl_in_op_names, op_conf.name())) {
+      continue;
+    }
+    bool all_consumers_lowered = true;
+    for (const OpEdge* out_edge : fake_quantization_node->out_edges()) {
+      if (!IsKeyFound(lowered_nodes, out_edge->dst_node())) { all_consumers_lowered = false; }
+    }
+    if (all_consumers_lowered) { delete_ops.emplace_back(op_conf); }
+  }
+  job_builder->MutOpsOnlyOnce(new_op_confs);
+  job_builder->DelOps(delete_ops);
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("QuantizedInferencePass", QuantizedInferencePass);
+
+}  // namespace oneflow
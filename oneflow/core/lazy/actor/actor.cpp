@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/job/runtime_job_descs.h"
 #include "oneflow/core/stream/include/stream_context.h"
+#include "oneflow/core/profiler/host_tracer.h"
 
 namespace oneflow {
 
@@ -421,7 +422,10 @@ int Actor::HandlerZombie(const ActorMsg& msg) {
 
 void Actor::ActUntilFail() {
   while (IsReadReady() && IsWriteReady()) {
-    Act();
+    {
+      OF_HOST_TRACER_RANGE_GUARD("Act:" + std::to_string(actor_id_));
+      Act();
+    }
 
     AsyncSendCustomizedProducedRegstMsgToConsumer();
     AsyncSendNaiveProducedRegstMsgToConsumer();
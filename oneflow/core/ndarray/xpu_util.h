@@ -27,8 +27,13 @@ namespace oneflow {
 #define XPU_1D_KERNEL_LOOP_BEGIN(i, n) CUDA_1D_KERNEL_LOOP(i, n) {
 #define XPU_1D_KERNEL_LOOP_END() }
 #else
-#define XPU_1D_KERNEL_LOOP_BEGIN(i, n) MultiThreadLoop(n, [&](size_t i) {
+constexpr int64_t kXpu1DKernelLoopGrainSize = 32768;
+#define XPU_1D_KERNEL_LOOP_BEGIN(i, n)                                                \
+  ParallelFor(0, n, kXpu1DKernelLoopGrainSize,                                        \
+              [&](int64_t OF_PP_CAT(i, _begin), int64_t OF_PP_CAT(i, _end)) {         \
+                for (int64_t i = OF_PP_CAT(i, _begin); i < OF_PP_CAT(i, _end); ++i) {
 #define XPU_1D_KERNEL_LOOP_END() \
+  }                              \
   });
 #endif
 
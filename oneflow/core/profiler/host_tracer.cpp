@@ -0,0 +1,302 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/profiler/host_tracer.h"
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace oneflow {
+
+namespace profiler {
+
+namespace detail {
+
+std::atomic<bool> host_tracer_enabled(false);
+
+}  // namespace detail
+
+namespace {
+
+constexpr int64_t kDefaultBufferSize = 65536;
+constexpr size_t kMaxEventNameLength = 48;
+
+struct HostTraceEvent {
+  int64_t begin_ticks;
+  int64_t end_ticks;
+  char name[kMaxEventNameLength];
+};
+
+int64_t NowNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+int64_t NowTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return static_cast<int64_t>(__rdtsc());
+#else
+  return NowNanoseconds();
+#endif
+}
+
+// Events are kept in a ring buffer which is only written by its owner thread. The owner publishes
+// the event count with a release store, so a reader sees complete events below the count.
+struct ThreadTraceBuffer {
+  int64_t tid = 0;
+  std::string thread_name;  // guarded by the registry mutex
+  std::atomic<int64_t> generation{-1};
+  std::atomic<int64_t> event_cnt{0};
+  std::vector<HostTraceEvent> events;
+  std::vector<HostTraceEvent> range_stack;
+};
+
+class HostTracerRegistry final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(HostTracerRegistry);
+  HostTracerRegistry()
+      : generation_(0),
+        buffer_size_(ParseIntegerFromEnv("ONEFLOW_PROFILER_HOST_TRACER_BUFFER_SIZE",
+                                         kDefaultBufferSize)),
+        start_ticks_(NowTicks()),
+        start_ns_(NowNanoseconds()) {
+    CHECK_GT(buffer_size_, 0);
+    if (ParseBooleanFromEnv("ONEFLOW_PROFILER_HOST_TRACER_ENABLE", false)) {
+      detail::host_tracer_enabled.store(true, std::memory_order_relaxed);
+    }
+  }
+  ~HostTracerRegistry() = default;
+
+  static HostTracerRegistry* Singleton() {
+    static HostTracerRegistry* registry = new HostTracerRegistry();
+    return registry;
+  }
+
+  int64_t generation() const { return generation_.load(std::memory_order_acquire); }
+  int64_t buffer_size() const { return buffer_size_; }
+
+  ThreadTraceBuffer* ThisThreadBuffer() {
+    static thread_local ThreadBufferHolder holder;
+    std::shared_ptr<ThreadTraceBuffer>& buffer = holder.buffer;
+    if (!buffer) {
+      buffer = std::make_shared<ThreadTraceBuffer>();
+      buffer->tid = syscall(SYS_gettid);
+      buffer->thread_name = "thread_" + std::to_string(buffer->tid);
+      std::unique_lock<std::mutex> lock(mutex_);
+      buffers_.push_back(buffer);
+    }
+    return buffer.get();
+  }
+
+  size_t thread_buffer_num() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return buffers_.size();
+  }
+
+  void SetThreadName(ThreadTraceBuffer* buffer, const std::string& name) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    buffer->thread_name = name;
+  }
+
+  void Restart() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    start_ticks_ = NowTicks();
+    start_ns_ = NowNanoseconds();
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
+  std::string ChromeTraceJson() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int64_t cur_generation = generation();
+    const double ticks_per_us = TicksPerMicrosecond();
+    const int64_t pid = getpid();
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "{\"traceEvents\":[";
+    bool is_first = true;
+    auto Separator = [&is_first]() -> const char* {
+      if (is_first) {
+        is_first = false;
+        return "";
+      }
+      return ",\n";
+    };
+    for (const auto& buffer : buffers_) {
+      if (buffer->generation.load(std::memory_order_acquire) != cur_generation) { continue; }
+      ss << Separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+         << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":\""
+         << EscapeJson(buffer->thread_name) << "\"}}";
+      const std::vector<HostTraceEvent> events = SnapshotEvents(*buffer);
+      for (const HostTraceEvent& event : events) {
+        ss << Separator() << "{\"name\":\"" << EscapeJson(event.name)
+           << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+           << ",\"ts\":" << (event.begin_ticks - start_ticks_) / ticks_per_us
+           << ",\"dur\":" << (event.end_ticks - event.begin_ticks) / ticks_per_us << "}";
+      }
+    }
+    ss << "],\"displayTimeUnit\":\"ns\"}";
+    return ss.str();
+  }
+
+ private:
+  // The buffer of a thread is dropped when the thread exits, so that short-lived threads do not
+  // leave their ring buffers behind. The events of exited threads are not dumped.
+  struct ThreadBufferHolder {
+    std::shared_ptr<ThreadTraceBuffer> buffer;
+    ~ThreadBufferHolder() {
+      if (buffer) { Singleton()->Unregister(buffer.get()); }
+    }
+  };
+
+  void Unregister(const ThreadTraceBuffer* buffer) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [buffer](const std::shared_ptr<ThreadTraceBuffer>& registered) {
+                                    return registered.get() == buffer;
+                                  }),
+                   buffers_.end());
+  }
+
+  // The owner thread keeps recording while the events are copied, so the slots it may have
+  // overwritten during the copy are dropped, like the read side of a seqlock. The owner overwrites
+  // the slot of event `cnt - capacity` before it publishes `cnt + 1`.
+  static std::vector<HostTraceEvent> SnapshotEvents(const ThreadTraceBuffer& buffer) {
+    const int64_t event_cnt = buffer.event_cnt.load(std::memory_order_acquire);
+    const int64_t capacity = buffer.events.size();
+    const int64_t begin = std::max<int64_t>(0, event_cnt - capacity);
+    std::vector<HostTraceEvent> events(event_cnt - begin);
+    for (int64_t i = begin; i < event_cnt; ++i) {
+      std::memcpy(&events.at(i - begin), &buffer.events.at(i % capacity), sizeof(HostTraceEvent));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const int64_t latest_event_cnt = buffer.event_cnt.load(std::memory_order_relaxed);
+    const int64_t valid_begin = std::max<int64_t>(begin, latest_event_cnt - capacity + 1);
+    if (valid_begin >= event_cnt) { return {}; }
+    events.erase(events.begin(), events.begin() + (valid_begin - begin));
+    return events;
+  }
+
+  double TicksPerMicrosecond() const {
+    const int64_t elapsed_ns = NowNanoseconds() - start_ns_;
+    const int64_t elapsed_ticks = NowTicks() - start_ticks_;
+    if (elapsed_ns <= 0 || elapsed_ticks <= 0) { return 1000.0; }
+    return static_cast<double>(elapsed_ticks) * 1000.0 / elapsed_ns;
+  }
+
+  static std::string EscapeJson(const std::string& str) {
+    std::string ret;
+    ret.reserve(str.size());
+    for (char c : str) {
+      if (c == '"' || c == '\\') {
+        ret.push_back('\\');
+        ret.push_back(c);
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        ret.push_back(' ');
+      } else {
+        ret.push_back(c);
+      }
+    }
+    return ret;
+  }
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers_;
+  std::atomic<int64_t> generation_;
+  const int64_t buffer_size_;
+  int64_t start_ticks_;
+  int64_t start_ns_;
+};
+
+// Construct the registry on load for ONEFLOW_PROFILER_HOST_TRACER_ENABLE
+COMMAND(HostTracerRegistry::Singleton());
+
+// Drop the events and ranges recorded before the last HostTracerStart
+ThreadTraceBuffer* ThisThreadBufferOfCurrentGeneration() {
+  HostTracerRegistry* registry = HostTracerRegistry::Singleton();
+  ThreadTraceBuffer* buffer = registry->ThisThreadBuffer();
+  const int64_t generation = registry->generation();
+  if (buffer->generation.load(std::memory_order_relaxed) != generation) {
+    if (buffer->events.empty()) { buffer->events.resize(registry->buffer_size()); }
+    buffer->range_stack.clear();
+    buffer->event_cnt.store(0, std::memory_order_release);
+    buffer->generation.store(generation, std::memory_order_release);
+  }
+  return buffer;
+}
+
+}  // namespace
+
+void HostTracerStart() {
+  HostTracerRegistry::Singleton()->Restart();
+  detail::host_tracer_enabled.store(true, std::memory_order_release);
+}
+
+void HostTracerStop() { detail::host_tracer_enabled.store(false, std::memory_order_release); }
+
+void HostTracerNameThisThread(const std::string& name) {
+  HostTracerRegistry* registry = HostTracerRegistry::Singleton();
+  registry->SetThreadName(registry->ThisThreadBuffer(), name);
+}
+
+void HostTracerRangePush(const std::string& name) {
+  ThreadTraceBuffer* buffer = ThisThreadBufferOfCurrentGeneration();
+  buffer->range_stack.emplace_back();
+  HostTraceEvent* event = &buffer->range_stack.back();
+  const size_t name_length = std::min(name.size(), kMaxEventNameLength - 1);
+  std::memcpy(event->name, name.data(), name_length);
+  event->name[name_length] = '\0';
+  event->begin_ticks = NowTicks();
+}
+
+void HostTracerRangePop() {
+  const int64_t end_ticks = NowTicks();
+  HostTracerRegistry* registry = HostTracerRegistry::Singleton();
+  ThreadTraceBuffer* buffer = registry->ThisThreadBuffer();
+  // the range is pushed before the last HostTracerStart, or not pushed at all
+  if (buffer->generation.load(std::memory_order_relaxed) != registry->generation()) { return; }
+  if (buffer->range_stack.empty()) { return; }
+  const int64_t event_cnt = buffer->event_cnt.load(std::memory_order_relaxed);
+  HostTraceEvent* event = &buffer->events.at(event_cnt % buffer->events.size());
+  *event = buffer->range_stack.back();
+  event->end_ticks = end_ticks;
+  buffer->range_stack.pop_back();
+  buffer->event_cnt.store(event_cnt + 1, std::memory_order_release);
+}
+
+size_t HostTracerThreadBufferNum() { return HostTracerRegistry::Singleton()->thread_buffer_num(); }
+
+std::string HostTracerChromeTraceJson() {
+  return HostTracerRegistry::Singleton()->ChromeTraceJson();
+}
+
+Maybe<void> HostTracerDumpChromeTrace(const std::string& path) {
+  std::ofstream ofs(path);
+  CHECK_OR_RETURN(ofs.is_open()) << "Can not open " << path;
+  ofs << HostTracerChromeTraceJson();
+  ofs.close();
+  return Maybe<void>::Ok();
+}
+
+}  // namespace profiler
+
+}  // namespace oneflow
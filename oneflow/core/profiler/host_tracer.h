@@ -0,0 +1,84 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PROFILER_HOST_TRACER_H_
+#define ONEFLOW_CORE_PROFILER_HOST_TRACER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/maybe.h"
+
+namespace oneflow {
+
+namespace profiler {
+
+// The host tracer records ranges of every thread into a per-thread ring buffer, which is only
+// written by its owner thread, and dumps them as Chrome trace JSON (chrome://tracing, Perfetto).
+// It does not depend on NVTX and can be switched on and off at runtime, the cost of a range is a
+// relaxed atomic load when it is off.
+//
+// Set ONEFLOW_PROFILER_HOST_TRACER_ENABLE=1 to trace from the process start, and
+// ONEFLOW_PROFILER_HOST_TRACER_BUFFER_SIZE to change the number of events kept per thread.
+
+namespace detail {
+
+extern std::atomic<bool> host_tracer_enabled;
+
+}  // namespace detail
+
+inline bool HostTracerEnabled() {
+  return detail::host_tracer_enabled.load(std::memory_order_relaxed);
+}
+
+// Drop all the recorded events and start tracing
+void HostTracerStart();
+void HostTracerStop();
+
+void HostTracerNameThisThread(const std::string& name);
+void HostTracerRangePush(const std::string& name);
+// It is safe to pop a range which is pushed before HostTracerStart or after HostTracerStop
+void HostTracerRangePop();
+
+// The number of threads with a ring buffer, a thread drops its buffer when it exits
+size_t HostTracerThreadBufferNum();
+
+std::string HostTracerChromeTraceJson();
+Maybe<void> HostTracerDumpChromeTrace(const std::string& path);
+
+// `GetName` is only called when the host tracer is enabled
+class HostTraceRangeGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(HostTraceRangeGuard);
+  template<typename GetNameT>
+  explicit HostTraceRangeGuard(const GetNameT& GetName) : started_(HostTracerEnabled()) {
+    if (started_) { HostTracerRangePush(GetName()); }
+  }
+  ~HostTraceRangeGuard() {
+    if (started_) { HostTracerRangePop(); }
+  }
+
+ private:
+  bool started_;
+};
+
+}  // namespace profiler
+
+}  // namespace oneflow
+
+// `name` is only evaluated when the host tracer is enabled
+#define OF_HOST_TRACER_RANGE_GUARD(name)                                                     \
+  ::oneflow::profiler::HostTraceRangeGuard OF_PP_CAT(_of_host_tracer_range_guard_, __COUNTER__)( \
+      [&]() -> std::string { return name; })
+
+#endif  // ONEFLOW_CORE_PROFILER_HOST_TRACER_H_
@@ -0,0 +1,113 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/profiler/host_tracer.h"
+#include "oneflow/core/profiler/profiler.h"
+
+namespace oneflow {
+
+namespace profiler {
+
+namespace {
+
+// The names of the complete events, the thread name metadata is skipped
+std::vector<std::string> EventNames(const std::string& json) {
+  std::vector<std::string> names;
+  const std::string key = "{\"name\":\"";
+  const std::string complete_event_phase = "\",\"ph\":\"X\"";
+  for (size_t pos = json.find(key); pos != std::string::npos; pos = json.find(key, pos)) {
+    pos += key.size();
+    const size_t end = json.find('"', pos);
+    if (json.compare(end, complete_event_phase.size(), complete_event_phase) != 0) { continue; }
+    names.emplace_back(json.substr(pos, end - pos));
+  }
+  return names;
+}
+
+}  // namespace
+
+TEST(HostTracer, range_pop_after_stop_is_not_recorded) {
+  HostTracerStart();
+  RangePush("traced_range");
+  RangePop();
+  RangePush("popped_after_stop");
+  HostTracerStop();
+  RangePop();
+  const std::vector<std::string> names = EventNames(HostTracerChromeTraceJson());
+  ASSERT_EQ(std::count(names.begin(), names.end(), "traced_range"), 1);
+  ASSERT_EQ(std::count(names.begin(), names.end(), "popped_after_stop"), 0);
+}
+
+TEST(HostTracer, range_guard_is_one_statement) {
+  HostTracerStart();
+  for (bool condition : {false, true}) {
+    // the guard is the whole body of the branch and does not take the else
+    if (condition)
+      OF_HOST_TRACER_RANGE_GUARD("if_branch");
+    else
+      OF_HOST_TRACER_RANGE_GUARD("else_branch");
+  }
+  {
+    // clang-format off
+    OF_HOST_TRACER_RANGE_GUARD("first_on_line"); OF_HOST_TRACER_RANGE_GUARD("second_on_line");
+    // clang-format on
+  }
+  HostTracerStop();
+  const std::vector<std::string> names = EventNames(HostTracerChromeTraceJson());
+  for (const std::string& name : {"if_branch", "else_branch", "first_on_line", "second_on_line"}) {
+    ASSERT_EQ(std::count(names.begin(), names.end(), name), 1) << name;
+  }
+}
+
+TEST(HostTracer, exited_threads_drop_their_buffers) {
+  HostTracerStart();
+  HostTracerRangePush("main_thread_range");
+  HostTracerRangePop();
+  const size_t thread_buffer_num = HostTracerThreadBufferNum();
+  for (int i = 0; i < 8; ++i) {
+    std::thread([]() {
+      HostTracerRangePush("short_lived_thread_range");
+      HostTracerRangePop();
+    }).join();
+  }
+  ASSERT_EQ(HostTracerThreadBufferNum(), thread_buffer_num);
+  HostTracerStop();
+}
+
+TEST(HostTracer, dump_while_recording) {
+  HostTracerStart();
+  std::atomic<bool> done(false);
+  std::thread recorder([&done]() {
+    // more events than the ring buffer keeps, so that slots are overwritten while dumping
+    for (int64_t i = 0; i < 200000; ++i) {
+      HostTracerRangePush(i % 2 == 0 ? "even_range" : "odd_range");
+      HostTracerRangePop();
+    }
+    done = true;
+  });
+  int64_t dump_cnt = 0;
+  while (!done || dump_cnt == 0) {
+    for (const auto& name : EventNames(HostTracerChromeTraceJson())) {
+      ASSERT_TRUE(name == "even_range" || name == "odd_range") << name;
+    }
+    ++dump_cnt;
+  }
+  recorder.join();
+  HostTracerStop();
+}
+
+}  // namespace profiler
+
+}  // namespace oneflow
@@ -28,24 +28,27 @@ namespace oneflow {
 namespace profiler {
 
 void NameThisHostThread(const std::string& name) {
-#ifdef OF_ENABLE_PROFILER
   static thread_local std::unique_ptr<std::string> thread_name_prefix;
   if (!thread_name_prefix) {
     thread_name_prefix.reset(
         new std::string(GetStringFromEnv("ONEFLOW_PROFILER_HOST_THREAD_NAME_PREFIX", "")));
   }
   const std::string name_with_prefix = *thread_name_prefix + name;
+  HostTracerNameThisThread(name_with_prefix);
+#ifdef OF_ENABLE_PROFILER
   nvtxNameOsThreadA(syscall(SYS_gettid), name_with_prefix.c_str());
 #endif  // OF_ENABLE_PROFILER
 }
 
 void RangePush(const std::string& name) {
+  if (HostTracerEnabled()) { HostTracerRangePush(name); }
 #ifdef OF_ENABLE_PROFILER
   nvtxRangePushA(name.c_str());
 #endif  // OF_ENABLE_PROFILER
 }
 
 void RangePop() {
+  if (HostTracerEnabled()) { HostTracerRangePop(); }
 #ifdef OF_ENABLE_PROFILER
   nvtxRangePop();
 #endif  // OF_ENABLE_PROFILER
@@ -68,7 +71,8 @@ class RangeGuardCtx {
 class RangeGuardCtx {};
 #endif  // OF_ENABLE_PROFILER
 
-RangeGuard::RangeGuard(const std::string& name) {
+RangeGuard::RangeGuard(const std::string& name) : host_traced_(HostTracerEnabled()) {
+  if (host_traced_) { HostTracerRangePush(name); }
 #ifdef OF_ENABLE_PROFILER
   nvtxRangeId_t range_id = nvtxRangeStartA(name.c_str());
   ctx_.reset(new RangeGuardCtx(range_id));
@@ -76,6 +80,7 @@ RangeGuard::RangeGuard(const std::string& name) {
 }
 
 RangeGuard::~RangeGuard() {
+  if (host_traced_) { HostTracerRangePop(); }
 #ifdef OF_ENABLE_PROFILER
   nvtxRangeEnd(ctx_->range_id());
 #endif  // OF_ENABLE_PROFILER
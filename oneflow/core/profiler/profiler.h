@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_PROFILER_PROFILER_H_
 
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/profiler/host_tracer.h"
 
 namespace oneflow {
 
@@ -44,6 +45,7 @@ class RangeGuard final {
 
  private:
   std::shared_ptr<RangeGuardCtx> ctx_;
+  bool host_traced_;
 };
 
 #ifdef OF_ENABLE_PROFILER
@@ -51,15 +53,19 @@ class RangeGuard final {
 #define OF_PROFILER_ONLY_CODE(...) __VA_ARGS__
 #define OF_PROFILER_RANGE_PUSH(name) ::oneflow::profiler::RangePush(name)
 #define OF_PROFILER_RANGE_POP() ::oneflow::profiler::RangePop()
-#define OF_PROFILER_RANGE_GUARD(name) \
+#define OF_PROFILER_RANGE_GUARD(name)                                                     \
   ::oneflow::profiler::RangeGuard OF_PP_CAT(_of_profiler_range_guard_, __COUNTER__)(name)
 #define OF_PROFILER_LOG_HOST_MEMORY_USAGE(name) ::oneflow::profiler::LogHostMemoryUsage(name)
 #else
+// Without OF_ENABLE_PROFILER the ranges only go to the host tracer, see host_tracer.h
 #define OF_PROFILER_ONLY_CODE(...)
-#define OF_PROFILER_RANGE_PUSH(name)
-#define OF_PROFILER_RANGE_POP()
-#define OF_PROFILER_RANGE_GUARD(name)
-#define OF_PROFILER_NAME_THIS_HOST_THREAD(name)
+#define OF_PROFILER_RANGE_PUSH(name)                                                        \
+  do {                                                                                      \
+    if (::oneflow::profiler::HostTracerEnabled()) { ::oneflow::profiler::RangePush(name); } \
+  } while (0)
+#define OF_PROFILER_RANGE_POP() ::oneflow::profiler::RangePop()
+#define OF_PROFILER_RANGE_GUARD(name) OF_HOST_TRACER_RANGE_GUARD(name)
+#define OF_PROFILER_NAME_THIS_HOST_THREAD(name) ::oneflow::profiler::NameThisHostThread(name)
 #define OF_PROFILER_LOG_HOST_MEMORY_USAGE(name)
 #endif
 
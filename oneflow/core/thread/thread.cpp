@@ -23,7 +23,21 @@ limitations under the License.
 
 namespace oneflow {
 
-Thread::Thread(const StreamId& stream_id) : thrd_id_(EncodeStreamIdToInt64(stream_id)) {
+namespace {
+
+constexpr int64_t kDefaultMsgChannelCapacity = 4096;
+
+size_t MsgChannelCapacity() {
+  const int64_t capacity =
+      ParseIntegerFromEnv("ONEFLOW_THREAD_MSG_CHANNEL_CAPACITY", kDefaultMsgChannelCapacity);
+  CHECK_GT(capacity, 0);
+  return 1ULL << (63 ^ __builtin_clzll(static_cast<uint64_t>(capacity)));
+}
+
+}  // namespace
+
+Thread::Thread(const StreamId& stream_id)
+    : msg_channel_(MsgChannelCapacity()), thrd_id_(EncodeStreamIdToInt64(stream_id)) {
   local_msg_queue_enabled_ =
       ParseBooleanFromEnv("ONEFLOW_THREAD_ENABLE_LOCAL_MESSAGE_QUEUE", false);
   light_actor_enabled_ = ParseBooleanFromEnv("ONEFLOW_ACTOR_ENABLE_LIGHT_ACTOR", false);
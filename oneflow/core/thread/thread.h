@@ -17,7 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_THREAD_THREAD_H_
 
 #include "oneflow/core/lazy/actor/actor_message_bus.h"
-#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/mpsc_ring_channel.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/job/task.pb.h"
 #include "oneflow/core/lazy/actor/actor.h"
@@ -35,7 +35,7 @@ class Thread {
 
   void AddTask(const TaskProto&);
 
-  Channel<ActorMsg>* GetMsgChannelPtr() { return &msg_channel_; }
+  MpscRingChannel<ActorMsg>* GetMsgChannelPtr() { return &msg_channel_; }
 
   inline void EnqueueActorMsg(const ActorMsg& msg) {
     if (UseLocalMsgQueue()) {
@@ -68,7 +68,7 @@ class Thread {
   std::mutex id2task_mtx_;
 
   std::thread actor_thread_;
-  Channel<ActorMsg> msg_channel_;
+  MpscRingChannel<ActorMsg> msg_channel_;
   HashMap<int64_t, std::pair<std::unique_ptr<ActorContext>, std::unique_ptr<ActorBase>>>
       id2actor_ptr_;
   HashMap<int64_t, int64_t> id2job_id_;
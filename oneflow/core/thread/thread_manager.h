@@ -47,6 +47,18 @@ class ThreadMgr final {
 
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 
+template<typename DoRangeT>
+void ParallelFor(int64_t begin, int64_t end, int64_t grain, const DoRangeT& DoRange) {
+  if (begin >= end) { return; }
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  // run on the caller thread out of an env, e.g. in the tests of primitives
+  if (unlikely(pthread_fork::IsForkedSubProcess() || thread_pool == nullptr)) {
+    DoRange(begin, end);
+    return;
+  }
+  thread_pool->ParallelFor(begin, end, grain, DoRange);
+}
+
 template<typename DoEachT>
 void MultiThreadLoop(size_t num, const DoEachT& DoEach) {
   if (num == 0) { return; }
@@ -54,20 +66,9 @@ void MultiThreadLoop(size_t num, const DoEachT& DoEach) {
     SingleThreadLoop(num, DoEach);
     return;
   }
-  size_t thread_num = Global<ThreadPool>::Get()->thread_num();
-  thread_num = std::min(num, thread_num);
-  BalancedSplitter bs(num, thread_num);
-  BlockingCounter bc(thread_num);
-  FOR_RANGE(size_t, range_id, 0, thread_num) {
-    Global<ThreadPool>::Get()->AddWork([&bc, &bs, range_id, DoEach] {
-      size_t start = bs.At(range_id).begin();
-      size_t end = bs.At(range_id).end();
-      FOR_RANGE(size_t, i, start, end) { DoEach(i); }
-      bc.Decrease();
-    });
-  }
-  // buzy loop wait.
-  bc.WaitUntilCntEqualZero();
+  Global<ThreadPool>::Get()->ParallelFor(0, num, 1, [&DoEach](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) { DoEach(i); }
+  });
 }
 
 }  // namespace oneflow
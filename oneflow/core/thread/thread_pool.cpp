@@ -14,31 +14,181 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kWorkerDequeCapacity = 1024;
+constexpr int kSpinCountBeforePark = 64;
+// Split a ParallelFor into more chunks than threads so that uneven chunks are balanced
+constexpr int64_t kChunkNumPerThread = 4;
+
+thread_local const ThreadPool* tls_thread_pool = nullptr;
+thread_local int32_t tls_worker_id = -1;
+thread_local int32_t tls_parallel_for_thread_budget = 0;
+
+struct ParallelForCtx {
+  ParallelForCtx(int64_t begin, int64_t end, int64_t chunk_size, int64_t chunk_num)
+      : begin(begin),
+        end(end),
+        chunk_size(chunk_size),
+        chunk_num(chunk_num),
+        next_chunk(0),
+        remaining_chunk_cnt(chunk_num),
+        bc(1) {}
+
+  const int64_t begin;
+  const int64_t end;
+  const int64_t chunk_size;
+  const int64_t chunk_num;
+  std::atomic<int64_t> next_chunk;
+  std::atomic<int64_t> remaining_chunk_cnt;
+  BlockingCounter bc;
+};
+
+// Grab and run chunks until all of them are taken. DoRange is only touched after a chunk is
+// grabbed, and ParallelFor returns only after all the grabbed chunks are done, so a helper running
+// after ParallelFor returns never touches a dangling DoRange.
+void RunParallelForChunks(ParallelForCtx* ctx,
+                          const std::function<void(int64_t, int64_t)>& DoRange) {
+  while (true) {
+    const int64_t chunk_id = ctx->next_chunk.fetch_add(1, std::memory_order_relaxed);
+    if (chunk_id >= ctx->chunk_num) { break; }
+    const int64_t range_begin = ctx->begin + chunk_id * ctx->chunk_size;
+    const int64_t range_end = std::min(range_begin + ctx->chunk_size, ctx->end);
+    DoRange(range_begin, range_end);
+    if (ctx->remaining_chunk_cnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      ctx->bc.Decrease();
+    }
+  }
+}
+
+}  // namespace
+
 ThreadPool::ThreadPool(int32_t thread_num)
-    : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
+    : worker_deques_(thread_num),
+      threads_(thread_num),
+      parked_worker_cnt_(0),
+      pending_work_cnt_(0),
+      is_closed_(false) {
   FOR_RANGE(int32_t, i, 0, thread_num) {
-    Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
-      std::function<void()> work;
-      while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
-    });
+    worker_deques_.at(i).reset(new WorkStealingDeque<Work*>(kWorkerDequeCapacity));
+  }
+  FOR_RANGE(int32_t, i, 0, thread_num) {
+    threads_[i] = std::thread([this, i]() { WorkerLoop(i); });
   }
 }
 
 ThreadPool::~ThreadPool() {
-  FOR_RANGE(int32_t, i, 0, work_chans_.size()) {
-    work_chans_.at(i).Close();
-    threads_.at(i).join();
+  {
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    is_closed_ = true;
   }
+  park_cond_.notify_all();
+  for (std::thread& thread : threads_) { thread.join(); }
+  CHECK(injection_queue_.empty());
 }
 
 void ThreadPool::AddWork(const std::function<void()>& work) {
-  const size_t cur_chan_idx =
-      work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_chans_.size();
-  work_chans_.at(cur_chan_idx).Send(work);
+  Work* new_work = new Work(work);
+  if (tls_thread_pool != this || !worker_deques_.at(tls_worker_id)->Push(new_work)) {
+    std::unique_lock<std::mutex> lock(injection_mutex_);
+    injection_queue_.push_back(new_work);
+  }
+  pending_work_cnt_.fetch_add(1, std::memory_order_seq_cst);
+  if (parked_worker_cnt_.load(std::memory_order_seq_cst) > 0) { NotifyOneParkedWorker(); }
+}
+
+void ThreadPool::NotifyOneParkedWorker() {
+  // Take the lock so that a worker is either before its predicate check or already waiting
+  { std::unique_lock<std::mutex> lock(park_mutex_); }
+  park_cond_.notify_one();
+}
+
+bool ThreadPool::TryGetWork(int32_t worker_id, Work** work) {
+  if (worker_deques_.at(worker_id)->Pop(work)) { return true; }
+  {
+    std::unique_lock<std::mutex> lock(injection_mutex_);
+    if (!injection_queue_.empty()) {
+      *work = injection_queue_.front();
+      injection_queue_.pop_front();
+      return true;
+    }
+  }
+  const int32_t worker_num = worker_deques_.size();
+  FOR_RANGE(int32_t, i, 1, worker_num) {
+    if (worker_deques_.at((worker_id + i) % worker_num)->Steal(work)) { return true; }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(int32_t worker_id) {
+  tls_thread_pool = this;
+  tls_worker_id = worker_id;
+  int spin_cnt = 0;
+  while (true) {
+    Work* work = nullptr;
+    if (TryGetWork(worker_id, &work)) {
+      pending_work_cnt_.fetch_sub(1, std::memory_order_seq_cst);
+      (*work)();
+      delete work;
+      spin_cnt = 0;
+      continue;
+    }
+    if (spin_cnt < kSpinCountBeforePark) {
+      ++spin_cnt;
+      std::this_thread::yield();
+      continue;
+    }
+    spin_cnt = 0;
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    parked_worker_cnt_.fetch_add(1, std::memory_order_seq_cst);
+    park_cond_.wait(lock, [this]() {
+      return is_closed_ || pending_work_cnt_.load(std::memory_order_seq_cst) > 0;
+    });
+    parked_worker_cnt_.fetch_sub(1, std::memory_order_seq_cst);
+    if (is_closed_ && pending_work_cnt_.load(std::memory_order_seq_cst) <= 0) { break; }
+  }
+}
+
+void ThreadPool::ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                             const std::function<void(int64_t, int64_t)>& DoRange) {
+  if (begin >= end) { return; }
+  grain = std::max<int64_t>(grain, 1);
+  const int64_t elem_cnt = end - begin;
+  // rounded down, so that every chunk but the tail has at least `grain` elements
+  const int64_t max_chunk_num = std::max<int64_t>(elem_cnt / grain, 1);
+  int64_t max_helper_num = thread_num();
+  if (tls_parallel_for_thread_budget > 0) {
+    max_helper_num = std::min<int64_t>(max_helper_num, tls_parallel_for_thread_budget - 1);
+  }
+  if (max_chunk_num <= 1 || max_helper_num == 0) {
+    DoRange(begin, end);
+    return;
+  }
+  int64_t chunk_num = std::min(max_chunk_num, (max_helper_num + 1) * kChunkNumPerThread);
+  const int64_t chunk_size = (elem_cnt + chunk_num - 1) / chunk_num;
+  chunk_num = (elem_cnt + chunk_size - 1) / chunk_size;
+  auto ctx = std::make_shared<ParallelForCtx>(begin, end, chunk_size, chunk_num);
+  const int64_t helper_num = std::min<int64_t>(chunk_num - 1, max_helper_num);
+  FOR_RANGE(int64_t, i, 0, helper_num) {
+    AddWork([ctx, &DoRange]() { RunParallelForChunks(ctx.get(), DoRange); });
+  }
+  RunParallelForChunks(ctx.get(), DoRange);
+  FOR_RANGE(int, i, 0, kSpinCountBeforePark) {
+    if (ctx->remaining_chunk_cnt.load(std::memory_order_acquire) == 0) { return; }
+    std::this_thread::yield();
+  }
+  ctx->bc.WaitUntilCntEqualZero();
+}
+
+void ThreadPool::SetParallelForThreadBudgetOfThisThread(int32_t thread_budget) {
+  CHECK_GE(thread_budget, 0);
+  tls_parallel_for_thread_budget = thread_budget;
 }
 
+int32_t ThreadPool::ParallelForThreadBudgetOfThisThread() { return tls_parallel_for_thread_budget; }
+
 }  // namespace oneflow
@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 #define ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 
+#include <deque>
 #include "oneflow/core/common/util.h"
-#include "oneflow/core/common/channel.h"
+#include "oneflow/core/thread/work_stealing_deque.h"
 
 namespace oneflow {
 
+// ThreadPool is a work-stealing pool. Works added by a worker thread go to its own deque, works
+// added by other threads go to a shared injection queue, and idle workers steal from each other.
 class ThreadPool final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ThreadPool);
@@ -31,11 +34,38 @@ class ThreadPool final {
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
 
+  // Call DoRange(range_begin, range_end) on disjoint sub-ranges covering [begin, end), each of
+  // which has at least `grain` elements unless it is the tail. The caller thread takes part in
+  // the loop and returns after all the sub-ranges are done, so it is safe to call ParallelFor
+  // inside a work of this pool.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                   const std::function<void(int64_t, int64_t)>& DoRange);
+
+  // Limit the threads, the caller included, a ParallelFor called on this thread runs on. Threads
+  // calling ParallelFor side by side, e.g. the cpu compute streams of the vm, split the cores by
+  // it instead of all taking every worker. 0 means no limit.
+  static void SetParallelForThreadBudgetOfThisThread(int32_t thread_budget);
+  static int32_t ParallelForThreadBudgetOfThisThread();
+
  private:
-  std::vector<Channel<std::function<void()>>> work_chans_;
+  using Work = std::function<void()>;
+
+  void WorkerLoop(int32_t worker_id);
+  bool TryGetWork(int32_t worker_id, Work** work);
+  void NotifyOneParkedWorker();
+
+  std::vector<std::unique_ptr<WorkStealingDeque<Work*>>> worker_deques_;
   std::vector<std::thread> threads_;
 
-  std::atomic<size_t> work_cnt_;
+  std::mutex injection_mutex_;
+  std::deque<Work*> injection_queue_;
+
+  std::mutex park_mutex_;
+  std::condition_variable park_cond_;
+  std::atomic<int32_t> parked_worker_cnt_;
+  // number of works added but not taken yet
+  std::atomic<int64_t> pending_work_cnt_;
+  bool is_closed_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,89 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
+
+namespace oneflow {
+
+namespace {
+
+void TestParallelForVisitEachOnce(ThreadPool* thread_pool, int64_t num, int64_t grain) {
+  std::vector<std::atomic<int32_t>> visit(num);
+  for (auto& cnt : visit) { cnt = 0; }
+  thread_pool->ParallelFor(0, num, grain, [&](int64_t begin, int64_t end) {
+    ASSERT_TRUE(end - begin >= grain || end == num);
+    FOR_RANGE(int64_t, i, begin, end) { visit.at(i) += 1; }
+  });
+  for (const auto& cnt : visit) { ASSERT_EQ(cnt, 1); }
+}
+
+}  // namespace
+
+TEST(ThreadPool, add_work) {
+  ThreadPool thread_pool(4);
+  std::atomic<int64_t> sum(0);
+  BlockingCounter bc(1000);
+  FOR_RANGE(int64_t, i, 0, 1000) {
+    thread_pool.AddWork([i, &sum, &bc]() {
+      sum += i;
+      bc.Decrease();
+    });
+  }
+  bc.WaitUntilCntEqualZero();
+  ASSERT_EQ(sum, 999 * 1000 / 2);
+}
+
+TEST(ThreadPool, parallel_for) {
+  ThreadPool thread_pool(4);
+  TestParallelForVisitEachOnce(&thread_pool, 1, 1);
+  TestParallelForVisitEachOnce(&thread_pool, 7, 1);
+  TestParallelForVisitEachOnce(&thread_pool, 1000, 1);
+  TestParallelForVisitEachOnce(&thread_pool, 1000, 33);
+  TestParallelForVisitEachOnce(&thread_pool, 4, 3);
+  TestParallelForVisitEachOnce(&thread_pool, 11, 5);
+  TestParallelForVisitEachOnce(&thread_pool, 1000, 999);
+  TestParallelForVisitEachOnce(&thread_pool, 100000, 1024);
+}
+
+TEST(ThreadPool, nested_parallel_for) {
+  ThreadPool thread_pool(2);
+  std::atomic<int64_t> cnt(0);
+  thread_pool.ParallelFor(0, 16, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      thread_pool.ParallelFor(0, 100, 1, [&](int64_t inner_begin, int64_t inner_end) {
+        cnt += inner_end - inner_begin;
+      });
+    }
+  });
+  ASSERT_EQ(cnt, 1600);
+}
+
+TEST(ThreadPool, parallel_for_thread_budget) {
+  ThreadPool thread_pool(4);
+  ThreadPool::SetParallelForThreadBudgetOfThisThread(1);
+  const auto caller_id = std::this_thread::get_id();
+  std::atomic<int64_t> other_thread_chunk_cnt(0);
+  thread_pool.ParallelFor(0, 1000, 1, [&](int64_t begin, int64_t end) {
+    if (std::this_thread::get_id() != caller_id) { other_thread_chunk_cnt += 1; }
+  });
+  ASSERT_EQ(other_thread_chunk_cnt, 0);
+  ThreadPool::SetParallelForThreadBudgetOfThisThread(2);
+  TestParallelForVisitEachOnce(&thread_pool, 1000, 1);
+  ThreadPool::SetParallelForThreadBudgetOfThisThread(0);
+  ASSERT_EQ(ThreadPool::ParallelForThreadBudgetOfThisThread(), 0);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,96 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_THREAD_WORK_STEALING_DEQUE_H_
+#define ONEFLOW_CORE_THREAD_WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Bounded Chase-Lev deque. Only the owner thread may call Push() and Pop(), which work on the
+// bottom end in LIFO order; any thread may call Steal(), which takes from the top end.
+// T must be trivially copyable, usually a pointer.
+template<typename T>
+class WorkStealingDeque final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(WorkStealingDeque);
+  explicit WorkStealingDeque(size_t capacity)
+      : top_(0), bottom_(0), mask_(capacity - 1), buffer_(new std::atomic<T>[capacity]) {
+    CHECK_GT(capacity, 0);
+    CHECK_EQ(capacity & mask_, 0) << "capacity must be power of 2";
+  }
+  ~WorkStealingDeque() = default;
+
+  // Return false if the deque is full
+  bool Push(T value) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_) { return false; }
+    buffer_[b & mask_].store(value, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool Pop(T* value) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    *value = buffer_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) {
+      // the last element, race with thieves
+      const bool success = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                        std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return success;
+    }
+    return true;
+  }
+
+  bool Steal(T* value) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) { return false; }
+    *value = buffer_[t & mask_].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+  bool Empty() const {
+    return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> top_;
+  // keep top_ and bottom_ on different cache lines, thieves only write top_
+  char padding_[64 - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom_;
+  const int64_t mask_;
+  std::unique_ptr<std::atomic<T>[]> buffer_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_THREAD_WORK_STEALING_DEQUE_H_
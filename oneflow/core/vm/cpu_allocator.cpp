@@ -20,11 +20,50 @@ limitations under the License.
 namespace oneflow {
 namespace vm {
 
+namespace {
+
+constexpr int64_t kDefaultMaxCachedMBytes = 1024;
+
+}  // namespace
+
+CpuAllocator::CpuAllocator() : Allocator(), cpu_caching_allocator_(nullptr) {
+  if (ParseBooleanFromEnv("ONEFLOW_VM_CPU_ALLOCATOR_ENABLE_CACHING", true)) {
+    const int64_t max_cached_mbytes =
+        ParseIntegerFromEnv("ONEFLOW_VM_CPU_ALLOCATOR_MAX_CACHED_MB", kDefaultMaxCachedMBytes);
+    CHECK_GE(max_cached_mbytes, 0);
+    cpu_caching_allocator_ = new CpuCachingAllocator(max_cached_mbytes << 20);
+    caching_allocator_.reset(
+        new ThreadSafeAllocator(std::unique_ptr<Allocator>(cpu_caching_allocator_)));
+  }
+}
+
 void CpuAllocator::Allocate(char** mem_ptr, std::size_t size) {
-  *mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, size));
+  if (caching_allocator_) {
+    caching_allocator_->Allocate(mem_ptr, size);
+  } else {
+    *mem_ptr = reinterpret_cast<char*>(aligned_alloc(kHostAlignSize, size));
+  }
 }
 
-void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) { std::free(mem_ptr); }
+void CpuAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (caching_allocator_) {
+    caching_allocator_->Deallocate(mem_ptr, size);
+  } else {
+    std::free(mem_ptr);
+  }
+}
+
+CpuAllocatorStats CpuAllocator::GetStats() {
+  if (!caching_allocator_) { return CpuAllocatorStats(); }
+  CpuAllocatorStats stats;
+  caching_allocator_->WithBackendLocked([&]() { stats = cpu_caching_allocator_->GetStats(); });
+  return stats;
+}
+
+void CpuAllocator::ReleaseCachedMemory() {
+  if (!caching_allocator_) { return; }
+  caching_allocator_->WithBackendLocked([&]() { cpu_caching_allocator_->ReleaseCachedMemory(); });
+}
 
 COMMAND(Global<CpuAllocator>::SetAllocated(new CpuAllocator()));
 
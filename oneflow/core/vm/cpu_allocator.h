@@ -18,17 +18,32 @@ limitations under the License.
 
 #include <cstdint>
 #include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+#include "oneflow/core/vm/thread_safe_allocator.h"
 
 namespace oneflow {
 namespace vm {
 
+// CpuAllocator is shared by all the cpu streams. Memory is cached by a CpuCachingAllocator unless
+// ONEFLOW_VM_CPU_ALLOCATOR_ENABLE_CACHING=0, and at most ONEFLOW_VM_CPU_ALLOCATOR_MAX_CACHED_MB
+// free bytes are kept in the cache. It is thread safe: the cache is wrapped with
+// ThreadSafeAllocator because the parallel cpu streams allocate from their own threads.
 class CpuAllocator final : public Allocator {
  public:
-  explicit CpuAllocator() = default;
+  explicit CpuAllocator();
   ~CpuAllocator() override = default;
 
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  bool caching_enabled() const { return static_cast<bool>(caching_allocator_); }
+  CpuAllocatorStats GetStats();
+  void ReleaseCachedMemory();
+
+ private:
+  std::unique_ptr<ThreadSafeAllocator> caching_allocator_;
+  // owned by caching_allocator_, only accessed under its lock
+  CpuCachingAllocator* cpu_caching_allocator_;
 };
 
 }  // namespace vm
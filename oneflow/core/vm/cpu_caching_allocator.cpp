@@ -0,0 +1,309 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <cstdlib>
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+namespace {
+
+inline size_t CpuMemAlignedBytes(size_t bytes) { return RoundUp(bytes, kHostAlignSize); }
+
+inline bool IsAlignedSize(size_t size) { return size % kHostAlignSize == 0; }
+
+static const size_t kPieceSplitThreshold = 128 << 20;  // 128MiB
+static const size_t kBlockAlignSize = 4096;
+
+}  // namespace
+
+CpuCachingAllocator::CpuCachingAllocator(size_t max_cached_bytes)
+    : Allocator(),
+      max_cached_bytes_(max_cached_bytes),
+      total_memory_bytes_(0),
+      peak_total_memory_bytes_(0),
+      allocated_bytes_(0),
+      allocate_count_(0),
+      miss_count_(0),
+      released_block_count_(0),
+      recycle_piece_list_(nullptr) {
+  bins_.resize(kBinNumSize);
+  for (int i = 0; i < kBinNumSize; ++i) {
+    size_t bin_size = BinSize4BinNum(i);
+    bins_.at(i).size = bin_size;
+    CHECK_EQ(BinNum4BinSize(bin_size), i);
+    CHECK_EQ(BinNum4BinSize(bin_size * 2 - 1), i);
+    CHECK_EQ(BinNum4BinSize(bin_size * 2), i == (kBinNumSize - 1) ? i : i + 1);
+  }
+}
+
+CpuCachingAllocator::~CpuCachingAllocator() {
+  for (auto& pair : mem_ptr2block_) { std::free(pair.first); }
+}
+
+void CpuCachingAllocator::InsertPiece2Bin(Piece* piece) {
+  CHECK(piece->is_free && piece->bin_num == kInvalidBinNum);
+  int32_t bin_num = BinNum4BinSize(piece->size);
+  piece->bin_num = bin_num;
+  CHECK(bins_.at(bin_num).pieces.insert(piece).second);
+}
+
+void CpuCachingAllocator::RemovePieceFromBin(Piece* piece) {
+  CHECK(piece->is_free);
+  CHECK_NE(piece->bin_num, kInvalidBinNum);
+  CHECK_GT(bins_.at(piece->bin_num).pieces.erase(piece), 0);
+  piece->bin_num = kInvalidBinNum;
+}
+
+CpuCachingAllocator::Piece* CpuCachingAllocator::AllocatePiece() {
+  if (recycle_piece_list_) {
+    Piece* ret = recycle_piece_list_;
+    recycle_piece_list_ = recycle_piece_list_->next;
+    return ret;
+  } else {
+    pieces_.emplace_back(new Piece());
+    return pieces_.at(pieces_.size() - 1).get();
+  }
+}
+
+void CpuCachingAllocator::DeallocatePiece(Piece* piece) {
+  piece->ptr = nullptr;
+  piece->size = 0;
+  piece->bin_num = kInvalidBinNum;
+  piece->is_free = true;
+  piece->prev = nullptr;
+  piece->next = recycle_piece_list_;
+  recycle_piece_list_ = piece;
+}
+
+void CpuCachingAllocator::MarkPiece(Piece* piece) {
+  CHECK_NOTNULL(piece->ptr);
+  CHECK(ptr2piece_.emplace(piece->ptr, piece).second);
+}
+
+void CpuCachingAllocator::UnMarkPiece(Piece* piece) {
+  CHECK_NOTNULL(piece->ptr);
+  auto it = ptr2piece_.find(piece->ptr);
+  CHECK(it != ptr2piece_.end());
+  ptr2piece_.erase(it);
+}
+
+CpuCachingAllocator::Piece* CpuCachingAllocator::FindPiece(size_t aligned_size) {
+  CHECK(IsAlignedSize(aligned_size));
+  Piece key;
+  key.size = aligned_size;
+  for (int32_t bin_num = BinNum4BinSize(aligned_size); bin_num < kBinNumSize; ++bin_num) {
+    Bin* bin = &bins_.at(bin_num);
+    // Pieces in a Bin are ordered by size, so the first one not less than `key` is the best fit
+    auto it = bin->pieces.lower_bound(&key);
+    if (it == bin->pieces.end()) { continue; }
+    Piece* piece = *it;
+    CHECK(piece->is_free);
+    CHECK_EQ(piece->bin_num, bin_num);
+    CHECK_GE(piece->size, aligned_size);
+    bin->pieces.erase(it);
+    piece->bin_num = kInvalidBinNum;
+    piece->is_free = false;
+    if (piece->size >= aligned_size * 2 || piece->size - aligned_size >= kPieceSplitThreshold) {
+      Piece* new_piece = AllocatePiece();
+      new_piece->ptr = piece->ptr + aligned_size;
+      new_piece->size = piece->size - aligned_size;
+      piece->size = aligned_size;
+
+      Piece* next_p = piece->next;
+      piece->next = new_piece;
+      new_piece->prev = piece;
+      new_piece->next = next_p;
+      if (next_p != nullptr) { next_p->prev = new_piece; }
+
+      new_piece->is_free = true;
+      new_piece->bin_num = kInvalidBinNum;
+      InsertPiece2Bin(new_piece);
+      MarkPiece(new_piece);
+    }
+    return piece;
+  }
+  return nullptr;
+}
+
+void CpuCachingAllocator::MergeNeighbourFreePiece(Piece* lhs, Piece* rhs) {
+  CHECK(lhs->is_free);
+  CHECK(rhs->is_free);
+  CHECK(lhs->next == rhs);
+  CHECK(lhs == rhs->prev);
+  CHECK(lhs->ptr + lhs->size == rhs->ptr);
+
+  lhs->size += rhs->size;
+  lhs->next = rhs->next;
+  if (rhs->next != nullptr) { rhs->next->prev = lhs; }
+  UnMarkPiece(rhs);
+  DeallocatePiece(rhs);
+}
+
+bool CpuCachingAllocator::AllocateBlockToExtendTotalMem(size_t aligned_size) {
+  CHECK(IsAlignedSize(aligned_size));
+  size_t allocate_bytes = aligned_size;
+  if (allocate_bytes < 1048576) {
+    // Allocate 2MB if `allocate_bytes` is less than 1MB
+    allocate_bytes = 2097152;
+  } else if (allocate_bytes < 10485760) {
+    // Allocate 20MB if `allocate_bytes` is between 1MB and 10MB
+    allocate_bytes = 20971520;
+  } else {
+    // Round up to 2MB if `allocate_bytes` is larger than 10MB
+    allocate_bytes = RoundUp(allocate_bytes, 2097152);
+  }
+  char* mem_ptr = reinterpret_cast<char*>(aligned_alloc(kBlockAlignSize, allocate_bytes));
+  if (mem_ptr == nullptr) { return false; }
+
+  total_memory_bytes_ += allocate_bytes;
+  peak_total_memory_bytes_ = std::max(peak_total_memory_bytes_, total_memory_bytes_);
+
+  Piece* piece = AllocatePiece();
+  piece->size = allocate_bytes;
+  piece->ptr = mem_ptr;
+  piece->prev = nullptr;
+  piece->next = nullptr;
+  piece->is_free = true;
+  piece->bin_num = kInvalidBinNum;
+  InsertPiece2Bin(piece);
+  MarkPiece(piece);
+
+  CHECK(mem_ptr2block_.emplace(mem_ptr, Block(piece)).second);
+  return true;
+}
+
+void CpuCachingAllocator::DeallocateBlock(Piece* piece) {
+  CHECK(piece->is_free);
+  CHECK(piece->prev == nullptr && piece->next == nullptr);
+  auto it = mem_ptr2block_.find(piece->ptr);
+  CHECK(it != mem_ptr2block_.end());
+  CHECK_EQ(it->second.size, piece->size);
+  char* ptr = piece->ptr;
+  total_memory_bytes_ -= piece->size;
+  released_block_count_ += 1;
+  if (piece->bin_num != kInvalidBinNum) { RemovePieceFromBin(piece); }
+  UnMarkPiece(piece);
+  DeallocatePiece(piece);
+  mem_ptr2block_.erase(it);
+  std::free(ptr);
+}
+
+bool CpuCachingAllocator::DeallocateFreeBlockForGarbageCollection() {
+  std::vector<Piece*> free_block_pieces;
+  for (const auto& pair : mem_ptr2block_) {
+    Piece* p = pair.second.start_piece;
+    // free neighbour Pieces are always merged, so a whole free Block has only one Piece
+    if (p->is_free && p->next == nullptr) { free_block_pieces.push_back(p); }
+  }
+  for (Piece* p : free_block_pieces) { DeallocateBlock(p); }
+  return !free_block_pieces.empty();
+}
+
+void CpuCachingAllocator::Allocate(char** mem_ptr, std::size_t size) {
+  if (size == 0) {
+    *mem_ptr = nullptr;
+    return;
+  }
+  size_t aligned_size = CpuMemAlignedBytes(size);
+  allocate_count_ += 1;
+
+  Piece* piece = FindPiece(aligned_size);
+  if (piece == nullptr) {
+    miss_count_ += 1;
+    if (AllocateBlockToExtendTotalMem(aligned_size)) { piece = FindPiece(aligned_size); }
+  }
+
+  if (piece == nullptr) {
+    if (DeallocateFreeBlockForGarbageCollection() && AllocateBlockToExtendTotalMem(aligned_size)) {
+      piece = FindPiece(aligned_size);
+    }
+  }
+
+  if (piece == nullptr) {
+    LOG(FATAL) << "Error! : Out of memory when allocate size : " << size
+               << ".\n The total_memory_bytes allocated by this CpuCachingAllocator is : "
+               << total_memory_bytes_;
+  }
+  CHECK_NOTNULL(piece->ptr);
+  CHECK(ptr2piece_.find(piece->ptr) != ptr2piece_.end());
+  allocated_bytes_ += piece->size;
+  *mem_ptr = piece->ptr;
+}
+
+void CpuCachingAllocator::Deallocate(char* mem_ptr, std::size_t size) {
+  if (mem_ptr == nullptr) { return; }
+
+  auto it = ptr2piece_.find(mem_ptr);
+  CHECK(it != ptr2piece_.end()) << "Error! : Try deallocate mem_ptr non-existent. mem ptr = "
+                                << mem_ptr << " size = " << size;
+  Piece* piece = it->second;
+  CHECK_NOTNULL(piece);
+  CHECK_EQ(piece->ptr, mem_ptr);
+  CHECK(!piece->is_free);
+
+  piece->is_free = true;
+  allocated_bytes_ -= piece->size;
+
+  Piece* last_piece_insert_to_bin = piece;
+  Piece* next_p = piece->next;
+  Piece* prev_p = piece->prev;
+
+  if (next_p != nullptr && next_p->is_free) {
+    CHECK_EQ(next_p->ptr, piece->ptr + piece->size);
+    RemovePieceFromBin(next_p);
+    MergeNeighbourFreePiece(piece, next_p);
+  }
+
+  if (prev_p != nullptr && prev_p->is_free) {
+    CHECK_EQ(piece->ptr, prev_p->ptr + prev_p->size);
+    RemovePieceFromBin(prev_p);
+    MergeNeighbourFreePiece(prev_p, piece);
+    last_piece_insert_to_bin = prev_p;
+  }
+
+  if (last_piece_insert_to_bin->prev == nullptr && last_piece_insert_to_bin->next == nullptr
+      && total_memory_bytes_ - allocated_bytes_ > max_cached_bytes_) {
+    // The whole Block is free and the cache is over its limit, give the Block back
+    DeallocateBlock(last_piece_insert_to_bin);
+  } else {
+    InsertPiece2Bin(last_piece_insert_to_bin);
+  }
+}
+
+CpuAllocatorStats CpuCachingAllocator::GetStats() const {
+  CpuAllocatorStats stats;
+  stats.allocate_count = allocate_count_;
+  stats.miss_count = miss_count_;
+  stats.hit_count = allocate_count_ - miss_count_;
+  stats.released_block_count = released_block_count_;
+  stats.reserved_bytes = total_memory_bytes_;
+  stats.peak_reserved_bytes = peak_total_memory_bytes_;
+  stats.allocated_bytes = allocated_bytes_;
+  for (int32_t bin_num = kBinNumSize - 1; bin_num >= 0; --bin_num) {
+    const auto& pieces = bins_.at(bin_num).pieces;
+    if (!pieces.empty()) {
+      stats.largest_free_piece_bytes = (*pieces.rbegin())->size;
+      break;
+    }
+  }
+  return stats;
+}
+
+void CpuCachingAllocator::ReleaseCachedMemory() { DeallocateFreeBlockForGarbageCollection(); }
+
+}  // namespace vm
+}  // namespace oneflow
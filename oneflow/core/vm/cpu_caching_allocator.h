@@ -0,0 +1,148 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+#define ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
+
+#include <cstdint>
+#include <set>
+#include "oneflow/core/vm/allocator.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+namespace vm {
+
+struct CpuAllocatorStats {
+  // number of Allocate() calls with non-zero size
+  int64_t allocate_count = 0;
+  // served from an already cached free Piece
+  int64_t hit_count = 0;
+  // needed a new Block from the system allocator
+  int64_t miss_count = 0;
+  // number of Blocks given back to the system allocator
+  int64_t released_block_count = 0;
+  // bytes held from the system allocator
+  size_t reserved_bytes = 0;
+  size_t peak_reserved_bytes = 0;
+  // bytes handed out to users (aligned)
+  size_t allocated_bytes = 0;
+  // largest single free Piece, a request larger than this one misses the cache
+  size_t largest_free_piece_bytes = 0;
+
+  size_t cached_free_bytes() const { return reserved_bytes - allocated_bytes; }
+  // 0 means all the free bytes are in one Piece, close to 1 means free bytes are scattered
+  double fragmentation() const {
+    const size_t free_bytes = cached_free_bytes();
+    if (free_bytes == 0) { return 0; }
+    return 1.0 - static_cast<double>(largest_free_piece_bytes) / free_bytes;
+  }
+};
+
+// CpuCachingAllocator keeps the host memory of freed tensors in size-classed Bins so that eager
+// cpu ops do not pay malloc/free and page faults for each output. It follows the Bin/Piece/Block
+// design of CudaAllocator. It is NOT thread safe, CpuAllocator wraps it with ThreadSafeAllocator.
+class CpuCachingAllocator final : public Allocator {
+ public:
+  // Whole free Blocks are given back to the system once the cached free bytes exceed
+  // `max_cached_bytes`.
+  explicit CpuCachingAllocator(size_t max_cached_bytes);
+  ~CpuCachingAllocator() override;
+
+  void Allocate(char** mem_ptr, std::size_t size) override;
+  void Deallocate(char* mem_ptr, std::size_t size) override;
+
+  CpuAllocatorStats GetStats() const;
+  // Give back all the whole free Blocks to the system allocator
+  void ReleaseCachedMemory();
+
+ private:
+  static constexpr int32_t kInvalidBinNum = -1;
+  // BinSize:  64, 128, 256, ... , 256MB
+  static constexpr int32_t kBinNumSize = 23;
+
+  // Piece is the basic memory unit of CpuCachingAllocator, see CudaAllocator::Piece
+  struct Piece {
+    size_t size = 0;
+    char* ptr = nullptr;
+    bool is_free = false;
+    Piece* prev = nullptr;
+    Piece* next = nullptr;
+    int32_t bin_num = kInvalidBinNum;
+  };
+
+  // Bin stores the free Pieces whose size is in [bin size, 2 * bin size)
+  struct Bin {
+    size_t size = 0;
+
+    struct PieceCmp {
+      bool operator()(const Piece* lhs, const Piece* rhs) const {
+        if (lhs->size != rhs->size) { return lhs->size < rhs->size; }
+        return lhs->ptr < rhs->ptr;
+      }
+    };
+    std::set<Piece*, PieceCmp> pieces;
+  };
+
+  // Block is the memory actually allocated from the system
+  struct Block {
+    size_t size = 0;
+    char* ptr = nullptr;
+    Piece* start_piece = nullptr;
+    Block(Piece* p) : size(p->size), ptr(p->ptr), start_piece(p) {}
+  };
+
+  size_t BinSize4BinNum(int32_t bin_num) { return kHostAlignSize << bin_num; }
+
+  int32_t BinNum4BinSize(size_t size) {
+    uint64_t value = std::max(size, kHostAlignSize) >> 6;
+    return std::min(kBinNumSize - 1, static_cast<int32_t>(63 ^ __builtin_clzll(value)));
+  }
+
+  Piece* FindPiece(size_t aligned_size);
+  void InsertPiece2Bin(Piece* piece);
+  void RemovePieceFromBin(Piece* piece);
+
+  Piece* AllocatePiece();
+  void DeallocatePiece(Piece* piece);
+
+  void MarkPiece(Piece* piece);
+  void UnMarkPiece(Piece* piece);
+
+  void MergeNeighbourFreePiece(Piece* lhs, Piece* rhs);
+
+  bool AllocateBlockToExtendTotalMem(size_t aligned_size);
+  // `piece` must be free and cover the whole Block
+  void DeallocateBlock(Piece* piece);
+  bool DeallocateFreeBlockForGarbageCollection();
+
+  size_t max_cached_bytes_;
+  size_t total_memory_bytes_;
+  size_t peak_total_memory_bytes_;
+  size_t allocated_bytes_;
+  int64_t allocate_count_;
+  int64_t miss_count_;
+  int64_t released_block_count_;
+  HashMap<char*, Block> mem_ptr2block_;
+
+  std::vector<Bin> bins_;
+  std::vector<std::unique_ptr<Piece>> pieces_;
+  HashMap<char*, Piece*> ptr2piece_;
+  Piece* recycle_piece_list_;
+};
+
+}  // namespace vm
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_VM_CPU_CACHING_ALLOCATOR_H_
@@ -0,0 +1,108 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <thread>
+#include "oneflow/core/vm/cpu_caching_allocator.h"
+#include "oneflow/core/vm/cpu_allocator.h"
+
+namespace oneflow {
+namespace vm {
+
+TEST(CpuCachingAllocator, allocate_and_reuse) {
+  CpuCachingAllocator allocator(0);
+  std::vector<char*> ptrs;
+  for (int i = 0; i < 512; ++i) {
+    char* ptr = nullptr;
+    allocator.Allocate(&ptr, 1);
+    ASSERT_TRUE(ptr != nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(ptr) % kHostAlignSize, 0);
+    ptrs.emplace_back(ptr);
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (int i = 1; i < 512; ++i) { ASSERT_GE(ptrs.at(i) - ptrs.at(i - 1), kHostAlignSize); }
+  CpuAllocatorStats stats = allocator.GetStats();
+  ASSERT_EQ(stats.allocate_count, 512);
+  ASSERT_EQ(stats.miss_count, 1);
+  ASSERT_EQ(stats.allocated_bytes, 512 * kHostAlignSize);
+  for (char* ptr : ptrs) { allocator.Deallocate(ptr, 1); }
+  // max_cached_bytes is 0, the Block is released as soon as it is free
+  stats = allocator.GetStats();
+  ASSERT_EQ(stats.reserved_bytes, 0);
+  ASSERT_EQ(stats.released_block_count, 1);
+}
+
+TEST(CpuCachingAllocator, split_and_merge) {
+  CpuCachingAllocator allocator(1 << 30);
+  char* data_ptr_1 = nullptr;
+  allocator.Allocate(&data_ptr_1, 2048 * sizeof(float));
+  char* data_ptr_2 = nullptr;
+  allocator.Allocate(&data_ptr_2, 4096 * sizeof(double));
+  ASSERT_TRUE(data_ptr_1 != data_ptr_2);
+  if (data_ptr_1 < data_ptr_2) {
+    ASSERT_TRUE(data_ptr_1 + 2048 * sizeof(float) <= data_ptr_2);
+  } else {
+    ASSERT_TRUE(data_ptr_2 + 4096 * sizeof(double) <= data_ptr_1);
+  }
+  allocator.Deallocate(data_ptr_2, 4096 * sizeof(double));
+  allocator.Deallocate(data_ptr_1, 2048 * sizeof(float));
+
+  CpuAllocatorStats stats = allocator.GetStats();
+  ASSERT_EQ(stats.allocated_bytes, 0);
+  ASSERT_GT(stats.reserved_bytes, 0);
+  // all the free Pieces are merged back into the Block
+  ASSERT_EQ(stats.largest_free_piece_bytes, stats.reserved_bytes);
+  ASSERT_EQ(stats.fragmentation(), 0);
+
+  char* data_ptr_3 = nullptr;
+  allocator.Allocate(&data_ptr_3, 4096 * sizeof(double));
+  stats = allocator.GetStats();
+  ASSERT_EQ(stats.hit_count, 2);
+  ASSERT_EQ(stats.miss_count, 1);
+  allocator.Deallocate(data_ptr_3, 4096 * sizeof(double));
+
+  allocator.ReleaseCachedMemory();
+  ASSERT_EQ(allocator.GetStats().reserved_bytes, 0);
+}
+
+TEST(CpuAllocator, concurrent_allocate) {
+  CpuAllocator allocator;
+  if (!allocator.caching_enabled()) { return; }
+  const CpuAllocatorStats init_stats = allocator.GetStats();
+  constexpr int kThreadNum = 8;
+  constexpr int kIterNum = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreadNum; ++t) {
+    threads.emplace_back([&allocator, t]() {
+      for (int i = 0; i < kIterNum; ++i) {
+        const size_t size = (t + 1) * (i % 7 + 1) * kHostAlignSize;
+        char* ptr = nullptr;
+        allocator.Allocate(&ptr, size);
+        ASSERT_TRUE(ptr != nullptr);
+        ptr[0] = static_cast<char>(t);
+        ptr[size - 1] = static_cast<char>(t);
+        allocator.Deallocate(ptr, size);
+      }
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+  const CpuAllocatorStats stats = allocator.GetStats();
+  ASSERT_EQ(stats.allocate_count - init_stats.allocate_count, kThreadNum * kIterNum);
+  ASSERT_EQ(stats.allocated_bytes, init_stats.allocated_bytes);
+  allocator.ReleaseCachedMemory();
+  ASSERT_EQ(allocator.GetStats().reserved_bytes, 0);
+}
+
+}  // namespace vm
+}  // namespace oneflow
@@ -69,8 +69,17 @@ intrusive::shared_ptr<StreamDesc> CpuStreamType::MakeStreamDesc(const Resource&
   ret->mut_stream_type_id()->__Init__(LookupStreamType4TypeIndex<CpuStreamType>());
   ret->set_num_streams_per_machine(device_num);
   ret->set_num_streams_per_thread(device_num);
+  ret->set_num_streams_per_device(GetCpuComputeStreamNumPerDevice());
   return ret;
 }
 
+bool CpuStreamType::OnSchedulerThread() const { return GetCpuComputeStreamNumPerDevice() == 1; }
+
+int32_t GetCpuComputeStreamNumPerDevice() {
+  static const int32_t stream_num =
+      std::max<int64_t>(ParseIntegerFromEnv("ONEFLOW_VM_CPU_COMPUTE_STREAM_NUM", 1), 1);
+  return stream_num;
+}
+
 }  // namespace vm
 }  // namespace oneflow
@@ -43,10 +43,16 @@ class CpuStreamType final : public StreamType {
   void Compute(Instruction* instruction) const override;
   intrusive::shared_ptr<StreamDesc> MakeStreamDesc(const Resource& resource,
                                                    int64_t this_machine_id) const override;
-  bool OnSchedulerThread() const override { return true; }
+  bool OnSchedulerThread() const override;
   bool SupportingTransportInstructions() const override { return true; }
 };
 
+// The number of compute streams every cpu device has, set by ONEFLOW_VM_CPU_COMPUTE_STREAM_NUM.
+// With the default 1 the instructions run on the scheduler thread one by one, otherwise every
+// stream has its own thread and independent instructions run in parallel, which is meant for
+// local tensors because the order of the instructions differs from process to process.
+int32_t GetCpuComputeStreamNumPerDevice();
+
 }  // namespace vm
 }  // namespace oneflow
 
@@ -36,6 +36,10 @@ class PhyInstrOperand {
   virtual const DependenceVector& input_dependences() const = 0;
   virtual const DependenceVector& output_dependences() const = 0;
 
+  // Whether the instruction may run on any of the parallel compute streams of its device. The
+  // others stay on the first stream, the only one with a thread_consistent_id.
+  virtual bool IsParallelizableOnStreams() const { return false; }
+
   static std::function<void(MirroredObject*)> SetInserter(DependenceVector* dependences) {
     auto existed =
         std::make_shared<std::set<MirroredObject*>>(dependences->begin(), dependences->end());
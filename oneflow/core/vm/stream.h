@@ -45,6 +45,8 @@ class Stream final : public intrusive::Base {
     return running_instruction_list_;
   }
   const StreamId& stream_id() const { return stream_id_.key(); }
+  // All the compute streams of this device including this one, empty if the device has only one
+  const std::vector<Stream*>& parallel_streams() const { return parallel_streams_; }
 
   // Setters
   void set_max_device_num_per_machine(int64_t val) { max_device_num_per_machine_ = val; }
@@ -56,6 +58,7 @@ class Stream final : public intrusive::Base {
   DispatchedInstructionList* mut_zombie_instruction_list() { return &zombie_instruction_list_; }
   DispatchedInstructionList* mut_running_instruction_list() { return &running_instruction_list_; }
   StreamId* mut_stream_id() { return stream_id_.mut_key(); }
+  std::vector<Stream*>* mut_parallel_streams() { return &parallel_streams_; }
 
   // methods
   void __Init__();
@@ -85,6 +88,7 @@ class Stream final : public intrusive::Base {
         free_instruction_list_(),
         zombie_instruction_list_(),
         running_instruction_list_(),
+        parallel_streams_(),
         stream_id_(),
         active_stream_hook_(),
         thread_ctx_stream_hook_() {}
@@ -97,6 +101,8 @@ class Stream final : public intrusive::Base {
   DispatchedInstructionList free_instruction_list_;
   DispatchedInstructionList zombie_instruction_list_;
   DispatchedInstructionList running_instruction_list_;
+  // containers
+  std::vector<Stream*> parallel_streams_;
 
  public:
   // skiplist hooks
@@ -61,10 +61,12 @@ class StreamDesc final : public intrusive::Base {
   // Getters
   int32_t num_streams_per_machine() const { return num_streams_per_machine_; }
   int32_t num_streams_per_thread() const { return num_streams_per_thread_; }
+  int32_t num_streams_per_device() const { return num_streams_per_device_; }
   const StreamTypeId& stream_type_id() const { return stream_type_id_.key().Get(); }
   // Setters
   void set_num_streams_per_machine(int32_t val) { num_streams_per_machine_ = val; }
   void set_num_streams_per_thread(int32_t val) { num_streams_per_thread_ = val; }
+  void set_num_streams_per_device(int32_t val) { num_streams_per_device_ = val; }
   StreamTypeId* mut_stream_type_id() { return stream_type_id_.mut_key()->Mutable(); }
 
   // methods
@@ -82,11 +84,15 @@ class StreamDesc final : public intrusive::Base {
       : intrusive_ref_(),
         num_streams_per_machine_(),
         num_streams_per_thread_(),
+        num_streams_per_device_(1),
         stream_type_id_() {}
   intrusive::Ref intrusive_ref_;
   // fields
   int32_t num_streams_per_machine_;
   int32_t num_streams_per_thread_;
+  // Streams of a device beyond the first one run on their own threads, and instructions of the
+  // device are spread over all of them by the scheduler
+  int32_t num_streams_per_device_;
 
  public:
   // skiplist hooks
@@ -34,6 +34,13 @@ class ThreadSafeAllocator final : public Allocator {
   void Allocate(char** mem_ptr, std::size_t size) override;
   void Deallocate(char* mem_ptr, std::size_t size) override;
 
+  // Runs `Handler` under the same lock as Allocate/Deallocate, for backend specific calls
+  template<typename HandlerT>
+  void WithBackendLocked(const HandlerT& Handler) {
+    std::unique_lock<std::mutex> lock(mutex4backend_allocator_);
+    Handler();
+  }
+
  private:
   std::unique_ptr<Allocator> backend_allocator_;
   std::mutex mutex4backend_allocator_;
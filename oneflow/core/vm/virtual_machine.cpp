@@ -24,6 +24,7 @@ limitations under the License.
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/thread/thread_consistent_id.h"
+#include "oneflow/core/thread/thread_pool.h"
 #include "oneflow/core/framework/transport_token.h"
 #include "oneflow/core/profiler/profiler.h"
 #include "oneflow/core/platform/include/pthread_fork.h"
@@ -57,6 +58,24 @@ std::type_index GetStreamTypeIndex(const vm::ThreadCtx* thread_ctx) {
   return typeid(stream_type);
 }
 
+// The parallel streams of a device share the cores, e.g. every one of 4 cpu compute streams
+// runs its ParallelFor on a quarter of the threads.
+void InitParallelForThreadBudget(vm::ThreadCtx* thread_ctx) {
+  const int32_t stream_num = thread_ctx->stream_rt_desc().stream_desc().num_streams_per_device();
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  if (stream_num <= 1 || thread_pool == nullptr) { return; }
+  ThreadPool::SetParallelForThreadBudgetOfThisThread(
+      std::max((thread_pool->thread_num() + 1) / stream_num, 1));
+}
+
+// The extra compute streams of a device run local instructions only, see
+// VirtualMachineEngine::ChooseParallelStream, so their threads need no thread_consistent_id.
+bool IsExtraParallelStreamThread(vm::ThreadCtx* thread_ctx) {
+  const vm::Stream* stream = thread_ctx->mut_stream_list()->Begin();
+  if (stream == nullptr || stream->parallel_streams().empty()) { return false; }
+  return stream->parallel_streams().front() != stream;
+}
+
 // Threads with the same stream_type share a thread_consistent_id.
 // e.g.
 //   Given there are 8 gpu thread in a single process.
@@ -81,10 +100,11 @@ void GetWorkerThreadInitializer(intrusive::shared_ptr<vm::VirtualMachineEngine>
     stream_type_index2consistent_id[stream_type_index] = thread_consistent_id++;
   }
   *Initializer = [stream_type_index2consistent_id](vm::ThreadCtx* thread_ctx) {
+    InitParallelForThreadBudget(thread_ctx);
     if (!CHECK_JUST(IsMultiClient())) { return; }
     const auto& stream_type_index = GetStreamTypeIndex(thread_ctx);
     const auto& iter = stream_type_index2consistent_id.find(stream_type_index);
-    if (iter != stream_type_index2consistent_id.end()) {
+    if (iter != stream_type_index2consistent_id.end() && !IsExtraParallelStreamThread(thread_ctx)) {
       CHECK_JUST(InitThisThreadConsistentId(iter->second, stream_type_index.name()));
     }
     OF_PROFILER_NAME_THIS_HOST_THREAD("_VM::Worker");
@@ -187,16 +207,9 @@ void VirtualMachine::Loop(const std::function<void()>& Initializer) {
       // about 10ns.
       int i = 0;
       do {
-        // Use ThreadUnsafeEmpty to avoid acquiring mutex lock.
         // It's safe to use ThreadUnsafeEmpty here. notifier_.notified_cnt_ will be greater than
-        // zero
-        // when inconsistency between vm->pending_msg_list.list_head_.list_head_.container_ and
-        // vm->pending_msg_list.list_head_.list_head_.size_ occured. hence the pending
-        // instructions
-        // will get handled in the next iteration.
-        //  VirtualMachine::Receive may be less effiencient if the thread safe version `vm->Empty()`
-        // used
-        //  here, because VirtualMachine::Loop is more likely to get the mutex lock.
+        // zero when a stale size of vm->pending_msg_list() is read, hence the pending
+        // instructions will get handled in the next iteration.
         do { vm->Schedule(); } while (!vm->ThreadUnsafeEmpty());
       } while (++i < kNumSchedulingPerTimoutTest);
     } while (MicrosecondsFrom(start) < kWorkingMicroseconds);
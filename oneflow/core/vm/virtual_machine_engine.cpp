@@ -82,22 +82,23 @@ void VirtualMachineEngine::ReleaseInstruction(Instruction* instruction) {
 void VirtualMachineEngine::HandlePending() {
   OF_PROFILER_RANGE_PUSH("HandlePending");
   InstructionMsgList tmp_pending_msg_list;
-  // MoveTo is under a lock.
+  // MoveTo takes all the pending batches at once without blocking the Receive callers.
   mut_pending_msg_list()->MoveTo(&tmp_pending_msg_list);
-  InstructionList new_instruction_list;
   INTRUSIVE_UNSAFE_FOR_EACH_PTR(instr_msg, &tmp_pending_msg_list) {
     if (unlikely(instr_msg->instr_type_id().instruction_type().ResettingIdToObjectMap())) {
       RunInstructionsInAdvance(instr_msg);
-    } else {
-      MakeInstructions(instr_msg, /*out*/ &new_instruction_list);
+      continue;
     }
-  }
-  OF_PROFILER_RANGE_PUSH("ConsumeMirroredObjects");
-  INTRUSIVE_FOR_EACH_PTR(instruction, &new_instruction_list) {
-    ConsumeMirroredObjects(mut_id2logical_object(), instruction);
-    if (likely(Dispatchable(instruction))) {
-      mut_ready_instruction_list()->PushBack(instruction);
-      new_instruction_list.Erase(instruction);
+    // Mirrored objects are consumed message by message, so that ChooseParallelStream sees the
+    // accesses of all the previous instructions.
+    InstructionList new_instruction_list;
+    MakeInstructions(instr_msg, /*out*/ &new_instruction_list);
+    INTRUSIVE_FOR_EACH_PTR(instruction, &new_instruction_list) {
+      ConsumeMirroredObjects(mut_id2logical_object(), instruction);
+      if (likely(Dispatchable(instruction))) {
+        mut_ready_instruction_list()->PushBack(instruction);
+        new_instruction_list.Erase(instruction);
+      }
     }
   }
   OF_PROFILER_RANGE_POP();
@@ -162,7 +163,7 @@ void VirtualMachineEngine::MakeInstructions(InstructionMsg* instr_msg,
     }
   };
   if (likely(instr_msg->phy_instr_stream() != nullptr)) {
-    NewAndMove(instr_msg->phy_instr_stream(), instr_msg->phy_instr_parallel_desc());
+    NewAndMove(ChooseParallelStream(*instr_msg), instr_msg->phy_instr_parallel_desc());
   } else {
     auto* stream_rt_desc = mut_stream_type_id2stream_rt_desc()->FindPtr(stream_type_id);
     if (unlikely(stream_rt_desc == nullptr)) {
@@ -180,6 +181,43 @@ void VirtualMachineEngine::MakeInstructions(InstructionMsg* instr_msg,
   }
 }
 
+// Only instructions parallelizable on streams leave the first stream. Such an instruction follows
+// the unfinished instruction it depends on, so that a chain of dependent instructions stays on one
+// stream, otherwise it goes to the least busy stream. Instructions on different streams are still
+// ordered by the edges made in ConsumeMirroredObjects.
+Stream* VirtualMachineEngine::ChooseParallelStream(const InstructionMsg& instr_msg) {
+  Stream* stream = instr_msg.phy_instr_stream();
+  const auto& parallel_streams = stream->parallel_streams();
+  if (likely(parallel_streams.empty())) { return stream; }
+  const auto& phy_instr_operand = instr_msg.phy_instr_operand();
+  if (!phy_instr_operand || !phy_instr_operand->IsParallelizableOnStreams()) { return stream; }
+  const auto& IsParallelStream = [&](Stream* candidate) {
+    return std::find(parallel_streams.begin(), parallel_streams.end(), candidate)
+           != parallel_streams.end();
+  };
+  for (auto* mirrored_object : phy_instr_operand->input_dependences()) {
+    // the writer is at the front of the access list if it has not finished
+    auto* access = mirrored_object->mut_rw_mutexed_object()->mut_access_list()->Begin();
+    if (access == nullptr || !access->is_mut_operand()) { continue; }
+    Stream* producer_stream = access->mut_instruction()->mut_stream();
+    if (IsParallelStream(producer_stream)) { return producer_stream; }
+  }
+  for (auto* mirrored_object : phy_instr_operand->output_dependences()) {
+    auto* access = mirrored_object->mut_rw_mutexed_object()->mut_access_list()->Last();
+    if (access == nullptr) { continue; }
+    Stream* last_stream = access->mut_instruction()->mut_stream();
+    if (IsParallelStream(last_stream)) { return last_stream; }
+  }
+  Stream* least_busy_stream = parallel_streams.front();
+  for (Stream* parallel_stream : parallel_streams) {
+    if (parallel_stream->running_instruction_list().size()
+        < least_busy_stream->running_instruction_list().size()) {
+      least_busy_stream = parallel_stream;
+    }
+  }
+  return least_busy_stream;
+}
+
 Maybe<const ParallelDesc> VirtualMachineEngine::GetInstructionParallelDesc(
     const InstructionMsg& instr_msg) {
   if (instr_msg.phy_instr_parallel_desc()) { return instr_msg.phy_instr_parallel_desc(); }
@@ -526,6 +564,31 @@ void VirtualMachineEngine::__Init__(const VmDesc& vm_desc) {
         thread_ctx->mut_stream_list()->PushBack(stream.Mutable());
       }
     }
+    if (stream_desc->num_streams_per_device() > 1) {
+      for (const auto& stream : stream_rt_desc->device_id2stream()) {
+        InitParallelStreams(stream_rt_desc.Mutable(), stream.get(),
+                            stream_desc->num_streams_per_device());
+      }
+    }
+  }
+}
+
+// The extra streams of a device share the stream id of the first one, but each of them runs on
+// its own thread. They are not indexed by StreamRtDesc::device_id2stream, instructions are moved to
+// them in MakeInstructions.
+void VirtualMachineEngine::InitParallelStreams(StreamRtDesc* stream_rt_desc, Stream* stream,
+                                               int32_t num_streams) {
+  std::vector<Stream*> parallel_streams{stream};
+  for (int32_t i = 1; i < num_streams; ++i) {
+    auto thread_ctx = intrusive::make_shared<ThreadCtx>(*stream_rt_desc);
+    mut_thread_ctx_list()->PushBack(thread_ctx.Mutable());
+    auto parallel_stream = intrusive::make_shared<Stream>(
+        thread_ctx.Mutable(), stream->stream_id(), vm_resource_desc().max_device_num_per_machine());
+    thread_ctx->mut_stream_list()->PushBack(parallel_stream.Mutable());
+    parallel_streams.push_back(parallel_stream.Mutable());
+  }
+  for (Stream* parallel_stream : parallel_streams) {
+    *parallel_stream->mut_parallel_streams() = parallel_streams;
   }
 }
 
@@ -706,14 +769,9 @@ void VirtualMachineEngine::Schedule() {
   // Try run the first barrier instruction.
   if (unlikely(mut_barrier_instruction_list()->size())) { TryRunBarrierInstruction(); }
   // Handle pending instructions, and try schedule them to ready list.
-  // Use thread_unsafe_size to avoid acquiring mutex lock.
-  // The inconsistency between pending_msg_list.list_head_.list_head_.container_ and
-  // pending_msg_list.list_head_.list_head_.size_ is not a fatal error because
+  // A relaxed load of the size is enough here. A stale size is not a fatal error because
   // VirtualMachineEngine::Schedule is always in a buzy loop. All instructions will get handled
   // eventually.
-  //  VirtualMachineEngine::Receive may be less effiencient if the thread safe version
-  //  `pending_msg_list().size()` used here, because VirtualMachineEngine::Schedule is more likely
-  //  to get the mutex lock.
   if (unlikely(pending_msg_list().thread_unsafe_size())) { HandlePending(); }
   // dispatch ready instructions and try to schedule out instructions in DAG onto ready list.
   if (unlikely(mut_ready_instruction_list()->size())) { DispatchAndPrescheduleInstructions(); }
@@ -724,7 +782,7 @@ bool VirtualMachineEngine::ThreadUnsafeEmpty() const {
 }
 
 bool VirtualMachineEngine::Empty() const {
-  // hook and size will be check in pending_msg_list().empty().
+  // the size of pending_msg_list() covers the batches being pushed.
   return pending_msg_list().empty() && ThreadUnsafeEmpty();
 }
 
@@ -28,7 +28,7 @@ limitations under the License.
 #include "oneflow/core/vm/vm_resource_desc.h"
 #include "oneflow/core/common/range.h"
 #include "oneflow/core/job/parallel_desc.h"
-#include "oneflow/core/intrusive/mutexed_list.h"
+#include "oneflow/core/intrusive/mpsc_list.h"
 #include "oneflow/core/intrusive/object_pool.h"
 
 namespace oneflow {
@@ -47,8 +47,8 @@ class VirtualMachineEngine final : public intrusive::Base {
       intrusive::List<INTRUSIVE_FIELD(Instruction, lively_instruction_hook_)>;
   using BarrierInstructionList =
       intrusive::List<INTRUSIVE_FIELD(Instruction, barrier_instruction_hook_)>;
-  using InstructionMsgMutextList =
-      intrusive::MutexedList<INTRUSIVE_FIELD(InstructionMsg, InstructionMsg::instr_msg_hook_)>;
+  using InstructionMsgMpscList =
+      intrusive::MpscList<INTRUSIVE_FIELD(InstructionMsg, InstructionMsg::instr_msg_hook_)>;
   using StreamTypeId2StreamRtDesc =
       intrusive::SkipList<INTRUSIVE_FIELD(StreamRtDesc, stream_type_id_)>;
   using Id2LogicalObject = intrusive::SkipList<INTRUSIVE_FIELD(LogicalObject, logical_object_id_)>;
@@ -72,7 +72,7 @@ class VirtualMachineEngine final : public intrusive::Base {
   const BarrierInstructionList& barrier_instruction_list() const {
     return barrier_instruction_list_;
   }
-  const InstructionMsgMutextList& pending_msg_list() const { return pending_msg_list_; }
+  const InstructionMsgMpscList& pending_msg_list() const { return pending_msg_list_; }
   const StreamTypeId2StreamRtDesc& stream_type_id2stream_rt_desc() const {
     return stream_type_id2stream_rt_desc_;
   }
@@ -88,7 +88,7 @@ class VirtualMachineEngine final : public intrusive::Base {
   LogicalObjectDeleteList* mut_delete_logical_object_list() { return &delete_logical_object_list_; }
   LivelyInstructionList* mut_lively_instruction_list() { return &lively_instruction_list_; }
   BarrierInstructionList* mut_barrier_instruction_list() { return &barrier_instruction_list_; }
-  InstructionMsgMutextList* mut_pending_msg_list() { return &pending_msg_list_; }
+  InstructionMsgMpscList* mut_pending_msg_list() { return &pending_msg_list_; }
   StreamTypeId2StreamRtDesc* mut_stream_type_id2stream_rt_desc() {
     return &stream_type_id2stream_rt_desc_;
   }
@@ -133,6 +133,8 @@ class VirtualMachineEngine final : public intrusive::Base {
 
   void ReleaseInstruction(Instruction* instruction);
   void MakeInstructions(InstructionMsg*, /*out*/ InstructionList* ret_instruction_list);
+  Stream* ChooseParallelStream(const InstructionMsg& instr_msg);
+  void InitParallelStreams(StreamRtDesc* stream_rt_desc, Stream* stream, int32_t num_streams);
   void RunInstructionsInAdvance(InstructionMsg* instr_msg);
   template<int64_t (*TransformLogicalObjectId)(int64_t), typename DoEachT>
   void ForEachMirroredObject(Id2LogicalObject* id2logical_object, const Operand& operand,
@@ -206,7 +208,7 @@ class VirtualMachineEngine final : public intrusive::Base {
   StreamTypeId2StreamRtDesc stream_type_id2stream_rt_desc_;
   Id2LogicalObject id2logical_object_;
   LogicalObjectDeleteList delete_logical_object_list_;
-  InstructionMsgMutextList pending_msg_list_;
+  InstructionMsgMpscList pending_msg_list_;
   ReadyInstructionList ready_instruction_list_;
   LivelyInstructionList lively_instruction_list_;
   BarrierInstructionList barrier_instruction_list_;
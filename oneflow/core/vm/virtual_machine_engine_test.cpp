@@ -13,7 +13,9 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include <chrono>
 #include <iostream>
+#include <thread>
 #include "oneflow/core/vm/virtual_machine_engine.h"
 #include "oneflow/core/vm/control_stream_type.h"
 #include "oneflow/core/vm/vm_desc.h"
@@ -22,6 +24,9 @@ limitations under the License.
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/test_util.h"
 #include "oneflow/core/vm/stream_desc.h"
+#include "oneflow/core/vm/host_stream_type.h"
+#include "oneflow/core/vm/no_arg_cb_phy_instr_operand.h"
+#include "oneflow/core/framework/device.h"
 #include "oneflow/core/common/util.h"
 
 namespace oneflow {
@@ -39,6 +44,72 @@ TEST(VirtualMachineEngine, __Init__) {
   ASSERT_EQ(vm->stream_type_id2stream_rt_desc().size(), 2);
 }
 
+class NopForTestInstructionType final : public InstructionType {
+ public:
+  NopForTestInstructionType() = default;
+  ~NopForTestInstructionType() override = default;
+
+  using stream_type = HostStreamType;
+
+  void Infer(Instruction* instruction) const override {}
+  void Compute(Instruction* instruction) const override {
+    const auto& phy_instr_operand = instruction->instr_msg().phy_instr_operand();
+    const auto* ptr = dynamic_cast<const NoArgCbPhyInstrOperand*>(phy_instr_operand.get());
+    CHECK_NOTNULL(ptr)->callback()();
+  }
+};
+COMMAND(RegisterInstructionType<NopForTestInstructionType>("NopForTest"));
+
+// Returns the seconds `submitter_num` threads take to submit and run `instr_num_per_submitter`
+// instructions each, one instruction per Receive like eager ops issued from python threads.
+double SubmitAndRunMany(int64_t submitter_num, int64_t instr_num_per_submitter) {
+  auto vm_desc = intrusive::make_shared<VmDesc>(TestUtil::NewVmResourceDesc().Get());
+  TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"NopForTest"});
+  auto vm = intrusive::make_shared<VirtualMachineEngine>(vm_desc.Get());
+  std::atomic<int64_t> done_cnt(0);
+  const auto& phy_instr_operand =
+      std::make_shared<NoArgCbPhyInstrOperand>([&done_cnt]() { ++done_cnt; });
+  const int64_t instr_num = submitter_num * instr_num_per_submitter;
+  const auto start = std::chrono::steady_clock::now();
+  std::thread scheduler([&]() {
+    while (done_cnt < instr_num) { vm->Schedule(); }
+    while (!vm->Empty()) { vm->Schedule(); }
+  });
+  std::vector<std::thread> submitters;
+  for (int64_t i = 0; i < submitter_num; ++i) {
+    submitters.emplace_back([&]() {
+      for (int64_t j = 0; j < instr_num_per_submitter; ++j) {
+        // keep below the high water mark, where Receive would release the python GIL
+        while (vm->flying_instruction_cnt() > GetInstructionLowWaterMark()) {
+          std::this_thread::yield();
+        }
+        InstructionMsgList list;
+        list.EmplaceBack(intrusive::make_shared<InstructionMsg>(
+            vm.Mutable(), "NopForTest", std::shared_ptr<const ParallelDesc>(),
+            phy_instr_operand));
+        CHECK_JUST(vm->Receive(&list));
+      }
+    });
+  }
+  for (std::thread& submitter : submitters) { submitter.join(); }
+  scheduler.join();
+  const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+  CHECK_EQ(done_cnt, instr_num);
+  CHECK(vm->Empty());
+  return seconds.count();
+}
+
+TEST(VirtualMachineEngine, receive_from_many_threads) { SubmitAndRunMany(8, 10000); }
+
+TEST(VirtualMachineEngine, benchmark) {
+  const int64_t instr_num_per_submitter = 100000;
+  for (int64_t submitter_num : {1, 2, 4, 8}) {
+    const double seconds = SubmitAndRunMany(submitter_num, instr_num_per_submitter);
+    LOG(INFO) << "submitters: " << submitter_num << ", instructions/s: "
+              << static_cast<int64_t>(submitter_num * instr_num_per_submitter / seconds);
+  }
+}
+
 }  // namespace
 
 }  // namespace test
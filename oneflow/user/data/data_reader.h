@@ -32,7 +32,9 @@ class DataReader {
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+      : is_closed_(false),
+        batch_buffer_(ParseIntegerFromEnv("ONEFLOW_DATA_READER_BATCH_BUFFER_SIZE",
+                                          kDataReaderBatchBufferSize)) {}
   virtual ~DataReader() {
     Close();
     if (load_thrd_.joinable()) { load_thrd_.join(); }
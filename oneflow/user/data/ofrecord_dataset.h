@@ -20,11 +20,13 @@ limitations under the License.
 #include "oneflow/core/common/multi_client.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
-#include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/core/rpc/include/global_process_ctx.h"
 #include "oneflow/core/job/env_desc.h"
 #include "oneflow/user/data/dataset.h"
+#include "oneflow/user/data/ofrecord_mmap_reader.h"
+#include "oneflow/user/data/ofrecord_parallel_reader.h"
+#include "oneflow/user/data/ofrecord_serial_reader.h"
 
 namespace oneflow {
 namespace data {
@@ -35,7 +37,6 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   OF_DISALLOW_COPY_AND_MOVE(OFRecordDataset);
   OFRecordDataset(user_op::KernelInitContext* ctx) {
-    current_epoch_ = 0;
     shuffle_after_epoch_ = ctx->Attr<bool>("shuffle_after_epoch");
 
     // in stream
@@ -74,51 +75,46 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
     CHECK_LE(parallel_num_, data_part_num_);
     BalancedSplitter bs(data_part_num_, parallel_num_);
     range_ = bs.At(parallel_id_);
-    std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(
-        new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, false));
+    // ONEFLOW_DATA_READER_OFRECORD_MMAP maps the part files instead of reading them, and
+    // ONEFLOW_DATA_READER_OFRECORD_PARALLEL_PART_NUM > 1 reads that many part files at the same
+    // time, which helps on storages with high latency like NFS
+    const int64_t parallel_part_num =
+        ParseIntegerFromEnv("ONEFLOW_DATA_READER_OFRECORD_PARALLEL_PART_NUM", 1);
+    if (ParseBooleanFromEnv("ONEFLOW_DATA_READER_OFRECORD_MMAP", false)) {
+      // the part files must be on the local file system
+      mmap_reader_.reset(new OFRecordMMapReader(
+          data_file_paths_, range_, parallel_id_, parallel_num_, shuffle_after_epoch_,
+          ParseBooleanFromEnv("ONEFLOW_DATA_READER_OFRECORD_MMAP_GLOBAL_SHUFFLE", false)));
+      // the number of samples this rank has read before, to resume a job
+      const int64_t skip_sample_num =
+          ParseIntegerFromEnv("ONEFLOW_DATA_READER_OFRECORD_MMAP_SKIP_SAMPLE_NUM", 0);
+      if (skip_sample_num > 0) { mmap_reader_->SeekToSample(skip_sample_num); }
+    } else if (parallel_part_num > 1) {
+      const int64_t prefetch_chunk_num =
+          ParseIntegerFromEnv("ONEFLOW_DATA_READER_OFRECORD_PREFETCH_CHUNK_NUM", 16);
+      parallel_reader_.reset(new OFRecordParallelReader(DataFS(), data_file_paths_, range_,
+                                                        shuffle_after_epoch_, parallel_part_num,
+                                                        prefetch_chunk_num));
+    } else {
+      serial_reader_.reset(
+          new OFRecordSerialReader(DataFS(), data_file_paths_, range_, shuffle_after_epoch_));
+    }
   }
   ~OFRecordDataset() = default;
 
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
-    LoadTargetPtr sample_ptr(new TensorBuffer());
-    ReadSample(*sample_ptr);
-    ret.emplace_back(std::move(sample_ptr));
-    return ret;
-  }
-
- private:
-  void ReadSample(TensorBuffer& tensor) {
-    int64_t OFRecord_size = -1;
-    char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
-    if (in_stream_->ReadFully(size_ptr, sizeof(int64_t)) != 0) {
-      ShuffleAfterEpoch();
-      CHECK_EQ(in_stream_->ReadFully(size_ptr, sizeof(int64_t)), 0);
-    }
-    CHECK_GT(OFRecord_size, 0);
-    tensor.Resize(Shape({OFRecord_size}), DataType::kChar);
-    CHECK_EQ(in_stream_->ReadFully(tensor.mut_data<char>(), OFRecord_size), 0);
-  }
-
-  void ShuffleAfterEpoch() {
-    CHECK(shuffle_after_epoch_);
-    current_epoch_++;  // move to next epoch
-    std::mt19937 g(kOneflowDatasetSeed + current_epoch_);
-    std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
-    std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, false));
-  }
-
-  std::vector<std::string> GetLocalFilePaths() {
-    std::vector<std::string> ret;
-    for (int i = range_.begin(); i < range_.end(); ++i) {
-      ret.emplace_back(data_file_paths_.at(i));
+    if (mmap_reader_) {
+      ret.emplace_back(mmap_reader_->Next());
+    } else if (parallel_reader_) {
+      ret.emplace_back(parallel_reader_->Next());
+    } else {
+      ret.emplace_back(serial_reader_->Next());
     }
     return ret;
   }
 
-  int32_t current_epoch_;
+ private:
   bool shuffle_after_epoch_;
 
   int32_t data_part_num_;
@@ -126,7 +122,9 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   int32_t parallel_num_;
   Range range_;
   std::vector<std::string> data_file_paths_;
-  std::unique_ptr<PersistentInStream> in_stream_;
+  std::unique_ptr<OFRecordSerialReader> serial_reader_;
+  std::unique_ptr<OFRecordParallelReader> parallel_reader_;
+  std::unique_ptr<OFRecordMMapReader> mmap_reader_;
 };
 
 }  // namespace data
@@ -25,6 +25,7 @@ limitations under the License.
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/user/data/ofrecord_dataset.h"
+#include "oneflow/user/data/ofrecord_scanner.h"
 #include "oneflow/user/image/image_util.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
@@ -45,15 +46,14 @@ using BaseLoadTargetPtrList = BaseDataset::LoadTargetPtrList;
 
 namespace {
 
-void DecodeImageFromOFRecord(const OFRecord& record, const std::string& feature_name,
+void DecodeImageFromOFRecord(const OFRecordFeatureView& image_feature,
                              const std::string& color_space, TensorBuffer* out) {
-  auto image_feature_it = record.feature().find(feature_name);
-  CHECK(image_feature_it != record.feature().end());
-  const Feature& image_feature = image_feature_it->second;
-  CHECK(image_feature.has_bytes_list());
-  CHECK(image_feature.bytes_list().value_size() == 1);
-  const std::string& src_data = image_feature.bytes_list().value(0);
-  cv::Mat image = cv::imdecode(cv::Mat(1, src_data.size(), CV_8UC1, (void*)(src_data.data())),
+  CHECK(image_feature.kind() == OFRecordFeatureKind::kBytesList);
+  CHECK(image_feature.value_size() == 1);
+  const char* src_data = nullptr;
+  size_t src_size = 0;
+  image_feature.GetBytesValue(0, &src_data, &src_size);
+  cv::Mat image = cv::imdecode(cv::Mat(1, src_size, CV_8UC1, (void*)(src_data)),  // NOLINT
                                cv::IMREAD_COLOR);
   int W = image.cols;
   int H = image.rows;
@@ -73,18 +73,12 @@ void DecodeImageFromOFRecord(const OFRecord& record, const std::string& feature_
   memcpy(out->mut_data<uint8_t>(), image.ptr(), image_shape.elem_cnt());
 }
 
-void DecodeLabelFromFromOFRecord(const OFRecord& record, const std::string& feature_name,
-                                 TensorBuffer* out) {
-  auto label_feature_it = record.feature().find(feature_name);
-  CHECK(label_feature_it != record.feature().end());
-  const Feature& label_feature = label_feature_it->second;
+void DecodeLabelFromFromOFRecord(const OFRecordFeatureView& label_feature, TensorBuffer* out) {
   out->Resize(Shape({1}), DataType::kInt32);
-  if (label_feature.has_int32_list()) {
-    CHECK_EQ(label_feature.int32_list().value_size(), 1);
-    *out->mut_data<int32_t>() = label_feature.int32_list().value(0);
-  } else if (label_feature.has_int64_list()) {
-    CHECK_EQ(label_feature.int64_list().value_size(), 1);
-    *out->mut_data<int32_t>() = label_feature.int64_list().value(0);
+  if (label_feature.kind() == OFRecordFeatureKind::kInt32List
+      || label_feature.kind() == OFRecordFeatureKind::kInt64List) {
+    CHECK_EQ(label_feature.value_size(), 1);
+    CHECK_EQ(label_feature.ReadValues(out->mut_data<int32_t>(), 1), 1);
   } else {
     UNIMPLEMENTED();
   }
@@ -112,20 +106,24 @@ void LoadWorker(BaseDataset* record_dataset,
 void DecodeWorker(const std::string image_feature_name, const std::string label_feature_name,
                   const std::string color_space, Buffer<BaseLoadTargetPtr>* in_buffer,
                   Buffer<std::shared_ptr<ImageClassificationDataInstance>>* out_buffer) {
+  // only the two features are located in the serialized record, the others are skipped
+  const std::vector<std::string> feature_names({image_feature_name, label_feature_name});
+  std::vector<OFRecordFeatureView> features;
   while (true) {
     BaseLoadTargetPtr serialized_record;
     auto receive_status = in_buffer->Pull(&serialized_record);
     if (receive_status == kBufferStatusErrorClosed) { break; }
     CHECK(receive_status == kBufferStatusSuccess);
-    OFRecord record;
-    CHECK(record.ParseFromArray(serialized_record->data<char>(),
-                                serialized_record->shape().elem_cnt()));
+    CHECK(ScanOFRecordFeatures(serialized_record->data<char>(),
+                               serialized_record->shape().elem_cnt(), feature_names, &features));
+    CHECK(features.at(0).IsValid()) << "Field " << image_feature_name << " not found";
+    CHECK(features.at(1).IsValid()) << "Field " << label_feature_name << " not found";
     std::shared_ptr<ImageClassificationDataInstance> instance(
         new ImageClassificationDataInstance());
     instance->image.reset(new TensorBuffer());
-    DecodeImageFromOFRecord(record, image_feature_name, color_space, instance->image.get());
+    DecodeImageFromOFRecord(features.at(0), color_space, instance->image.get());
     instance->label.reset(new TensorBuffer());
-    DecodeLabelFromFromOFRecord(record, label_feature_name, instance->label.get());
+    DecodeLabelFromFromOFRecord(features.at(1), instance->label.get());
     auto send_status = out_buffer->Push(instance);
     if (send_status == kBufferStatusErrorClosed) { break; }
     CHECK(send_status == kBufferStatusSuccess);
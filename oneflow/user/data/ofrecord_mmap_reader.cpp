@@ -0,0 +1,236 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/ofrecord_mmap_reader.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/user/data/dataset.h"
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr char kIndexMagicCode[] = "OFRIDX\x00\x00";
+constexpr size_t kIndexMagicCodeLen = sizeof(kIndexMagicCode) - 1;
+constexpr int64_t kRecordSizeBytes = sizeof(int64_t);
+
+int64_t ReadRecordSize(const char* data, int64_t offset) {
+  int64_t record_size = -1;
+  std::memcpy(&record_size, data + offset, kRecordSizeBytes);
+  return record_size;
+}
+
+}  // namespace
+
+MappedOFRecordPart::MappedOFRecordPart(const std::string& path)
+    : data_(std::make_shared<const MappedBuffer>(path)) {
+  const std::string index_path = path + ".idx";
+  if (!LoadIndex(index_path)) {
+    BuildIndex();
+    if (ParseBooleanFromEnv("ONEFLOW_DATA_READER_OFRECORD_MMAP_SAVE_INDEX", true)) {
+      SaveIndex(index_path);
+    }
+  }
+}
+
+void MappedOFRecordPart::ViewRecord(int64_t record_idx, TensorBuffer* buffer) const {
+  const char* data = static_cast<const char*>(data_->ptr());
+  const int64_t offset = offsets_.at(record_idx);
+  const int64_t record_size = ReadRecordSize(data, offset);
+  buffer->ShareExternalData(data + offset + kRecordSizeBytes, Shape({record_size}),
+                            DataType::kChar, data_);
+}
+
+bool MappedOFRecordPart::LoadIndex(const std::string& index_path) {
+  std::ifstream stream(index_path, std::ios::binary);
+  if (!stream.is_open()) { return false; }
+  char magic_code[kIndexMagicCodeLen];
+  uint64_t data_size = 0;
+  uint64_t num_records = 0;
+  stream.read(magic_code, kIndexMagicCodeLen);
+  stream.read(reinterpret_cast<char*>(&data_size), sizeof(data_size));
+  stream.read(reinterpret_cast<char*>(&num_records), sizeof(num_records));
+  if (!stream || std::memcmp(magic_code, kIndexMagicCode, kIndexMagicCodeLen) != 0
+      || data_size != data_->size()) {
+    LOG(WARNING) << "ignore the mismatched OFRecord index file " << index_path;
+    return false;
+  }
+  // every record takes its size and at least one byte, a larger count is not trusted
+  if (num_records > data_size / (kRecordSizeBytes + 1)) {
+    LOG(WARNING) << "ignore the corrupted OFRecord index file " << index_path;
+    return false;
+  }
+  offsets_.resize(num_records);
+  stream.read(reinterpret_cast<char*>(offsets_.data()), sizeof(int64_t) * num_records);
+  if (!stream) {
+    LOG(WARNING) << "ignore the truncated OFRecord index file " << index_path;
+    offsets_.clear();
+    return false;
+  }
+  if (!IsIndexValid()) {
+    LOG(WARNING) << "ignore the corrupted OFRecord index file " << index_path;
+    offsets_.clear();
+    return false;
+  }
+  return true;
+}
+
+// The records must follow one another and fit in the part file, as BuildIndex finds them
+bool MappedOFRecordPart::IsIndexValid() const {
+  const char* data = static_cast<const char*>(data_->ptr());
+  const int64_t data_size = data_->size();
+  int64_t expected_offset = 0;
+  for (int64_t offset : offsets_) {
+    if (offset != expected_offset || offset + kRecordSizeBytes > data_size) { return false; }
+    const int64_t record_size = ReadRecordSize(data, offset);
+    if (record_size <= 0 || record_size > data_size - offset - kRecordSizeBytes) { return false; }
+    expected_offset = offset + kRecordSizeBytes + record_size;
+  }
+  return expected_offset == data_size;
+}
+
+void MappedOFRecordPart::BuildIndex() {
+  const char* data = static_cast<const char*>(data_->ptr());
+  const int64_t data_size = data_->size();
+  int64_t offset = 0;
+  while (offset < data_size) {
+    CHECK_LE(offset + kRecordSizeBytes, data_size) << "truncated OFRecord part file";
+    const int64_t record_size = ReadRecordSize(data, offset);
+    CHECK_GT(record_size, 0);
+    CHECK_LE(offset + kRecordSizeBytes + record_size, data_size) << "truncated OFRecord part file";
+    offsets_.emplace_back(offset);
+    offset += kRecordSizeBytes + record_size;
+  }
+}
+
+void MappedOFRecordPart::SaveIndex(const std::string& index_path) const {
+  // write to a temporary file first, other ranks may be reading the same index file
+  const std::string tmp_path = index_path + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream stream(tmp_path, std::ios::binary);
+    if (!stream.is_open()) {
+      LOG(INFO) << "can not save OFRecord index file " << index_path;
+      return;
+    }
+    const uint64_t data_size = data_->size();
+    const uint64_t num_records = offsets_.size();
+    stream.write(kIndexMagicCode, kIndexMagicCodeLen);
+    stream.write(reinterpret_cast<const char*>(&data_size), sizeof(data_size));
+    stream.write(reinterpret_cast<const char*>(&num_records), sizeof(num_records));
+    stream.write(reinterpret_cast<const char*>(offsets_.data()), sizeof(int64_t) * num_records);
+  }
+  if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) { std::remove(tmp_path.c_str()); }
+}
+
+OFRecordMMapReader::OFRecordMMapReader(const std::vector<std::string>& data_file_paths,
+                                       Range range, int64_t parallel_id, int64_t parallel_num,
+                                       bool shuffle_after_epoch, bool global_shuffle)
+    : data_file_paths_(data_file_paths),
+      range_(range),
+      parallel_id_(parallel_id),
+      parallel_num_(parallel_num),
+      shuffle_after_epoch_(shuffle_after_epoch),
+      global_shuffle_(global_shuffle),
+      epoch_(0),
+      cur_sample_idx_(0),
+      epoch_sample_num_(0) {
+  StartEpoch(0);
+}
+
+std::shared_ptr<TensorBuffer> OFRecordMMapReader::Next() {
+  if (cur_sample_idx_ == epoch_sample_num_) { StartEpoch(epoch_ + 1); }
+  const int64_t record_id =
+      global_shuffle_ ? epoch_record_ids_.at(cur_sample_idx_) : cur_sample_idx_;
+  cur_sample_idx_ += 1;
+  const int64_t part_idx = std::upper_bound(epoch_part_offsets_.cbegin(),
+                                            epoch_part_offsets_.cend(), record_id)
+                           - epoch_part_offsets_.cbegin() - 1;
+  std::shared_ptr<TensorBuffer> sample_ptr(new TensorBuffer());
+  epoch_parts_.at(part_idx)->ViewRecord(record_id - epoch_part_offsets_.at(part_idx),
+                                        sample_ptr.get());
+  return sample_ptr;
+}
+
+void OFRecordMMapReader::SeekToSample(int64_t sample_idx) {
+  CHECK_GE(sample_idx, 0);
+  StartEpoch(0);
+  if (global_shuffle_) {
+    // every epoch has the same number of samples
+    StartEpoch(sample_idx / epoch_sample_num_);
+    cur_sample_idx_ = sample_idx % epoch_sample_num_;
+    return;
+  }
+  while (sample_idx >= epoch_sample_num_) {
+    sample_idx -= epoch_sample_num_;
+    StartEpoch(epoch_ + 1);
+  }
+  cur_sample_idx_ = sample_idx;
+}
+
+void OFRecordMMapReader::StartEpoch(int64_t epoch) {
+  CHECK(global_shuffle_ || epoch == 0 || epoch == epoch_ + 1);
+  epoch_ = epoch;
+  cur_sample_idx_ = 0;
+  if (global_shuffle_) {
+    if (epoch_parts_.empty()) {
+      epoch_part_offsets_.assign(1, 0);
+      for (const std::string& path : data_file_paths_) {
+        epoch_parts_.emplace_back(GetOrMapPart(path));
+        epoch_part_offsets_.emplace_back(epoch_part_offsets_.back()
+                                         + epoch_parts_.back()->num_records());
+      }
+    }
+    const int64_t total_record_num = epoch_part_offsets_.back();
+    std::vector<int64_t> record_ids(total_record_num);
+    std::iota(record_ids.begin(), record_ids.end(), 0);
+    std::mt19937 g(kOneflowDatasetSeed + epoch_);
+    std::shuffle(record_ids.begin(), record_ids.end(), g);
+    const Range record_range = BalancedSplitter(total_record_num, parallel_num_).At(parallel_id_);
+    epoch_record_ids_.assign(record_ids.cbegin() + record_range.begin(),
+                             record_ids.cbegin() + record_range.end());
+    epoch_sample_num_ = epoch_record_ids_.size();
+  } else {
+    if (epoch_ == 0) {
+      epoch_file_paths_ = data_file_paths_;
+    } else if (shuffle_after_epoch_) {
+      std::mt19937 g(kOneflowDatasetSeed + epoch_);
+      std::shuffle(epoch_file_paths_.begin(), epoch_file_paths_.end(), g);
+    }
+    epoch_parts_.clear();
+    epoch_part_offsets_.assign(1, 0);
+    for (int64_t i = range_.begin(); i < range_.end(); ++i) {
+      epoch_parts_.emplace_back(GetOrMapPart(epoch_file_paths_.at(i)));
+      epoch_part_offsets_.emplace_back(epoch_part_offsets_.back()
+                                       + epoch_parts_.back()->num_records());
+    }
+    epoch_sample_num_ = epoch_part_offsets_.back();
+  }
+  CHECK_GT(epoch_sample_num_, 0) << "no OFRecord in the part files of epoch " << epoch_;
+}
+
+const MappedOFRecordPart* OFRecordMMapReader::GetOrMapPart(const std::string& path) {
+  auto it = path2part_.find(path);
+  if (it == path2part_.end()) {
+    it = path2part_.emplace(path, std::make_unique<MappedOFRecordPart>(path)).first;
+  }
+  return it->second.get();
+}
+
+}  // namespace data
+}  // namespace oneflow
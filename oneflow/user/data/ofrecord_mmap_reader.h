@@ -0,0 +1,100 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_OFRECORD_MMAP_READER_H_
+#define ONEFLOW_USER_DATA_OFRECORD_MMAP_READER_H_
+
+#include "oneflow/core/common/range.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/user/data/mapped_buffer.h"
+
+namespace oneflow {
+namespace data {
+
+// A memory-mapped OFRecord part file and the offsets of its records.
+//
+// The offsets are loaded from the sidecar index file "<part file>.idx" if it matches the part
+// file, otherwise they are built by a scan over the length prefixes of the records and saved to
+// the sidecar index file when possible.
+class MappedOFRecordPart final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MappedOFRecordPart);
+  explicit MappedOFRecordPart(const std::string& path);
+  ~MappedOFRecordPart() = default;
+
+  int64_t num_records() const { return offsets_.size(); }
+  // Make `buffer` a view of the record, the view keeps the part file mapped
+  void ViewRecord(int64_t record_idx, TensorBuffer* buffer) const;
+
+ private:
+  bool LoadIndex(const std::string& index_path);
+  bool IsIndexValid() const;
+  void BuildIndex();
+  void SaveIndex(const std::string& index_path) const;
+
+  std::shared_ptr<const MappedBuffer> data_;
+  // offsets of the length prefixes
+  std::vector<int64_t> offsets_;
+};
+
+// OFRecordMMapReader returns the records of the local file system part files as views of the
+// mapped files, so they are never copied before parsing.
+//
+// By default the records are returned in the same order as OFRecordDataset, including the
+// `shuffle_after_epoch` of part files. If `global_shuffle` is set, the records of all the part
+// files are shuffled every epoch and every rank takes its balanced share of them.
+class OFRecordMMapReader final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordMMapReader);
+  OFRecordMMapReader(const std::vector<std::string>& data_file_paths, Range range,
+                     int64_t parallel_id, int64_t parallel_num, bool shuffle_after_epoch,
+                     bool global_shuffle);
+  ~OFRecordMMapReader() = default;
+
+  std::shared_ptr<TensorBuffer> Next();
+  // Seek to the `sample_idx`-th sample of this rank counted from the beginning, only the record
+  // numbers of the passed epochs are visited
+  void SeekToSample(int64_t sample_idx);
+
+ private:
+  // Without global_shuffle_, `epoch` must be 0 or the next epoch
+  void StartEpoch(int64_t epoch);
+  const MappedOFRecordPart* GetOrMapPart(const std::string& path);
+
+  const std::vector<std::string> data_file_paths_;
+  const Range range_;
+  const int64_t parallel_id_;
+  const int64_t parallel_num_;
+  const bool shuffle_after_epoch_;
+  const bool global_shuffle_;
+
+  HashMap<std::string, std::unique_ptr<MappedOFRecordPart>> path2part_;
+  // data_file_paths_ shuffled after every epoch, used without global_shuffle_
+  std::vector<std::string> epoch_file_paths_;
+
+  int64_t epoch_;
+  int64_t cur_sample_idx_;
+  int64_t epoch_sample_num_;
+  std::vector<const MappedOFRecordPart*> epoch_parts_;
+  // prefix sums of the record numbers of epoch_parts_
+  std::vector<int64_t> epoch_part_offsets_;
+  // the records of this rank in the current epoch, used with global_shuffle_
+  std::vector<int64_t> epoch_record_ids_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_OFRECORD_MMAP_READER_H_
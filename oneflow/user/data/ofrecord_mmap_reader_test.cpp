@@ -0,0 +1,214 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <fstream>
+#include <set>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/user/data/ofrecord_mmap_reader.h"
+#include "oneflow/user/data/ofrecord_serial_reader.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// The record `j` of the part file `i` is filled with the byte `i` and has `j + 1` bytes
+void WritePartFile(const std::string& path, int64_t part_id, int64_t record_num) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  FOR_RANGE(int64_t, j, 0, record_num) {
+    const int64_t size = j + 1;
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out << std::string(size, static_cast<char>(part_id));
+  }
+}
+
+std::vector<std::string> WritePartFiles(const std::string& dir,
+                                        const std::vector<int64_t>& record_nums) {
+  LocalFS()->RecursivelyCreateDirIfNotExist(dir);
+  std::vector<std::string> paths;
+  FOR_RANGE(size_t, i, 0, record_nums.size()) {
+    paths.emplace_back(JoinPath(dir, "part-" + std::to_string(i)));
+    WritePartFile(paths.back(), i, record_nums.at(i));
+  }
+  return paths;
+}
+
+std::string ToString(const TensorBuffer& buffer) {
+  return std::string(buffer.data<char>(), buffer.nbytes());
+}
+
+void WriteIndexFile(const std::string& path, uint64_t data_size, uint64_t num_records,
+                    const std::vector<int64_t>& offsets) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write("OFRIDX\x00\x00", 8);
+  out.write(reinterpret_cast<const char*>(&data_size), sizeof(data_size));
+  out.write(reinterpret_cast<const char*>(&num_records), sizeof(num_records));
+  out.write(reinterpret_cast<const char*>(offsets.data()), sizeof(int64_t) * offsets.size());
+}
+
+bool FileExists(const std::string& path) { return std::ifstream(path).good(); }
+
+void CheckPart(const MappedOFRecordPart& part, int64_t part_id, int64_t record_num) {
+  ASSERT_EQ(part.num_records(), record_num);
+  FOR_RANGE(int64_t, j, 0, record_num) {
+    TensorBuffer buffer;
+    part.ViewRecord(j, &buffer);
+    ASSERT_EQ(ToString(buffer), std::string(j + 1, static_cast<char>(part_id)));
+  }
+}
+
+}  // namespace
+
+TEST(OFRecordMMapReader, offset_index) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_mmap_reader_index_test_dir");
+  const std::string path = WritePartFiles(dir, {5}).front();
+  const std::string index_path = path + ".idx";
+  ASSERT_FALSE(FileExists(index_path));
+  // the first mapping builds and saves the index, the second one loads it
+  CheckPart(MappedOFRecordPart(path), 0, 5);
+  ASSERT_TRUE(FileExists(index_path));
+  CheckPart(MappedOFRecordPart(path), 0, 5);
+  // an index of a different part file size is rebuilt
+  WritePartFile(path, 0, 9);
+  CheckPart(MappedOFRecordPart(path), 0, 9);
+  CheckPart(MappedOFRecordPart(path), 0, 9);
+  // a truncated index is rebuilt
+  std::ofstream(index_path, std::ios::binary | std::ios::trunc) << "OFRIDX";
+  CheckPart(MappedOFRecordPart(path), 0, 9);
+  // corrupted indexes of the right part file size are rebuilt
+  const uint64_t data_size = 9 * sizeof(int64_t) + 45;
+  std::vector<int64_t> offsets;
+  FOR_RANGE(int64_t, j, 0, 9) { offsets.emplace_back(j * sizeof(int64_t) + j * (j + 1) / 2); }
+  std::vector<std::vector<int64_t>> corrupted_offsets_list(4, offsets);
+  corrupted_offsets_list.at(0).at(3) += 1;
+  corrupted_offsets_list.at(1).at(8) = data_size;
+  corrupted_offsets_list.at(2).pop_back();
+  std::swap(corrupted_offsets_list.at(3).at(2), corrupted_offsets_list.at(3).at(5));
+  for (const auto& corrupted_offsets : corrupted_offsets_list) {
+    WriteIndexFile(index_path, data_size, corrupted_offsets.size(), corrupted_offsets);
+    CheckPart(MappedOFRecordPart(path), 0, 9);
+  }
+  WriteIndexFile(index_path, data_size, uint64_t(1) << 60, offsets);
+  CheckPart(MappedOFRecordPart(path), 0, 9);
+  WriteIndexFile(index_path, data_size, offsets.size(), offsets);
+  CheckPart(MappedOFRecordPart(path), 0, 9);
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+TEST(OFRecordMMapReader, mapped_record) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_mmap_reader_mapping_test_dir");
+  const std::string path = WritePartFiles(dir, {3}).front();
+  TensorBuffer view;
+  TensorBuffer other_view;
+  {
+    MappedOFRecordPart part(path);
+    part.ViewRecord(2, &view);
+    part.ViewRecord(2, &other_view);
+  }
+  // the views keep the part file mapped
+  ASSERT_EQ(ToString(view), std::string(3, '\0'));
+  ASSERT_EQ(view.data<char>(), other_view.data<char>());
+  // writing a view copies the record first, the mapped memory is read-only
+  const char* mapped_ptr = view.data<char>();
+  char* written_ptr = view.mut_data<char>();
+  ASSERT_NE(written_ptr, mapped_ptr);
+  written_ptr[0] = 'x';
+  ASSERT_EQ(ToString(view), std::string("x") + std::string(2, '\0'));
+  ASSERT_EQ(ToString(other_view), std::string(3, '\0'));
+  ASSERT_EQ(other_view.data<char>(), mapped_ptr);
+  // resizing a view allocates a buffer of its own
+  other_view.Resize(Shape({3}));
+  ASSERT_NE(other_view.data<char>(), mapped_ptr);
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+TEST(OFRecordMMapReader, same_order_as_serial_reader) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_mmap_reader_order_test_dir");
+  const std::vector<int64_t> record_nums = {3, 1, 5, 40, 7, 2};
+  const std::vector<std::string> paths = WritePartFiles(dir, record_nums);
+  for (bool shuffle_after_epoch : {false, true}) {
+    // the part files 1 to 3 are the shard of the rank 1 of 3 ranks
+    for (Range range : {Range(0, 6), Range(2, 4)}) {
+      int64_t epoch_record_num = 0;
+      FOR_RANGE(int64_t, i, range.begin(), range.end()) { epoch_record_num += record_nums.at(i); }
+      OFRecordSerialReader serial_reader(LocalFS(), paths, range, shuffle_after_epoch);
+      OFRecordMMapReader mmap_reader(paths, range, 1, 3, shuffle_after_epoch, false);
+      FOR_RANGE(int64_t, i, 0, epoch_record_num * 4) {
+        ASSERT_EQ(ToString(*mmap_reader.Next()), ToString(*serial_reader.Next()))
+            << "record " << i << " shuffle_after_epoch " << shuffle_after_epoch;
+      }
+    }
+  }
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+TEST(OFRecordMMapReader, global_shuffle_sharding) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_mmap_reader_sharding_test_dir");
+  const std::vector<int64_t> record_nums = {3, 1, 5, 40, 7, 2};
+  const std::vector<std::string> paths = WritePartFiles(dir, record_nums);
+  const int64_t total_record_num = 58;
+  const int64_t parallel_num = 3;
+  std::vector<std::unique_ptr<OFRecordMMapReader>> readers;
+  FOR_RANGE(int64_t, parallel_id, 0, parallel_num) {
+    readers.emplace_back(
+        new OFRecordMMapReader(paths, Range(0, 6), parallel_id, parallel_num, false, true));
+  }
+  std::vector<std::string> prev_epoch_records;
+  FOR_RANGE(int64_t, epoch, 0, 3) {
+    // the ranks read every record of the epoch exactly once
+    std::vector<std::string> epoch_records;
+    FOR_RANGE(int64_t, parallel_id, 0, parallel_num) {
+      // 58 records are split into 20, 19 and 19
+      FOR_RANGE(int64_t, i, 0, parallel_id == 0 ? 20 : 19) {
+        epoch_records.emplace_back(ToString(*readers.at(parallel_id)->Next()));
+      }
+    }
+    ASSERT_NE(epoch_records, prev_epoch_records);
+    prev_epoch_records = epoch_records;
+    std::multiset<std::string> records(epoch_records.begin(), epoch_records.end());
+    std::multiset<std::string> expected_records;
+    FOR_RANGE(size_t, part_id, 0, record_nums.size()) {
+      FOR_RANGE(int64_t, j, 0, record_nums.at(part_id)) {
+        expected_records.emplace(std::string(j + 1, static_cast<char>(part_id)));
+      }
+    }
+    ASSERT_EQ(records.size(), total_record_num);
+    ASSERT_EQ(records, expected_records);
+  }
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+TEST(OFRecordMMapReader, seek_to_sample) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_mmap_reader_seek_test_dir");
+  const std::vector<std::string> paths = WritePartFiles(dir, {3, 1, 5, 40, 7, 2});
+  for (bool global_shuffle : {false, true}) {
+    for (int64_t skip_sample_num : {0, 5, 19, 57, 58, 130}) {
+      OFRecordMMapReader reader(paths, Range(0, 6), 0, 1, true, global_shuffle);
+      OFRecordMMapReader seeked_reader(paths, Range(0, 6), 0, 1, true, global_shuffle);
+      FOR_RANGE(int64_t, i, 0, skip_sample_num) { reader.Next(); }
+      seeked_reader.SeekToSample(skip_sample_num);
+      FOR_RANGE(int64_t, i, 0, 100) {
+        ASSERT_EQ(ToString(*seeked_reader.Next()), ToString(*reader.Next()))
+            << "global_shuffle " << global_shuffle << " skip_sample_num " << skip_sample_num;
+      }
+    }
+  }
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace data
+}  // namespace oneflow
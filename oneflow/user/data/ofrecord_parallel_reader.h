@@ -0,0 +1,154 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_OFRECORD_PARALLEL_READER_H_
+#define ONEFLOW_USER_DATA_OFRECORD_PARALLEL_READER_H_
+
+#include "oneflow/core/common/buffer.h"
+#include "oneflow/core/common/range.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/user/data/dataset.h"
+
+namespace oneflow {
+namespace data {
+
+// OFRecordParallelReader reads the local part files with `worker_num` threads, each of which owns
+// a PersistentInStream of one part file at a time and reads ahead up to `prefetch_chunk_num`
+// chunks of records.
+//
+// The part files are read as an endless sequence of tasks, the task `i` is the part file
+// `i % local_part_num` of the epoch `i / local_part_num` and is handled by the worker
+// `i % worker_num`. Records are returned task by task, so the order is exactly the same as reading
+// the part files one after another with a single stream, and the part files of every epoch are
+// shuffled in the same way as OFRecordDataset if `shuffle_after_epoch` is set.
+class OFRecordParallelReader final {
+ public:
+  using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetPtrList = std::vector<LoadTargetPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordParallelReader);
+  OFRecordParallelReader(fs::FileSystem* fs, const std::vector<std::string>& data_file_paths,
+                         Range range, bool shuffle_after_epoch, int32_t worker_num,
+                         int32_t prefetch_chunk_num)
+      : fs_(fs),
+        data_file_paths_(data_file_paths),
+        range_(range),
+        shuffle_after_epoch_(shuffle_after_epoch),
+        cur_task_id_(0),
+        cur_chunk_idx_(0),
+        empty_task_num_(0) {
+    CHECK_GT(range_.size(), 0);
+    CHECK_GT(worker_num, 0);
+    CHECK_GT(prefetch_chunk_num, 0);
+    worker_num = std::min<int32_t>(worker_num, range_.size());
+    FOR_RANGE(int32_t, worker_id, 0, worker_num) {
+      chunk_buffers_.emplace_back(
+          new Buffer<std::shared_ptr<LoadTargetPtrList>>(prefetch_chunk_num));
+    }
+    FOR_RANGE(int32_t, worker_id, 0, worker_num) {
+      workers_.emplace_back([this, worker_id]() { WorkerLoop(worker_id); });
+    }
+  }
+  ~OFRecordParallelReader() {
+    for (auto& buffer : chunk_buffers_) { buffer->Close(); }
+    for (std::thread& worker : workers_) { worker.join(); }
+  }
+
+  LoadTargetPtr Next() {
+    while (!cur_chunk_ || cur_chunk_idx_ == cur_chunk_->size()) {
+      auto* buffer = chunk_buffers_.at(cur_task_id_ % chunk_buffers_.size()).get();
+      CHECK_EQ(buffer->Pull(&cur_chunk_), kBufferStatusSuccess);
+      cur_chunk_idx_ = 0;
+      // an empty chunk marks the end of a part file
+      if (cur_chunk_->empty()) {
+        cur_task_id_ += 1;
+        empty_task_num_ += 1;
+        // a whole epoch of part files without any record would never return
+        CHECK_LT(empty_task_num_, range_.size()) << "all the local OFRecord part files are empty";
+      } else {
+        empty_task_num_ = 0;
+      }
+    }
+    return std::move(cur_chunk_->at(cur_chunk_idx_++));
+  }
+
+ private:
+  static constexpr size_t kRecordNumPerChunk = 32;
+
+  void WorkerLoop(int32_t worker_id) {
+    const int64_t local_part_num = range_.size();
+    const int64_t worker_num = chunk_buffers_.size();
+    auto* buffer = chunk_buffers_.at(worker_id).get();
+    // every worker shuffles its own copy of the file paths, the tasks of a worker never go back
+    // to an earlier epoch
+    std::vector<std::string> epoch_file_paths = data_file_paths_;
+    int64_t epoch = 0;
+    for (int64_t task_id = worker_id;; task_id += worker_num) {
+      while (shuffle_after_epoch_ && epoch < task_id / local_part_num) {
+        epoch += 1;
+        std::mt19937 g(kOneflowDatasetSeed + epoch);
+        std::shuffle(epoch_file_paths.begin(), epoch_file_paths.end(), g);
+      }
+      const std::string& path = epoch_file_paths.at(range_.begin() + task_id % local_part_num);
+      if (!ReadPartFile(path, buffer)) { return; }
+    }
+  }
+
+  // Return false if the reader is closed
+  bool ReadPartFile(const std::string& path, Buffer<std::shared_ptr<LoadTargetPtrList>>* buffer) {
+    PersistentInStream in_stream(fs_, path);
+    auto chunk = std::make_shared<LoadTargetPtrList>();
+    chunk->reserve(kRecordNumPerChunk);
+    while (true) {
+      int64_t OFRecord_size = -1;
+      char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
+      if (in_stream.ReadFully(size_ptr, sizeof(int64_t)) != 0) { break; }
+      CHECK_GT(OFRecord_size, 0);
+      LoadTargetPtr sample_ptr(new TensorBuffer());
+      sample_ptr->Resize(Shape({OFRecord_size}), DataType::kChar);
+      CHECK_EQ(in_stream.ReadFully(sample_ptr->mut_data<char>(), OFRecord_size), 0);
+      chunk->emplace_back(std::move(sample_ptr));
+      if (chunk->size() == kRecordNumPerChunk) {
+        if (buffer->Push(chunk) != kBufferStatusSuccess) { return false; }
+        chunk = std::make_shared<LoadTargetPtrList>();
+        chunk->reserve(kRecordNumPerChunk);
+      }
+    }
+    if (!chunk->empty()) {
+      if (buffer->Push(chunk) != kBufferStatusSuccess) { return false; }
+    }
+    return buffer->Push(std::make_shared<LoadTargetPtrList>()) == kBufferStatusSuccess;
+  }
+
+  fs::FileSystem* fs_;
+  const std::vector<std::string> data_file_paths_;
+  const Range range_;
+  const bool shuffle_after_epoch_;
+
+  std::vector<std::unique_ptr<Buffer<std::shared_ptr<LoadTargetPtrList>>>> chunk_buffers_;
+  std::vector<std::thread> workers_;
+
+  // only touched by the consumer
+  int64_t cur_task_id_;
+  std::shared_ptr<LoadTargetPtrList> cur_chunk_;
+  size_t cur_chunk_idx_;
+  // the number of part files read in a row without any record
+  int64_t empty_task_num_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_OFRECORD_PARALLEL_READER_H_
@@ -0,0 +1,102 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <fstream>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/user/data/ofrecord_parallel_reader.h"
+#include "oneflow/user/data/ofrecord_serial_reader.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// Write part files of length-prefixed records, the record `j` of the part file `i` is filled with
+// the byte `i` and has `j + 1` bytes, so every record can be told apart
+std::vector<std::string> WritePartFiles(const std::string& dir,
+                                        const std::vector<int64_t>& record_nums) {
+  LocalFS()->RecursivelyCreateDirIfNotExist(dir);
+  std::vector<std::string> paths;
+  FOR_RANGE(size_t, i, 0, record_nums.size()) {
+    paths.emplace_back(JoinPath(dir, "part-" + std::to_string(i)));
+    std::ofstream out(paths.back(), std::ios::binary | std::ios::trunc);
+    FOR_RANGE(int64_t, j, 0, record_nums.at(i)) {
+      const int64_t size = j + 1;
+      out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      out << std::string(size, static_cast<char>(i));
+    }
+  }
+  return paths;
+}
+
+std::string ToString(const TensorBuffer& buffer) {
+  return std::string(buffer.data<char>(), buffer.nbytes());
+}
+
+void TestSameOrderAsSerialReader(const std::string& dir, Range range, bool shuffle_after_epoch,
+                                 int32_t worker_num) {
+  // the part files 3 and 5 span several chunks, PersistentInStream can't read empty part files
+  const std::vector<int64_t> record_nums = {3, 1, 5, 40, 7, 65, 2};
+  const std::vector<std::string> paths = WritePartFiles(dir, record_nums);
+  int64_t epoch_record_num = 0;
+  FOR_RANGE(int64_t, i, range.begin(), range.end()) { epoch_record_num += record_nums.at(i); }
+  {
+    OFRecordSerialReader serial_reader(LocalFS(), paths, range, shuffle_after_epoch);
+    OFRecordParallelReader parallel_reader(LocalFS(), paths, range, shuffle_after_epoch,
+                                           worker_num, 2);
+    FOR_RANGE(int64_t, i, 0, epoch_record_num * 4) {
+      ASSERT_EQ(ToString(*parallel_reader.Next()), ToString(*serial_reader.Next()))
+          << "record " << i << " worker_num " << worker_num;
+    }
+  }
+  // the workers of the parallel reader may be reading ahead until it is destructed
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace
+
+TEST(OFRecordParallelReader, same_order_as_serial_reader) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_parallel_reader_test_dir");
+  for (int32_t worker_num : {1, 2, 3, 8}) {
+    TestSameOrderAsSerialReader(dir, Range(0, 7), false, worker_num);
+    TestSameOrderAsSerialReader(dir, Range(2, 6), false, worker_num);
+  }
+}
+
+TEST(OFRecordParallelReader, same_order_as_serial_reader_with_shuffle_after_epoch) {
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_parallel_reader_shuffle_test_dir");
+  for (int32_t worker_num : {1, 2, 3, 8}) {
+    TestSameOrderAsSerialReader(dir, Range(0, 7), true, worker_num);
+    TestSameOrderAsSerialReader(dir, Range(2, 6), true, worker_num);
+  }
+}
+
+TEST(OFRecordParallelReader, all_part_files_empty) {
+  testing::FLAGS_gtest_death_test_style = "threadsafe";
+  const std::string dir = JoinPath(GetCwd(), "ofrecord_parallel_reader_empty_test_dir");
+  const std::vector<std::string> paths = WritePartFiles(dir, {0, 0, 0});
+  ASSERT_DEATH(
+      {
+        OFRecordParallelReader reader(LocalFS(), paths, Range(0, 3), false, 2, 2);
+        reader.Next();
+      },
+      "all the local OFRecord part files are empty");
+  LocalFS()->RecursivelyDeleteDir(dir);
+}
+
+}  // namespace data
+}  // namespace oneflow
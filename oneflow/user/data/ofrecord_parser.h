@@ -35,6 +35,8 @@ class OFRecordParser final : public Parser<TensorBuffer> {
              user_op::KernelComputeContext* ctx) override {
     user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
     OFRecord* dptr = out_tensor->mut_dptr<OFRecord>();
+    // the out tensor of kOFRecord is the contract with the decoder ops, so every record is fully
+    // parsed here, only the readers which decode the records themselves use ScanOFRecordFeatures
     MultiThreadLoop(batch_data->size(), [&](size_t i) {
       TensorBuffer* buffer = batch_data->at(i).get();
       CHECK(dptr[i].ParseFromArray(buffer->data<char>(), buffer->shape().elem_cnt()));
@@ -0,0 +1,195 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/ofrecord_scanner.h"
+
+namespace oneflow {
+namespace data {
+
+namespace ofrecord_wire {
+
+bool SkipField(const char** ptr, const char* end, uint32_t wire_type) {
+  switch (wire_type) {
+    case kWireTypeVarint: {
+      uint64_t value = 0;
+      return ReadVarint(ptr, end, &value);
+    }
+    case kWireTypeFixed64: {
+      if (end - *ptr < 8) { return false; }
+      *ptr += 8;
+      return true;
+    }
+    case kWireTypeLengthDelimited: {
+      const char* data = nullptr;
+      size_t size = 0;
+      return ReadLengthDelimited(ptr, end, &data, &size);
+    }
+    case kWireTypeFixed32: {
+      if (end - *ptr < 4) { return false; }
+      *ptr += 4;
+      return true;
+    }
+    default: return false;
+  }
+}
+
+}  // namespace ofrecord_wire
+
+namespace {
+
+using namespace ofrecord_wire;
+
+// Parse a map entry of OFRecord.feature, which is {1: key, 2: Feature}
+bool ParseFeatureEntry(const char* ptr, const char* end, const char** key, size_t* key_size,
+                       const char** feature, size_t* feature_size) {
+  *key = nullptr;
+  *key_size = 0;
+  *feature = nullptr;
+  *feature_size = 0;
+  while (ptr < end) {
+    uint32_t field_number = 0;
+    uint32_t wire_type = 0;
+    if (!ReadTag(&ptr, end, &field_number, &wire_type)) { return false; }
+    if (field_number == 1 && wire_type == kWireTypeLengthDelimited) {
+      if (!ReadLengthDelimited(&ptr, end, key, key_size)) { return false; }
+    } else if (field_number == 2 && wire_type == kWireTypeLengthDelimited) {
+      if (!ReadLengthDelimited(&ptr, end, feature, feature_size)) { return false; }
+    } else if (!SkipField(&ptr, end, wire_type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parse a Feature, the last field of the oneof wins as protobuf does
+bool ParseFeature(const char* ptr, const char* end, OFRecordFeatureView* feature) {
+  *feature = OFRecordFeatureView();
+  while (ptr < end) {
+    uint32_t field_number = 0;
+    uint32_t wire_type = 0;
+    if (!ReadTag(&ptr, end, &field_number, &wire_type)) { return false; }
+    if (field_number >= static_cast<uint32_t>(OFRecordFeatureKind::kBytesList)
+        && field_number <= static_cast<uint32_t>(OFRecordFeatureKind::kInt64List)
+        && wire_type == kWireTypeLengthDelimited) {
+      const char* list_data = nullptr;
+      size_t list_size = 0;
+      if (!ReadLengthDelimited(&ptr, end, &list_data, &list_size)) { return false; }
+      *feature =
+          OFRecordFeatureView(static_cast<OFRecordFeatureKind>(field_number), list_data, list_size);
+    } else if (!SkipField(&ptr, end, wire_type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int64_t OFRecordFeatureView::value_size() const {
+  const char* ptr = list_data_;
+  const char* end = list_data_ + list_size_;
+  int64_t num = 0;
+  while (ptr < end) {
+    uint32_t field_number = 0;
+    uint32_t wire_type = 0;
+    CHECK(ReadTag(&ptr, end, &field_number, &wire_type));
+    if (field_number == 1 && wire_type == kWireTypeLengthDelimited
+        && kind_ != OFRecordFeatureKind::kBytesList) {
+      const char* packed = nullptr;
+      size_t packed_size = 0;
+      CHECK(ReadLengthDelimited(&ptr, end, &packed, &packed_size));
+      if (kind_ == OFRecordFeatureKind::kFloatList) {
+        num += packed_size / sizeof(float);
+      } else if (kind_ == OFRecordFeatureKind::kDoubleList) {
+        num += packed_size / sizeof(double);
+      } else {
+        // every varint ends with a byte without the continuation bit
+        FOR_RANGE(size_t, i, 0, packed_size) {
+          if ((static_cast<uint8_t>(packed[i]) & 0x80) == 0) { num += 1; }
+        }
+      }
+    } else {
+      if (field_number == 1) { num += 1; }
+      CHECK(SkipField(&ptr, end, wire_type));
+    }
+  }
+  return num;
+}
+
+void OFRecordFeatureView::GetBytesValue(int64_t index, const char** data, size_t* size) const {
+  CHECK(kind_ == OFRecordFeatureKind::kBytesList);
+  const char* ptr = list_data_;
+  const char* end = list_data_ + list_size_;
+  int64_t cur_index = 0;
+  while (ptr < end) {
+    uint32_t field_number = 0;
+    uint32_t wire_type = 0;
+    CHECK(ReadTag(&ptr, end, &field_number, &wire_type));
+    if (field_number == 1 && wire_type == kWireTypeLengthDelimited) {
+      CHECK(ReadLengthDelimited(&ptr, end, data, size));
+      if (cur_index == index) { return; }
+      cur_index += 1;
+    } else {
+      CHECK(SkipField(&ptr, end, wire_type));
+    }
+  }
+  LOG(FATAL) << "index " << index << " is out of the range of " << cur_index << " bytes values";
+}
+
+bool ScanOFRecordFeatures(const char* data, size_t size, const std::vector<std::string>& names,
+                          std::vector<OFRecordFeatureView>* features) {
+  features->assign(names.size(), OFRecordFeatureView());
+  const char* ptr = data;
+  const char* end = data + size;
+  while (ptr < end) {
+    uint32_t field_number = 0;
+    uint32_t wire_type = 0;
+    if (!ReadTag(&ptr, end, &field_number, &wire_type)) { return false; }
+    if (field_number != 1 || wire_type != kWireTypeLengthDelimited) {
+      if (!SkipField(&ptr, end, wire_type)) { return false; }
+      continue;
+    }
+    const char* entry = nullptr;
+    size_t entry_size = 0;
+    if (!ReadLengthDelimited(&ptr, end, &entry, &entry_size)) { return false; }
+    const char* key = nullptr;
+    size_t key_size = 0;
+    const char* feature = nullptr;
+    size_t feature_size = 0;
+    if (!ParseFeatureEntry(entry, entry + entry_size, &key, &key_size, &feature, &feature_size)) {
+      return false;
+    }
+    FOR_RANGE(size_t, i, 0, names.size()) {
+      const std::string& name = names.at(i);
+      if (name.size() != key_size || std::memcmp(name.data(), key, key_size) != 0) { continue; }
+      // the last entry of the same key wins as protobuf does
+      if (!ParseFeature(feature, feature + feature_size, &features->at(i))) { return false; }
+    }
+  }
+  return true;
+}
+
+bool FindOFRecordFeature(const char* data, size_t size, const std::string& name,
+                         OFRecordFeatureView* feature) {
+  std::vector<OFRecordFeatureView> features;
+  if (!ScanOFRecordFeatures(data, size, std::vector<std::string>({name}), &features)) {
+    return false;
+  }
+  *feature = features.front();
+  return true;
+}
+
+}  // namespace data
+}  // namespace oneflow
@@ -0,0 +1,194 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_OFRECORD_SCANNER_H_
+#define ONEFLOW_USER_DATA_OFRECORD_SCANNER_H_
+
+#include "oneflow/core/common/util.h"
+#include <cstring>
+#include <type_traits>
+
+namespace oneflow {
+namespace data {
+
+// The scanner works on the protobuf wire format of a serialized OFRecord and locates features by
+// name without deserializing the record, so the features which are not requested, e.g. large
+// image bytes, are skipped instead of being copied into an OFRecord message.
+
+namespace ofrecord_wire {
+
+enum WireType : uint32_t {
+  kWireTypeVarint = 0,
+  kWireTypeFixed64 = 1,
+  kWireTypeLengthDelimited = 2,
+  kWireTypeFixed32 = 5,
+};
+
+inline bool ReadVarint(const char** ptr, const char* end, uint64_t* value) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && *ptr < end; shift += 7) {
+    const uint8_t byte = static_cast<uint8_t>(*(*ptr)++);
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+inline bool ReadTag(const char** ptr, const char* end, uint32_t* field_number,
+                    uint32_t* wire_type) {
+  uint64_t tag = 0;
+  if (!ReadVarint(ptr, end, &tag)) { return false; }
+  *field_number = static_cast<uint32_t>(tag >> 3);
+  *wire_type = static_cast<uint32_t>(tag & 0x7);
+  return true;
+}
+
+inline bool ReadLengthDelimited(const char** ptr, const char* end, const char** data,
+                                size_t* size) {
+  uint64_t length = 0;
+  if (!ReadVarint(ptr, end, &length) || length > static_cast<uint64_t>(end - *ptr)) {
+    return false;
+  }
+  *data = *ptr;
+  *size = length;
+  *ptr += length;
+  return true;
+}
+
+bool SkipField(const char** ptr, const char* end, uint32_t wire_type);
+
+}  // namespace ofrecord_wire
+
+enum class OFRecordFeatureKind {
+  kInvalid = 0,
+  kBytesList = 1,
+  kFloatList = 2,
+  kDoubleList = 3,
+  kInt32List = 4,
+  kInt64List = 5,
+};
+
+// A feature of a serialized OFRecord, which refers to the memory of the serialized record
+class OFRecordFeatureView final {
+ public:
+  OFRecordFeatureView()
+      : kind_(OFRecordFeatureKind::kInvalid), list_data_(nullptr), list_size_(0) {}
+  OFRecordFeatureView(OFRecordFeatureKind kind, const char* list_data, size_t list_size)
+      : kind_(kind), list_data_(list_data), list_size_(list_size) {}
+  ~OFRecordFeatureView() = default;
+
+  OFRecordFeatureKind kind() const { return kind_; }
+  bool IsValid() const { return kind_ != OFRecordFeatureKind::kInvalid; }
+
+  // Number of values of the list, works for all the kinds
+  int64_t value_size() const;
+  // Get the `index`-th value of a BytesList without copying
+  void GetBytesValue(int64_t index, const char** data, size_t* size) const;
+  // Convert up to `max_num` values of a numeric list to T, return the number of converted values
+  template<typename T>
+  int64_t ReadValues(T* dst, int64_t max_num) const;
+
+ private:
+  template<typename CppT, typename T>
+  int64_t ReadValuesAs(T* dst, int64_t max_num) const;
+
+  OFRecordFeatureKind kind_;
+  // the serialized BytesList, FloatList, DoubleList, Int32List or Int64List
+  const char* list_data_;
+  size_t list_size_;
+};
+
+// Find the features named `names` in the serialized OFRecord. `features` is resized to the size
+// of `names`, and a feature which is not found is left invalid. Return false if the record is
+// malformed.
+bool ScanOFRecordFeatures(const char* data, size_t size, const std::vector<std::string>& names,
+                          std::vector<OFRecordFeatureView>* features);
+bool FindOFRecordFeature(const char* data, size_t size, const std::string& name,
+                         OFRecordFeatureView* feature);
+
+template<typename T>
+int64_t OFRecordFeatureView::ReadValues(T* dst, int64_t max_num) const {
+  switch (kind_) {
+    case OFRecordFeatureKind::kFloatList: return ReadValuesAs<float>(dst, max_num);
+    case OFRecordFeatureKind::kDoubleList: return ReadValuesAs<double>(dst, max_num);
+    case OFRecordFeatureKind::kInt32List: return ReadValuesAs<int32_t>(dst, max_num);
+    case OFRecordFeatureKind::kInt64List: return ReadValuesAs<int64_t>(dst, max_num);
+    default: UNIMPLEMENTED();
+  }
+  return 0;
+}
+
+template<typename CppT, typename T>
+int64_t OFRecordFeatureView::ReadValuesAs(T* dst, int64_t max_num) const {
+  using namespace ofrecord_wire;
+  const uint32_t fixed_wire_type = sizeof(CppT) == 4 ? kWireTypeFixed32 : kWireTypeFixed64;
+  const uint32_t value_wire_type =
+      std::is_floating_point<CppT>::value ? fixed_wire_type : kWireTypeVarint;
+  // values are packed by protobuf serializers, but parsers have to accept unpacked values too
+  auto DecodeOne = [fixed_wire_type](const char** ptr, const char* end, uint32_t wire_type,
+                                     CppT* value) {
+    if (wire_type == kWireTypeVarint) {
+      uint64_t raw = 0;
+      CHECK(ReadVarint(ptr, end, &raw));
+      *value = static_cast<CppT>(raw);
+    } else {
+      CHECK_EQ(wire_type, fixed_wire_type);
+      CHECK_LE(sizeof(CppT), static_cast<size_t>(end - *ptr));
+      std::memcpy(value, *ptr, sizeof(CppT));
+      *ptr += sizeof(CppT);
+    }
+  };
+  int64_t num = 0;
+  const char* ptr = list_data_;
+  const char* end = list_data_ + list_size_;
+  while (ptr < end && num < max_num) {
+    uint32_t field_number = 0;
+    uint32_t wire_type = 0;
+    CHECK(ReadTag(&ptr, end, &field_number, &wire_type));
+    if (field_number != 1) {
+      CHECK(SkipField(&ptr, end, wire_type));
+    } else if (wire_type == kWireTypeLengthDelimited) {
+      const char* packed = nullptr;
+      size_t packed_size = 0;
+      CHECK(ReadLengthDelimited(&ptr, end, &packed, &packed_size));
+      const char* packed_end = packed + packed_size;
+      if (value_wire_type != kWireTypeVarint && std::is_same<CppT, T>::value) {
+        const int64_t copy_num =
+            std::min<int64_t>(max_num - num, packed_size / sizeof(CppT));
+        std::memcpy(dst + num, packed, copy_num * sizeof(CppT));
+        num += copy_num;
+        continue;
+      }
+      while (packed < packed_end && num < max_num) {
+        CppT value;
+        DecodeOne(&packed, packed_end, value_wire_type, &value);
+        dst[num++] = static_cast<T>(value);
+      }
+    } else {
+      CppT value;
+      DecodeOne(&ptr, end, wire_type, &value);
+      dst[num++] = static_cast<T>(value);
+    }
+  }
+  return num;
+}
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_OFRECORD_SCANNER_H_
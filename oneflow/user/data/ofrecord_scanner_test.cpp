@@ -0,0 +1,128 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <chrono>
+#include "oneflow/user/data/ofrecord_scanner.h"
+#include "oneflow/core/record/record.pb.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+OFRecord MakeRecord(int64_t image_size, int64_t unused_feature_num) {
+  OFRecord record;
+  auto* feature = record.mutable_feature();
+  std::string image(image_size, '\0');
+  FOR_RANGE(int64_t, i, 0, image_size) { image[i] = static_cast<char>(i * 7); }
+  (*feature)["image"].mutable_bytes_list()->add_value(image);
+  (*feature)["label"].mutable_int64_list()->add_value(-3);
+  (*feature)["bbox"].mutable_float_list()->add_value(0.5);
+  (*feature)["bbox"].mutable_float_list()->add_value(-1.25);
+  (*feature)["score"].mutable_double_list()->add_value(2.5);
+  (*feature)["ids"].mutable_int32_list()->add_value(-1);
+  (*feature)["ids"].mutable_int32_list()->add_value(300);
+  FOR_RANGE(int64_t, i, 0, unused_feature_num) {
+    (*feature)["unused_" + std::to_string(i)].mutable_bytes_list()->add_value(
+        std::string(1024, 'x'));
+  }
+  return record;
+}
+
+}  // namespace
+
+TEST(OFRecordScanner, same_as_parse) {
+  const std::string serialized = MakeRecord(1000, 8).SerializeAsString();
+  std::vector<OFRecordFeatureView> features;
+  ASSERT_TRUE(ScanOFRecordFeatures(serialized.data(), serialized.size(),
+                                   {"image", "label", "bbox", "score", "ids", "missing"},
+                                   &features));
+  OFRecord record;
+  ASSERT_TRUE(record.ParseFromString(serialized));
+
+  ASSERT_TRUE(features.at(0).kind() == OFRecordFeatureKind::kBytesList);
+  ASSERT_EQ(features.at(0).value_size(), 1);
+  const char* image = nullptr;
+  size_t image_size = 0;
+  features.at(0).GetBytesValue(0, &image, &image_size);
+  ASSERT_EQ(std::string(image, image_size), record.feature().at("image").bytes_list().value(0));
+
+  int32_t label = 0;
+  ASSERT_TRUE(features.at(1).kind() == OFRecordFeatureKind::kInt64List);
+  ASSERT_EQ(features.at(1).ReadValues(&label, 1), 1);
+  ASSERT_EQ(label, -3);
+
+  float bbox[3] = {0, 0, 0};
+  ASSERT_EQ(features.at(2).value_size(), 2);
+  ASSERT_EQ(features.at(2).ReadValues(bbox, 3), 2);
+  ASSERT_EQ(bbox[0], 0.5);
+  ASSERT_EQ(bbox[1], -1.25);
+
+  int64_t score = 0;
+  ASSERT_EQ(features.at(3).ReadValues(&score, 1), 1);
+  ASSERT_EQ(score, 2);
+
+  double ids[2] = {0, 0};
+  ASSERT_EQ(features.at(4).value_size(), 2);
+  ASSERT_EQ(features.at(4).ReadValues(ids, 2), 2);
+  ASSERT_EQ(ids[0], -1);
+  ASSERT_EQ(ids[1], 300);
+
+  ASSERT_FALSE(features.at(5).IsValid());
+  // truncated record
+  ASSERT_FALSE(
+      ScanOFRecordFeatures(serialized.data(), serialized.size() - 1, {"image"}, &features));
+}
+
+// not a unit test, run it with --gtest_also_run_disabled_tests
+TEST(OFRecordScanner, DISABLED_benchmark) {
+  const int64_t record_num = 2000;
+  const std::string serialized = MakeRecord(128 * 1024, 32).SerializeAsString();
+  int64_t checksum = 0;
+
+  const auto parse_start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, record_num) {
+    OFRecord record;
+    CHECK(record.ParseFromArray(serialized.data(), serialized.size()));
+    checksum += record.feature().at("image").bytes_list().value(0).size();
+    checksum += record.feature().at("label").int64_list().value(0);
+  }
+  const auto parse_end = std::chrono::steady_clock::now();
+
+  const std::vector<std::string> names({"image", "label"});
+  std::vector<OFRecordFeatureView> features;
+  FOR_RANGE(int64_t, i, 0, record_num) {
+    CHECK(ScanOFRecordFeatures(serialized.data(), serialized.size(), names, &features));
+    const char* image = nullptr;
+    size_t image_size = 0;
+    features.at(0).GetBytesValue(0, &image, &image_size);
+    int64_t label = 0;
+    CHECK_EQ(features.at(1).ReadValues(&label, 1), 1);
+    checksum -= image_size + label;
+  }
+  const auto scan_end = std::chrono::steady_clock::now();
+  ASSERT_EQ(checksum, 0);
+
+  const double parse_seconds = std::chrono::duration<double>(parse_end - parse_start).count();
+  const double scan_seconds = std::chrono::duration<double>(scan_end - parse_end).count();
+  LOG(INFO) << "record bytes: " << serialized.size()
+            << ", ParseFromArray records/s: " << static_cast<int64_t>(record_num / parse_seconds)
+            << ", ScanOFRecordFeatures records/s: "
+            << static_cast<int64_t>(record_num / scan_seconds);
+}
+
+}  // namespace data
+}  // namespace oneflow
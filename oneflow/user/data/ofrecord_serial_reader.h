@@ -0,0 +1,92 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_OFRECORD_SERIAL_READER_H_
+#define ONEFLOW_USER_DATA_OFRECORD_SERIAL_READER_H_
+
+#include "oneflow/core/common/range.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/user/data/dataset.h"
+
+namespace oneflow {
+namespace data {
+
+// OFRecordSerialReader reads the local part files one after another with a single
+// PersistentInStream. The part files of every epoch after the first one are shuffled if
+// `shuffle_after_epoch` is set.
+class OFRecordSerialReader final {
+ public:
+  using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordSerialReader);
+  OFRecordSerialReader(fs::FileSystem* fs, const std::vector<std::string>& data_file_paths,
+                       Range range, bool shuffle_after_epoch)
+      : fs_(fs),
+        data_file_paths_(data_file_paths),
+        range_(range),
+        shuffle_after_epoch_(shuffle_after_epoch),
+        current_epoch_(0) {
+    in_stream_.reset(
+        new PersistentInStream(fs_, GetLocalFilePaths(), !shuffle_after_epoch_, false));
+  }
+  ~OFRecordSerialReader() = default;
+
+  LoadTargetPtr Next() {
+    LoadTargetPtr sample_ptr(new TensorBuffer());
+    ReadSample(*sample_ptr);
+    return sample_ptr;
+  }
+
+ private:
+  void ReadSample(TensorBuffer& tensor) {
+    int64_t OFRecord_size = -1;
+    char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
+    if (in_stream_->ReadFully(size_ptr, sizeof(int64_t)) != 0) {
+      ShuffleAfterEpoch();
+      CHECK_EQ(in_stream_->ReadFully(size_ptr, sizeof(int64_t)), 0);
+    }
+    CHECK_GT(OFRecord_size, 0);
+    tensor.Resize(Shape({OFRecord_size}), DataType::kChar);
+    CHECK_EQ(in_stream_->ReadFully(tensor.mut_data<char>(), OFRecord_size), 0);
+  }
+
+  void ShuffleAfterEpoch() {
+    CHECK(shuffle_after_epoch_);
+    current_epoch_++;  // move to next epoch
+    std::mt19937 g(kOneflowDatasetSeed + current_epoch_);
+    std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
+    in_stream_.reset(new PersistentInStream(fs_, GetLocalFilePaths(), false, false));
+  }
+
+  std::vector<std::string> GetLocalFilePaths() {
+    std::vector<std::string> ret;
+    for (int i = range_.begin(); i < range_.end(); ++i) {
+      ret.emplace_back(data_file_paths_.at(i));
+    }
+    return ret;
+  }
+
+  fs::FileSystem* fs_;
+  std::vector<std::string> data_file_paths_;
+  const Range range_;
+  const bool shuffle_after_epoch_;
+  int32_t current_epoch_;
+  std::unique_ptr<PersistentInStream> in_stream_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_OFRECORD_SERIAL_READER_H_
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/avg_pooling_kernel_util.h"
+#include "oneflow/core/ep/include/primitive/pooling.h"
 
 namespace oneflow {
 
@@ -41,12 +42,41 @@ std::shared_ptr<AvgPoolingOpKernelCache> CreateAvgOpKernelCache(user_op::KernelC
   return cache;
 }
 
+// Launch the pooling primitive if there is one for the data type, e.g. built with oneDNN, and it
+// divides the same way. The 1d and 2d poolings are launched as 3d ones with unit dims.
+template<typename T>
+bool TryLaunchAvgPoolingPrimitive(ep::Stream* stream, const T* src, T* dest,
+                                  const AvgPoolingParams3D& params_3d) {
+  // the padding counted in ceil_mode ends at the padded input, but oneDNN counts the whole window
+  if (params_3d.data_format() != "channels_first" || params_3d.divisor_override() != 0
+      || (params_3d.ceil_mode() && params_3d.count_include_pad())) {
+    return false;
+  }
+  ep::primitive::PoolingParams params;
+  params.num_spatial_dims = 3;
+  params.mode = params_3d.count_include_pad() ? ep::primitive::PoolingMode::kAvgIncludePadding
+                                              : ep::primitive::PoolingMode::kAvgExcludePadding;
+  params.channels_last = false;
+  params.kernel_size = params_3d.pooling_size_3d();
+  params.strides = params_3d.stride_3d();
+  params.padding_before = params_3d.padding();
+  std::unique_ptr<ep::primitive::Pooling> pooling =
+      ep::primitive::NewPrimitive<ep::primitive::PoolingFactory>(DeviceType::kCPU,
+                                                                 GetDataType<T>::value, params);
+  if (!pooling) { return false; }
+  const Shape x_shape = params_3d.GetXShape5D();
+  const Shape y_shape = params_3d.GetYShape5D();
+  pooling->Launch(stream, x_shape.dim_vec().data(), src, y_shape.dim_vec().data(), dest);
+  return true;
+}
+
 template<typename T>
 struct AvgPoolingKernelUtil<DeviceType::kCPU, T> {
   static void Avgpool1dForward(ep::Stream* stream,
                                const NdIndexOffsetHelper<int64_t, 3>& index_helper,
                                const int64_t elem_num, const T* src, T* dest,
                                const AvgPoolingParams3D& params_3d) {
+    if (TryLaunchAvgPoolingPrimitive<T>(stream, src, dest, params_3d)) { return; }
     Avgpool1dForwardCompute<T>(index_helper, elem_num, src, dest, params_3d.padding()[2],
                                params_3d.num_batch(), params_3d.num_channel(),
                                params_3d.GetXShape5D().At(4), params_3d.GetYShape5D().At(4),
@@ -69,6 +99,7 @@ struct AvgPoolingKernelUtil<DeviceType::kCPU, T> {
                                const NdIndexOffsetHelper<int64_t, 4>& index_helper,
                                const int64_t elem_num, const T* src, T* dest,
                                const AvgPoolingParams3D& params_3d) {
+    if (TryLaunchAvgPoolingPrimitive<T>(stream, src, dest, params_3d)) { return; }
     Avgpool2dForwardCompute<T>(
         index_helper, elem_num, src, dest, params_3d.padding()[1], params_3d.padding()[2],
         params_3d.num_batch(), params_3d.num_channel(), params_3d.GetXShape5D().At(3),
@@ -93,6 +124,7 @@ struct AvgPoolingKernelUtil<DeviceType::kCPU, T> {
                                const NdIndexOffsetHelper<int64_t, 5>& index_helper,
                                const int64_t elem_num, const T* src, T* dest,
                                const AvgPoolingParams3D& params_3d) {
+    if (TryLaunchAvgPoolingPrimitive<T>(stream, src, dest, params_3d)) { return; }
     Avgpool3dForwardCompute<T>(
         index_helper, elem_num, src, dest, params_3d.padding()[0], params_3d.padding()[1],
         params_3d.padding()[2], params_3d.num_batch(), params_3d.num_channel(),
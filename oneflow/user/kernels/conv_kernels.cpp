@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
 #include "oneflow/core/ep/include/primitive/add.h"
+#include "oneflow/core/ep/include/primitive/convolution.h"
 
 namespace oneflow {
 
@@ -310,6 +311,9 @@ struct ConvOpKernelCache final : public user_op::OpKernelCache {
   enum CBLAS_TRANSPOSE is_out_diff_need_trans_ = CblasNoTrans;
   int32_t idx_offset_{};
   bool is_dynamic_{};
+
+  // the forward convolution primitive, nullptr if the kernel runs im2col and gemm
+  std::unique_ptr<ep::primitive::Convolution> convolution_;
 };
 
 template<typename T>
@@ -374,6 +378,45 @@ void InitBiasMulBuf(T* dptr, int64_t num) {
   for (int64_t i = 0; i < num; ++i) { dptr[i] = 1; }
 }
 
+template<typename Context>
+ep::primitive::ConvolutionParams GetConvolutionParams(Context* ctx, size_t num_spatial_dims) {
+  ep::primitive::ConvolutionParams params;
+  params.num_spatial_dims = num_spatial_dims;
+  params.channels_last = ctx->template Attr<std::string>("data_format") == "channels_last";
+  params.groups = ctx->template Attr<int32_t>("groups");
+  params.strides = ctx->template Attr<std::vector<int32_t>>("strides");
+  params.dilation_rate = ctx->template Attr<std::vector<int32_t>>("dilation_rate");
+  params.padding_before = ctx->template Attr<std::vector<int32_t>>("padding_before");
+  return params;
+}
+
+// Return nullptr if there is no convolution primitive for the data type, e.g. built without oneDNN,
+// then the kernel falls back to im2col and gemm
+template<typename Context>
+std::unique_ptr<ep::primitive::Convolution> NewConvolutionPrimitive(Context* ctx,
+                                                                    DataType data_type,
+                                                                    size_t num_spatial_dims) {
+  return ep::primitive::NewPrimitive<ep::primitive::ConvolutionFactory>(
+      DeviceType::kCPU, data_type, GetConvolutionParams(ctx, num_spatial_dims));
+}
+
+// Whether the kernels of T run the convolution primitive, which only depends on the data type. It
+// is asked once instead of creating a primitive in every InferTmpSizeFn.
+template<typename T>
+bool HasConvolutionPrimitive() {
+  static const bool has_primitive = []() {
+    ep::primitive::ConvolutionParams params;
+    params.num_spatial_dims = 1;
+    params.strides = {1};
+    params.dilation_rate = {1};
+    params.padding_before = {0};
+    return ep::primitive::NewPrimitive<ep::primitive::ConvolutionFactory>(
+               DeviceType::kCPU, GetDataType<T>::value, params)
+           != nullptr;
+  }();
+  return has_primitive;
+}
+
 template<typename T, size_t NDims>
 class ConvCpuKernel final : public user_op::OpKernel {
  public:
@@ -385,7 +428,12 @@ class ConvCpuKernel final : public user_op::OpKernel {
  private:
   std::shared_ptr<user_op::OpKernelCache> InitOpKernelCache(
       user_op::KernelCacheContext* ctx) const override {
-    return CreateConvOpKernelCache<T>(ctx, "in", "out", "weight");
+    std::shared_ptr<ConvOpKernelCache<T>> cache =
+        CreateConvOpKernelCache<T>(ctx, "in", "out", "weight");
+    if (HasConvolutionPrimitive<T>()) {
+      cache->convolution_ = NewConvolutionPrimitive(ctx, GetDataType<T>::value, NDims);
+    }
+    return cache;
   }
 
   void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState*,
@@ -398,6 +446,15 @@ class ConvCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
 
+    if (conv_cache->convolution_) {
+      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
+      conv_cache->convolution_->Launch(ctx->stream(), in->shape().ptr(), in->dptr(),
+                                       weight->shape().ptr(), weight->dptr(),
+                                       bias == nullptr ? nullptr : bias->dptr(),
+                                       out->shape().ptr(), out->mut_dptr());
+      return;
+    }
+
     T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
 
     bool is_bias_mul_inited = false;
@@ -452,6 +509,7 @@ class ConvCpuKernel final : public user_op::OpKernel {
                        && (user_op::HobAttr<int32_t>("groups") == 1)                        \
                        && (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))     \
       .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                         \
+        if (HasConvolutionPrimitive<dtype>()) { return 0; }                                 \
         size_t tmp_buffer_size = 0;                                                         \
         const auto& out_shape = ctx->OutputTensorDesc("out", 0)->shape();                   \
         const auto& weight_shape = ctx->InputTensorDesc("weight", 0).shape();               \
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/ep/include/primitive/convolution.h"
 
 namespace oneflow {
 
@@ -249,6 +250,9 @@ struct DeconvOpKernelCache final : public user_op::OpKernelCache {
   int32_t idx_offset_ = 0;
   bool is_dynamic_ = false;
 
+  // nullptr if the kernel runs gemm and col2im
+  std::unique_ptr<ep::primitive::Deconvolution> deconvolution_;
+
   void Update(const ShapeView& x_shape, const ShapeView& out_shape) {
     auto Gen5DShape = [](const ShapeView& shape, int32_t idx_offset) -> Shape {
       DimVector ret_vec;
@@ -317,6 +321,48 @@ std::shared_ptr<DeconvOpKernelCache<T>> CreateDeconvOpKernelCache(user_op::Kerne
   return cache;
 }
 
+// Whether there is a deconvolution primitive for T, e.g. not without oneDNN. It only depends on the
+// data type, so it is asked once instead of creating a primitive in every InferTmpSizeFn.
+template<typename T>
+bool HasDeconvolutionPrimitive() {
+  static const bool has_primitive = []() {
+    ep::primitive::ConvolutionParams params;
+    params.num_spatial_dims = 1;
+    params.strides = {1};
+    params.dilation_rate = {1};
+    params.padding_before = {0};
+    return ep::primitive::NewPrimitive<ep::primitive::DeconvolutionFactory>(
+               DeviceType::kCPU, GetDataType<T>::value, params)
+           != nullptr;
+  }();
+  return has_primitive;
+}
+
+// The kernel falls back to gemm and col2im if there is no deconvolution primitive for T or the
+// output padding is not expressible by it
+template<typename T, typename Context>
+bool UseDeconvolutionPrimitive(Context* ctx) {
+  if (!HasDeconvolutionPrimitive<T>()) { return false; }
+  const auto& output_padding = ctx->template Attr<std::vector<int32_t>>("output_padding");
+  return std::all_of(output_padding.cbegin(), output_padding.cend(),
+                     [](int32_t padding) { return padding == 0; });
+}
+
+template<typename Context>
+std::unique_ptr<ep::primitive::Deconvolution> NewDeconvolutionPrimitive(Context* ctx,
+                                                                        DataType data_type,
+                                                                        size_t num_spatial_dims) {
+  ep::primitive::ConvolutionParams params;
+  params.num_spatial_dims = num_spatial_dims;
+  params.channels_last = ctx->template Attr<std::string>("data_format") == "channels_last";
+  params.groups = ctx->template Attr<int32_t>("groups");
+  params.strides = ctx->template Attr<std::vector<int32_t>>("strides");
+  params.dilation_rate = ctx->template Attr<std::vector<int32_t>>("dilation_rate");
+  params.padding_before = ctx->template Attr<std::vector<int32_t>>("padding_before");
+  return ep::primitive::NewPrimitive<ep::primitive::DeconvolutionFactory>(DeviceType::kCPU,
+                                                                          data_type, params);
+}
+
 template<typename T>
 class DeconvCpuKernel final : public user_op::OpKernel {
  public:
@@ -335,7 +381,15 @@ class DeconvCpuKernel final : public user_op::OpKernel {
                            ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape());
       return;
     }
-    *cache_ptr = CreateDeconvOpKernelCache<T>(ctx, "out", "in", "weight");
+    std::shared_ptr<DeconvOpKernelCache<T>> deconv_cache =
+        CreateDeconvOpKernelCache<T>(ctx, "out", "in", "weight");
+    if (UseDeconvolutionPrimitive<T>(ctx)) {
+      const int64_t num_spatial_dims =
+          ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape().NumAxes() - 2;
+      deconv_cache->deconvolution_ =
+          NewDeconvolutionPrimitive(ctx, GetDataType<T>::value, num_spatial_dims);
+    }
+    *cache_ptr = deconv_cache;
   }
 
  private:
@@ -348,6 +402,13 @@ class DeconvCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
     user_op::Tensor* col_buf = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
+    if (deconv_cache->deconvolution_) {
+      deconv_cache->deconvolution_->Launch(ctx->stream(), in->shape().ptr(), in->dptr(),
+                                           weight->shape().ptr(), weight->dptr(), nullptr,
+                                           out->shape().ptr(), out->mut_dptr());
+      return;
+    }
+
     Memset<DeviceType::kCPU>(ctx->stream(), out->mut_dptr<T>(), 0,
                              out->shape().elem_cnt() * sizeof(T));
 
@@ -382,6 +443,7 @@ class DeconvCpuKernel final : public user_op::OpKernel {
       .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                      \
         size_t tmp_buffer_size = 0;                                                      \
         const auto& in_shape = ctx->InputTensorDesc("in", 0).shape();                    \
+        if (UseDeconvolutionPrimitive<dtype>(ctx)) { return 0; }                         \
         const auto& weight_shape = ctx->InputTensorDesc("weight", 0).shape();            \
                                                                                          \
         int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));           \
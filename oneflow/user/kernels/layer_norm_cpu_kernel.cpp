@@ -14,9 +14,23 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#include "oneflow/user/kernels/layer_norm_cpu_kernel_util.h"
 
 namespace oneflow {
 
+namespace {
+
+// The partial sums of gamma_diff and beta_diff are reduced over at most this many blocks of rows,
+// the blocks do not depend on the number of threads so the results are deterministic
+constexpr int64_t kLayerNormParamGradMaxBlockNum = 32;
+
+int64_t GetLayerNormParamGradBlockNum(int64_t rows) {
+  return std::max<int64_t>(std::min(rows, kLayerNormParamGradMaxBlockNum), 1);
+}
+
+}  // namespace
+
 template<typename T>
 class LayerNormCpuKernel final : public user_op::OpKernel {
  public:
@@ -24,8 +38,38 @@ class LayerNormCpuKernel final : public user_op::OpKernel {
   ~LayerNormCpuKernel() = default;
 
  private:
+  using user_op::OpKernel::Compute;
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    const double epsilon = ctx->Attr<double>("epsilon");
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = x->shape().elem_cnt() / num_instances;
+    const T* gamma_ptr = nullptr;
+    const T* beta_ptr = nullptr;
+    T* normalized_ptr = nullptr;
+    if (ctx->has_input("gamma", 0)) {
+      const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+      gamma_ptr = gamma->dptr<T>();
+      CHECK_EQ(gamma->shape().elem_cnt(), norm_size);
+      normalized_ptr = ctx->Tensor4ArgNameAndIndex("normalized", 0)->mut_dptr<T>();
+    }
+    if (ctx->has_input("beta", 0)) {
+      const user_op::Tensor* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+      beta_ptr = beta->dptr<T>();
+      CHECK_EQ(beta->shape().elem_cnt(), norm_size);
+    }
+    const layer_norm::LayerNormForwardFunc<T> forward =
+        layer_norm::SelectLayerNormForwardFunc<T>(gamma_ptr != nullptr, beta_ptr != nullptr);
+    ep::CpuParallelForRows(num_instances, norm_size, [&](int64_t begin, int64_t end) {
+      forward(begin, end, norm_size, epsilon, x->dptr<T>(), gamma_ptr, beta_ptr, normalized_ptr,
+              y->mut_dptr<T>(), mean->mut_dptr<T>(), inv_variance->mut_dptr<T>());
+    });
+  };
 };
 
 #define REGISTER_LAYER_NORM_CPU_KERNEL(dtype)                         \
@@ -44,15 +88,51 @@ class LayerNormGradCpuKernel final : public user_op::OpKernel {
   ~LayerNormGradCpuKernel() = default;
 
  private:
+  using user_op::OpKernel::Compute;
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const user_op::Tensor* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    const user_op::Tensor* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const user_op::Tensor* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    user_op::Tensor* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const int64_t num_instances = mean->shape().elem_cnt();
+    if (num_instances == 0) { return; }
+    const int64_t norm_size = x->shape().elem_cnt() / num_instances;
+    const T* gamma_ptr = nullptr;
+    if (ctx->has_input("gamma", 0)) {
+      gamma_ptr = ctx->Tensor4ArgNameAndIndex("gamma", 0)->dptr<T>();
+    }
+    const T* add_to_output_ptr = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), dx->data_type());
+      CHECK_EQ(add_to_output->shape(), dx->shape());
+      add_to_output_ptr = add_to_output->dptr<T>();
+    }
+    const layer_norm::LayerNormBackwardFunc<T> backward =
+        layer_norm::SelectLayerNormBackwardFunc<T>(gamma_ptr != nullptr,
+                                                   add_to_output_ptr != nullptr);
+    ep::CpuParallelForRows(num_instances, norm_size, [&](int64_t begin, int64_t end) {
+      backward(begin, end, norm_size, dy->dptr<T>(), x->dptr<T>(), mean->dptr<T>(),
+               inv_variance->dptr<T>(), gamma_ptr, add_to_output_ptr, dx->mut_dptr<T>());
+    });
+  };
 };
 
-#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)                    \
-  REGISTER_USER_KERNEL("layer_norm_grad")                             \
-      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()                   \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
-                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value));
+#define REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(dtype)                                         \
+  REGISTER_USER_KERNEL("layer_norm_grad")                                                  \
+      .SetCreateFn<LayerNormGradCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                      \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))    \
+      .SetInplaceProposalFn(                                                               \
+          [](const user_op::InferContext& ctx,                                             \
+             const user_op::AddInplaceArgPair& AddInplaceArgPairFn) -> Maybe<void> {       \
+            if (ctx.has_input("_add_to_output", 0)) {                                      \
+              OF_RETURN_IF_ERROR(AddInplaceArgPairFn("dx", 0, "_add_to_output", 0, true)); \
+            }                                                                              \
+            return Maybe<void>::Ok();                                                      \
+          });
 
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_GRAD_CPU_KERNEL(double)
@@ -64,15 +144,87 @@ class LayerNormParamGradCpuKernel final : public user_op::OpKernel {
   ~LayerNormParamGradCpuKernel() = default;
 
  private:
+  using user_op::OpKernel::Compute;
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
-  void Compute(user_op::KernelComputeContext* ctx) const override { TODO(); };
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    user_op::Tensor* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    user_op::Tensor* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    user_op::Tensor* normalized_diff = ctx->Tensor4ArgNameAndIndex("normalized_diff", 0);
+    const user_op::Tensor* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const user_op::Tensor* normalized =
+        gamma_diff != nullptr ? ctx->Tensor4ArgNameAndIndex("normalized", 0) : nullptr;
+    const int64_t begin_params_axis = ctx->Attr<int64_t>("begin_params_axis");
+    const int64_t m = dy->shape().Count(begin_params_axis);
+    if (m == 0) { return; }
+    const int64_t n = dy->shape().elem_cnt() / m;
+    const T* dy_ptr = dy->dptr<T>();
+    const T* gamma_ptr = gamma != nullptr ? gamma->dptr<T>() : nullptr;
+    if (gamma != nullptr) { CHECK_EQ(gamma->shape().elem_cnt(), m); }
+    const T* normalized_ptr = normalized != nullptr ? normalized->dptr<T>() : nullptr;
+    T* normalized_diff_ptr = normalized_diff != nullptr ? normalized_diff->mut_dptr<T>() : nullptr;
+    // Every block of rows sums its gamma_diff and beta_diff into its own part of the tmp buffer
+    const int64_t block_num = GetLayerNormParamGradBlockNum(n);
+    const int64_t rows_per_block = (n + block_num - 1) / block_num;
+    T* partial_gamma_diff = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0)->mut_dptr<T>();
+    T* partial_beta_diff = partial_gamma_diff + block_num * m;
+    ParallelFor(0, block_num, 1, [&](int64_t begin_block, int64_t end_block) {
+      for (int64_t block = begin_block; block < end_block; ++block) {
+        T* block_gamma_diff = partial_gamma_diff + block * m;
+        T* block_beta_diff = partial_beta_diff + block * m;
+        std::fill(block_gamma_diff, block_gamma_diff + m, static_cast<T>(0));
+        std::fill(block_beta_diff, block_beta_diff + m, static_cast<T>(0));
+        const int64_t end_row = std::min((block + 1) * rows_per_block, n);
+        for (int64_t i = block * rows_per_block; i < end_row; ++i) {
+          const T* row_dy = dy_ptr + i * m;
+          if (normalized_ptr != nullptr) {
+            const T* row_normalized = normalized_ptr + i * m;
+            for (int64_t j = 0; j < m; ++j) {
+              block_gamma_diff[j] += row_dy[j] * row_normalized[j];
+            }
+          }
+          for (int64_t j = 0; j < m; ++j) { block_beta_diff[j] += row_dy[j]; }
+          if (normalized_diff_ptr != nullptr) {
+            T* row_normalized_diff = normalized_diff_ptr + i * m;
+            if (gamma_ptr != nullptr) {
+              for (int64_t j = 0; j < m; ++j) {
+                row_normalized_diff[j] = row_dy[j] * gamma_ptr[j];
+              }
+            } else {
+              std::copy(row_dy, row_dy + m, row_normalized_diff);
+            }
+          }
+        }
+      }
+    });
+    T* gamma_diff_ptr = gamma_diff != nullptr ? gamma_diff->mut_dptr<T>() : nullptr;
+    T* beta_diff_ptr = beta_diff != nullptr ? beta_diff->mut_dptr<T>() : nullptr;
+    ep::CpuParallelForRows(m, block_num, [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j < end; ++j) {
+        T gamma_diff_sum = 0;
+        T beta_diff_sum = 0;
+        for (int64_t block = 0; block < block_num; ++block) {
+          gamma_diff_sum += partial_gamma_diff[block * m + j];
+          beta_diff_sum += partial_beta_diff[block * m + j];
+        }
+        if (gamma_diff_ptr != nullptr) { gamma_diff_ptr[j] = gamma_diff_sum; }
+        if (beta_diff_ptr != nullptr) { beta_diff_ptr[j] = beta_diff_sum; }
+      }
+    });
+  };
 };
 
-#define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)              \
-  REGISTER_USER_KERNEL("layer_norm_param_grad")                       \
-      .SetCreateFn<LayerNormParamGradCpuKernel<dtype>>()              \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
-                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value));
+#define REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(dtype)                                  \
+  REGISTER_USER_KERNEL("layer_norm_param_grad")                                           \
+      .SetCreateFn<LayerNormParamGradCpuKernel<dtype>>()                                  \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                     \
+                       && (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))   \
+      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                       \
+        const Shape& dy_shape = ctx->InputShape("dy", 0);                                 \
+        const int64_t m = dy_shape.Count(ctx->Attr<int64_t>("begin_params_axis"));       \
+        const int64_t n = m == 0 ? 0 : dy_shape.elem_cnt() / m;                           \
+        return 2 * GetLayerNormParamGradBlockNum(n) * m * sizeof(dtype);                  \
+      });
 
 REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(float)
 REGISTER_LAYER_NORM_PARAM_GRAD_CPU_KERNEL(double)
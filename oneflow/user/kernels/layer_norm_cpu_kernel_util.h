@@ -0,0 +1,326 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_LAYER_NORM_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_LAYER_NORM_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/primitive/simd_math.h"
+
+namespace oneflow {
+
+namespace layer_norm {
+
+// The row functions of the CPU LayerNorm kernels, which compute the rows [begin_row, end_row) of
+// the (rows, cols) input. The float ones take the AVX2 kernels when GetCpuIsa() allows.
+
+template<typename T>
+void WelfordCombine(T x, T* mean, T* m2, int64_t* count) {
+  *count += 1;
+  const T delta = x - *mean;
+  *mean += delta / *count;
+  *m2 += delta * (x - *mean);
+}
+
+template<typename T>
+T InvVariance(T m2, int64_t cols, double epsilon) {
+  return static_cast<T>(1) / std::sqrt(m2 / cols + static_cast<T>(epsilon));
+}
+
+template<typename T, bool do_scale, bool do_center>
+void LayerNormForwardRows(int64_t begin_row, int64_t end_row, int64_t cols, double epsilon,
+                          const T* x, const T* gamma, const T* beta, T* normalized, T* y, T* mean,
+                          T* inv_variance) {
+  for (int64_t i = begin_row; i < end_row; ++i) {
+    const T* row_x = x + i * cols;
+    T row_mean = 0;
+    T row_m2 = 0;
+    int64_t count = 0;
+    for (int64_t j = 0; j < cols; ++j) { WelfordCombine(row_x[j], &row_mean, &row_m2, &count); }
+    const T row_inv_variance = InvVariance(row_m2, cols, epsilon);
+    mean[i] = row_mean;
+    inv_variance[i] = row_inv_variance;
+    for (int64_t j = 0; j < cols; ++j) {
+      T value = (row_x[j] - row_mean) * row_inv_variance;
+      if (do_scale) {
+        normalized[i * cols + j] = value;
+        value *= gamma[j];
+      }
+      if (do_center) { value += beta[j]; }
+      y[i * cols + j] = value;
+    }
+  }
+}
+
+// dx = inv_variance * (dy - mean(dy) - normalized * mean(dy * normalized)), where dy is scaled by
+// gamma if there is
+template<typename T, bool do_scale, bool do_add>
+void LayerNormBackwardRows(int64_t begin_row, int64_t end_row, int64_t cols, const T* dy,
+                           const T* x, const T* mean, const T* inv_variance, const T* gamma,
+                           const T* add_to_output, T* dx) {
+  for (int64_t i = begin_row; i < end_row; ++i) {
+    const int64_t offset = i * cols;
+    T sum_dy = 0;
+    T sum_dy_normalized = 0;
+    for (int64_t j = 0; j < cols; ++j) {
+      const T scaled_dy = do_scale ? dy[offset + j] * gamma[j] : dy[offset + j];
+      sum_dy += scaled_dy;
+      sum_dy_normalized += scaled_dy * (x[offset + j] - mean[i]) * inv_variance[i];
+    }
+    const T mean_dy = sum_dy / cols;
+    const T mean_dy_normalized = sum_dy_normalized / cols;
+    for (int64_t j = 0; j < cols; ++j) {
+      const T scaled_dy = do_scale ? dy[offset + j] * gamma[j] : dy[offset + j];
+      const T normalized = (x[offset + j] - mean[i]) * inv_variance[i];
+      T value = (scaled_dy - mean_dy - normalized * mean_dy_normalized) * inv_variance[i];
+      if (do_add) { value += add_to_output[offset + j]; }
+      dx[offset + j] = value;
+    }
+  }
+}
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+// Two independent Welford states of 8 lanes hide the latency of the updates, all the 16 lanes
+// have the same count so they are combined in closed form, and the tail goes on with the scalar
+// update
+OF_EP_CPU_TARGET_AVX2 inline void WelfordRowAvx2(const float* x, int64_t cols, float* mean,
+                                                  float* m2) {
+  constexpr int64_t kPackSize = 8;
+  __m256 mean_pack0 = _mm256_setzero_ps();
+  __m256 mean_pack1 = _mm256_setzero_ps();
+  __m256 m2_pack0 = _mm256_setzero_ps();
+  __m256 m2_pack1 = _mm256_setzero_ps();
+  int64_t lane_count = 0;
+  int64_t j = 0;
+  for (; j + 2 * kPackSize <= cols; j += 2 * kPackSize) {
+    lane_count += 1;
+    const __m256 reciprocal = _mm256_set1_ps(1.0f / lane_count);
+    const __m256 x0 = _mm256_loadu_ps(x + j);
+    const __m256 x1 = _mm256_loadu_ps(x + j + kPackSize);
+    const __m256 delta0 = _mm256_sub_ps(x0, mean_pack0);
+    const __m256 delta1 = _mm256_sub_ps(x1, mean_pack1);
+    mean_pack0 = _mm256_fmadd_ps(delta0, reciprocal, mean_pack0);
+    mean_pack1 = _mm256_fmadd_ps(delta1, reciprocal, mean_pack1);
+    m2_pack0 = _mm256_fmadd_ps(delta0, _mm256_sub_ps(x0, mean_pack0), m2_pack0);
+    m2_pack1 = _mm256_fmadd_ps(delta1, _mm256_sub_ps(x1, mean_pack1), m2_pack1);
+  }
+  float row_mean = 0;
+  float row_m2 = 0;
+  int64_t count = 0;
+  if (lane_count > 0) {
+    row_mean = ep::primitive::simd::ReduceSum(_mm256_add_ps(mean_pack0, mean_pack1))
+               / (2 * kPackSize);
+    const __m256 row_mean_pack = _mm256_set1_ps(row_mean);
+    const __m256 diff0 = _mm256_sub_ps(mean_pack0, row_mean_pack);
+    const __m256 diff1 = _mm256_sub_ps(mean_pack1, row_mean_pack);
+    const __m256 diff_square = _mm256_fmadd_ps(diff0, diff0, _mm256_mul_ps(diff1, diff1));
+    row_m2 = ep::primitive::simd::ReduceSum(_mm256_add_ps(m2_pack0, m2_pack1))
+             + lane_count * ep::primitive::simd::ReduceSum(diff_square);
+    count = lane_count * 2 * kPackSize;
+  }
+  for (; j < cols; ++j) { WelfordCombine(x[j], &row_mean, &row_m2, &count); }
+  *mean = row_mean;
+  *m2 = row_m2;
+}
+
+template<bool do_scale, bool do_center>
+OF_EP_CPU_TARGET_AVX2 void LayerNormForwardRowsAvx2(int64_t begin_row, int64_t end_row,
+                                                    int64_t cols, double epsilon, const float* x,
+                                                    const float* gamma, const float* beta,
+                                                    float* normalized, float* y, float* mean,
+                                                    float* inv_variance) {
+  constexpr int64_t kPackSize = 8;
+  const int64_t tail_offset = cols - cols % kPackSize;
+  for (int64_t i = begin_row; i < end_row; ++i) {
+    const float* row_x = x + i * cols;
+    float* row_y = y + i * cols;
+    float* row_normalized = do_scale ? normalized + i * cols : nullptr;
+    float row_mean = 0;
+    float row_m2 = 0;
+    WelfordRowAvx2(row_x, cols, &row_mean, &row_m2);
+    const float row_inv_variance = InvVariance(row_m2, cols, epsilon);
+    mean[i] = row_mean;
+    inv_variance[i] = row_inv_variance;
+    const __m256 mean_pack = _mm256_set1_ps(row_mean);
+    const __m256 inv_variance_pack = _mm256_set1_ps(row_inv_variance);
+    for (int64_t j = 0; j < tail_offset; j += kPackSize) {
+      __m256 value =
+          _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(row_x + j), mean_pack), inv_variance_pack);
+      if (do_scale) {
+        _mm256_storeu_ps(row_normalized + j, value);
+        if (do_center) {
+          value = _mm256_fmadd_ps(value, _mm256_loadu_ps(gamma + j), _mm256_loadu_ps(beta + j));
+        } else {
+          value = _mm256_mul_ps(value, _mm256_loadu_ps(gamma + j));
+        }
+      } else if (do_center) {
+        value = _mm256_add_ps(value, _mm256_loadu_ps(beta + j));
+      }
+      _mm256_storeu_ps(row_y + j, value);
+    }
+    for (int64_t j = tail_offset; j < cols; ++j) {
+      float value = (row_x[j] - row_mean) * row_inv_variance;
+      if (do_scale) {
+        row_normalized[j] = value;
+        value *= gamma[j];
+      }
+      if (do_center) { value += beta[j]; }
+      row_y[j] = value;
+    }
+  }
+}
+
+template<bool do_scale>
+OF_EP_CPU_TARGET_AVX2 inline __m256 LoadScaledDy(const float* dy, const float* gamma) {
+  const __m256 dy_pack = _mm256_loadu_ps(dy);
+  return do_scale ? _mm256_mul_ps(dy_pack, _mm256_loadu_ps(gamma)) : dy_pack;
+}
+
+template<bool do_scale, bool do_add>
+OF_EP_CPU_TARGET_AVX2 void LayerNormBackwardRowsAvx2(int64_t begin_row, int64_t end_row,
+                                                     int64_t cols, const float* dy,
+                                                     const float* x, const float* mean,
+                                                     const float* inv_variance,
+                                                     const float* gamma,
+                                                     const float* add_to_output, float* dx) {
+  constexpr int64_t kPackSize = 8;
+  const int64_t tail_offset = cols - cols % kPackSize;
+  for (int64_t i = begin_row; i < end_row; ++i) {
+    const int64_t offset = i * cols;
+    const __m256 mean_pack = _mm256_set1_ps(mean[i]);
+    const __m256 inv_variance_pack = _mm256_set1_ps(inv_variance[i]);
+    __m256 sum_dy_pack = _mm256_setzero_ps();
+    __m256 sum_dy_normalized_pack = _mm256_setzero_ps();
+    for (int64_t j = 0; j < tail_offset; j += kPackSize) {
+      const __m256 scaled_dy = LoadScaledDy<do_scale>(dy + offset + j, gamma + j);
+      const __m256 normalized = _mm256_mul_ps(
+          _mm256_sub_ps(_mm256_loadu_ps(x + offset + j), mean_pack), inv_variance_pack);
+      sum_dy_pack = _mm256_add_ps(sum_dy_pack, scaled_dy);
+      sum_dy_normalized_pack = _mm256_fmadd_ps(scaled_dy, normalized, sum_dy_normalized_pack);
+    }
+    float sum_dy = ep::primitive::simd::ReduceSum(sum_dy_pack);
+    float sum_dy_normalized = ep::primitive::simd::ReduceSum(sum_dy_normalized_pack);
+    for (int64_t j = tail_offset; j < cols; ++j) {
+      const float scaled_dy = do_scale ? dy[offset + j] * gamma[j] : dy[offset + j];
+      sum_dy += scaled_dy;
+      sum_dy_normalized += scaled_dy * (x[offset + j] - mean[i]) * inv_variance[i];
+    }
+    const float mean_dy = sum_dy / cols;
+    const float mean_dy_normalized = sum_dy_normalized / cols;
+    const __m256 mean_dy_pack = _mm256_set1_ps(mean_dy);
+    const __m256 mean_dy_normalized_pack = _mm256_set1_ps(mean_dy_normalized);
+    for (int64_t j = 0; j < tail_offset; j += kPackSize) {
+      const __m256 scaled_dy = LoadScaledDy<do_scale>(dy + offset + j, gamma + j);
+      const __m256 normalized = _mm256_mul_ps(
+          _mm256_sub_ps(_mm256_loadu_ps(x + offset + j), mean_pack), inv_variance_pack);
+      __m256 value = _mm256_sub_ps(_mm256_sub_ps(scaled_dy, mean_dy_pack),
+                                   _mm256_mul_ps(normalized, mean_dy_normalized_pack));
+      value = _mm256_mul_ps(value, inv_variance_pack);
+      if (do_add) { value = _mm256_add_ps(value, _mm256_loadu_ps(add_to_output + offset + j)); }
+      _mm256_storeu_ps(dx + offset + j, value);
+    }
+    for (int64_t j = tail_offset; j < cols; ++j) {
+      const float scaled_dy = do_scale ? dy[offset + j] * gamma[j] : dy[offset + j];
+      const float normalized = (x[offset + j] - mean[i]) * inv_variance[i];
+      float value = (scaled_dy - mean_dy - normalized * mean_dy_normalized) * inv_variance[i];
+      if (do_add) { value += add_to_output[offset + j]; }
+      dx[offset + j] = value;
+    }
+  }
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+template<typename T>
+using LayerNormForwardFunc = void (*)(int64_t begin_row, int64_t end_row, int64_t cols,
+                                      double epsilon, const T* x, const T* gamma, const T* beta,
+                                      T* normalized, T* y, T* mean, T* inv_variance);
+
+template<typename T>
+using LayerNormBackwardFunc = void (*)(int64_t begin_row, int64_t end_row, int64_t cols,
+                                       const T* dy, const T* x, const T* mean,
+                                       const T* inv_variance, const T* gamma,
+                                       const T* add_to_output, T* dx);
+
+template<typename T, bool do_scale, bool do_center>
+struct LayerNormForwardFuncSelector {
+  static LayerNormForwardFunc<T> Select() {
+    return &LayerNormForwardRows<T, do_scale, do_center>;
+  }
+};
+
+template<typename T, bool do_scale, bool do_add>
+struct LayerNormBackwardFuncSelector {
+  static LayerNormBackwardFunc<T> Select() {
+    return &LayerNormBackwardRows<T, do_scale, do_add>;
+  }
+};
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+template<bool do_scale, bool do_center>
+struct LayerNormForwardFuncSelector<float, do_scale, do_center> {
+  static LayerNormForwardFunc<float> Select() {
+    if (ep::GetCpuIsa() >= ep::CpuIsa::kAvx2) {
+      return &LayerNormForwardRowsAvx2<do_scale, do_center>;
+    }
+    return &LayerNormForwardRows<float, do_scale, do_center>;
+  }
+};
+
+template<bool do_scale, bool do_add>
+struct LayerNormBackwardFuncSelector<float, do_scale, do_add> {
+  static LayerNormBackwardFunc<float> Select() {
+    if (ep::GetCpuIsa() >= ep::CpuIsa::kAvx2) {
+      return &LayerNormBackwardRowsAvx2<do_scale, do_add>;
+    }
+    return &LayerNormBackwardRows<float, do_scale, do_add>;
+  }
+};
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+template<typename T>
+LayerNormForwardFunc<T> SelectLayerNormForwardFunc(bool do_scale, bool do_center) {
+  if (do_scale && do_center) {
+    return LayerNormForwardFuncSelector<T, true, true>::Select();
+  } else if (do_scale) {
+    return LayerNormForwardFuncSelector<T, true, false>::Select();
+  } else if (do_center) {
+    return LayerNormForwardFuncSelector<T, false, true>::Select();
+  } else {
+    return LayerNormForwardFuncSelector<T, false, false>::Select();
+  }
+}
+
+template<typename T>
+LayerNormBackwardFunc<T> SelectLayerNormBackwardFunc(bool do_scale, bool do_add) {
+  if (do_scale && do_add) {
+    return LayerNormBackwardFuncSelector<T, true, true>::Select();
+  } else if (do_scale) {
+    return LayerNormBackwardFuncSelector<T, true, false>::Select();
+  } else if (do_add) {
+    return LayerNormBackwardFuncSelector<T, false, true>::Select();
+  } else {
+    return LayerNormBackwardFuncSelector<T, false, false>::Select();
+  }
+}
+
+}  // namespace layer_norm
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_LAYER_NORM_CPU_KERNEL_UTIL_H_
@@ -0,0 +1,117 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <random>
+#include "oneflow/user/kernels/layer_norm_cpu_kernel_util.h"
+
+namespace oneflow {
+
+namespace layer_norm {
+
+namespace {
+
+std::vector<float> RandomVector(size_t n, float offset, float scale, uint32_t seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dis(offset - scale, offset + scale);
+  std::vector<float> vec(n);
+  for (float& v : vec) { v = dis(gen); }
+  return vec;
+}
+
+void AssertNear(const std::vector<float>& out, const std::vector<float>& expected,
+                const std::string& name) {
+  ASSERT_EQ(out.size(), expected.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    ASSERT_NEAR(out[i], expected[i], 1e-4 + 1e-4 * std::abs(expected[i]))
+        << name << ", index: " << i;
+  }
+}
+
+// Odd norm sizes cover the 16 lanes of the Welford loop, the 8 lanes of the other loops and the
+// scalar tails
+const std::vector<int64_t> kNormSizes = {1, 3, 7, 8, 9, 15, 16, 17, 31, 33, 100, 257, 1023};
+constexpr int64_t kRows = 6;
+
+struct ForwardResult {
+  std::vector<float> normalized;
+  std::vector<float> y;
+  std::vector<float> mean;
+  std::vector<float> inv_variance;
+};
+
+ForwardResult RunForward(ep::CpuIsa isa, bool do_scale, bool do_center, int64_t cols,
+                         const std::vector<float>& x, const std::vector<float>& gamma,
+                         const std::vector<float>& beta) {
+  ep::CpuIsaGuard isa_guard(isa);
+  ForwardResult result{std::vector<float>(kRows * cols), std::vector<float>(kRows * cols),
+                       std::vector<float>(kRows), std::vector<float>(kRows)};
+  SelectLayerNormForwardFunc<float>(do_scale, do_center)(
+      0, kRows, cols, 1e-5, x.data(), gamma.data(), beta.data(), result.normalized.data(),
+      result.y.data(), result.mean.data(), result.inv_variance.data());
+  return result;
+}
+
+std::vector<float> RunBackward(ep::CpuIsa isa, bool do_scale, bool do_add, int64_t cols,
+                               const std::vector<float>& dy, const std::vector<float>& x,
+                               const ForwardResult& forward, const std::vector<float>& gamma,
+                               const std::vector<float>& add_to_output) {
+  ep::CpuIsaGuard isa_guard(isa);
+  std::vector<float> dx(kRows * cols);
+  SelectLayerNormBackwardFunc<float>(do_scale, do_add)(
+      0, kRows, cols, dy.data(), x.data(), forward.mean.data(), forward.inv_variance.data(),
+      gamma.data(), add_to_output.data(), dx.data());
+  return dx;
+}
+
+}  // namespace
+
+TEST(LayerNormCpuKernel, avx2_same_as_scalar) {
+  if (ep::GetSupportedCpuIsa() < ep::CpuIsa::kAvx2) { return; }
+  for (int64_t cols : kNormSizes) {
+    // a large offset makes a one-pass variance lose its precision, but not the Welford one
+    const std::vector<float> x = RandomVector(kRows * cols, 100, 3, cols);
+    const std::vector<float> gamma = RandomVector(cols, 1, 0.5, cols + 1);
+    const std::vector<float> beta = RandomVector(cols, 0, 1, cols + 2);
+    const std::vector<float> dy = RandomVector(kRows * cols, 0, 1, cols + 3);
+    const std::vector<float> add_to_output = RandomVector(kRows * cols, 0, 1, cols + 4);
+    for (bool do_scale : {false, true}) {
+      for (bool do_center_or_add : {false, true}) {
+        const std::string name = "cols: " + std::to_string(cols)
+                                 + ", do_scale: " + std::to_string(do_scale)
+                                 + ", do_center_or_add: " + std::to_string(do_center_or_add);
+        const ForwardResult scalar = RunForward(ep::CpuIsa::kScalar, do_scale, do_center_or_add,
+                                                cols, x, gamma, beta);
+        const ForwardResult avx2 =
+            RunForward(ep::CpuIsa::kAvx2, do_scale, do_center_or_add, cols, x, gamma, beta);
+        AssertNear(avx2.mean, scalar.mean, name + ", mean");
+        AssertNear(avx2.inv_variance, scalar.inv_variance, name + ", inv_variance");
+        AssertNear(avx2.y, scalar.y, name + ", y");
+        if (do_scale) { AssertNear(avx2.normalized, scalar.normalized, name + ", normalized"); }
+        const std::vector<float> scalar_dx = RunBackward(
+            ep::CpuIsa::kScalar, do_scale, do_center_or_add, cols, dy, x, scalar, gamma,
+            add_to_output);
+        const std::vector<float> avx2_dx = RunBackward(ep::CpuIsa::kAvx2, do_scale,
+                                                       do_center_or_add, cols, dy, x, scalar,
+                                                       gamma, add_to_output);
+        AssertNear(avx2_dx, scalar_dx, name + ", dx");
+      }
+    }
+  }
+}
+
+}  // namespace layer_norm
+
+}  // namespace oneflow
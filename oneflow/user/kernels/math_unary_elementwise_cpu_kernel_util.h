@@ -0,0 +1,70 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_MATH_UNARY_ELEMENTWISE_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_MATH_UNARY_ELEMENTWISE_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/user/kernels/math_unary_elementwise_func.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#include "oneflow/core/ep/cpu/primitive/vectorized_unary.h"
+
+namespace oneflow {
+
+namespace math_unary {
+
+template<template<typename> class UnaryFunctor, typename T>
+void ForwardCpu(size_t n, const T* x, T* y) {
+  for (size_t i = 0; i < n; ++i) { y[i] = UnaryFunctor<T>::Forward(x[i]); }
+}
+
+template<typename T>
+using ForwardCpuFunc = void (*)(size_t n, const T* x, T* y);
+
+// The float forward of the ops in vectorized_unary.h takes the SIMD kernel when GetCpuIsa() allows
+template<template<typename> class UnaryFunctor, typename T>
+struct ForwardCpuFuncSelector {
+  static ForwardCpuFunc<T> Select() { return &ForwardCpu<UnaryFunctor, T>; }
+};
+
+#define SPECIALIZE_VECTORIZED_MATH_UNARY_FORWARD(functor, vectorized_op)                          \
+  template<>                                                                                      \
+  struct ForwardCpuFuncSelector<functor, float> {                                                 \
+    static ForwardCpuFunc<float> Select() {                                                       \
+      const ep::primitive::VectorizedUnaryFunc func =                                             \
+          ep::primitive::GetVectorizedUnaryFunc(ep::primitive::VectorizedUnaryOp::vectorized_op); \
+      return func != nullptr ? func : &ForwardCpu<functor, float>;                                \
+    }                                                                                             \
+  };
+
+SPECIALIZE_VECTORIZED_MATH_UNARY_FORWARD(ExpFunctor, kExp)
+SPECIALIZE_VECTORIZED_MATH_UNARY_FORWARD(LogFunctor, kLog)
+SPECIALIZE_VECTORIZED_MATH_UNARY_FORWARD(SigmoidFunctor, kSigmoid)
+SPECIALIZE_VECTORIZED_MATH_UNARY_FORWARD(ErfFunctor, kErf)
+
+#undef SPECIALIZE_VECTORIZED_MATH_UNARY_FORWARD
+
+// Split the n elements across the thread pool
+template<typename T>
+void LaunchForwardCpu(ForwardCpuFunc<T> func, int64_t n, const T* x, T* y) {
+  ep::CpuParallelForRows(n, 1, [&](int64_t begin, int64_t end) {
+    func(end - begin, x + begin, y + begin);
+  });
+}
+
+}  // namespace math_unary
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_MATH_UNARY_ELEMENTWISE_CPU_KERNEL_UTIL_H_
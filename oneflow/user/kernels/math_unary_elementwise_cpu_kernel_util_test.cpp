@@ -0,0 +1,73 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <random>
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/user/kernels/math_unary_elementwise_cpu_kernel_util.h"
+
+namespace oneflow {
+
+namespace math_unary {
+
+namespace {
+
+template<template<typename> class UnaryFunctor>
+void TestVectorizedForward(const std::string& name, float low, float high) {
+  const ForwardCpuFunc<float> scalar_func = &ForwardCpu<UnaryFunctor, float>;
+  {
+    ep::CpuIsaGuard isa_guard(ep::CpuIsa::kScalar);
+    const ForwardCpuFunc<float> func = ForwardCpuFuncSelector<UnaryFunctor, float>::Select();
+    ASSERT_EQ(func, scalar_func) << name;
+  }
+  ep::CpuIsaGuard isa_guard(ep::CpuIsa::kAvx2);
+  const ForwardCpuFunc<float> func = ForwardCpuFuncSelector<UnaryFunctor, float>::Select();
+  if (ep::GetCpuIsa() < ep::CpuIsa::kAvx2) {
+    ASSERT_EQ(func, scalar_func) << name;
+    return;
+  }
+  ASSERT_NE(func, scalar_func) << name;
+  // the tails of 8 lanes and the splitting across threads
+  for (int64_t n : {1, 7, 8, 9, 31, 100003}) {
+    std::mt19937 gen(n);
+    std::uniform_real_distribution<float> dis(low, high);
+    std::vector<float> x(n);
+    for (float& v : x) { v = dis(gen); }
+    std::vector<float> y(n);
+    std::vector<float> expected(n);
+    LaunchForwardCpu(func, n, x.data(), y.data());
+    LaunchForwardCpu(scalar_func, n, x.data(), expected.data());
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_NEAR(y[i], expected[i], 1e-6 + 2e-6 * std::abs(expected[i]))
+          << name << "(" << x[i] << ")";
+    }
+  }
+}
+
+}  // namespace
+
+TEST(MathUnaryElementwiseCpuKernel, vectorized_forward) {
+  Global<ThreadPool>::New(4);
+  TestVectorizedForward<ExpFunctor>("exp", -80, 80);
+  TestVectorizedForward<LogFunctor>("log", 1e-30, 1e6);
+  TestVectorizedForward<SigmoidFunctor>("sigmoid", -30, 30);
+  TestVectorizedForward<ErfFunctor>("erf", -5, 5);
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace math_unary
+
+}  // namespace oneflow
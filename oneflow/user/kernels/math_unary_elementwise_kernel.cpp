@@ -14,14 +14,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
-#include "oneflow/user/kernels/math_unary_elementwise_func.h"
+#include "oneflow/user/kernels/math_unary_elementwise_cpu_kernel_util.h"
 
 namespace oneflow {
 
 template<template<typename> class UnaryFunctor, typename T>
 class MathUnaryElementwiseCpuKernel final : public user_op::OpKernel {
  public:
-  MathUnaryElementwiseCpuKernel() = default;
+  MathUnaryElementwiseCpuKernel()
+      : forward_func_(math_unary::ForwardCpuFuncSelector<UnaryFunctor, T>::Select()) {}
   ~MathUnaryElementwiseCpuKernel() = default;
 
  private:
@@ -30,11 +31,11 @@ class MathUnaryElementwiseCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* tensor_y = ctx->Tensor4ArgNameAndIndex("y", 0);
     const T* x = tensor_x->dptr<T>();
     T* y = tensor_y->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { y[i] = UnaryFunctor<T>::Forward(x[i]); }
+    math_unary::LaunchForwardCpu(forward_func_, tensor_x->shape().elem_cnt(), x, y);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+
+  math_unary::ForwardCpuFunc<T> forward_func_;
 };
 
 template<template<typename> class UnaryFunctor, typename T>
@@ -52,9 +53,10 @@ class MathUnaryElementwiseGradCpuKernel final : public user_op::OpKernel {
     const T* x = tensor_x->dptr<T>();
     const T* dy = tensor_dy->dptr<T>();
     T* dx = tensor_dx->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dx[i] = UnaryFunctor<T>::Backward(x[i], dy[i]); }
+    const int64_t n = tensor_x->shape().elem_cnt();
+    ep::CpuParallelForRows(n, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) { dx[i] = UnaryFunctor<T>::Backward(x[i], dy[i]); }
+    });
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -14,84 +14,315 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/include/primitive/batch_normalization.h"
+#include "oneflow/core/ep/cpu/cpu_isa.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#include "oneflow/core/ep/cpu/primitive/simd_math.h"
 
 namespace oneflow {
 
-template<typename T>
-static void ComputeMeanAndVar(const T* input_ptr, T* mean_ptr, T* inv_variance_ptr,
-                              T* moving_mean_ptr, T* moving_variance_ptr, const int64_t batch_size,
-                              const int64_t channel_size, const int64_t spatial_size,
-                              const float epsilon, const float momentum) {
-  // NOTE(Liang Depeng): the following parameters were used to compute mean and var
-  const int64_t jump_step = spatial_size * channel_size;
-  const int64_t reduce_count = batch_size * spatial_size;
-  const int64_t unbias_reduce_count = reduce_count - 1;
-  const T reduce_scale_factor = static_cast<T>(1) / reduce_count;
-  const T unbias_reduce_scale_factor = static_cast<T>(1) / unbias_reduce_count;
-  const T unbias_reduce_scale_factor_m2 = unbias_reduce_scale_factor * -static_cast<T>(2);
-  const T unbias_reduce_scale_factor_mn = reduce_count * unbias_reduce_scale_factor;
-
-  const T exponential_average_factor = 1.0f - momentum;
+// x is viewed as (outer_size, channel_size, inner_size) by the axis, e.g. (N, C, H * W) for NCHW
+// and (N * H * W, C, 1) for NHWC
+struct NormalizationLayout {
+  NormalizationLayout(const ShapeView& shape, int32_t axis)
+      : outer_size(shape.Count(0, axis)),
+        channel_size(shape.At(axis)),
+        inner_size(shape.Count(axis + 1)) {}
+
+  int64_t outer_size;
+  int64_t channel_size;
+  int64_t inner_size;
+};
 
-  for (int64_t channel = 0; channel < channel_size; ++channel) {
-    const T* temp_input_ptr = input_ptr + channel * spatial_size;
-    T sum = 0;
-    T sum_square = 0;
-    for (int64_t batch = 0; batch < batch_size; ++batch) {
-      for (int64_t s = 0; s < spatial_size; ++s) {
-        const T x = temp_input_ptr[s];
-        sum += x;
-        sum_square += x * x;
-      }
-      temp_input_ptr += jump_step;
+// The per-channel sums are reduced over at most this many blocks of the outer axis, the blocks do
+// not depend on the number of threads so the results are deterministic
+constexpr int64_t kNormalizationMaxBlockNum = 32;
+
+static int64_t GetNormalizationBlockNum(int64_t outer_size) {
+  return std::max<int64_t>(std::min(outer_size, kNormalizationMaxBlockNum), 1);
+}
+
+// The partial sums of every block of the outer axis and every channel
+static size_t GetNormalizationPartialSumsSize(const ShapeView& x_shape, int32_t axis,
+                                              DataType data_type) {
+  return 2 * GetNormalizationBlockNum(x_shape.Count(0, axis)) * x_shape.At(axis)
+         * GetSizeOfDataType(data_type);
+}
+
+// The sums of a run of one channel or of a row of all the channels: sum += v and dot += v * u,
+// where u = x - center and v = dy if with_dy, otherwise v = u. So they are the shifted sum and sum
+// of squares of x, or the sum of dy and its dot product with x - mean.
+template<typename T, bool with_dy>
+static void ChannelSumsRun(const T* x, const T* dy, int64_t n, T center, T* sum, T* dot) {
+  T run_sum = 0;
+  T run_dot = 0;
+  for (int64_t i = 0; i < n; ++i) {
+    const T u = x[i] - center;
+    const T v = with_dy ? dy[i] : u;
+    run_sum += v;
+    run_dot += v * u;
+  }
+  *sum += run_sum;
+  *dot += run_dot;
+}
+
+template<typename T, bool with_dy>
+static void ChannelSumsRow(const T* x, const T* dy, int64_t channels, const T* center, T* sum,
+                           T* dot) {
+  for (int64_t c = 0; c < channels; ++c) {
+    const T u = x[c] - center[c];
+    const T v = with_dy ? dy[c] : u;
+    sum[c] += v;
+    dot[c] += v * u;
+  }
+}
+
+// y = (x - center) * x_scale + bias, plus dy * dy_scale if with_dy, for a run of one channel or a
+// row of all the channels
+template<typename T, bool with_dy>
+static void ChannelAffineRun(const T* x, const T* dy, int64_t n, T center, T x_scale, T dy_scale,
+                             T bias, T* y) {
+  for (int64_t i = 0; i < n; ++i) {
+    T value = (x[i] - center) * x_scale + bias;
+    if (with_dy) { value += dy[i] * dy_scale; }
+    y[i] = value;
+  }
+}
+
+template<typename T, bool with_dy>
+static void ChannelAffineRow(const T* x, const T* dy, int64_t channels, const T* center,
+                             const T* x_scale, const T* dy_scale, const T* bias, T* y) {
+  for (int64_t c = 0; c < channels; ++c) {
+    T value = (x[c] - center[c]) * x_scale[c] + bias[c];
+    if (with_dy) { value += dy[c] * dy_scale[c]; }
+    y[c] = value;
+  }
+}
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+template<bool with_dy>
+OF_EP_CPU_TARGET_AVX2 static void ChannelSumsRunAvx2(const float* x, const float* dy, int64_t n,
+                                                     float center, float* sum, float* dot) {
+  constexpr int64_t kPackSize = 8;
+  const __m256 center_pack = _mm256_set1_ps(center);
+  __m256 sum_pack0 = _mm256_setzero_ps();
+  __m256 sum_pack1 = _mm256_setzero_ps();
+  __m256 dot_pack0 = _mm256_setzero_ps();
+  __m256 dot_pack1 = _mm256_setzero_ps();
+  int64_t i = 0;
+  for (; i + 2 * kPackSize <= n; i += 2 * kPackSize) {
+    const __m256 u0 = _mm256_sub_ps(_mm256_loadu_ps(x + i), center_pack);
+    const __m256 u1 = _mm256_sub_ps(_mm256_loadu_ps(x + i + kPackSize), center_pack);
+    const __m256 v0 = with_dy ? _mm256_loadu_ps(dy + i) : u0;
+    const __m256 v1 = with_dy ? _mm256_loadu_ps(dy + i + kPackSize) : u1;
+    sum_pack0 = _mm256_add_ps(sum_pack0, v0);
+    sum_pack1 = _mm256_add_ps(sum_pack1, v1);
+    dot_pack0 = _mm256_fmadd_ps(v0, u0, dot_pack0);
+    dot_pack1 = _mm256_fmadd_ps(v1, u1, dot_pack1);
+  }
+  *sum += ep::primitive::simd::ReduceSum(_mm256_add_ps(sum_pack0, sum_pack1));
+  *dot += ep::primitive::simd::ReduceSum(_mm256_add_ps(dot_pack0, dot_pack1));
+  ChannelSumsRun<float, with_dy>(x + i, with_dy ? dy + i : nullptr, n - i, center, sum, dot);
+}
+
+template<bool with_dy>
+OF_EP_CPU_TARGET_AVX2 static void ChannelSumsRowAvx2(const float* x, const float* dy,
+                                                     int64_t channels, const float* center,
+                                                     float* sum, float* dot) {
+  constexpr int64_t kPackSize = 8;
+  int64_t c = 0;
+  for (; c + kPackSize <= channels; c += kPackSize) {
+    const __m256 u = _mm256_sub_ps(_mm256_loadu_ps(x + c), _mm256_loadu_ps(center + c));
+    const __m256 v = with_dy ? _mm256_loadu_ps(dy + c) : u;
+    _mm256_storeu_ps(sum + c, _mm256_add_ps(_mm256_loadu_ps(sum + c), v));
+    _mm256_storeu_ps(dot + c, _mm256_fmadd_ps(v, u, _mm256_loadu_ps(dot + c)));
+  }
+  ChannelSumsRow<float, with_dy>(x + c, with_dy ? dy + c : nullptr, channels - c, center + c,
+                                 sum + c, dot + c);
+}
+
+template<bool with_dy>
+OF_EP_CPU_TARGET_AVX2 static void ChannelAffineRunAvx2(const float* x, const float* dy,
+                                                       int64_t n, float center, float x_scale,
+                                                       float dy_scale, float bias, float* y) {
+  constexpr int64_t kPackSize = 8;
+  const __m256 center_pack = _mm256_set1_ps(center);
+  const __m256 x_scale_pack = _mm256_set1_ps(x_scale);
+  const __m256 dy_scale_pack = _mm256_set1_ps(dy_scale);
+  const __m256 bias_pack = _mm256_set1_ps(bias);
+  int64_t i = 0;
+  for (; i + kPackSize <= n; i += kPackSize) {
+    __m256 value = _mm256_fmadd_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), center_pack),
+                                   x_scale_pack, bias_pack);
+    if (with_dy) { value = _mm256_fmadd_ps(_mm256_loadu_ps(dy + i), dy_scale_pack, value); }
+    _mm256_storeu_ps(y + i, value);
+  }
+  ChannelAffineRun<float, with_dy>(x + i, with_dy ? dy + i : nullptr, n - i, center, x_scale,
+                                   dy_scale, bias, y + i);
+}
+
+template<bool with_dy>
+OF_EP_CPU_TARGET_AVX2 static void ChannelAffineRowAvx2(const float* x, const float* dy,
+                                                       int64_t channels, const float* center,
+                                                       const float* x_scale,
+                                                       const float* dy_scale, const float* bias,
+                                                       float* y) {
+  constexpr int64_t kPackSize = 8;
+  int64_t c = 0;
+  for (; c + kPackSize <= channels; c += kPackSize) {
+    __m256 value =
+        _mm256_fmadd_ps(_mm256_sub_ps(_mm256_loadu_ps(x + c), _mm256_loadu_ps(center + c)),
+                        _mm256_loadu_ps(x_scale + c), _mm256_loadu_ps(bias + c));
+    if (with_dy) {
+      value = _mm256_fmadd_ps(_mm256_loadu_ps(dy + c), _mm256_loadu_ps(dy_scale + c), value);
     }
+    _mm256_storeu_ps(y + c, value);
+  }
+  ChannelAffineRow<float, with_dy>(x + c, with_dy ? dy + c : nullptr, channels - c, center + c,
+                                   x_scale + c, with_dy ? dy_scale + c : nullptr, bias + c, y + c);
+}
 
-    const T temp_mean = sum * reduce_scale_factor;
-    mean_ptr[channel] = temp_mean;
+#endif  // OF_EP_CPU_WITH_X86_SIMD
 
-    const T temp_mean_square = temp_mean * temp_mean;
-    const T temp_variance = sum_square * reduce_scale_factor - temp_mean_square;
+template<typename T, bool with_dy>
+struct ChannelFuncs {
+  void (*sums_run)(const T* x, const T* dy, int64_t n, T center, T* sum, T* dot);
+  void (*sums_row)(const T* x, const T* dy, int64_t channels, const T* center, T* sum, T* dot);
+  void (*affine_run)(const T* x, const T* dy, int64_t n, T center, T x_scale, T dy_scale, T bias,
+                     T* y);
+  void (*affine_row)(const T* x, const T* dy, int64_t channels, const T* center,
+                     const T* x_scale, const T* dy_scale, const T* bias, T* y);
+};
 
-    const T temp_unbias_variance = sum_square * unbias_reduce_scale_factor
-                                   + unbias_reduce_scale_factor_m2 * temp_mean * sum
-                                   + unbias_reduce_scale_factor_mn * temp_mean_square;
+template<typename T, bool with_dy>
+struct ChannelFuncsSelector {
+  static ChannelFuncs<T, with_dy> Select() {
+    return {&ChannelSumsRun<T, with_dy>, &ChannelSumsRow<T, with_dy>,
+            &ChannelAffineRun<T, with_dy>, &ChannelAffineRow<T, with_dy>};
+  }
+};
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
 
-    inv_variance_ptr[channel] = static_cast<T>(1) / std::sqrt(temp_variance + epsilon);
+template<bool with_dy>
+struct ChannelFuncsSelector<float, with_dy> {
+  static ChannelFuncs<float, with_dy> Select() {
+    if (ep::GetCpuIsa() >= ep::CpuIsa::kAvx2) {
+      return {&ChannelSumsRunAvx2<with_dy>, &ChannelSumsRowAvx2<with_dy>,
+              &ChannelAffineRunAvx2<with_dy>, &ChannelAffineRowAvx2<with_dy>};
+    }
+    return {&ChannelSumsRun<float, with_dy>, &ChannelSumsRow<float, with_dy>,
+            &ChannelAffineRun<float, with_dy>, &ChannelAffineRow<float, with_dy>};
+  }
+};
 
-    if (moving_mean_ptr != nullptr && moving_variance_ptr != nullptr) {
-      moving_mean_ptr[channel] =
-          moving_mean_ptr[channel] * momentum + temp_mean * exponential_average_factor;
-      moving_variance_ptr[channel] = moving_variance_ptr[channel] * momentum
-                                     + temp_unbias_variance * exponential_average_factor;
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+// sum[c] and dot[c] of ChannelSumsRun over all the elements of the channels. Every block of the
+// outer axis sums into its own part of `partial_sums`, which has GetNormalizationPartialSumsSize.
+template<typename T, bool with_dy>
+static void ComputeChannelSums(const NormalizationLayout& layout, const T* x, const T* dy,
+                               const T* center, T* partial_sums, T* sum, T* dot) {
+  const ChannelFuncs<T, with_dy> funcs = ChannelFuncsSelector<T, with_dy>::Select();
+  const int64_t channel_size = layout.channel_size;
+  const int64_t inner_size = layout.inner_size;
+  const int64_t block_num = GetNormalizationBlockNum(layout.outer_size);
+  const int64_t rows_per_block = (layout.outer_size + block_num - 1) / block_num;
+  T* partial_sum = partial_sums;
+  T* partial_dot = partial_sums + block_num * channel_size;
+  if (inner_size == 1) {
+    // channels last, every row of the block is accumulated into the vectors of the block
+    ep::CpuParallelForRows(
+        block_num, rows_per_block * channel_size, [&](int64_t begin_block, int64_t end_block) {
+          for (int64_t block = begin_block; block < end_block; ++block) {
+            T* block_sum = partial_sum + block * channel_size;
+            T* block_dot = partial_dot + block * channel_size;
+            std::fill(block_sum, block_sum + channel_size, static_cast<T>(0));
+            std::fill(block_dot, block_dot + channel_size, static_cast<T>(0));
+            const int64_t end_row = std::min((block + 1) * rows_per_block, layout.outer_size);
+            for (int64_t row = block * rows_per_block; row < end_row; ++row) {
+              const int64_t offset = row * channel_size;
+              funcs.sums_row(x + offset, with_dy ? dy + offset : nullptr, channel_size, center,
+                             block_sum, block_dot);
+            }
+          }
+        });
+  } else {
+    // every (block, channel) reduces the contiguous runs of the channel in the block
+    ep::CpuParallelForRows(
+        block_num * channel_size, rows_per_block * inner_size,
+        [&](int64_t begin_unit, int64_t end_unit) {
+          for (int64_t unit = begin_unit; unit < end_unit; ++unit) {
+            const int64_t block = unit / channel_size;
+            const int64_t channel = unit % channel_size;
+            T unit_sum = 0;
+            T unit_dot = 0;
+            const int64_t end_row = std::min((block + 1) * rows_per_block, layout.outer_size);
+            for (int64_t row = block * rows_per_block; row < end_row; ++row) {
+              const int64_t offset = (row * channel_size + channel) * inner_size;
+              funcs.sums_run(x + offset, with_dy ? dy + offset : nullptr, inner_size,
+                             center[channel], &unit_sum, &unit_dot);
+            }
+            partial_sum[unit] = unit_sum;
+            partial_dot[unit] = unit_dot;
+          }
+        });
+  }
+  for (int64_t channel = 0; channel < channel_size; ++channel) {
+    T channel_sum = 0;
+    T channel_dot = 0;
+    for (int64_t block = 0; block < block_num; ++block) {
+      channel_sum += partial_sum[block * channel_size + channel];
+      channel_dot += partial_dot[block * channel_size + channel];
     }
+    sum[channel] = channel_sum;
+    dot[channel] = channel_dot;
   }
 }
 
-template<typename T>
-static void Normalize(const T* input_ptr, const T* mean_ptr, const T* variance_ptr,
-                      const T* gamma_ptr, const T* beta_ptr, T* output_ptr,
-                      const int64_t batch_size, const int64_t channel_size,
-                      const int64_t spatial_size, const float epsilon, const bool training) {
-  const T* temp_input_ptr = input_ptr;
-  T* temp_output_ptr = output_ptr;
-  const int64_t all_channels = batch_size * channel_size;
-  int64_t channel = -1;
-  for (int64_t ac = 0; ac < all_channels; ++ac) {
-    channel += 1;
-    if (channel >= channel_size) { channel = 0; }
-    T inv_variance = variance_ptr[channel];
-    if (!training) { inv_variance = 1.0f / std::sqrt(inv_variance + epsilon); }
-    const T gamma = gamma_ptr[channel] * inv_variance;
-    const T beta = beta_ptr[channel];
-    const T mean = mean_ptr[channel];
-    for (int64_t s = 0; s < spatial_size; ++s) {
-      temp_output_ptr[s] = (temp_input_ptr[s] - mean) * gamma + beta;
+// y[begin, end) = (x - center[c]) * x_scale[c] + bias[c], plus dy * dy_scale[c] if with_dy, where
+// c is the channel of every element
+template<typename T, bool with_dy>
+static void ChannelAffine(const ChannelFuncs<T, with_dy>& funcs,
+                          const NormalizationLayout& layout, int64_t begin, int64_t end, const T* x,
+                          const T* dy, const T* center, const T* x_scale, const T* dy_scale,
+                          const T* bias, T* y) {
+  const int64_t channel_size = layout.channel_size;
+  const int64_t inner_size = layout.inner_size;
+  int64_t i = begin;
+  while (i < end) {
+    int64_t n = 0;
+    if (inner_size == 1) {
+      const int64_t channel = i % channel_size;
+      n = std::min(channel_size - channel, end - i);
+      funcs.affine_row(x + i, with_dy ? dy + i : nullptr, n, center + channel, x_scale + channel,
+                       with_dy ? dy_scale + channel : nullptr, bias + channel, y + i);
+    } else {
+      const int64_t channel = (i / inner_size) % channel_size;
+      n = std::min(inner_size - i % inner_size, end - i);
+      funcs.affine_run(x + i, with_dy ? dy + i : nullptr, n, center[channel], x_scale[channel],
+                       with_dy ? dy_scale[channel] : static_cast<T>(0), bias[channel], y + i);
     }
-    temp_input_ptr += spatial_size;
-    temp_output_ptr += spatial_size;
+    i += n;
   }
 }
 
+// The relu masks pack 32 elements into an int32, so the elements are split across threads and
+// handled in chunks at multiples of 32
+constexpr int64_t kNormalizationChunkSize = 8192;
+
+template<typename DoChunkT>
+static void ForEachNormalizationChunk(int64_t elem_cnt, const DoChunkT& DoChunk) {
+  const int64_t chunk_num = (elem_cnt + kNormalizationChunkSize - 1) / kNormalizationChunkSize;
+  ep::CpuParallelForRows(chunk_num, kNormalizationChunkSize, [&](int64_t begin, int64_t end) {
+    for (int64_t chunk = begin; chunk < end; ++chunk) {
+      DoChunk(chunk * kNormalizationChunkSize,
+              std::min((chunk + 1) * kNormalizationChunkSize, elem_cnt));
+    }
+  });
+}
+
 template<typename T>
 static void AddToOutput(const T* add_to_output_ptr, T* output_ptr, const int64_t elem_count) {
   for (int64_t i = 0; i < elem_count; ++i) { output_ptr[i] += add_to_output_ptr[i]; }
@@ -214,58 +445,138 @@ static void ReluGrad(const T* dy_ptr, const int32_t* mask_ptr, T* relu_dx_ptr,
   }
 }
 
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+template<bool with_addend>
+OF_EP_CPU_TARGET_AVX2 static void AddReluAvx2(const float* addend_ptr, int32_t* mask_ptr,
+                                              float* output_ptr, const int64_t elem_cnt) {
+  constexpr int64_t kPackSize = 8;
+  constexpr int64_t kStep = 32;
+  const int64_t outer_loop = elem_cnt / kStep;
+  const __m256 zero = _mm256_setzero_ps();
+  for (int64_t outer = 0; outer < outer_loop; ++outer) {
+    uint32_t mask_val = 0;
+    for (int64_t p = 0; p < kStep / kPackSize; ++p) {
+      const int64_t offset = outer * kStep + p * kPackSize;
+      __m256 output = _mm256_loadu_ps(output_ptr + offset);
+      if (with_addend) { output = _mm256_add_ps(output, _mm256_loadu_ps(addend_ptr + offset)); }
+      // NaN is not positive, which is the same as the scalar version
+      const __m256 is_positive = _mm256_cmp_ps(output, zero, _CMP_GT_OQ);
+      _mm256_storeu_ps(output_ptr + offset, _mm256_and_ps(output, is_positive));
+      mask_val |= static_cast<uint32_t>(_mm256_movemask_ps(is_positive)) << (p * kPackSize);
+    }
+    mask_ptr[outer] = static_cast<int32_t>(mask_val);
+  }
+  const int64_t remain_loop_start_idx = outer_loop * kStep;
+  if (remain_loop_start_idx < elem_cnt) {
+    if (with_addend) {
+      AddRelu(addend_ptr + remain_loop_start_idx, mask_ptr + outer_loop,
+              output_ptr + remain_loop_start_idx, elem_cnt - remain_loop_start_idx);
+    } else {
+      Relu(mask_ptr + outer_loop, output_ptr + remain_loop_start_idx,
+           elem_cnt - remain_loop_start_idx);
+    }
+  }
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+// relu(output + addend), or relu(output) if addend_ptr is nullptr
+template<typename T>
+static void AddReluOrRelu(const T* addend_ptr, int32_t* mask_ptr, T* output_ptr,
+                          const int64_t elem_cnt) {
+  if (addend_ptr != nullptr) {
+    AddRelu(addend_ptr, mask_ptr, output_ptr, elem_cnt);
+  } else {
+    Relu(mask_ptr, output_ptr, elem_cnt);
+  }
+}
+
+#ifdef OF_EP_CPU_WITH_X86_SIMD
+
+template<>
+void AddReluOrRelu<float>(const float* addend_ptr, int32_t* mask_ptr, float* output_ptr,
+                          const int64_t elem_cnt) {
+  if (ep::GetCpuIsa() < ep::CpuIsa::kAvx2) {
+    if (addend_ptr != nullptr) {
+      AddRelu(addend_ptr, mask_ptr, output_ptr, elem_cnt);
+    } else {
+      Relu(mask_ptr, output_ptr, elem_cnt);
+    }
+  } else if (addend_ptr != nullptr) {
+    AddReluAvx2<true>(addend_ptr, mask_ptr, output_ptr, elem_cnt);
+  } else {
+    AddReluAvx2<false>(nullptr, mask_ptr, output_ptr, elem_cnt);
+  }
+}
+
+#endif  // OF_EP_CPU_WITH_X86_SIMD
+
+static size_t InferTrainTmpSizeForCpuKernel(user_op::InferContext* ctx) {
+  const auto& x = ctx->InputTensorDesc("x", 0);
+  return GetNormalizationPartialSumsSize(x.shape(), ctx->Attr<int32_t>("axis"), x.data_type());
+}
+
 static size_t InferGradTmpSizeForCpuKernel(user_op::InferContext* ctx) {
   const auto& dy = ctx->InputTensorDesc("dy", 0);
-  size_t tmp_size = 0;
+  size_t tmp_size =
+      GetNormalizationPartialSumsSize(dy.shape(), ctx->Attr<int32_t>("axis"), dy.data_type());
   if (ctx->op_type_name() == "normalization_add_relu_grad" && !ctx->has_output("addend_diff", 0)) {
     tmp_size += dy.shape().elem_cnt() * GetSizeOfDataType(dy.data_type());
   }
   return tmp_size;
 }
 
-// NOTE(Liang Depeng): helper functions to process datas for specific channel over all samples.
-template<typename T, typename DataProcessor>
-static inline void ForEachFast(const T* data, const int64_t batch_size, const int64_t spatial_size,
-                               const int64_t jump_step, const int64_t channel_idx,
-                               DataProcessor data_processor) {
-  const int64_t start_offset = channel_idx * spatial_size;
-  const T* tmp_data = data + start_offset;
-  for (int64_t outer = 0; outer < batch_size; ++outer) {
-    for (int64_t i = 0; i < spatial_size; ++i) { data_processor(&tmp_data[i]); }
-    tmp_data += jump_step;
+// NOTE(Liang Depeng): y = (x - mean) * gamma * inv_variance + beta, where x_scale is
+// gamma * inv_variance, then plus _add_to_output, or y = relu(y + addend) and its mask for
+// normalization_add_relu. All the steps are done chunk by chunk in one pass.
+template<typename T>
+static void NormalizeForward(user_op::KernelComputeContext* ctx, const NormalizationLayout& layout,
+                             const T* mean_ptr, const T* x_scale_ptr) {
+  const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+  auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+  const T* input_ptr = x->dptr<T>();
+  const T* beta_ptr = ctx->Tensor4ArgNameAndIndex("beta", 0)->dptr<T>();
+  T* output_ptr = y->mut_dptr<T>();
+  const int64_t elem_cnt = x->shape().elem_cnt();
+
+  // y may be in place of _add_to_output, which is added as dy of the affine to be read first
+  const T* add_to_output_ptr = nullptr;
+  std::vector<T> ones;
+  if (ctx->has_input("_add_to_output", 0)) {
+    const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+    CHECK_EQ(add_to_output->data_type(), y->data_type());
+    CHECK_EQ(add_to_output->shape(), y->shape());
+    add_to_output_ptr = add_to_output->dptr<T>();
+    ones.resize(layout.channel_size, static_cast<T>(1));
   }
-}
-
-template<typename T, typename DataProcessor>
-static inline void ForEachFast(const T* in_data1, const T* in_data2, const int64_t batch_size,
-                               const int64_t spatial_size, const int64_t jump_step,
-                               const int64_t channel_idx, DataProcessor data_processor) {
-  const int64_t start_offset = channel_idx * spatial_size;
-  const T* tmp_in_data1 = in_data1 + start_offset;
-  const T* tmp_in_data2 = in_data2 + start_offset;
-  for (int64_t outer = 0; outer < batch_size; ++outer) {
-    for (int64_t i = 0; i < spatial_size; ++i) {
-      data_processor(&tmp_in_data1[i], &tmp_in_data2[i]);
+  const bool with_relu = ctx->op_type_name() == "normalization_add_relu";
+  const T* addend_ptr = nullptr;
+  int32_t* mask_ptr = nullptr;
+  if (with_relu) {
+    CHECK(add_to_output_ptr == nullptr);
+    mask_ptr = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->mut_dptr<int32_t>();
+    if (ctx->has_input("addend", 0)) {
+      addend_ptr = ctx->Tensor4ArgNameAndIndex("addend", 0)->dptr<T>();
     }
-    tmp_in_data1 += jump_step;
-    tmp_in_data2 += jump_step;
   }
-}
 
-template<typename T, typename DataProcessor>
-static inline void ForEachFast(const T* in_data, T* out_data, const int64_t batch_size,
-                               const int64_t spatial_size, const int64_t jump_step,
-                               const int64_t channel_idx, DataProcessor data_processor) {
-  const int64_t start_offset = channel_idx * spatial_size;
-  const T* tmp_in_data = in_data + start_offset;
-  T* tmp_out_data = out_data + start_offset;
-  for (int64_t outer = 0; outer < batch_size; ++outer) {
-    for (int64_t i = 0; i < spatial_size; ++i) {
-      data_processor(&tmp_in_data[i], &tmp_out_data[i]);
+  const ChannelFuncs<T, false> funcs = ChannelFuncsSelector<T, false>::Select();
+  const ChannelFuncs<T, true> add_funcs = ChannelFuncsSelector<T, true>::Select();
+  ForEachNormalizationChunk(elem_cnt, [&](int64_t begin, int64_t end) {
+    if (add_to_output_ptr != nullptr) {
+      ChannelAffine<T, true>(add_funcs, layout, begin, end, input_ptr, add_to_output_ptr,
+                             mean_ptr, x_scale_ptr, ones.data(), beta_ptr, output_ptr);
+    } else {
+      ChannelAffine<T, false>(funcs, layout, begin, end, input_ptr, nullptr, mean_ptr,
+                              x_scale_ptr, nullptr, beta_ptr, output_ptr);
     }
-    tmp_in_data += jump_step;
-    tmp_out_data += jump_step;
-  }
+    if (with_relu) {
+      // begin is a multiple of 32, so is the first element of the mask
+      AddReluOrRelu(addend_ptr == nullptr ? nullptr : addend_ptr + begin, mask_ptr + begin / 32,
+                    output_ptr + begin, end - begin);
+    }
+  });
 }
 
 template<typename T>
@@ -293,34 +604,34 @@ class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
     CHECK_EQ(y->data_type(), data_type);
     CHECK_GE(axis, 0);
     CHECK_LT(axis, x->shape().NumAxes());
+    if (x->shape().elem_cnt() == 0) { return; }
+
+    // NOTE: the batch normalization primitive exists if built with oneDNN, which does not fuse the
+    // addition and relu
+    std::unique_ptr<ep::primitive::BatchNormalization> batch_normalization;
+    if ((axis == 1 || axis == x->shape().NumAxes() - 1) && ctx->op_type_name() == "normalization"
+        && !ctx->has_input("_add_to_output", 0)) {
+      batch_normalization =
+          ep::primitive::NewPrimitive<ep::primitive::BatchNormalizationFactory>(
+              DeviceType::kCPU, data_type, axis != 1);
+    }
+    if (batch_normalization) {
+      batch_normalization->Launch(ctx->stream(), x->shape().NumAxes(), x->shape().ptr(),
+                                  x->dptr(), moving_mean->dptr(), moving_variance->dptr(),
+                                  gamma->dptr(), beta->dptr(), epsilon, y->mut_dptr());
+      return;
+    }
 
-    if (axis == 1) {  // NOTE(Liang Depeng): NCHW format
-      const T* input_ptr = x->dptr<T>();
-      const T* gamma_ptr = gamma->dptr<T>();
-      const T* beta_ptr = beta->dptr<T>();
-
-      T* output_ptr = y->mut_dptr<T>();
-      T* moving_mean_ptr = moving_mean->mut_dptr<T>();
-      T* moving_variance_ptr = moving_variance->mut_dptr<T>();
-
-      const int64_t batch_size = x->shape().At(0);
-      const int64_t channel_size = x->shape().At(axis);
-      const int64_t spatial_size = x->shape().Count(axis + 1);
-
-      // NOTE(Liang Depeng):
-      // compute the normalization result
-      Normalize(input_ptr, moving_mean_ptr, moving_variance_ptr, gamma_ptr, beta_ptr, output_ptr,
-                batch_size, channel_size, spatial_size, epsilon, false);
-
-      if (ctx->has_input("_add_to_output", 0)) {
-        const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
-        CHECK_EQ(add_to_output->data_type(), y->data_type());
-        CHECK_EQ(add_to_output->shape(), y->shape());
-        AddToOutput(add_to_output->dptr<T>(), output_ptr, x->shape().elem_cnt());
-      }
-
-    } else {  // TODO(Liang Depeng): NHWC format
+    // NOTE(Liang Depeng): compute the normalization result with the moving statistics, whose
+    // gamma * inv_variance are computed once for all the elements of the channel
+    const NormalizationLayout layout(x->shape(), axis);
+    const T* gamma_ptr = gamma->dptr<T>();
+    const T* moving_variance_ptr = moving_variance->dptr<T>();
+    std::vector<T> x_scale(layout.channel_size);
+    for (int64_t channel = 0; channel < layout.channel_size; ++channel) {
+      x_scale[channel] = gamma_ptr[channel] / std::sqrt(moving_variance_ptr[channel] + epsilon);
     }
+    NormalizeForward<T>(ctx, layout, moving_mean->dptr<T>(), x_scale.data());
   }
 
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
@@ -355,7 +666,7 @@ class NormalizationTrainCpuKernel final : public user_op::OpKernel {
  private:
   using user_op::OpKernel::Compute;
   void Compute(user_op::KernelComputeContext* ctx) const override {
-    if (ctx->op_type_name() == "normalization") { CHECK(ctx->Attr<bool>("training")); }
+    CHECK(ctx->Attr<bool>("training"));
     const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
     auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
 
@@ -368,70 +679,63 @@ class NormalizationTrainCpuKernel final : public user_op::OpKernel {
     CHECK_EQ(y->data_type(), data_type);
     CHECK_GE(axis, 0);
     CHECK_LT(axis, x->shape().NumAxes());
+    if (x->shape().elem_cnt() == 0) { return; }
 
     const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
-    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
     auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
     auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    auto* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
 
-    user_op::Tensor* moving_mean = nullptr;
-    user_op::Tensor* moving_variance = nullptr;
+    T* moving_mean_ptr = nullptr;
+    T* moving_variance_ptr = nullptr;
     if (ctx->has_input("moving_mean", 0)) {
       CHECK(ctx->has_input("moving_variance", 0));
-      moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
-      moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+      moving_mean_ptr = ctx->Tensor4ArgNameAndIndex("moving_mean", 0)->mut_dptr<T>();
+      moving_variance_ptr = ctx->Tensor4ArgNameAndIndex("moving_variance", 0)->mut_dptr<T>();
     }
 
-    if (axis == 1) {  // NOTE(Liang Depeng): NCHW format
-      const T* input_ptr = x->dptr<T>();
-      const T* gamma_ptr = gamma->dptr<T>();
-      const T* beta_ptr = beta->dptr<T>();
-
-      T* output_ptr = y->mut_dptr<T>();
-      T* mean_ptr = mean->mut_dptr<T>();
-      T* inv_variance_ptr = inv_variance->mut_dptr<T>();
-
-      T* moving_mean_ptr = nullptr;
-      T* moving_variance_ptr = nullptr;
-      if (moving_mean != nullptr && moving_variance != nullptr) {
-        moving_mean_ptr = moving_mean->mut_dptr<T>();
-        moving_variance_ptr = moving_variance->mut_dptr<T>();
-      }
-
-      const int64_t batch_size = x->shape().At(0);
-      const int64_t channel_size = x->shape().At(axis);
-      const int64_t spatial_size = x->shape().Count(axis + 1);
-
-      // NOTE(Liang Depeng):
-      // Compute mean & inv_variance and update moving_mean & moving_variance for each channel.
-      ComputeMeanAndVar(input_ptr, mean_ptr, inv_variance_ptr, moving_mean_ptr, moving_variance_ptr,
-                        batch_size, channel_size, spatial_size, epsilon, momentum);
-
-      // NOTE(Liang Depeng):
-      // compute the normalization result
-      Normalize(input_ptr, mean_ptr, inv_variance_ptr, gamma_ptr, beta_ptr, output_ptr, batch_size,
-                channel_size, spatial_size, epsilon, true);
-
-      if (ctx->has_input("_add_to_output", 0)) {
-        const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
-        CHECK_EQ(add_to_output->data_type(), y->data_type());
-        CHECK_EQ(add_to_output->shape(), y->shape());
-        AddToOutput(add_to_output->dptr<T>(), output_ptr, x->shape().elem_cnt());
-      }
-
-      if (ctx->op_type_name() == "normalization_add_relu") {
-        CHECK(!ctx->has_input("_add_to_output", 0));
-        auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
-
-        if (ctx->has_input("addend", 0)) {
-          const auto* addend = ctx->Tensor4ArgNameAndIndex("addend", 0);
-          AddRelu(addend->dptr<T>(), mask->mut_dptr<int32_t>(), output_ptr, x->shape().elem_cnt());
-        } else {
-          Relu(mask->mut_dptr<int32_t>(), output_ptr, x->shape().elem_cnt());
-        }
+    const NormalizationLayout layout(x->shape(), axis);
+    const int64_t channel_size = layout.channel_size;
+    const T* input_ptr = x->dptr<T>();
+    const T* gamma_ptr = gamma->dptr<T>();
+    T* mean_ptr = mean->mut_dptr<T>();
+    T* inv_variance_ptr = inv_variance->mut_dptr<T>();
+
+    // NOTE(Liang Depeng):
+    // Compute mean & inv_variance and update moving_mean & moving_variance for each channel.
+    // The sums are shifted by the first element of the channel, so the variance does not lose the
+    // precision to a large mean.
+    std::vector<T> shift(channel_size);
+    std::vector<T> sum(channel_size);
+    std::vector<T> square_sum(channel_size);
+    for (int64_t channel = 0; channel < channel_size; ++channel) {
+      shift[channel] = input_ptr[channel * layout.inner_size];
+    }
+    ComputeChannelSums<T, false>(layout, input_ptr, nullptr, shift.data(),
+                                 tmp_buffer->mut_dptr<T>(), sum.data(), square_sum.data());
+    const int64_t reduce_count = layout.outer_size * layout.inner_size;
+    const T unbias_factor = static_cast<T>(reduce_count) / static_cast<T>(reduce_count - 1);
+    const T exponential_average_factor = 1.0f - momentum;
+    std::vector<T> x_scale(channel_size);
+    for (int64_t channel = 0; channel < channel_size; ++channel) {
+      const T shifted_mean = sum[channel] / reduce_count;
+      const T variance = std::max(square_sum[channel] / reduce_count - shifted_mean * shifted_mean,
+                                  static_cast<T>(0));
+      const T channel_mean = shift[channel] + shifted_mean;
+      mean_ptr[channel] = channel_mean;
+      inv_variance_ptr[channel] = static_cast<T>(1) / std::sqrt(variance + epsilon);
+      x_scale[channel] = gamma_ptr[channel] * inv_variance_ptr[channel];
+      if (moving_mean_ptr != nullptr && moving_variance_ptr != nullptr) {
+        moving_mean_ptr[channel] =
+            moving_mean_ptr[channel] * momentum + channel_mean * exponential_average_factor;
+        moving_variance_ptr[channel] = moving_variance_ptr[channel] * momentum
+                                       + variance * unbias_factor * exponential_average_factor;
       }
-    } else {  // TODO(Liang Depeng): NHWC format
     }
+
+    // NOTE(Liang Depeng):
+    // compute the normalization result
+    NormalizeForward<T>(ctx, layout, mean_ptr, x_scale.data());
   }
 
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
@@ -443,6 +747,7 @@ class NormalizationTrainCpuKernel final : public user_op::OpKernel {
       .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                     \
                        && (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)     \
                        && (user_op::HobAttr<bool>("training") == true))                   \
+      .SetInferTmpSizeFn(InferTrainTmpSizeForCpuKernel)                                   \
       .SetInplaceProposalFn(                                                              \
           [](const user_op::InferContext& ctx,                                            \
              const user_op::AddInplaceArgPair& AddInplaceArgPairFn) -> Maybe<void> {      \
@@ -457,11 +762,18 @@ REGISTER_BN_TRAIN_CPU_KERNEL(double)
 
 #undef REGISTER_BN_TRAIN_CPU_KERNEL
 
-#define REGISTER_BN_ADD_RELU_CPU_KERNEL(dtype)                        \
-  REGISTER_USER_KERNEL("normalization_add_relu")                      \
-      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()              \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
-                       && (user_op::HobDataType("y", 0) == GetDataType<dtype>::value));
+#define REGISTER_BN_ADD_RELU_CPU_KERNEL(dtype)                                        \
+  REGISTER_USER_KERNEL("normalization_add_relu")                                      \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                              \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                 \
+                       && (user_op::HobDataType("y", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobAttr<bool>("training") == true))               \
+      .SetInferTmpSizeFn(InferTrainTmpSizeForCpuKernel);                              \
+  REGISTER_USER_KERNEL("normalization_add_relu")                                      \
+      .SetCreateFn<NormalizationInferenceCpuKernel<dtype>>()                          \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                 \
+                       && (user_op::HobDataType("y", 0) == GetDataType<dtype>::value) \
+                       && (user_op::HobAttr<bool>("training") == false));
 
 REGISTER_BN_ADD_RELU_CPU_KERNEL(float)
 REGISTER_BN_ADD_RELU_CPU_KERNEL(double)
@@ -495,93 +807,88 @@ class NormalizationGradCpuKernel final : public user_op::OpKernel {
     CHECK_EQ(dx->data_type(), data_type);
     CHECK_GE(axis, 0);
     CHECK_LT(axis, x->shape().NumAxes());
+    const int64_t elem_cnt = x->shape().elem_cnt();
+    if (elem_cnt == 0) { return; }
 
+    // the partial sums of the channels are followed by the relu dx if there is
+    T* partial_sums_ptr = tmp_buffer->mut_dptr<T>();
+    T* relu_dx_ptr = partial_sums_ptr
+                     + GetNormalizationPartialSumsSize(x->shape(), axis, data_type) / sizeof(T);
     const T* dy_ptr = nullptr;
     if (ctx->op_type_name() == "normalization_grad") {
       dy_ptr = dy->dptr<T>();
     } else if (ctx->op_type_name() == "normalization_add_relu_grad") {
-      const auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
+      const int32_t* mask_ptr = ctx->Tensor4ArgNameAndIndex("reserve_space", 0)->dptr<int32_t>();
+      T* addend_diff_ptr = nullptr;
       if (ctx->has_output("addend_diff", 0)) {
-        user_op::Tensor* addend_diff = ctx->Tensor4ArgNameAndIndex("addend_diff", 0);
-        AddReluGrad(dy->dptr<T>(), mask->dptr<int32_t>(), addend_diff->mut_dptr<T>(),
-                    dy->shape().elem_cnt());
-        dy_ptr = addend_diff->dptr<T>();
-      } else {
-        ReluGrad(dy->dptr<T>(), mask->dptr<int32_t>(), tmp_buffer->mut_dptr<T>(),
-                 dy->shape().elem_cnt());
-        dy_ptr = tmp_buffer->dptr<T>();
+        addend_diff_ptr = ctx->Tensor4ArgNameAndIndex("addend_diff", 0)->mut_dptr<T>();
       }
-
+      ForEachNormalizationChunk(elem_cnt, [&](int64_t begin, int64_t end) {
+        if (addend_diff_ptr != nullptr) {
+          AddReluGrad(dy->dptr<T>() + begin, mask_ptr + begin / 32, addend_diff_ptr + begin,
+                      end - begin);
+        } else {
+          ReluGrad(dy->dptr<T>() + begin, mask_ptr + begin / 32, relu_dx_ptr + begin,
+                   end - begin);
+        }
+      });
+      dy_ptr = addend_diff_ptr != nullptr ? addend_diff_ptr : relu_dx_ptr;
     } else {
       UNIMPLEMENTED();
     }
 
-    if (axis == 1) {  // NOTE(Liang Depeng): NCHW format
-      const T* x_ptr = x->dptr<T>();
-      const T* gamma_ptr = gamma->dptr<T>();
-      const T* mean_ptr = mean->dptr<T>();
-      const T* inv_variance_ptr = inv_variance->dptr<T>();
-
-      T* dx_ptr = dx->mut_dptr<T>();
-      T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
-      T* beta_diff_ptr = beta_diff->mut_dptr<T>();
-
-      const int64_t batch_size = x->shape().At(0);
-      const int64_t channel_size = x->shape().At(axis);
-      const int64_t spatial_size = x->shape().Count(axis + 1);
-      const int64_t jump_step = spatial_size * channel_size;
-      const int64_t reduce_count = batch_size * spatial_size;
-
-      // NOTE(Liang Depeng):
-      // Borrow the MXNet implementation to compute dx, gamma_diff and beta_diff.
-      // For more details pls refers to:
-      // https://github.com/apache/incubator-mxnet/blob/master/src/operator/nn/batch_norm.cc
-      for (int64_t channel = 0; channel < channel_size; ++channel) {
-        const T gamma_c = gamma_ptr[channel];
-        const T mean_c = mean_ptr[channel];
-        const T inv_variance_c = inv_variance_ptr[channel];
-
-        // NOTE(Liang Depeng): sum dy for specific channel over all samples
-        T sum_dy_out = 0;
-        ForEachFast(dy_ptr, batch_size, spatial_size, jump_step, channel,
-                    [&sum_dy_out](const T* dy_data) { sum_dy_out += *dy_data; });
-
-        // NOTE(Liang Depeng): dot product of the x and dy
-        T dotp = 0;
-        ForEachFast(x_ptr, dy_ptr, batch_size, spatial_size, jump_step, channel,
-                    [&dotp, mean_c](const T* x_data, const T* dy_data) {
-                      dotp += (*x_data - mean_c) * (*dy_data);
-                    });
-
-        // NOTE(Liang Depeng): projection of dy on to output scaled by std
-        const T k = dotp * inv_variance_c * inv_variance_c / reduce_count;
-        const T iw = inv_variance_c * gamma_c;
-        const T grad_mean_c = sum_dy_out / reduce_count;
-        ForEachFast(
-            x_ptr, dx_ptr, batch_size, spatial_size, jump_step, channel,
-            [&mean_c, &k](const T* x_data, T* dx_data) { *dx_data = (*x_data - mean_c) * k; });
-
-        ForEachFast(dy_ptr, dx_ptr, batch_size, spatial_size, jump_step, channel,
-                    [iw, grad_mean_c](const T* dy_data, T* dx_data) {
-                      *dx_data = (*dy_data - grad_mean_c - *dx_data) * iw;
-                    });
-
-        gamma_diff_ptr[channel] = dotp * inv_variance_c;
-        beta_diff_ptr[channel] = sum_dy_out;
-      }
-
-    } else {  // TODO(Liang Depeng): NHWC format
+    const NormalizationLayout layout(x->shape(), axis);
+    const int64_t channel_size = layout.channel_size;
+    const T* x_ptr = x->dptr<T>();
+    const T* gamma_ptr = gamma->dptr<T>();
+    const T* mean_ptr = mean->dptr<T>();
+    const T* inv_variance_ptr = inv_variance->dptr<T>();
+    T* gamma_diff_ptr = gamma_diff->mut_dptr<T>();
+    T* beta_diff_ptr = beta_diff->mut_dptr<T>();
+    const int64_t reduce_count = layout.outer_size * layout.inner_size;
+
+    // NOTE(Liang Depeng):
+    // Borrow the MXNet implementation to compute dx, gamma_diff and beta_diff.
+    // For more details pls refers to:
+    // https://github.com/apache/incubator-mxnet/blob/master/src/operator/nn/batch_norm.cc
+    // sum dy and the dot product of x - mean and dy for every channel over all samples
+    std::vector<T> sum_dy(channel_size);
+    std::vector<T> dotp(channel_size);
+    ComputeChannelSums<T, true>(layout, x_ptr, dy_ptr, mean_ptr, partial_sums_ptr, sum_dy.data(),
+                                dotp.data());
+    // dx = (dy - grad_mean - (x - mean) * k) * iw, where k is the projection of dy on to output
+    // scaled by std
+    std::vector<T> x_scale(channel_size);
+    std::vector<T> dy_scale(channel_size);
+    std::vector<T> bias(channel_size);
+    for (int64_t channel = 0; channel < channel_size; ++channel) {
+      const T inv_variance_c = inv_variance_ptr[channel];
+      const T k = dotp[channel] * inv_variance_c * inv_variance_c / reduce_count;
+      const T iw = inv_variance_c * gamma_ptr[channel];
+      const T grad_mean_c = sum_dy[channel] / reduce_count;
+      x_scale[channel] = -k * iw;
+      dy_scale[channel] = iw;
+      bias[channel] = -grad_mean_c * iw;
+      gamma_diff_ptr[channel] = dotp[channel] * inv_variance_c;
+      beta_diff_ptr[channel] = sum_dy[channel];
     }
+    const ChannelFuncs<T, true> funcs = ChannelFuncsSelector<T, true>::Select();
+    T* dx_ptr = dx->mut_dptr<T>();
+    ForEachNormalizationChunk(elem_cnt, [&](int64_t begin, int64_t end) {
+      ChannelAffine<T, true>(funcs, layout, begin, end, x_ptr, dy_ptr, mean_ptr, x_scale.data(),
+                             dy_scale.data(), bias.data(), dx_ptr);
+    });
   }
 
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
 
-#define REGISTER_BN_GRAD_CPU_KERNEL(dtype)                            \
-  REGISTER_USER_KERNEL("normalization_grad")                          \
-      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()               \
-      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU) \
-                       && (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+#define REGISTER_BN_GRAD_CPU_KERNEL(dtype)                                              \
+  REGISTER_USER_KERNEL("normalization_grad")                                            \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()                                 \
+      .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)                   \
+                       && (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferGradTmpSizeForCpuKernel);
 
 REGISTER_BN_GRAD_CPU_KERNEL(float)
 REGISTER_BN_GRAD_CPU_KERNEL(double)
@@ -32,6 +32,15 @@ namespace oneflow {
 
 namespace {
 
+// The records are fully parsed OFRecord messages made by OFRecordParser, kOFRecord is the contract
+// between the reader and the decoder ops. Looking up a feature is one hash map find, only the
+// readers that decode their records themselves skip the parse with ScanOFRecordFeatures.
+const Feature& GetFeature(const OFRecord& record, const std::string& name) {
+  auto it = record.feature().find(name);
+  CHECK(it != record.feature().end()) << "Field " << name << " not found";
+  return it->second;
+}
+
 template<typename T>
 void DecodeOneRawOFRecord(const Feature& feature, T* dptr, int64_t sample_elem_cnt, bool truncate,
                           bool dim1_varying_length) {
@@ -99,9 +108,7 @@ class OFRecordRawDecoderKernel final : public user_op::OpKernel {
     MultiThreadLoop(record_num, [&](size_t i) {
       const OFRecord& record = *(records + i);
       T* dptr = out_dptr + i * sample_elem_cnt;
-      CHECK(record.feature().find(name) != record.feature().end())
-          << "Field " << name << " not found";
-      const Feature& feature = record.feature().at(name);
+      const Feature& feature = GetFeature(record, name);
       DecodeOneRawOFRecord(feature, dptr, sample_elem_cnt, truncate, dim1_varying_length);
     });
   }
@@ -142,9 +149,7 @@ class OFRecordBytesDecoderKernel final : public user_op::OpKernel {
     MultiThreadLoop(num_instances, [&](size_t i) {
       const OFRecord& record = *(records + i);
       TensorBuffer* buffer = buffers + i;
-      auto it = record.feature().find(name);
-      CHECK(it != record.feature().end()) << "Field " << name << " not found";
-      const Feature& feature = it->second;
+      const Feature& feature = GetFeature(record, name);
       CHECK(feature.has_bytes_list());
       CHECK_EQ(feature.bytes_list().value_size(), 1);
       const int64_t size = feature.bytes_list().value(0).size();
@@ -166,8 +171,7 @@ namespace {
 void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* buffer,
                                         const std::string& name, const std::string& color_space,
                                         RandomCropGenerator* random_crop_gen) {
-  CHECK(record.feature().find(name) != record.feature().end()) << "Field " << name << " not found";
-  const Feature& feature = record.feature().at(name);
+  const Feature& feature = GetFeature(record, name);
   CHECK(feature.has_bytes_list());
   CHECK(feature.bytes_list().value_size() == 1);
   const std::string& src_data = feature.bytes_list().value(0);
@@ -0,0 +1,170 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/ep/cpu/cpu_parallel.h"
+#include "oneflow/core/ep/cpu/primitive/int8_gemm.h"
+
+#include <cmath>
+
+namespace oneflow {
+
+namespace {
+
+// The packed b is reused while it stays at the same address, which is only safe if it is not
+// updated in place, e.g. the weights of an inference graph which are loaded once.
+bool IsPackedWeightReuseEnabled() {
+  static const bool enabled =
+      ParseBooleanFromEnv("ONEFLOW_CPU_QUANTIZED_MATMUL_REUSE_PACKED_WEIGHTS", false);
+  return enabled;
+}
+
+class QuantizedMatmulKernelState final : public user_op::OpKernelState {
+ public:
+  QuantizedMatmulKernelState() : packed_b_src_(nullptr) {}
+  ~QuantizedMatmulKernelState() override = default;
+
+  const void* packed_b_src() const { return packed_b_src_; }
+  void set_packed_b_src(const void* packed_b_src) { packed_b_src_ = packed_b_src; }
+  ep::primitive::Int8GemmPackedB* mut_packed_b() { return &packed_b_; }
+  std::vector<uint8_t>* mut_quantized_a() { return &quantized_a_; }
+  std::vector<int32_t>* mut_a_row_sums() { return &a_row_sums_; }
+
+ private:
+  const void* packed_b_src_;
+  ep::primitive::Int8GemmPackedB packed_b_;
+  std::vector<uint8_t> quantized_a_;
+  std::vector<int32_t> a_row_sums_;
+};
+
+// Quantize a of m x k like fake_quantization into uint8 rows of lda, the symmetric int8 values are
+// shifted by 128 so that both schemes have a zero point
+int32_t QuantizeA(const std::string& quantization_scheme, int64_t m, int64_t k, const float* a,
+                  float scale, float zero_point, int64_t lda, uint8_t* quantized_a,
+                  int32_t* row_sums) {
+  const bool symmetric = quantization_scheme == "symmetric";
+  const float lower_bound = symmetric ? -128 : 0;
+  const float upper_bound = symmetric ? 127 : 255;
+  const float offset = symmetric ? 0 : static_cast<uint8_t>(std::round(zero_point));
+  const int32_t shift = symmetric ? 128 : 0;
+  ep::CpuParallelForRows(m, k, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const float* a_row = a + i * k;
+      uint8_t* quantized_row = quantized_a + i * lda;
+      int32_t row_sum = 0;
+      for (int64_t l = 0; l < k; ++l) {
+        const float q = std::min(std::max(std::nearbyint(a_row[l] / scale + offset), lower_bound),
+                                 upper_bound);
+        quantized_row[l] = static_cast<uint8_t>(static_cast<int32_t>(q) + shift);
+        row_sum += quantized_row[l];
+      }
+      std::fill(quantized_row + k, quantized_row + lda, 0);
+      row_sums[i] = row_sum;
+    }
+  });
+  return static_cast<int32_t>(offset) + shift;
+}
+
+// Quantize b like fake_quantization into int8 and pack it, the affine uint8 values are shifted by
+// -128. The per-channel scales are along axis 0, which is n as b is transposed.
+void QuantizeAndPackB(const std::string& quantization_scheme, bool transpose_b, int64_t n,
+                      int64_t k, const float* b, int64_t num_scales, const float* scales,
+                      const float* zero_points, ep::primitive::Int8GemmPackedB* packed_b) {
+  const bool symmetric = quantization_scheme == "symmetric";
+  const float lower_bound = symmetric ? -128 : 0;
+  const float upper_bound = symmetric ? 127 : 255;
+  const int32_t shift = symmetric ? 0 : -128;
+  std::vector<int8_t> quantized_b(n * k);
+  std::vector<int32_t> col_zero_points(n);
+  FOR_RANGE(int64_t, i, 0, n * k) {
+    const int64_t channel = num_scales == 1 ? 0 : i / k;
+    const float offset = symmetric ? 0 : static_cast<uint8_t>(std::round(zero_points[channel]));
+    const float q = std::min(
+        std::max(std::nearbyint(b[i] / scales[channel] + offset), lower_bound), upper_bound);
+    quantized_b[i] = static_cast<int8_t>(static_cast<int32_t>(q) + shift);
+  }
+  FOR_RANGE(int64_t, j, 0, n) {
+    const int64_t channel = num_scales == 1 ? 0 : j;
+    col_zero_points[j] =
+        symmetric ? 0 : static_cast<uint8_t>(std::round(zero_points[channel])) + shift;
+  }
+  ep::primitive::PackInt8GemmB(transpose_b, n, k, quantized_b.data(), col_zero_points.data(),
+                               packed_b);
+}
+
+class QuantizedMatmulCpuKernel final : public user_op::OpKernel {
+ public:
+  QuantizedMatmulCpuKernel() = default;
+  ~QuantizedMatmulCpuKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<QuantizedMatmulKernelState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state,
+               const user_op::OpKernelCache*) const override {
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* a_scale = ctx->Tensor4ArgNameAndIndex("a_scale", 0);
+    const user_op::Tensor* a_zero_point = ctx->Tensor4ArgNameAndIndex("a_zero_point", 0);
+    const user_op::Tensor* b_scale = ctx->Tensor4ArgNameAndIndex("b_scale", 0);
+    const user_op::Tensor* b_zero_point = ctx->Tensor4ArgNameAndIndex("b_zero_point", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const bool transpose_b = ctx->Attr<bool>("transpose_b");
+    const double alpha = ctx->Attr<double>("alpha");
+    auto* kernel_state = dynamic_cast<QuantizedMatmulKernelState*>(state);
+    CHECK_NOTNULL(kernel_state);
+
+    const int64_t k = a->shape().At(a->shape().NumAxes() - 1);
+    const int64_t m = a->shape().elem_cnt() / k;
+    const int64_t n = out->shape().At(out->shape().NumAxes() - 1);
+    const int64_t num_b_scales = b_scale->shape().elem_cnt();
+    if (!IsPackedWeightReuseEnabled() || kernel_state->packed_b_src() != b->dptr()) {
+      QuantizeAndPackB(ctx->Attr<std::string>("b_quantization_scheme"), transpose_b, n, k,
+                       b->dptr<float>(), num_b_scales, b_scale->dptr<float>(),
+                       b_zero_point->dptr<float>(), kernel_state->mut_packed_b());
+      kernel_state->set_packed_b_src(b->dptr());
+    }
+    const int64_t lda = ep::primitive::GetInt8GemmLda(k);
+    std::vector<uint8_t>* quantized_a = kernel_state->mut_quantized_a();
+    std::vector<int32_t>* a_row_sums = kernel_state->mut_a_row_sums();
+    quantized_a->resize(m * lda);
+    a_row_sums->resize(m);
+    const float a_scale_value = *a_scale->dptr<float>();
+    const int32_t quantized_a_zero_point = QuantizeA(
+        ctx->Attr<std::string>("a_quantization_scheme"), m, k, a->dptr<float>(), a_scale_value,
+        *a_zero_point->dptr<float>(), lda, quantized_a->data(), a_row_sums->data());
+    std::vector<float> scales(n);
+    FOR_RANGE(int64_t, j, 0, n) {
+      const float b_scale_value = b_scale->dptr<float>()[num_b_scales == 1 ? 0 : j];
+      scales[j] = static_cast<float>(alpha) * a_scale_value * b_scale_value;
+    }
+    ep::primitive::Int8Gemm(m, quantized_a->data(), quantized_a_zero_point, a_row_sums->data(),
+                            *kernel_state->mut_packed_b(), scales.data(), out->mut_dptr<float>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+REGISTER_USER_KERNEL("quantized_matmul")
+    .SetCreateFn<QuantizedMatmulCpuKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceType() == DeviceType::kCPU)
+                     && (user_op::HobDataType("a", 0) == DataType::kFloat));
+
+}  // namespace oneflow
@@ -73,7 +73,7 @@ std::function<Maybe<void>(const std::string&)> MakeSetParamDataTypeFn(user_op::I
 Maybe<void> FwInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifierFn,
                                const user_op::UserOpConfWrapper& conf) {
   bool training;
-  if (conf.op_type_name() == "normalization") {
+  if (conf.op_type_name() == "normalization" || conf.op_type_name() == "normalization_add_relu") {
     training = conf.attr<bool>("training");
   } else {
     training = true;
@@ -0,0 +1,111 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/op_generated.h"
+
+namespace oneflow {
+
+// out = alpha * fake_quantization(a) x fake_quantization(b), which is computed in int8. It is
+// created by QuantizedInferencePass from the fake quantizations of quantization aware training, so
+// a and b are quantized with the "google" formula in 8 bits. a is (..., k), b is (k, n) or (n, k)
+// if transpose_b, its scale and zero point are per-layer or per output channel.
+
+/* static */ Maybe<void> QuantizedMatmulOp::InferLogicalTensorDesc(user_op::InferContext* ctx) {
+  const bool transpose_b = ctx->Attr<bool>("transpose_b");
+  const Shape& a_shape = ctx->InputShape("a", 0);
+  const Shape& b_shape = ctx->InputShape("b", 0);
+  CHECK_GE_OR_RETURN(a_shape.NumAxes(), 2);
+  CHECK_EQ_OR_RETURN(b_shape.NumAxes(), 2);
+  const int64_t k = a_shape.At(a_shape.NumAxes() - 1);
+  const int64_t n = transpose_b ? b_shape.At(0) : b_shape.At(1);
+  CHECK_EQ_OR_RETURN(transpose_b ? b_shape.At(1) : b_shape.At(0), k);
+  CHECK_EQ_OR_RETURN(ctx->InputShape("a_scale", 0).elem_cnt(), 1);
+  CHECK_EQ_OR_RETURN(ctx->InputShape("a_zero_point", 0).elem_cnt(), 1);
+  const int64_t b_scale_cnt = ctx->InputShape("b_scale", 0).elem_cnt();
+  // the per-channel scales of b are along axis 0, which is n only if b is transposed
+  CHECK_OR_RETURN(b_scale_cnt == 1 || (transpose_b && b_scale_cnt == n));
+  CHECK_EQ_OR_RETURN(ctx->InputShape("b_zero_point", 0).elem_cnt(), b_scale_cnt);
+  DimVector out_dim_vec(a_shape.dim_vec().begin(), a_shape.dim_vec().end() - 1);
+  out_dim_vec.emplace_back(n);
+  *ctx->OutputShape("out", 0) = Shape(out_dim_vec);
+  return Maybe<void>::Ok();
+}
+
+/*static*/ Maybe<void> QuantizedMatmulOp::InferPhysicalTensorDesc(user_op::InferContext* ctx) {
+  return InferLogicalTensorDesc(ctx);
+}
+
+/* static */ Maybe<void> QuantizedMatmulOp::GetSbp(user_op::SbpContext* ctx) {
+  const Shape& a_shape = ctx->LogicalTensorDesc4InputArgNameAndIndex("a", 0).shape();
+  const int64_t b_scale_cnt =
+      ctx->LogicalTensorDesc4InputArgNameAndIndex("b_scale", 0).shape().elem_cnt();
+  // S(b or m axis) x B -> S(b or m axis)
+  for (int64_t i = 0; i < a_shape.NumAxes() - 1; ++i) {
+    ctx->NewBuilder()
+        .Split(user_op::OpArg("a", 0), i)
+        .Broadcast(user_op::OpArg("b", 0))
+        .Broadcast(user_op::OpArg("a_scale", 0))
+        .Broadcast(user_op::OpArg("a_zero_point", 0))
+        .Broadcast(user_op::OpArg("b_scale", 0))
+        .Broadcast(user_op::OpArg("b_zero_point", 0))
+        .Split(user_op::OpArg("out", 0), i)
+        .Build();
+  }
+  // B x S(n axis) -> S(n axis), the per-channel scales of b are split with it
+  if (ctx->Attr<bool>("transpose_b")) {
+    auto builder = ctx->NewBuilder();
+    builder.Broadcast(user_op::OpArg("a", 0))
+        .Split(user_op::OpArg("b", 0), 0)
+        .Broadcast(user_op::OpArg("a_scale", 0))
+        .Broadcast(user_op::OpArg("a_zero_point", 0));
+    if (b_scale_cnt > 1) {
+      builder.Split(user_op::OpArg("b_scale", 0), 0).Split(user_op::OpArg("b_zero_point", 0), 0);
+    } else {
+      builder.Broadcast(user_op::OpArg("b_scale", 0))
+          .Broadcast(user_op::OpArg("b_zero_point", 0));
+    }
+    builder.Split(user_op::OpArg("out", 0), a_shape.NumAxes() - 1).Build();
+  } else if (b_scale_cnt == 1) {
+    ctx->NewBuilder()
+        .Broadcast(user_op::OpArg("a", 0))
+        .Split(user_op::OpArg("b", 0), 1)
+        .Broadcast(user_op::OpArg("a_scale", 0))
+        .Broadcast(user_op::OpArg("a_zero_point", 0))
+        .Broadcast(user_op::OpArg("b_scale", 0))
+        .Broadcast(user_op::OpArg("b_zero_point", 0))
+        .Split(user_op::OpArg("out", 0), a_shape.NumAxes() - 1)
+        .Build();
+  }
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> QuantizedMatmulOp::InferDataType(user_op::InferContext* ctx) {
+  const DataType data_type = ctx->InputDType("a", 0);
+  CHECK_EQ_OR_RETURN(ctx->InputDType("b", 0), data_type);
+  *ctx->OutputDType("out", 0) = data_type;
+  return Maybe<void>::Ok();
+}
+
+/* static */ Maybe<void> QuantizedMatmulOp::CheckAttr(const user_op::UserOpDefWrapper&,
+                                                     const user_op::UserOpConfWrapper& op_conf) {
+  for (const std::string& attr_name : {"a_quantization_scheme", "b_quantization_scheme"}) {
+    const std::string& quantization_scheme = op_conf.attr<std::string>(attr_name);
+    CHECK_OR_RETURN(quantization_scheme == "symmetric" || quantization_scheme == "affine");
+  }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,59 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import oneflow
+
+
+class CapturedInstructions(object):
+    r"""Captures the instructions of a static eager step, e.g. one training
+    iteration, and replays them later without dispatching the ops again.
+
+    The step runs once while it is captured. Replays skip the python code, the op
+    interpreter and the shape inference, and read and write the same tensors as the
+    captured step, so copy new inputs into the captured input tensors before replaying.
+    Reading tensors in the step, e.g. by ``numpy()`` or ``item()``, can not be captured.
+
+    For example:
+
+    .. code-block:: python
+
+        >>> import oneflow as flow
+        >>> x = flow.ones(2, 3)
+        >>> y = flow.ones(2, 3)
+        >>> with flow.utils.CapturedInstructions() as step:
+        ...     z = x + y
+        >>> x.copy_(flow.zeros(2, 3))
+        >>> step.replay()
+        >>> z
+        tensor([[1., 1., 1.],
+                [1., 1., 1.]], dtype=oneflow.float32)
+
+    """
+
+    def __init__(self):
+        self._captured = oneflow._oneflow_internal.CapturedInstructions()
+
+    def __enter__(self):
+        oneflow._oneflow_internal.BeginCapturingInstructions(self._captured)
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        oneflow._oneflow_internal.EndCapturingInstructions()
+
+    def __len__(self):
+        return len(self._captured)
+
+    def replay(self):
+        self._captured.replay()
@@ -30,3 +30,15 @@ def ProfilerStart():
 
 def ProfilerStop():
     oneflow._oneflow_internal.profiler.ProfilerStop()
+
+
+def HostTracerStart():
+    oneflow._oneflow_internal.profiler.HostTracerStart()
+
+
+def HostTracerStop():
+    oneflow._oneflow_internal.profiler.HostTracerStop()
+
+
+def HostTracerDumpChromeTrace(path):
+    oneflow._oneflow_internal.profiler.HostTracerDumpChromeTrace(path)
@@ -15,10 +15,12 @@ limitations under the License.
 """
 import atexit
 import imp
+import inspect
 import os
 import socket
 import subprocess
 import sys
+import tempfile
 import unittest
 import uuid
 import doctest
@@ -27,6 +29,7 @@ from tempfile import NamedTemporaryFile
 from typing import Any, Callable, Dict
 
 import google.protobuf.text_format as pbtxt
+import numpy as np
 
 import oneflow
 import oneflow.env
@@ -334,6 +337,49 @@ class TestCase(unittest.TestCase):
             _unittest_env_initilized = True
 
 
+_run_in_subprocess_script = """
+import importlib.util
+import os
+import sys
+
+import numpy as np
+
+module_path, func_name, result_path = sys.argv[1:]
+sys.path.insert(0, os.path.dirname(module_path))
+spec = importlib.util.spec_from_file_location("_run_in_subprocess_module", module_path)
+module = importlib.util.module_from_spec(spec)
+spec.loader.exec_module(module)
+np.savez(result_path, **getattr(module, func_name)())
+"""
+
+
+def run_in_subprocess(
+    func: Callable[[], Dict[str, np.ndarray]], env_vars: Dict[str, str] = None
+) -> Dict[str, np.ndarray]:
+    """Runs the module level `func` in a new python process with `env_vars` added to the
+    environment, and returns the dict of numpy arrays it returns. It is for the options
+    which are read once when oneflow starts. The module of `func` is imported again in the
+    new process, so its test cases must stay under `if __name__ == "__main__"`.
+    """
+    env = dict(os.environ)
+    env.update(env_vars or {})
+    with tempfile.TemporaryDirectory() as tmp_dir:
+        result_path = os.path.join(tmp_dir, "results.npz")
+        subprocess.check_call(
+            [
+                sys.executable,
+                "-c",
+                _run_in_subprocess_script,
+                os.path.abspath(inspect.getfile(func)),
+                func.__name__,
+                result_path,
+            ],
+            env=env,
+        )
+        with np.load(result_path) as results:
+            return dict(results)
+
+
 def skip_unless(n, d):
     if (n > 1 or d > 1) and oneflow.sysconfig.has_rpc_backend_grpc() == False:
         return unittest.skip(
@@ -145,6 +145,15 @@ class GraphConfig(object):
         """
         self.proto.mutable_xrt_config().set_use_openvino(value)
 
+    def enable_quantized_inference(self, mode: bool = True):
+        """If true, the matmuls on CPU whose inputs are fake quantized in 8 bits are computed in int8
+        when the graph is not for training, e.g. to run a model from quantization aware training.
+
+        Args:
+            mode (bool, optional): [description]. Default is True.
+        """
+        self.proto.set_enable_quantized_inference(mode)
+
     def enable_cudnn_conv_heuristic_search_algo(self, mode: bool = True):
         """ Whether enable cudnn conv operatioin to use heuristic search algorithm.
     
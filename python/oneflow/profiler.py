@@ -13,6 +13,11 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 """
+from oneflow.framework.profiler import HostTracerStart as host_tracer_start
+from oneflow.framework.profiler import HostTracerStop as host_tracer_stop
+from oneflow.framework.profiler import (
+    HostTracerDumpChromeTrace as host_tracer_dump_chrome_trace,
+)
 from oneflow.framework.profiler import ProfilerStart as profiler_start
 from oneflow.framework.profiler import ProfilerStop as profiler_stop
 from oneflow.framework.profiler import RangePop as range_pop
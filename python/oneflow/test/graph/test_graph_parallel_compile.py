@@ -0,0 +1,109 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+import unittest
+
+import oneflow as flow
+import oneflow.unittest
+from oneflow.core.job.plan_cache_pb2 import PlanCacheEntry
+
+# The compiler reads ONEFLOW_COMPILER_PARALLEL once per process, so every compilation runs in a
+# child process, which saves its plan in the plan cache directory.
+_compile_script = """
+import oneflow as flow
+
+class Model(flow.nn.Module):
+    def __init__(self):
+        super().__init__()
+        self.branches = flow.nn.ModuleList(
+            [
+                flow.nn.Sequential(flow.nn.Linear(16, 16), flow.nn.ReLU(), flow.nn.Linear(16, 8))
+                for _ in range(8)
+            ]
+        )
+
+    def forward(self, x):
+        ys = [branch(x) for branch in self.branches]
+        return flow.cat(ys, dim=1).sum()
+
+model = Model()
+optimizer = flow.optim.SGD(model.parameters(), lr=0.1, momentum=0.9)
+
+class TrainGraph(flow.nn.Graph):
+    def __init__(self):
+        super().__init__()
+        self.model = model
+        self.add_optimizer(optimizer)
+
+    def build(self, x):
+        loss = self.model(x)
+        loss.backward()
+        return loss
+
+TrainGraph()(flow.ones(4, 16))
+"""
+
+
+def _compile_plans(compiler_parallel):
+    with tempfile.TemporaryDirectory() as cache_dir:
+        env = dict(os.environ)
+        env["ONEFLOW_PLAN_CACHE_DIR"] = cache_dir
+        env["ONEFLOW_COMPILER_PARALLEL"] = compiler_parallel
+        result = subprocess.run(
+            [sys.executable, "-c", _compile_script],
+            env=env,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+        )
+        assert result.returncode == 0, result.stdout.decode()
+        job_name2plan = {}
+        for path in glob.glob(os.path.join(cache_dir, "*.plan")):
+            entry = PlanCacheEntry()
+            with open(path, "rb") as f:
+                entry.ParseFromString(f.read())
+            # the tasks are added to the plan by a thread pool in any order
+            tasks = sorted(entry.plan.task, key=lambda task: task.task_id)
+            del entry.plan.task[:]
+            entry.plan.task.extend(tasks)
+            entry.key = ""
+            (job_conf,) = entry.plan.job_confs.job_id2job_conf.values()
+            job_name2plan[job_conf.job_name] = entry.SerializeToString(
+                deterministic=True
+            )
+        return job_name2plan
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestGraphParallelCompile(flow.unittest.TestCase):
+    def test_parallel_compile_generates_identical_plans(test_case):
+        serial_plans = _compile_plans("0")
+        parallel_plans = _compile_plans("1")
+        test_case.assertGreater(len(serial_plans), 0)
+        test_case.assertEqual(serial_plans.keys(), parallel_plans.keys())
+        for job_name, serial_plan in serial_plans.items():
+            test_case.assertTrue(
+                serial_plan == parallel_plans[job_name],
+                "the plans of job " + job_name + " are different",
+            )
+
+
+if __name__ == "__main__":
+    unittest.main()
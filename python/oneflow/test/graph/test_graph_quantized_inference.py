@@ -0,0 +1,140 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+import numpy as np
+
+import oneflow as flow
+import oneflow.unittest
+
+
+class FakeQuantizedLinear(flow.nn.Module):
+    def __init__(self, in_features, out_features, a_scheme, b_per_layer, transpose_b):
+        super().__init__()
+        weight_shape = (
+            (out_features, in_features) if transpose_b else (in_features, out_features)
+        )
+        self.weight = flow.nn.Parameter(
+            flow.tensor(np.random.uniform(-1, 1, weight_shape).astype(np.float32))
+        )
+        self.transpose_b = transpose_b
+        self.a_observer = flow.nn.MinMaxObserver(
+            quantization_formula="google",
+            quantization_bit=8,
+            quantization_scheme=a_scheme,
+            per_layer_quantization=True,
+        )
+        self.a_fake_quantization = flow.nn.FakeQuantization(
+            quantization_formula="google",
+            quantization_bit=8,
+            quantization_scheme=a_scheme,
+        )
+        self.b_observer = flow.nn.MinMaxObserver(
+            quantization_formula="google",
+            quantization_bit=8,
+            quantization_scheme="symmetric",
+            per_layer_quantization=b_per_layer,
+        )
+        self.b_fake_quantization = flow.nn.FakeQuantization(
+            quantization_formula="google",
+            quantization_bit=8,
+            quantization_scheme="symmetric",
+        )
+
+    def forward(self, x):
+        a_scale, a_zero_point = self.a_observer(x)
+        b_scale, b_zero_point = self.b_observer(self.weight)
+        a = self.a_fake_quantization(x, a_scale, a_zero_point)
+        b = self.b_fake_quantization(self.weight, b_scale, b_zero_point)
+        return flow._C.matmul(a, b, transpose_b=self.transpose_b)
+
+
+class FakeQuantizedLinearGraph(flow.nn.Graph):
+    def __init__(self, linear, quantized_inference):
+        super().__init__()
+        self.linear = linear
+        self.config.enable_quantized_inference(quantized_inference)
+
+    def build(self, x):
+        return self.linear(x)
+
+
+def _op_type_names(graph):
+    return [
+        op.user_conf.op_type_name
+        for op in graph._full_graph_proto.net.op
+        if op.HasField("user_conf")
+    ]
+
+
+def _test_quantized_inference(test_case, x_shape, a_scheme, b_per_layer, transpose_b):
+    linear = FakeQuantizedLinear(x_shape[-1], 24, a_scheme, b_per_layer, transpose_b)
+    x = flow.tensor(np.random.uniform(-2, 2, x_shape).astype(np.float32))
+    fake_quantized_out = FakeQuantizedLinearGraph(linear, False)(x)
+    quantized_graph = FakeQuantizedLinearGraph(linear, True)
+    quantized_out = quantized_graph(x)
+
+    # both fake quantizations only feed the matmul, so they are gone with it
+    op_type_names = _op_type_names(quantized_graph)
+    test_case.assertIn("quantized_matmul", op_type_names)
+    test_case.assertNotIn("fake_quantization", op_type_names)
+    test_case.assertNotIn("matmul", op_type_names)
+    test_case.assertNotIn("broadcast_matmul", op_type_names)
+
+    # the fake quantized values are exactly the dequantized int8 ones, only the rounding
+    # of the float accumulation differs
+    test_case.assertTrue(
+        np.allclose(
+            quantized_out.numpy(), fake_quantized_out.numpy(), rtol=1e-3, atol=1e-3
+        )
+    )
+
+
+def _test_unsupported_matmul_kept(test_case):
+    # a (k, n) weight quantized per row has no int8 kernel
+    linear = FakeQuantizedLinear(16, 24, "affine", False, False)
+    x = flow.tensor(np.random.uniform(-2, 2, (8, 16)).astype(np.float32))
+    fake_quantized_out = FakeQuantizedLinearGraph(linear, False)(x)
+    quantized_graph = FakeQuantizedLinearGraph(linear, True)
+    quantized_out = quantized_graph(x)
+    op_type_names = _op_type_names(quantized_graph)
+    test_case.assertNotIn("quantized_matmul", op_type_names)
+    test_case.assertIn("fake_quantization", op_type_names)
+    test_case.assertTrue(
+        np.array_equal(quantized_out.numpy(), fake_quantized_out.numpy())
+    )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestQuantizedInferenceGraph(oneflow.unittest.TestCase):
+    def test_quantized_matmul(test_case):
+        for a_scheme in ["symmetric", "affine"]:
+            for b_per_layer in [True, False]:
+                _test_quantized_inference(
+                    test_case, (8, 16), a_scheme, b_per_layer, True
+                )
+        _test_quantized_inference(test_case, (8, 16), "affine", True, False)
+
+    def test_quantized_broadcast_matmul(test_case):
+        _test_quantized_inference(test_case, (2, 5, 16), "affine", False, True)
+        _test_quantized_inference(test_case, (2, 5, 16), "symmetric", True, False)
+
+    def test_unsupported_matmul_kept(test_case):
+        _test_unsupported_matmul_kept(test_case)
+
+
+if __name__ == "__main__":
+    unittest.main()
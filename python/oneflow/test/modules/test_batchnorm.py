@@ -68,6 +68,45 @@ class TestBatchNormModule(flow.unittest.TestCase):
         y = m(x)
         return y
 
+    def test_batchnorm2d_channels_last(test_case):
+        device = "cpu"
+        channel = 6
+        x = np.random.randn(4, channel, 5, 7)
+        params = [
+            np.random.randn(channel),
+            np.random.rand(channel) + 0.5,
+            np.random.randn(channel),
+            np.random.randn(channel),
+        ]
+        for training in [True, False]:
+            outs = []
+            grads = []
+            for axis, perm in [(1, (0, 1, 2, 3)), (3, (0, 2, 3, 1))]:
+                x_tensor = flow.tensor(x.transpose(perm), dtype=flow.float32)
+                x_tensor = x_tensor.to(device)
+                x_tensor.requires_grad = True
+                running_mean, running_var, weight, bias = [
+                    flow.tensor(param, dtype=flow.float32).to(device)
+                    for param in params
+                ]
+                y = flow._C.normalization(
+                    x_tensor,
+                    running_mean,
+                    running_var,
+                    weight,
+                    bias,
+                    axis=axis,
+                    epsilon=1e-5,
+                    momentum=0.9,
+                    is_training=training,
+                )
+                (y * y).sum().backward()
+                inv_perm = np.argsort(perm)
+                outs.append(y.numpy().transpose(inv_perm))
+                grads.append(x_tensor.grad.numpy().transpose(inv_perm))
+            test_case.assertTrue(np.allclose(outs[0], outs[1], atol=1e-4, rtol=1e-4))
+            test_case.assertTrue(np.allclose(grads[0], grads[1], atol=1e-4, rtol=1e-4))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -447,6 +447,12 @@ def _test_bn_relu_eval(test_case, device, batch, channel, height, width):
     )
 
 
+def _test_bn_add_relu_eval_no_grad(test_case, device, batch, channel, height, width):
+    with flow.no_grad():
+        _test_bn_add_relu_eval(test_case, device, batch, channel, height, width)
+        _test_bn_relu_eval(test_case, device, batch, channel, height, width)
+
+
 @flow.unittest.skip_unless_1n1d()
 @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test gpu cases")
 class TestBnAddRelu(flow.unittest.TestCase):
@@ -459,6 +465,7 @@ class TestBnAddRelu(flow.unittest.TestCase):
             _test_bn_add_relu_track_running_states_false,
             _test_bn_add_relu_eval,
             _test_bn_relu_eval,
+            _test_bn_add_relu_eval_no_grad,
         ]
         arg_dict["device"] = ["cpu", "cuda"]
         arg_dict["batch"] = [1, 2, 5, 8]
@@ -0,0 +1,85 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.unittest
+
+
+def _inputs():
+    rng = np.random.RandomState(0)
+    x_np = rng.rand(256, 256).astype(np.float32)
+    w_np = rng.rand(256, 256).astype(np.float32) / 256
+    return x_np, w_np
+
+
+def _run_flow():
+    x_np, w_np = _inputs()
+    x = flow.tensor(x_np)
+    w = flow.tensor(w_np, requires_grad=True)
+    ys = [x]
+    for _ in range(16):
+        ys.append(flow.relu(flow.matmul(ys[-1], w)) + ys[-1])
+    ys[-1].sum().backward()
+    results = {"y": ys[-1].numpy(), "w_grad": w.grad.numpy()}
+    # reading the activations from the last one materializes the evicted ones again
+    for i, y in enumerate(reversed(ys)):
+        results[f"y_{i}"] = y.numpy()
+    stats = flow._oneflow_internal.GetDtrStats()
+    results["eviction_count"] = np.array(stats["eviction_count"])
+    results["recompute_count"] = np.array(stats["recompute_count"])
+    return results
+
+
+def _run_with_budget(budget_mb):
+    # The budget is read once per process
+    return flow.unittest.run_in_subprocess(
+        _run_flow,
+        {
+            "ONEFLOW_DTR_BUDGET_MB": str(budget_mb),
+            "ONEFLOW_VM_CPU_COMPUTE_STREAM_NUM": "1",
+        },
+    )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestDtr(flow.unittest.TestCase):
+    def test_dtr_recompute_evicted_cpu_tensors(test_case):
+        # every activation takes 256KB, the budget of 1MB forces them to be
+        # evicted and computed again, the budget of 0 disables DTR
+        dtr_results = _run_with_budget(1)
+        results = _run_with_budget(0)
+        test_case.assertGreater(int(dtr_results["eviction_count"]), 0)
+        test_case.assertGreater(int(dtr_results["recompute_count"]), 0)
+        test_case.assertEqual(int(results["eviction_count"]), 0)
+        test_case.assertEqual(int(results["recompute_count"]), 0)
+        for key, value in results.items():
+            if key.endswith("_count"):
+                continue
+            test_case.assertTrue(
+                np.allclose(dtr_results[key], value, rtol=1e-4, atol=1e-4), key
+            )
+        x_np, w_np = _inputs()
+        y_np = x_np
+        for _ in range(16):
+            y_np = np.maximum(np.matmul(y_np, w_np), 0) + y_np
+        test_case.assertTrue(np.allclose(dtr_results["y"], y_np, rtol=1e-4, atol=1e-4))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -42,6 +42,51 @@ def _test_instruction_replay_impl(test_case, device, shape):
     oneflow._oneflow_internal.debug.clear_recorded_instructions()
 
 
+def _test_captured_instructions_rebind_input(test_case, device, shape):
+    x = flow.tensor(
+        np.random.rand(*shape), dtype=flow.float32, device=flow.device(device)
+    )
+    y = flow.tensor(
+        np.random.rand(*shape), dtype=flow.float32, device=flow.device(device)
+    )
+    with flow.utils.CapturedInstructions() as step:
+        z = flow.relu(x * y) + y
+    test_case.assertTrue(len(step) > 0)
+    for _ in range(3):
+        x_np = np.random.randn(*shape).astype(np.float32)
+        x.copy_(x_np)
+        step.replay()
+        z_np = np.maximum(x_np * y.numpy(), 0) + y.numpy()
+        test_case.assertTrue(np.allclose(z.numpy(), z_np, 0.0001, 0.0001))
+
+
+def _test_captured_instructions_train_step(test_case, device, shape):
+    x_np = np.random.rand(*shape).astype(np.float32)
+    w_np = np.random.rand(*shape).astype(np.float32)
+    x = flow.tensor(x_np, device=flow.device(device))
+    w = flow.nn.Parameter(flow.tensor(w_np, device=flow.device(device)))
+    optimizer = flow.optim.SGD([w], lr=0.1)
+    with flow.utils.CapturedInstructions() as step:
+        loss = (x * w).sum()
+        loss.backward()
+        optimizer.step()
+        optimizer.zero_grad()
+    replay_num = 3
+    for _ in range(replay_num):
+        step.replay()
+    w_np = w_np - 0.1 * x_np * (replay_num + 1)
+    test_case.assertTrue(np.allclose(w.numpy(), w_np, 0.0001, 0.0001))
+
+
+def _test_captured_instructions_reject_callback(test_case, device, shape):
+    x = flow.tensor(
+        np.random.rand(*shape), dtype=flow.float32, device=flow.device(device)
+    )
+    with test_case.assertRaises(Exception):
+        with flow.utils.CapturedInstructions():
+            (x + 1).numpy()
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestIntructionReplay(flow.unittest.TestCase):
     def test_instruction_replay(test_case):
@@ -51,6 +96,18 @@ class TestIntructionReplay(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             _test_instruction_replay_impl(test_case, *arg)
 
+    def test_captured_instructions(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["test_fun"] = [
+            _test_captured_instructions_rebind_input,
+            _test_captured_instructions_train_step,
+            _test_captured_instructions_reject_callback,
+        ]
+        arg_dict["device"] = ["cpu", "cuda"]
+        arg_dict["shape"] = [[2, 3], [1, 10]]
+        for arg in GenArgList(arg_dict):
+            arg[0](test_case, *arg[1:])
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,102 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.unittest
+
+
+def _infer_cache_stats():
+    stats = flow._oneflow_internal.GetLocalTensorInferCacheStats()
+    return stats["hit_count"], stats["miss_count"]
+
+
+def _run_ops(x, y):
+    return flow.sum(flow.matmul(flow.add(flow.relu(x), y), y), dim=0)
+
+
+def _warmed_up_hit_count():
+    x = flow.ones(4, 4)
+    y = flow.ones(4, 4)
+    for _ in range(3):
+        _run_ops(x, y).numpy()
+    return {"hit_count": np.array(_infer_cache_stats()[0])}
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestLocalTensorInferCache(flow.unittest.TestCase):
+    def test_same_op_with_different_metas(test_case):
+        for _ in range(3):
+            for shape in [(2, 3), (4, 5, 6), (2, 3)]:
+                for dtype in [flow.float32, flow.int32]:
+                    x = flow.ones(shape, dtype=dtype)
+                    y = flow.relu(x)
+                    test_case.assertEqual(y.shape, flow.Size(shape))
+                    test_case.assertEqual(y.dtype, dtype)
+                    test_case.assertEqual(y.stride(), x.stride())
+
+    def test_same_op_with_different_attrs(test_case):
+        x_np = np.random.randn(2, 3, 4).astype(np.float32)
+        x = flow.tensor(x_np)
+        for _ in range(3):
+            for dim in range(3):
+                y = flow.sum(x, dim=dim)
+                test_case.assertTrue(
+                    np.allclose(y.numpy(), x_np.sum(axis=dim), rtol=1e-5, atol=1e-5)
+                )
+
+    def test_inplace_after_out_of_place(test_case):
+        x = flow.ones(2, 3)
+        y = flow.ones(2, 3)
+        for _ in range(3):
+            z = flow.add(x, y)
+            test_case.assertEqual(z.shape, flow.Size((2, 3)))
+            x.add_(y)
+        test_case.assertTrue(np.allclose(x.numpy(), np.full((2, 3), 4.0)))
+
+    def test_dynamic_output_shape(test_case):
+        for _ in range(3):
+            for x_np in [np.array([0, 1, 0, 2]), np.array([1, 1, 0, 2])]:
+                x = flow.tensor(x_np, dtype=flow.int32)
+                y = flow.argwhere(x)
+                test_case.assertTrue(np.array_equal(y.numpy(), np.argwhere(x_np)))
+
+    def test_hit_after_warm_up(test_case):
+        x = flow.ones(4, 4)
+        y = flow.ones(4, 4)
+        _run_ops(x, y)
+        start_hit_count, start_miss_count = _infer_cache_stats()
+        iter_num = 10
+        for _ in range(iter_num):
+            z = _run_ops(x, y)
+        hit_count, miss_count = _infer_cache_stats()
+        test_case.assertEqual(miss_count - start_miss_count, 0)
+        test_case.assertGreaterEqual(hit_count - start_hit_count, iter_num * 4)
+        test_case.assertTrue(np.allclose(z.numpy(), np.full((4,), 32.0)))
+
+    def test_zero_capacity_disables_cache(test_case):
+        # the capacity is read once per process
+        results = flow.unittest.run_in_subprocess(
+            _warmed_up_hit_count,
+            {"ONEFLOW_EAGER_LOCAL_TENSOR_INFER_CACHE_CAPACITY": "0"},
+        )
+        test_case.assertEqual(int(results["hit_count"]), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,95 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.unittest
+
+
+def _inputs():
+    rng = np.random.RandomState(0)
+    xs = [rng.randn(32, 64).astype(np.float32) for _ in range(8)]
+    ws = [rng.randn(64, 16).astype(np.float32) for _ in range(8)]
+    bs = [rng.randn(32, 16).astype(np.float32) for _ in range(8)]
+    return xs, ws, bs
+
+
+def _run_flow():
+    xs, ws, bs = _inputs()
+    results = {}
+    # independent branches, which the scheduler may spread over the streams
+    branches = [
+        flow.relu(flow.matmul(flow.tensor(x), flow.tensor(w))) + 1
+        for x, w in zip(xs, ws)
+    ]
+    results["branch_sum"] = sum(branches).numpy()
+    # in-place updates read by instructions placed before and after them
+    acc = flow.zeros(32, 16)
+    for i, b in enumerate(bs):
+        results[f"before_{i}"] = acc * 2
+        acc.add_(flow.tensor(b))
+        results[f"after_{i}"] = acc * 2
+        if i % 2 == 0:
+            results[f"after_{i}"] = results[f"after_{i}"].numpy()
+    # numpy() syncs in the middle of a chain of dependent ops
+    y = flow.tensor(xs[0])
+    for i in range(8):
+        y = flow.matmul(y, flow.tensor(ws[i])).tanh()
+        results[f"chain_{i}"] = y.numpy()
+        y = flow.cat([y, y, y, y], dim=1)
+    return {
+        key: value if isinstance(value, np.ndarray) else value.numpy()
+        for key, value in results.items()
+    }
+
+
+def _run_numpy():
+    xs, ws, bs = _inputs()
+    results = {}
+    branches = [np.maximum(x @ w, 0) + 1 for x, w in zip(xs, ws)]
+    results["branch_sum"] = sum(branches)
+    acc = np.zeros((32, 16), dtype=np.float32)
+    for i, b in enumerate(bs):
+        results[f"before_{i}"] = acc * 2
+        acc = acc + b
+        results[f"after_{i}"] = acc * 2
+    y = xs[0]
+    for i in range(8):
+        y = np.tanh(y @ ws[i])
+        results[f"chain_{i}"] = y
+        y = np.concatenate([y, y, y, y], axis=1)
+    return results
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestVmParallelCpuStreams(flow.unittest.TestCase):
+    def test_parallel_cpu_compute_streams(test_case):
+        # the stream number is read when the vm is created at the start of the process
+        results = flow.unittest.run_in_subprocess(
+            _run_flow, {"ONEFLOW_VM_CPU_COMPUTE_STREAM_NUM": "4"}
+        )
+        expected = _run_numpy()
+        test_case.assertEqual(set(results.keys()), set(expected.keys()))
+        for key, value in expected.items():
+            test_case.assertTrue(
+                np.allclose(results[key], value, rtol=1e-4, atol=1e-4), key
+            )
+
+
+if __name__ == "__main__":
+    unittest.main()
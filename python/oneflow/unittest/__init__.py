@@ -17,6 +17,7 @@ from oneflow.framework.unittest import (
     TestCase,
     num_nodes_required,
     register_test_cases,
+    run_in_subprocess,
     skip_unless_1n1d,
     skip_unless_1n2d,
     skip_unless_1n4d,
@@ -14,3 +14,4 @@ See the License for the specific language governing permissions and
 limitations under the License.
 """
 from oneflow.framework.config_util import api_load_library_now as load_library
+from oneflow.framework.instruction_capture import CapturedInstructions
@@ -0,0 +1,58 @@
+"""
+Compare the eager dispatch latency of small cpu ops with and without the local tensor
+infer cache. The cache capacity is read once per process, so the uncached run is done
+in a child process with ONEFLOW_EAGER_LOCAL_TENSOR_INFER_CACHE_CAPACITY=0.
+
+    python3 tools/benchmark_local_tensor_infer_cache.py --iters 1000
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import oneflow as flow
+
+
+def dispatch_latency_us(iter_num):
+    # small tensors, so that the time is spent in the dispatch rather than the kernels
+    x = flow.ones(4, 4)
+    y = flow.ones(4, 4)
+    for _ in range(10):
+        z = flow.sum(flow.matmul(flow.add(flow.relu(x), y), y), dim=0)
+    z.numpy()
+    start = time.perf_counter()
+    for _ in range(iter_num):
+        z = flow.sum(flow.matmul(flow.add(flow.relu(x), y), y), dim=0)
+    z.numpy()
+    return (time.perf_counter() - start) / (iter_num * 4) * 1e6
+
+
+def infer_cache_hit_rate():
+    stats = flow._oneflow_internal.GetLocalTensorInferCacheStats()
+    total = stats["hit_count"] + stats["miss_count"]
+    return stats["hit_count"] / total if total > 0 else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--iters", type=int, default=1000)
+    parser.add_argument("--only-this-process", action="store_true")
+    args = parser.parse_args()
+
+    latency = dispatch_latency_us(args.iters)
+    print(f"hit rate {infer_cache_hit_rate():.4f}, dispatch latency {latency:.2f} us")
+    if args.only_this_process:
+        return
+    env = dict(os.environ)
+    env["ONEFLOW_EAGER_LOCAL_TENSOR_INFER_CACHE_CAPACITY"] = "0"
+    print("without the cache: ", end="", flush=True)
+    subprocess.check_call(
+        [sys.executable, __file__, "--iters", str(args.iters), "--only-this-process"],
+        env=env,
+    )
+
+
+if __name__ == "__main__":
+    main()